@@ -0,0 +1,89 @@
+#version 330 core
+
+// sphere mesh
+in vec3 position;
+in vec3 normal;
+
+// per-atom data (see AtomInstance in instance_data.h)
+in vec3 instance_position;
+in uint instance_element;
+in uint instance_flags;
+
+out vec3 vertex_direction_eyespace;
+out vec3 lightdirection_eyespace;
+out vec3 normal_eyespace;
+flat out vec3 color;
+
+uniform mat4 model;             // scene rotation and unit cell centering
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 transposition;     // applied to atoms that are being moved
+uniform vec3 lightpos;
+uniform sampler1D element_data; // color (rgb) and radius (a) per element
+
+// playback: the atoms of the upcoming frames (see AtomInstance) are kept in
+// frame_atom_data, the instance then holds the lattice coefficients of the
+// periodic image and the atom follows from the instance index
+uniform samplerBuffer frame_atom_data;
+uniform int frame_base;         // first atom of the shown frame, -1 if not playing
+uniform int frame_nr_atoms;     // number of atoms per frame
+uniform mat3 frame_cell;        // lattice vectors (columns) of the shown frame
+
+const uint FLAG_EXPANSION = 1u;
+const uint FLAG_FROZEN = 2u;
+const uint SELECT_SHIFT = 2u;
+const uint SELECT_MASK = 3u;
+
+const int ATOM_INSTANCE_WORDS = 5;
+
+vec3 get_instance_position() {
+    if(frame_base < 0) {
+        return instance_position;
+    }
+
+    int word = ATOM_INSTANCE_WORDS * (frame_base + gl_InstanceID % frame_nr_atoms);
+    vec3 center = vec3(texelFetch(frame_atom_data, word).r,
+                       texelFetch(frame_atom_data, word + 1).r,
+                       texelFetch(frame_atom_data, word + 2).r);
+    return center + frame_cell * instance_position;
+}
+
+void main() {
+    vec4 element = texelFetch(element_data, int(instance_element), 0);
+    uint selection = (instance_flags >> SELECT_SHIFT) & SELECT_MASK;
+
+    vec3 center = get_instance_position();
+
+    mat4 atom_model = model;
+    if(selection == 1u) {
+        atom_model = model * transposition;
+    }
+
+    // output position of the vertex
+    vec4 position_worldspace = atom_model * vec4(center + element.a * position, 1.0);
+    gl_Position = projection * view * position_worldspace;
+
+    // calculate vertex-to-camera direction in eye space
+    vec3 position_eyespace = (view * position_worldspace).xyz;
+    vertex_direction_eyespace = vec3(0,0,0) - position_eyespace;
+
+    // calculate light-to-vertex direction in eye space
+    vec3 light_direction_worldspace = lightpos - position_worldspace.xyz;
+    lightdirection_eyespace = (view * vec4(light_direction_worldspace, 0.0)).xyz;
+
+    // the model and view matrices only rotate, translate and scale uniformly
+    normal_eyespace = mat3(view * atom_model) * normal;
+
+    // darken atoms in the periodicity expansion or with frozen directions,
+    // lighten selected atoms
+    color = element.rgb;
+    if((instance_flags & FLAG_EXPANSION) != 0u) {
+        color = mix(color, vec3(1.0) - color, 0.4);
+    } else if((instance_flags & FLAG_FROZEN) != 0u) {
+        color = 0.5 * color;
+    }
+
+    if(selection != 0u) {
+        color = mix(color, vec3(1.0), 0.1);
+    }
+}
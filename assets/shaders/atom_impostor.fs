@@ -0,0 +1,79 @@
+#version 330 core
+
+in vec3 position_eyespace;
+flat in vec3 center_eyespace;
+flat in float radius_eyespace;
+flat in vec3 lightpos_eyespace;
+flat in vec3 color;
+
+out vec4 fragColor;
+
+uniform mat4 projection;
+uniform bool silhouette;
+
+// Tunable parameters
+const float ambient_strength  = 0.05;
+const float specular_strength = 0.4;
+const float shininess         = 64.0;   // higher = tighter highlight
+
+void main()
+{
+    // ray through this fragment; in an orthographic projection all rays
+    // run along the viewing direction
+    vec3 origin = vec3(0.0);
+    vec3 direction = normalize(position_eyespace);
+    if(projection[2][3] == 0.0) {
+        origin = position_eyespace;
+        direction = vec3(0.0, 0.0, -1.0);
+    }
+
+    // closest intersection of the ray with the sphere
+    vec3 oc = origin - center_eyespace;
+    float b = dot(oc, direction);
+    float c = dot(oc, oc) - radius_eyespace * radius_eyespace;
+    float h = b * b - c;
+    if(h < 0.0) {
+        discard;
+    }
+    vec3 p = origin + (-b - sqrt(h)) * direction;
+
+    vec4 p_clipspace = projection * vec4(p, 1.0);
+    float depth_ndc = p_clipspace.z / p_clipspace.w;
+    gl_FragDepth = 0.5 * (gl_DepthRange.diff * depth_ndc + gl_DepthRange.near + gl_DepthRange.far);
+
+    if(silhouette) {
+        fragColor = vec4(color, 1.0);
+        return;
+    }
+
+    // Normalize inputs
+    vec3 N = (p - center_eyespace) / radius_eyespace;
+    vec3 L = normalize(lightpos_eyespace - p);
+    vec3 V = normalize(-p);
+
+    // --- Ambient ---
+    vec3 ambient = ambient_strength * color;
+
+    // --- Diffuse (Lambert) ---
+    float NdotL = max(dot(N, L), 0.0);
+    vec3 diffuse = NdotL * color;
+
+    // --- Specular (Blinn-Phong, more stable than reflect()) ---
+    vec3 H = normalize(L + V);   // half-vector
+    float NdotH = max(dot(N, H), 0.0);
+    float spec  = pow(NdotH, shininess);
+
+    vec3 specular = specular_strength * spec * vec3(1.0);
+
+    // --- Optional rim lighting (helps thin bonds & silhouettes) ---
+    float rim = pow(1.0 - max(dot(N, V), 0.0), 2.0);
+    vec3 rim_light = 0.15 * rim * color;
+
+    // --- Combine ---
+    vec3 result = ambient + diffuse + specular + rim_light;
+
+    // --- Gamma correction (CRITICAL for correct appearance) ---
+    result = pow(result, vec3(1.0 / 2.2));
+
+    fragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,114 @@
+#version 330 core
+
+// screen-aligned quad spanning [-1,1] x [-1,1]
+in vec2 corner;
+
+// per-atom data (see AtomInstance in instance_data.h)
+in vec3 instance_position;
+in uint instance_element;
+in uint instance_flags;
+
+out vec3 position_eyespace;     // position on the quad
+flat out vec3 center_eyespace;
+flat out float radius_eyespace;
+flat out vec3 lightpos_eyespace;
+flat out vec3 color;
+
+uniform mat4 model;             // scene rotation and unit cell centering
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 transposition;     // applied to atoms that are being moved
+uniform vec3 lightpos;
+uniform sampler1D element_data; // color (rgb) and radius (a) per element
+uniform bool silhouette;        // output the silhouette encoding rather than the atom color
+
+// playback: the atoms of the upcoming frames (see AtomInstance) are kept in
+// frame_atom_data, the instance then holds the lattice coefficients of the
+// periodic image and the atom follows from the instance index
+uniform samplerBuffer frame_atom_data;
+uniform int frame_base;         // first atom of the shown frame, -1 if not playing
+uniform int frame_nr_atoms;     // number of atoms per frame
+uniform mat3 frame_cell;        // lattice vectors (columns) of the shown frame
+
+const uint FLAG_EXPANSION = 1u;
+const uint FLAG_FROZEN = 2u;
+const uint SELECT_SHIFT = 2u;
+const uint SELECT_MASK = 3u;
+const uint RANK_SHIFT = 8u;
+
+const int ATOM_INSTANCE_WORDS = 5;
+
+vec3 get_instance_position() {
+    if(frame_base < 0) {
+        return instance_position;
+    }
+
+    int word = ATOM_INSTANCE_WORDS * (frame_base + gl_InstanceID % frame_nr_atoms);
+    vec3 center = vec3(texelFetch(frame_atom_data, word).r,
+                       texelFetch(frame_atom_data, word + 1).r,
+                       texelFetch(frame_atom_data, word + 2).r);
+    return center + frame_cell * instance_position;
+}
+
+void main() {
+    vec4 element = texelFetch(element_data, int(instance_element), 0);
+    uint selection = (instance_flags >> SELECT_SHIFT) & SELECT_MASK;
+
+    vec3 center = get_instance_position();
+
+    mat4 atom_model = model;
+    if(selection == 1u) {
+        atom_model = model * transposition;
+    }
+
+    // the model and view matrices only rotate, translate and scale uniformly
+    mat4 modelview = view * atom_model;
+    center_eyespace = (modelview * vec4(center, 1.0)).xyz;
+    radius_eyespace = element.a * length(modelview[0].xyz);
+
+    // the quad faces the viewer; in a perspective projection it is placed
+    // perpendicular to the line of sight towards the center and enlarged
+    // to the circle in which the cone of sight touches the sphere
+    float size = radius_eyespace;
+    vec3 axis_z = vec3(0.0, 0.0, 1.0);
+    if(projection[2][3] != 0.0) {
+        float distance = length(center_eyespace);
+        axis_z = -center_eyespace / distance;
+        size *= distance / sqrt(max(distance * distance - radius_eyespace * radius_eyespace, 1e-6));
+    }
+    vec3 helper = abs(axis_z.y) < 0.999 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 axis_x = normalize(cross(helper, axis_z));
+    vec3 axis_y = cross(axis_z, axis_x);
+
+    position_eyespace = center_eyespace + size * (axis_x * corner.x + axis_y * corner.y);
+    gl_Position = projection * vec4(position_eyespace, 1.0);
+
+    lightpos_eyespace = (view * vec4(lightpos, 1.0)).xyz;
+
+    if(silhouette) {
+        // selected atoms are encoded by their rank in the red channel and
+        // their selection state in the blue channel
+        float rank = float(instance_flags >> RANK_SHIFT) / 255.0;
+        if(selection == 1u) {
+            color = vec3(rank, 0.0, 0.25);
+        } else if(selection == 2u) {
+            color = vec3(rank, 0.0, 0.50);
+        } else {
+            color = vec3(0.0);
+        }
+        return;
+    }
+
+    // darken atoms in the periodicity expansion or with frozen directions,
+    // lighten selected atoms
+    color = element.rgb;
+    if((instance_flags & FLAG_EXPANSION) != 0u) {
+        color = mix(color, vec3(1.0) - color, 0.4);
+    } else if((instance_flags & FLAG_FROZEN) != 0u) {
+        color = 0.5 * color;
+    }
+
+    if(selection != 0u) {
+        color = mix(color, vec3(1.0), 0.1);
+    }
+}
@@ -0,0 +1,100 @@
+#version 330 core
+
+// bond mesh: two unit cylinders along z, one per half of the bond
+in vec4 position;               // xyz: vertex, w: half of the bond (0 or 1)
+in vec3 normal;
+
+// per-bond data (see BondInstance in instance_data.h)
+in vec3 instance_start;
+in vec3 instance_end;
+in vec3 instance_translation;
+in uint instance_atoms;
+
+out vec3 vertex_direction_eyespace;
+out vec3 lightdirection_eyespace;
+out vec3 normal_eyespace;
+out float bond_half;
+flat out vec3 color1;
+flat out vec3 color2;
+
+uniform mat4 model;             // scene rotation and unit cell centering
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightpos;
+uniform float radius;
+uniform sampler1D element_data; // color (rgb) and radius (a) per element
+
+// playback: the bonds of the upcoming frames (see BondInstance) are kept in
+// frame_bond_data, the bond then follows from the instance index
+uniform usamplerBuffer frame_bond_data;
+uniform int frame_base;         // first bond of the shown frame, -1 if not playing
+
+const uint ELEMENT_MASK = 0xFFu;
+const uint ELEMENT2_SHIFT = 8u;
+const uint FLAG_FROZEN1 = 0x10000u;
+const uint FLAG_FROZEN2 = 0x20000u;
+
+const int BOND_INSTANCE_WORDS = 10;
+
+vec3 fetch_bond_vector(int word) {
+    return vec3(uintBitsToFloat(texelFetch(frame_bond_data, word).r),
+                uintBitsToFloat(texelFetch(frame_bond_data, word + 1).r),
+                uintBitsToFloat(texelFetch(frame_bond_data, word + 2).r));
+}
+
+void main() {
+    vec3 start = instance_start;
+    vec3 end = instance_end;
+    vec3 translation = instance_translation;
+    uint atoms = instance_atoms;
+    if(frame_base >= 0) {
+        int word = BOND_INSTANCE_WORDS * (frame_base + gl_InstanceID);
+        start = fetch_bond_vector(word);
+        end = fetch_bond_vector(word + 3);
+        translation = fetch_bond_vector(word + 6);
+        atoms = texelFetch(frame_bond_data, word + 9).r;
+    }
+
+    // the bond runs from atom1 towards the (periodic image of) atom2
+    vec3 bond = end + translation - start;
+    float bond_length = length(bond);
+    vec3 axis_z = bond / bond_length;
+
+    // any orthonormal frame around the bond will do as the cylinder is symmetric
+    vec3 helper = abs(axis_z.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 axis_x = normalize(cross(helper, axis_z));
+    vec3 axis_y = cross(axis_z, axis_x);
+
+    // the first half is anchored at atom1 and the second half at atom2, such
+    // that bonds crossing the unit cell boundary end at the cell faces
+    vec3 anchor = position.w < 0.5 ? start : end - bond;
+    vec3 vertex = anchor + axis_z * (position.z * bond_length) +
+                  radius * (axis_x * position.x + axis_y * position.y);
+
+    // output position of the vertex
+    vec4 position_worldspace = model * vec4(vertex, 1.0);
+    gl_Position = projection * view * position_worldspace;
+
+    // calculate vertex-to-camera direction in eye space
+    vec3 position_eyespace = (view * position_worldspace).xyz;
+    vertex_direction_eyespace = vec3(0,0,0) - position_eyespace;
+
+    // calculate light-to-vertex direction in eye space
+    vec3 light_direction_worldspace = lightpos - position_worldspace.xyz;
+    lightdirection_eyespace = (view * vec4(light_direction_worldspace, 0.0)).xyz;
+
+    // the model and view matrices only rotate, translate and scale uniformly
+    normal_eyespace = mat3(view * model) * (axis_x * normal.x + axis_y * normal.y);
+
+    // each half takes the color of the atom it is attached to, darkened
+    // when that atom has frozen directions
+    bond_half = position.w;
+    color1 = texelFetch(element_data, int(atoms & ELEMENT_MASK), 0).rgb;
+    color2 = texelFetch(element_data, int((atoms >> ELEMENT2_SHIFT) & ELEMENT_MASK), 0).rgb;
+    if((atoms & FLAG_FROZEN1) != 0u) {
+        color1 = 0.5 * color1;
+    }
+    if((atoms & FLAG_FROZEN2) != 0u) {
+        color2 = 0.5 * color2;
+    }
+}
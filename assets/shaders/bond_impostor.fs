@@ -0,0 +1,85 @@
+#version 330 core
+
+in vec3 position_eyespace;
+flat in vec3 segment_start_eyespace;
+flat in vec3 segment_end_eyespace;
+flat in float radius_eyespace;
+flat in vec3 lightpos_eyespace;
+flat in vec3 color;
+
+out vec4 fragColor;
+
+uniform mat4 projection;
+
+// Tunable parameters
+const float ambient_strength  = 0.05;
+const float specular_strength = 0.4;
+const float shininess         = 64.0;   // higher = tighter highlight
+
+void main()
+{
+    // ray through this fragment; in an orthographic projection all rays
+    // run along the viewing direction
+    vec3 origin = vec3(0.0);
+    vec3 direction = normalize(position_eyespace);
+    if(projection[2][3] == 0.0) {
+        origin = position_eyespace;
+        direction = vec3(0.0, 0.0, -1.0);
+    }
+
+    // closest intersection of the ray with the side of the cylinder; the
+    // ends are covered by the atoms
+    vec3 ba = segment_end_eyespace - segment_start_eyespace;
+    vec3 oc = origin - segment_start_eyespace;
+    float baba = dot(ba, ba);
+    float bard = dot(ba, direction);
+    float baoc = dot(ba, oc);
+    float k2 = baba - bard * bard;
+    float k1 = baba * dot(oc, direction) - baoc * bard;
+    float k0 = baba * dot(oc, oc) - baoc * baoc - radius_eyespace * radius_eyespace * baba;
+    float h = k1 * k1 - k2 * k0;
+    if(k2 <= 0.0 || h < 0.0) {
+        discard;
+    }
+    float t = (-k1 - sqrt(h)) / k2;
+    float y = baoc + t * bard;
+    if(y < 0.0 || y > baba) {
+        discard;
+    }
+    vec3 p = origin + t * direction;
+
+    vec4 p_clipspace = projection * vec4(p, 1.0);
+    float depth_ndc = p_clipspace.z / p_clipspace.w;
+    gl_FragDepth = 0.5 * (gl_DepthRange.diff * depth_ndc + gl_DepthRange.near + gl_DepthRange.far);
+
+    // Normalize inputs
+    vec3 N = (oc + t * direction - ba * (y / baba)) / radius_eyespace;
+    vec3 L = normalize(lightpos_eyespace - p);
+    vec3 V = normalize(-p);
+
+    // --- Ambient ---
+    vec3 ambient = ambient_strength * color;
+
+    // --- Diffuse (Lambert) ---
+    float NdotL = max(dot(N, L), 0.0);
+    vec3 diffuse = NdotL * color;
+
+    // --- Specular (Blinn-Phong, more stable than reflect()) ---
+    vec3 H = normalize(L + V);   // half-vector
+    float NdotH = max(dot(N, H), 0.0);
+    float spec  = pow(NdotH, shininess);
+
+    vec3 specular = specular_strength * spec * vec3(1.0);
+
+    // --- Optional rim lighting (helps thin bonds & silhouettes) ---
+    float rim = pow(1.0 - max(dot(N, V), 0.0), 2.0);
+    vec3 rim_light = 0.15 * rim * color;
+
+    // --- Combine ---
+    vec3 result = ambient + diffuse + specular + rim_light;
+
+    // --- Gamma correction (CRITICAL for correct appearance) ---
+    result = pow(result, vec3(1.0 / 2.2));
+
+    fragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,96 @@
+#version 330 core
+
+// bond proxy: two boxes around the unit cylinders along z, one per half of the bond
+in vec4 position;               // xyz: vertex, w: half of the bond (0 or 1)
+
+// per-bond data (see BondInstance in instance_data.h)
+in vec3 instance_start;
+in vec3 instance_end;
+in vec3 instance_translation;
+in uint instance_atoms;
+
+out vec3 position_eyespace;     // position on the box
+flat out vec3 segment_start_eyespace;
+flat out vec3 segment_end_eyespace;
+flat out float radius_eyespace;
+flat out vec3 lightpos_eyespace;
+flat out vec3 color;
+
+uniform mat4 model;             // scene rotation and unit cell centering
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 lightpos;
+uniform float radius;
+uniform sampler1D element_data; // color (rgb) and radius (a) per element
+
+// playback: the bonds of the upcoming frames (see BondInstance) are kept in
+// frame_bond_data, the bond then follows from the instance index
+uniform usamplerBuffer frame_bond_data;
+uniform int frame_base;         // first bond of the shown frame, -1 if not playing
+
+const uint ELEMENT_MASK = 0xFFu;
+const uint ELEMENT2_SHIFT = 8u;
+const uint FLAG_FROZEN1 = 0x10000u;
+const uint FLAG_FROZEN2 = 0x20000u;
+
+const int BOND_INSTANCE_WORDS = 10;
+
+vec3 fetch_bond_vector(int word) {
+    return vec3(uintBitsToFloat(texelFetch(frame_bond_data, word).r),
+                uintBitsToFloat(texelFetch(frame_bond_data, word + 1).r),
+                uintBitsToFloat(texelFetch(frame_bond_data, word + 2).r));
+}
+
+void main() {
+    vec3 start = instance_start;
+    vec3 end = instance_end;
+    vec3 translation = instance_translation;
+    uint atoms = instance_atoms;
+    if(frame_base >= 0) {
+        int word = BOND_INSTANCE_WORDS * (frame_base + gl_InstanceID);
+        start = fetch_bond_vector(word);
+        end = fetch_bond_vector(word + 3);
+        translation = fetch_bond_vector(word + 6);
+        atoms = texelFetch(frame_bond_data, word + 9).r;
+    }
+
+    // the bond runs from atom1 towards the (periodic image of) atom2
+    vec3 bond = end + translation - start;
+    float bond_length = length(bond);
+    vec3 axis_z = bond / bond_length;
+
+    vec3 helper = abs(axis_z.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 axis_x = normalize(cross(helper, axis_z));
+    vec3 axis_y = cross(axis_z, axis_x);
+
+    // the first half is anchored at atom1 and the second half at atom2, such
+    // that bonds crossing the unit cell boundary end at the cell faces
+    vec3 anchor = position.w < 0.5 ? start : end - bond;
+    float segment_offset = position.w < 0.5 ? 0.0 : 0.5;
+    vec3 vertex = anchor + axis_z * (position.z * bond_length) +
+                  radius * (axis_x * position.x + axis_y * position.y);
+
+    // the model and view matrices only rotate, translate and scale uniformly
+    mat4 modelview = view * model;
+    position_eyespace = (modelview * vec4(vertex, 1.0)).xyz;
+    gl_Position = projection * vec4(position_eyespace, 1.0);
+
+    segment_start_eyespace = (modelview * vec4(anchor + axis_z * (segment_offset * bond_length), 1.0)).xyz;
+    segment_end_eyespace = (modelview * vec4(anchor + axis_z * ((segment_offset + 0.5) * bond_length), 1.0)).xyz;
+    radius_eyespace = radius * length(modelview[0].xyz);
+    lightpos_eyespace = (view * vec4(lightpos, 1.0)).xyz;
+
+    // each half takes the color of the atom it is attached to, darkened
+    // when that atom has frozen directions
+    if(position.w < 0.5) {
+        color = texelFetch(element_data, int(atoms & ELEMENT_MASK), 0).rgb;
+        if((atoms & FLAG_FROZEN1) != 0u) {
+            color = 0.5 * color;
+        }
+    } else {
+        color = texelFetch(element_data, int((atoms >> ELEMENT2_SHIFT) & ELEMENT_MASK), 0).rgb;
+        if((atoms & FLAG_FROZEN2) != 0u) {
+            color = 0.5 * color;
+        }
+    }
+}
@@ -1,11 +1,66 @@
 #version 330 core
 
+// sphere mesh
 in vec3 position;
 in vec3 normal;
 
+// per-atom data (see AtomInstance in instance_data.h)
+in vec3 instance_position;
+in uint instance_element;
+in uint instance_flags;
+
+flat out vec3 color;
+
 uniform mat4 mvp;
+uniform mat4 transposition;     // applied to atoms that are being moved
+uniform sampler1D element_data; // color (rgb) and radius (a) per element
+
+// playback: the atoms of the upcoming frames (see AtomInstance) are kept in
+// frame_atom_data, the instance then holds the lattice coefficients of the
+// periodic image and the atom follows from the instance index
+uniform samplerBuffer frame_atom_data;
+uniform int frame_base;         // first atom of the shown frame, -1 if not playing
+uniform int frame_nr_atoms;     // number of atoms per frame
+uniform mat3 frame_cell;        // lattice vectors (columns) of the shown frame
+
+const uint SELECT_SHIFT = 2u;
+const uint SELECT_MASK = 3u;
+const uint RANK_SHIFT = 8u;
+
+const int ATOM_INSTANCE_WORDS = 5;
+
+vec3 get_instance_position() {
+    if(frame_base < 0) {
+        return instance_position;
+    }
+
+    int word = ATOM_INSTANCE_WORDS * (frame_base + gl_InstanceID % frame_nr_atoms);
+    vec3 center = vec3(texelFetch(frame_atom_data, word).r,
+                       texelFetch(frame_atom_data, word + 1).r,
+                       texelFetch(frame_atom_data, word + 2).r);
+    return center + frame_cell * instance_position;
+}
 
 void main() {
+    float radius = texelFetch(element_data, int(instance_element), 0).a;
+    uint selection = (instance_flags >> SELECT_SHIFT) & SELECT_MASK;
+
+    vec4 p = vec4(get_instance_position() + radius * position, 1.0);
+    if(selection == 1u) {
+        p = transposition * p;
+    }
+
     // output position of the vertex
-    gl_Position = mvp * vec4(position, 1.0);
+    gl_Position = mvp * p;
+
+    // selected atoms are encoded by their rank in the red channel and
+    // their selection state in the blue channel
+    float rank = float(instance_flags >> RANK_SHIFT) / 255.0;
+    if(selection == 1u) {
+        color = vec3(rank, 0.0, 0.25);
+    } else if(selection == 2u) {
+        color = vec3(rank, 0.0, 0.50);
+    } else {
+        color = vec3(0.0);
+    }
 }
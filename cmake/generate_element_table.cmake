@@ -0,0 +1,43 @@
+# Generate the element table of AtomSettings from atoms.json
+#
+# Usage: cmake -DINPUT=<atoms.json> -DOUTPUT=<element_table.inc> -P generate_element_table.cmake
+#
+# Every line of the output holds one initializer of an ElementData entry
+# (symbol, color, radius, mass), ordered by atomic number. Atomic numbers
+# that are absent from atoms.json yield an empty entry.
+
+file(READ ${INPUT} json)
+
+# find the largest atomic number
+string(JSON nr_entries LENGTH ${json} atoms nr2element)
+set(max_elnr 0)
+math(EXPR last_entry "${nr_entries} - 1")
+foreach(i RANGE ${last_entry})
+    string(JSON elnr MEMBER ${json} atoms nr2element ${i})
+    if(elnr GREATER max_elnr)
+        set(max_elnr ${elnr})
+    endif()
+endforeach()
+
+set(content "// generated from atoms.json by generate_element_table.cmake, do not edit\n")
+foreach(elnr RANGE ${max_elnr})
+    string(JSON elname ERROR_VARIABLE error GET ${json} atoms nr2element ${elnr})
+    if(error)
+        string(APPEND content "{\"\", {0x00, 0x00, 0x00}, 0.0, 0.0},\n")
+        continue()
+    endif()
+
+    string(JSON color GET ${json} atoms colors ${elname})
+    string(JSON radius GET ${json} atoms radii ${elname})
+    string(JSON mass GET ${json} atoms masses ${elname})
+    if(NOT color MATCHES "^#[0-9A-Fa-f][0-9A-Fa-f][0-9A-Fa-f][0-9A-Fa-f][0-9A-Fa-f][0-9A-Fa-f]$")
+        message(FATAL_ERROR "Invalid color '${color}' for element ${elname} in ${INPUT}")
+    endif()
+    string(SUBSTRING ${color} 1 2 red)
+    string(SUBSTRING ${color} 3 2 green)
+    string(SUBSTRING ${color} 5 2 blue)
+
+    string(APPEND content "{\"${elname}\", {0x${red}, 0x${green}, 0x${blue}}, ${radius}, ${mass}},\n")
+endforeach()
+
+file(WRITE ${OUTPUT} ${content})
@@ -0,0 +1,427 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "atom_arrays.h"
+
+#include <cmath>
+#include <limits>
+
+#ifdef ATOM_ARRAYS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "atom_settings.h"
+#include "parallel.h"
+
+/**
+ * @brief      Constructs a new instance.
+ */
+AtomArrays::AtomArrays() {
+
+}
+
+    /**
+     * @brief      Fill the arrays from a set of atoms
+     *
+     * @param[in]  atoms  The atoms
+     */
+void AtomArrays::assign(const std::vector<Atom>& atoms) {
+    this->nr_atoms = atoms.size();
+    this->x.resize(this->nr_atoms);
+    this->y.resize(this->nr_atoms);
+    this->z.resize(this->nr_atoms);
+    this->radius.resize(this->nr_atoms);
+    this->element.resize(this->nr_atoms);
+    this->flags.resize(this->nr_atoms);
+
+    for(size_t i=0; i<this->nr_atoms; i++) {
+        const Atom& atom = atoms[i];
+        this->x[i] = (float)atom.x;
+        this->y[i] = (float)atom.y;
+        this->z[i] = (float)atom.z;
+        this->radius[i] = AtomSettings::get().get_atom_radius_from_elnr(atom.atnr);
+        this->element[i] = (uint8_t)atom.atnr;
+
+        uint8_t f = (uint8_t)(atom.atomtype & ATOM_FLAG_TYPE_MASK);
+        f |= (uint8_t)((atom.select << ATOM_FLAG_SELECT_SHIFT) & ATOM_FLAG_SELECT_MASK);
+        if(!atom.selective_dynamics[0] || !atom.selective_dynamics[1] || !atom.selective_dynamics[2]) {
+            f |= ATOM_FLAG_FROZEN;
+        }
+        this->flags[i] = f;
+    }
+}
+
+    /**
+     * @brief      Get the atom furthest from the origin
+     *
+     * @return     Index of the atom, zero if there are no atoms
+     */
+size_t AtomArrays::find_furthest_from_origin() const {
+    typedef std::pair<float, size_t> Candidate;     // squared distance and index
+
+    // on ties, the earlier chunk and thereby the lowest index is kept
+    const Candidate best = Parallel::reduce(this->nr_atoms, Candidate(-1.0f, 0),
+        [this](size_t begin, size_t end) {
+            Candidate c(-1.0f, 0);
+            c.second = this->find_furthest_from_origin(begin, end, c.first);
+            return c;
+        },
+        [](const Candidate& a, const Candidate& b) {
+            return b.first > a.first ? b : a;
+        });
+
+    return best.second;
+}
+
+    /**
+     * @brief      Get the atom furthest from the origin in a range of atoms
+     *
+     * @param[in]  begin  First atom
+     * @param[in]  end    One past the last atom
+     * @param      best   Squared distance of the furthest atom (output)
+     *
+     * @return     Index of the atom, begin if the range is empty
+     */
+size_t AtomArrays::find_furthest_from_origin(size_t begin, size_t end, float& best) const {
+    const size_t n = end;
+    best = -1.0f;
+    size_t best_idx = begin;
+    size_t i = begin;
+
+#ifdef ATOM_ARRAYS_SSE2
+    if(n - i >= 4) {
+        __m128 vbest = _mm_set1_ps(-1.0f);
+        __m128i vbest_idx = _mm_set1_epi32((int)i);
+        __m128i vidx = _mm_setr_epi32((int)i, (int)i+1, (int)i+2, (int)i+3);
+        const __m128i vfour = _mm_set1_epi32(4);
+        for(; i+4 <= n; i+=4) {
+            const __m128 vx = _mm_loadu_ps(&this->x[i]);
+            const __m128 vy = _mm_loadu_ps(&this->y[i]);
+            const __m128 vz = _mm_loadu_ps(&this->z[i]);
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+            // strict comparison keeps the earliest index within each lane
+            const __m128 gt = _mm_cmpgt_ps(d, vbest);
+            vbest = _mm_or_ps(_mm_and_ps(gt, d), _mm_andnot_ps(gt, vbest));
+            const __m128i gti = _mm_castps_si128(gt);
+            vbest_idx = _mm_or_si128(_mm_and_si128(gti, vidx), _mm_andnot_si128(gti, vbest_idx));
+            vidx = _mm_add_epi32(vidx, vfour);
+        }
+
+        alignas(16) float lane_best[4];
+        alignas(16) int32_t lane_idx[4];
+        _mm_store_ps(lane_best, vbest);
+        _mm_store_si128((__m128i*)lane_idx, vbest_idx);
+        best_idx = std::numeric_limits<size_t>::max();
+        for(unsigned int l=0; l<4; l++) {
+            if(lane_best[l] > best || (lane_best[l] == best && (size_t)lane_idx[l] < best_idx)) {
+                best = lane_best[l];
+                best_idx = (size_t)lane_idx[l];
+            }
+        }
+    }
+#endif
+
+    for(; i<n; i++) {
+        const float d = this->x[i] * this->x[i] + this->y[i] * this->y[i] + this->z[i] * this->z[i];
+        if(d > best) {
+            best = d;
+            best_idx = i;
+        }
+    }
+
+    return best_idx;
+}
+
+    /**
+     * @brief      Calculate squared distances of all atoms to a point
+     *
+     * @param[in]  p     The point
+     * @param      out   Output (resized to the number of atoms)
+     */
+void AtomArrays::get_distances2(const QVector3D& p, std::vector<float>& out) const {
+    out.resize(this->nr_atoms);
+    Parallel::for_chunks(this->nr_atoms, [&](size_t begin, size_t end) {
+        this->get_distances2(p, out.data(), begin, end);
+    });
+}
+
+    /**
+     * @brief      Calculate squared distances of a range of atoms to a point
+     *
+     * @param[in]  p      The point
+     * @param      out    Output (indexed by atom)
+     * @param[in]  begin  First atom
+     * @param[in]  end    One past the last atom
+     */
+void AtomArrays::get_distances2(const QVector3D& p, float* out, size_t begin, size_t end) const {
+    const size_t n = end;
+    size_t i = begin;
+
+#ifdef ATOM_ARRAYS_SSE2
+    const __m128 px = _mm_set1_ps(p[0]);
+    const __m128 py = _mm_set1_ps(p[1]);
+    const __m128 pz = _mm_set1_ps(p[2]);
+    for(; i+4 <= n; i+=4) {
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&this->x[i]), px);
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&this->y[i]), py);
+        const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&this->z[i]), pz);
+        _mm_storeu_ps(&out[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+    }
+#endif
+
+    for(; i<n; i++) {
+        const float dx = this->x[i] - p[0];
+        const float dy = this->y[i] - p[1];
+        const float dz = this->z[i] - p[2];
+        out[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+    /**
+     * @brief      Find the closest atom intersected by a ray
+     *
+     * @param[in]  origin        Ray origin
+     * @param[in]  direction     Normalized ray direction
+     * @param[in]  depth_axis    Axis used to sort the hits
+     * @param[in]  depth_offset  Offset added to the depth
+     * @param      best_depth    Depth of the best hit
+     * @param[in]  visible       Optional lookup table indexed by atomtype
+     *
+     * @return     Index of the atom or -1 if no atom is hit
+     */
+int AtomArrays::raycast(const QVector3D& origin,
+                        const QVector3D& direction,
+                        const QVector3D& depth_axis,
+                        float depth_offset,
+                        float& best_depth,
+                        const std::array<bool, 8>* visible) const {
+    typedef std::pair<float, int> Candidate;    // depth and index
+
+    // on ties, the earlier chunk and thereby the lowest index is kept
+    const Candidate best = Parallel::reduce(this->nr_atoms, Candidate(best_depth, -1),
+        [&](size_t begin, size_t end) {
+            Candidate c(best_depth, -1);
+            c.second = this->raycast(begin, end, origin, direction, depth_axis, depth_offset, c.first, visible);
+            return c;
+        },
+        [](const Candidate& a, const Candidate& b) {
+            return (b.second >= 0 && b.first < a.first) ? b : a;
+        });
+
+    best_depth = best.first;
+    return best.second;
+}
+
+    /**
+     * @brief      Find the closest atom intersected by a ray in a range of atoms
+     *
+     * @param[in]  begin         First atom
+     * @param[in]  end           One past the last atom
+     * @param[in]  origin        Ray origin
+     * @param[in]  direction     Normalized ray direction
+     * @param[in]  depth_axis    Axis used to sort the hits
+     * @param[in]  depth_offset  Offset added to the depth
+     * @param      best_depth    Depth of the best hit
+     * @param[in]  visible       Optional lookup table indexed by atomtype
+     *
+     * @return     Index of the atom or -1 if no atom is hit
+     */
+int AtomArrays::raycast(size_t begin,
+                        size_t end,
+                        const QVector3D& origin,
+                        const QVector3D& direction,
+                        const QVector3D& depth_axis,
+                        float depth_offset,
+                        float& best_depth,
+                        const std::array<bool, 8>* visible) const {
+    const size_t n = end;
+    int best_idx = -1;
+    size_t i = begin;
+
+#ifdef ATOM_ARRAYS_SSE2
+    if(n - i >= 4) {
+        const __m128 ox = _mm_set1_ps(origin[0]);
+        const __m128 oy = _mm_set1_ps(origin[1]);
+        const __m128 oz = _mm_set1_ps(origin[2]);
+        const __m128 dx = _mm_set1_ps(direction[0]);
+        const __m128 dy = _mm_set1_ps(direction[1]);
+        const __m128 dz = _mm_set1_ps(direction[2]);
+        const __m128 ax = _mm_set1_ps(depth_axis[0]);
+        const __m128 ay = _mm_set1_ps(depth_axis[1]);
+        const __m128 az = _mm_set1_ps(depth_axis[2]);
+        const __m128 aoff = _mm_set1_ps(depth_offset);
+
+        __m128 vbest = _mm_set1_ps(best_depth);
+        __m128i vbest_idx = _mm_set1_epi32(-1);
+        __m128i vidx = _mm_setr_epi32((int)i, (int)i+1, (int)i+2, (int)i+3);
+        const __m128i vfour = _mm_set1_epi32(4);
+
+        for(; i+4 <= n; i+=4) {
+            const __m128 px = _mm_loadu_ps(&this->x[i]);
+            const __m128 py = _mm_loadu_ps(&this->y[i]);
+            const __m128 pz = _mm_loadu_ps(&this->z[i]);
+            const __m128 r = _mm_loadu_ps(&this->radius[i]);
+
+            // vector from atom to ray origin
+            const __m128 qx = _mm_sub_ps(ox, px);
+            const __m128 qy = _mm_sub_ps(oy, py);
+            const __m128 qz = _mm_sub_ps(oz, pz);
+
+            const __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz));
+            const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz)),
+                                        _mm_mul_ps(r, r));
+            const __m128 depth = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, px), _mm_mul_ps(ay, py)), _mm_mul_ps(az, pz)), aoff);
+
+            __m128 mask = _mm_and_ps(_mm_cmpge_ps(_mm_mul_ps(b, b), c), _mm_cmplt_ps(depth, vbest));
+            if(visible) {
+                const __m128i vis = _mm_setr_epi32(
+                    (*visible)[this->flags[i]   & ATOM_FLAG_TYPE_MASK] ? -1 : 0,
+                    (*visible)[this->flags[i+1] & ATOM_FLAG_TYPE_MASK] ? -1 : 0,
+                    (*visible)[this->flags[i+2] & ATOM_FLAG_TYPE_MASK] ? -1 : 0,
+                    (*visible)[this->flags[i+3] & ATOM_FLAG_TYPE_MASK] ? -1 : 0);
+                mask = _mm_and_ps(mask, _mm_castsi128_ps(vis));
+            }
+
+            vbest = _mm_or_ps(_mm_and_ps(mask, depth), _mm_andnot_ps(mask, vbest));
+            const __m128i maski = _mm_castps_si128(mask);
+            vbest_idx = _mm_or_si128(_mm_and_si128(maski, vidx), _mm_andnot_si128(maski, vbest_idx));
+            vidx = _mm_add_epi32(vidx, vfour);
+        }
+
+        alignas(16) float lane_best[4];
+        alignas(16) int32_t lane_idx[4];
+        _mm_store_ps(lane_best, vbest);
+        _mm_store_si128((__m128i*)lane_idx, vbest_idx);
+        for(unsigned int l=0; l<4; l++) {
+            if(lane_idx[l] < 0) {
+                continue;
+            }
+
+            if(lane_best[l] < best_depth || (lane_best[l] == best_depth && lane_idx[l] < best_idx)) {
+                best_depth = lane_best[l];
+                best_idx = lane_idx[l];
+            }
+        }
+    }
+#endif
+
+    for(; i<n; i++) {
+        if(visible && !(*visible)[this->flags[i] & ATOM_FLAG_TYPE_MASK]) {
+            continue;
+        }
+
+        const float qx = origin[0] - this->x[i];
+        const float qy = origin[1] - this->y[i];
+        const float qz = origin[2] - this->z[i];
+        const float b = direction[0] * qx + direction[1] * qy + direction[2] * qz;
+        const float c = qx * qx + qy * qy + qz * qz - this->radius[i] * this->radius[i];
+        const float depth = depth_axis[0] * this->x[i] + depth_axis[1] * this->y[i] + depth_axis[2] * this->z[i] + depth_offset;
+
+        if(b * b >= c && depth < best_depth) {
+            best_depth = depth;
+            best_idx = (int)i;
+        }
+    }
+
+    return best_idx;
+}
+
+    /**
+     * @brief      Wrap positions into the unit cell
+     *
+     * @param      px        x coordinates
+     * @param      py        y coordinates
+     * @param      pz        z coordinates
+     * @param[in]  n         Number of positions
+     * @param[in]  unitcell  The unitcell
+     */
+void AtomArrays::wrap_positions(double* px, double* py, double* pz, size_t n, const MatrixUnitcell& unitcell) {
+    const MatrixUnitcell m = unitcell.transpose();  // direct to cartesian
+    const MatrixUnitcell minv = m.inverse();        // cartesian to direct
+    Parallel::for_chunks(n, [&](size_t begin, size_t end) {
+        AtomArrays::wrap_positions(px, py, pz, begin, end, m, minv);
+    });
+}
+
+    /**
+     * @brief      Wrap a range of positions into the unit cell
+     *
+     * @param      px     x coordinates
+     * @param      py     y coordinates
+     * @param      pz     z coordinates
+     * @param[in]  begin  First position
+     * @param[in]  end    One past the last position
+     * @param[in]  m      Transposed unit cell (direct to cartesian)
+     * @param[in]  minv   Inverse of m (cartesian to direct)
+     */
+void AtomArrays::wrap_positions(double* px, double* py, double* pz, size_t begin, size_t end,
+                                const MatrixUnitcell& m, const MatrixUnitcell& minv) {
+    const size_t n = end;
+    size_t i = begin;
+
+#ifdef ATOM_ARRAYS_SSE2
+    __m128d vm[3][3];
+    __m128d vminv[3][3];
+    for(unsigned int r=0; r<3; r++) {
+        for(unsigned int c=0; c<3; c++) {
+            vm[r][c] = _mm_set1_pd(m(r,c));
+            vminv[r][c] = _mm_set1_pd(minv(r,c));
+        }
+    }
+    const __m128d one = _mm_set1_pd(1.0);
+
+    // SSE2 lacks a floor instruction; truncate and correct negative values
+    auto vfloor = [&one](__m128d v) {
+        const __m128d t = _mm_cvtepi32_pd(_mm_cvttpd_epi32(v));
+        return _mm_sub_pd(t, _mm_and_pd(_mm_cmpgt_pd(t, v), one));
+    };
+
+    for(; i+2 <= n; i+=2) {
+        const __m128d p[3] = {_mm_loadu_pd(&px[i]), _mm_loadu_pd(&py[i]), _mm_loadu_pd(&pz[i])};
+        __m128d f[3];
+        for(unsigned int r=0; r<3; r++) {
+            f[r] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vminv[r][0], p[0]), _mm_mul_pd(vminv[r][1], p[1])), _mm_mul_pd(vminv[r][2], p[2]));
+            f[r] = _mm_sub_pd(f[r], vfloor(f[r]));
+        }
+
+        __m128d q[3];
+        for(unsigned int r=0; r<3; r++) {
+            q[r] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vm[r][0], f[0]), _mm_mul_pd(vm[r][1], f[1])), _mm_mul_pd(vm[r][2], f[2]));
+        }
+
+        _mm_storeu_pd(&px[i], q[0]);
+        _mm_storeu_pd(&py[i], q[1]);
+        _mm_storeu_pd(&pz[i], q[2]);
+    }
+#endif
+
+    for(; i<n; i++) {
+        VectorPosition f = minv * VectorPosition(px[i], py[i], pz[i]);
+        for(unsigned int j=0; j<3; j++) {
+            f[j] -= std::floor(f[j]);
+        }
+
+        const VectorPosition q = m * f;
+        px[i] = q[0];
+        py[i] = q[1];
+        pz[i] = q[2];
+    }
+}
@@ -0,0 +1,246 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QVector3D>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "atom.h"
+#include "matrixmath.h"
+
+// SSE2 is part of every x86-64 target; other architectures use the scalar kernels
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ATOM_ARRAYS_SSE2
+#endif
+
+enum {
+    ATOM_FLAG_TYPE_MASK = 0x07,         // bits 0-2: atomtype (central, expansion xy, expansion z)
+    ATOM_FLAG_SELECT_SHIFT = 3,         // bits 3-4: selection state (0, 1 or 2)
+    ATOM_FLAG_SELECT_MASK = 0x18,
+    ATOM_FLAG_FROZEN = 0x20             // bit 5: at least one direction is frozen
+};
+
+/**
+ * @brief      Structure-of-arrays representation of a set of atoms
+ *
+ * Positions are stored as contiguous single-precision arrays such that the
+ * hot loops (centering, distance queries and ray tests) only stream through
+ * the data they need and can be evaluated four atoms at a time.
+ */
+class AtomArrays {
+private:
+    std::vector<float> x;               // x coordinates
+    std::vector<float> y;               // y coordinates
+    std::vector<float> z;               // z coordinates
+    std::vector<float> radius;          // atomic radii
+    std::vector<uint8_t> element;       // atomic numbers
+    std::vector<uint8_t> flags;         // atomtype, selection and frozen flags
+    size_t nr_atoms = 0;                // number of atoms
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    AtomArrays();
+
+    /**
+     * @brief      Fill the arrays from a set of atoms
+     *
+     * @param[in]  atoms  The atoms
+     */
+    void assign(const std::vector<Atom>& atoms);
+
+    /**
+     * @brief      Gets the number of atoms.
+     *
+     * @return     The number of atoms.
+     */
+    inline size_t size() const {
+        return this->nr_atoms;
+    }
+
+    /**
+     * @brief      Gets the memory used by the arrays.
+     *
+     * @return     The memory usage in bytes.
+     */
+    inline size_t get_memory_usage() const {
+        return sizeof(AtomArrays) +
+               (this->x.capacity() + this->y.capacity() + this->z.capacity() + this->radius.capacity()) * sizeof(float) +
+               (this->element.capacity() + this->flags.capacity()) * sizeof(uint8_t);
+    }
+
+    /**
+     * @brief      Gets the position of an atom
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The position.
+     */
+    inline QVector3D get_position(size_t idx) const {
+        return QVector3D(this->x[idx], this->y[idx], this->z[idx]);
+    }
+
+    /**
+     * @brief      Gets the atomic number of an atom
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The atomic number.
+     */
+    inline unsigned int get_element(size_t idx) const {
+        return this->element[idx];
+    }
+
+    /**
+     * @brief      Gets the flags of an atom
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The flags.
+     */
+    inline uint8_t get_flags(size_t idx) const {
+        return this->flags[idx];
+    }
+
+    /**
+     * @brief      Gets the radius of an atom
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The radius.
+     */
+    inline float get_radius(size_t idx) const {
+        return this->radius[idx];
+    }
+
+    /**
+     * @brief      Get the atom furthest from the origin
+     *
+     * On ties, the atom with the lowest index is returned.
+     *
+     * @return     Index of the atom, zero if there are no atoms
+     */
+    size_t find_furthest_from_origin() const;
+
+    /**
+     * @brief      Calculate squared distances of all atoms to a point
+     *
+     * @param[in]  p     The point
+     * @param      out   Output (resized to the number of atoms)
+     */
+    void get_distances2(const QVector3D& p, std::vector<float>& out) const;
+
+    /**
+     * @brief      Find the closest atom intersected by a ray
+     *
+     * The ray is expressed in the coordinate frame of the atoms; among the
+     * intersected atoms the one with the lowest depth (dot product with the
+     * depth axis plus the depth offset) is returned.
+     *
+     * @param[in]  origin        Ray origin
+     * @param[in]  direction     Normalized ray direction
+     * @param[in]  depth_axis    Axis used to sort the hits
+     * @param[in]  depth_offset  Offset added to the depth
+     * @param      best_depth    Depth of the best hit; only hits closer than
+     *                           this value are accepted and it is updated on a hit
+     * @param[in]  visible       Optional lookup table indexed by atomtype; atoms
+     *                           whose entry is false are skipped
+     *
+     * @return     Index of the atom or -1 if no atom is hit
+     */
+    int raycast(const QVector3D& origin,
+                const QVector3D& direction,
+                const QVector3D& depth_axis,
+                float depth_offset,
+                float& best_depth,
+                const std::array<bool, 8>* visible = nullptr) const;
+
+    /**
+     * @brief      Wrap positions into the unit cell
+     *
+     * Operates in double precision on separate coordinate arrays such that
+     * it can be used on the authoritative atom coordinates.
+     *
+     * @param      px        x coordinates
+     * @param      py        y coordinates
+     * @param      pz        z coordinates
+     * @param[in]  n         Number of positions
+     * @param[in]  unitcell  The unitcell
+     */
+    static void wrap_positions(double* px, double* py, double* pz, size_t n, const MatrixUnitcell& unitcell);
+
+private:
+    // kernels operating on a range of atoms; the public functions above
+    // distribute the atoms over these in chunks (see Parallel)
+
+    /**
+     * @brief      Get the atom furthest from the origin in a range of atoms
+     *
+     * @param[in]  begin  First atom
+     * @param[in]  end    One past the last atom
+     * @param      best   Squared distance of the furthest atom (output)
+     *
+     * @return     Index of the atom, begin if the range is empty
+     */
+    size_t find_furthest_from_origin(size_t begin, size_t end, float& best) const;
+
+    /**
+     * @brief      Calculate squared distances of a range of atoms to a point
+     *
+     * @param[in]  p      The point
+     * @param      out    Output (indexed by atom)
+     * @param[in]  begin  First atom
+     * @param[in]  end    One past the last atom
+     */
+    void get_distances2(const QVector3D& p, float* out, size_t begin, size_t end) const;
+
+    /**
+     * @brief      Find the closest atom intersected by a ray in a range of atoms
+     *
+     * @return     Index of the atom or -1 if no atom is hit
+     */
+    int raycast(size_t begin,
+                size_t end,
+                const QVector3D& origin,
+                const QVector3D& direction,
+                const QVector3D& depth_axis,
+                float depth_offset,
+                float& best_depth,
+                const std::array<bool, 8>* visible) const;
+
+    /**
+     * @brief      Wrap a range of positions into the unit cell
+     *
+     * @param      px     x coordinates
+     * @param      py     y coordinates
+     * @param      pz     z coordinates
+     * @param[in]  begin  First position
+     * @param[in]  end    One past the last position
+     * @param[in]  m      Transposed unit cell (direct to cartesian)
+     * @param[in]  minv   Inverse of m (cartesian to direct)
+     */
+    static void wrap_positions(double* px, double* py, double* pz, size_t begin, size_t end,
+                               const MatrixUnitcell& m, const MatrixUnitcell& minv);
+};
@@ -20,92 +20,188 @@
 
 #include "atom_settings.h"
 
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace {
+/**
+ * @brief      Properties of a single element
+ */
+struct ElementData {
+    const char* name;           // element symbol
+    unsigned char color[3];     // default color (RGB)
+    float radius;               // atomic radius
+    double mass;                // atomic mass (amu)
+};
+
+// periodic table indexed by atomic number, generated from atoms.json at build time
+constexpr ElementData ELEMENT_TABLE[] = {
+#include "element_table.inc"
+};
+
+constexpr unsigned int ELEMENT_TABLE_SIZE = sizeof(ELEMENT_TABLE) / sizeof(ElementData);
+static_assert(ELEMENT_TABLE_SIZE <= AtomSettings::MAX_ELEMENTS, "element table exceeds MAX_ELEMENTS");
+
+/**
+ * @brief      Read a number that is stored either as a string or as a number
+ *
+ * @param[in]  value  The JSON value
+ *
+ * @return     The number.
+ */
+double json_to_double(const QJsonValue& value) {
+    return value.isString() ? value.toString().toDouble() : value.toDouble();
+}
+}
+
     /**
      * @brief      Constructs a new instance.
      */
 AtomSettings::AtomSettings() {
     this->load();
+    this->set_bond_distances();
+    this->load_overrides(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/atoms.json");
+}
 
-    // set all bonds by default to 3.0
-    this->bond_distances.resize(121);
-    for(unsigned int i=0; i<121; i++) {
-        this->bond_distances[i].resize(121, 3.0);
+    /**
+     * @brief      Fill the element tables from the embedded periodic table
+     */
+void AtomSettings::load() {
+    // unknown elements are reported with an empty name and zero properties
+    this->names.assign(MAX_ELEMENTS, std::string());
+    this->colors.assign(MAX_ELEMENTS, QVector3D(0.0f, 0.0f, 0.0f));
+    this->radii.assign(MAX_ELEMENTS, 0.0f);
+    this->masses.assign(MAX_ELEMENTS, 0.0);
+    this->elnr_lookup.clear();
+
+    for(unsigned int elnr=0; elnr<ELEMENT_TABLE_SIZE; elnr++) {
+        const ElementData& element = ELEMENT_TABLE[elnr];
+        if(element.name[0] == '\0') {
+            continue;
+        }
+
+        this->names[elnr] = element.name;
+        this->elnr_lookup.emplace(this->names[elnr], elnr);
+        this->colors[elnr] = QVector3D((float)element.color[0]/255, (float)element.color[1]/255, (float)element.color[2]/255);
+        this->radii[elnr] = element.radius;
+        this->masses[elnr] = element.mass;
     }
+}
 
-    // loop over all atoms
-    for(unsigned int i=0; i<121; i++) {
-        if(i > 20) {
-            for(unsigned int j=2; j<=20; j++) {
-                // bonds for hydrogen
-                this->bond_distances[i][1] = 2.0;
-                this->bond_distances[1][i] = 2.0;
+    /**
+     * @brief      Apply user-defined element properties
+     *
+     * The file follows the layout of atoms.json, i.e. "colors", "radii" and
+     * "masses" objects keyed by element symbol inside an "atoms" object;
+     * only the listed entries are replaced. Bond cutoffs are given in a
+     * top-level "bonds" object with keys such as "Al-C". A missing file is
+     * silently ignored.
+     *
+     * @param[in]  filename  Path to the override file
+     */
+void AtomSettings::load_overrides(const QString& filename) {
+    QFile f(filename);
+    if(!f.exists() || !f.open(QIODevice::ReadOnly)) {
+        return;
+    }
 
-                // other atoms
-                this->bond_distances[i][j] = 2.5;
-                this->bond_distances[j][i] = 2.5;
-            }
-        } else {
-            for(unsigned int j=2; j<=20; j++) {
-                // bonds for hydrogen
-                this->bond_distances[i][1] = 1.2;
-                this->bond_distances[1][i] = 1.2;
+    QJsonParseError parseError;
+    const QJsonDocument root = QJsonDocument::fromJson(f.readAll(), &parseError);
+    f.close();
+    if(parseError.error != QJsonParseError::NoError) {
+        qWarning() << "Ignoring" << filename << "; parse error at " << parseError.offset << ":" << parseError.errorString();
+        return;
+    }
 
-                // other atoms
-                this->bond_distances[i][j] = 2.0;
-                this->bond_distances[j][i] = 2.0;
-            }
+    qDebug() << "Loading element settings from" << filename;
+
+    const QJsonObject atoms = root["atoms"].toObject();
+    const QJsonObject colors = atoms["colors"].toObject();
+    for(auto it = colors.begin(); it != colors.end(); ++it) {
+        const unsigned int elnr = this->find_elnr(it.key().toStdString());
+        const QColor color(it.value().toString());
+        if(elnr < MAX_ELEMENTS && color.isValid()) {
+            this->colors[elnr] = QVector3D((float)color.red()/255, (float)color.green()/255, (float)color.blue()/255);
         }
     }
 
-    // add some special cases on the basis of user input
-    this->bond_distances[6][13] = 3.5; // Al-C
-    this->bond_distances[13][6] = 3.5;
-
-    this->radii.resize(119);
-    this->masses.resize(119);
-    for(unsigned int i=1; i<=118; i++) {
-        const std::string elname = this->get_name_from_elnr(i);
-        this->radii[i] = this->get_atom_radius(elname);
-        this->masses[i] = this->get_atom_mass(elname);
+    const QJsonObject radii = atoms["radii"].toObject();
+    for(auto it = radii.begin(); it != radii.end(); ++it) {
+        const unsigned int elnr = this->find_elnr(it.key().toStdString());
+        if(elnr < MAX_ELEMENTS) {
+            this->radii[elnr] = json_to_double(it.value());
+        }
+    }
+
+    const QJsonObject masses = atoms["masses"].toObject();
+    for(auto it = masses.begin(); it != masses.end(); ++it) {
+        const unsigned int elnr = this->find_elnr(it.key().toStdString());
+        if(elnr < MAX_ELEMENTS) {
+            this->masses[elnr] = json_to_double(it.value());
+        }
+    }
+
+    const QJsonObject bonds = root["bonds"].toObject();
+    for(auto it = bonds.begin(); it != bonds.end(); ++it) {
+        const QStringList pair = it.key().split('-');
+        const unsigned int elnr1 = pair.size() == 2 ? this->find_elnr(pair[0].trimmed().toStdString()) : MAX_ELEMENTS;
+        const unsigned int elnr2 = pair.size() == 2 ? this->find_elnr(pair[1].trimmed().toStdString()) : MAX_ELEMENTS;
+        if(elnr1 >= MAX_ELEMENTS || elnr2 >= MAX_ELEMENTS) {
+            qWarning() << "Ignoring bond cutoff for unknown element pair" << it.key();
+            continue;
+        }
+
+        this->bond_distances[elnr1 * MAX_ELEMENTS + elnr2] = json_to_double(it.value());
+        this->bond_distances[elnr2 * MAX_ELEMENTS + elnr1] = json_to_double(it.value());
     }
+    this->max_bond_distance = *std::max_element(this->bond_distances.begin(), this->bond_distances.end());
 }
 
     /**
-     * @brief      Load the JSON file and parse its contents
+     * @brief      Set the bond cutoffs for all pairs of elements
      */
-void AtomSettings::load() {
-    // try to locate atoms.json
-    QFile f(":/assets/configuration/atoms.json");
-    if (!f.exists()) {
-        qWarning() << "Cannot open atoms.json";
-        exit(-1);
+void AtomSettings::set_bond_distances() {
+    // set all bonds by default to 3.0
+    this->bond_distances.assign(MAX_ELEMENTS * MAX_ELEMENTS, 3.0);
+    auto set = [this](unsigned int i, unsigned int j, double distance) {
+        this->bond_distances[i * MAX_ELEMENTS + j] = distance;
+        this->bond_distances[j * MAX_ELEMENTS + i] = distance;
+    };
+
+    // loop over all atoms
+    for(unsigned int i=0; i<MAX_ELEMENTS; i++) {
+        if(i > 20) {
+            for(unsigned int j=2; j<=20; j++) {
+                set(i, 1, 2.0);     // bonds for hydrogen
+                set(i, j, 2.5);     // other atoms
+            }
+        } else {
+            for(unsigned int j=2; j<=20; j++) {
+                set(i, 1, 1.2);     // bonds for hydrogen
+                set(i, j, 2.0);     // other atoms
+            }
+        }
     }
 
-    // open the file and read the data
-    f.open(QIODevice::ReadOnly);
-    QString jsondata = f.readAll();
-    f.close();
+    // add some special cases on the basis of user input
+    set(6, 13, 3.5); // Al-C
 
-    // try to parse the file
-    QJsonParseError parseError;
-    this->root = QJsonDocument::fromJson(jsondata.toUtf8(), &parseError);
-    if(parseError.error != QJsonParseError::NoError){
-        qWarning() << "Parse error at " << parseError.offset << ":" << parseError.errorString();
-        exit(-1);
-    }
+    // largest cutoff sets the cell size for neighbour searches
+    this->max_bond_distance = *std::max_element(this->bond_distances.begin(), this->bond_distances.end());
 }
 
     /**
-     * @brief      Get the default color for an atom
+     * @brief      Get the atomic number of an element, if known
      *
      * @param[in]  elname  Element name
      *
-     * @return     Color of the atom
+     * @return     The atomic number or MAX_ELEMENTS if the element is unknown
      */
-glm::vec3 AtomSettings::get_atom_color(const std::string& elname){
-    QString hexColor = this->root["atoms"]["colors"][QString(elname.c_str())].toString();
-    QColor *getColor = new QColor(hexColor);
-    return glm::vec3((float)getColor->red()/255, (float)getColor->green()/255, (float)getColor->blue()/255);
+unsigned int AtomSettings::find_elnr(const std::string& elname) const {
+    auto got = this->elnr_lookup.find(elname);
+    return got != this->elnr_lookup.end() ? got->second : MAX_ELEMENTS;
 }
 
     /**
@@ -115,21 +211,21 @@ glm::vec3 AtomSettings::get_atom_color(const std::string& elname){
      *
      * @return     Color of the atom
      */
-QVector3D AtomSettings::get_atom_color_qvector(const std::string& elname){
-    QString hexColor = this->root["atoms"]["colors"][QString(elname.c_str())].toString();
-    QColor *getColor = new QColor(hexColor);
-    return QVector3D((float)getColor->red()/255, (float)getColor->green()/255, (float)getColor->blue()/255);
+glm::vec3 AtomSettings::get_atom_color(const std::string& elname) const {
+    const QVector3D& color = this->get_atom_color_qvector(elname);
+    return glm::vec3(color[0], color[1], color[2]);
 }
 
     /**
-     * @brief      Get the atomic radius of an element
+     * @brief      Get the default color for an atom
      *
      * @param[in]  elname  Element name
      *
-     * @return     atomic radius
+     * @return     Color of the atom
      */
-float AtomSettings::get_atom_radius(const std::string& elname){
-    return this->root["atoms"]["radii"][QString(elname.c_str())].toString().toDouble();
+QVector3D AtomSettings::get_atom_color_qvector(const std::string& elname) const {
+    const unsigned int elnr = this->find_elnr(elname);
+    return elnr < MAX_ELEMENTS ? this->colors[elnr] : QVector3D(0.0f, 0.0f, 0.0f);
 }
 
     /**
@@ -139,8 +235,8 @@ float AtomSettings::get_atom_radius(const std::string& elname){
      *
      * @return     atomic radius
      */
-float AtomSettings::get_atom_radius_from_elnr(unsigned int elnr) {
-    return this->radii[elnr];
+float AtomSettings::get_atom_radius(const std::string& elname) const {
+    return this->get_atom_radius_from_elnr(this->find_elnr(elname));
 }
 
     /**
@@ -148,10 +244,11 @@ float AtomSettings::get_atom_radius_from_elnr(unsigned int elnr) {
      *
      * @param[in]  elname  Element name
      *
-     * @return     The atom elnr.
+     * @return     The atom elnr (zero if the element is unknown).
      */
-unsigned int AtomSettings::get_atom_elnr(const std::string& elname){
-    return this->root["atoms"]["elnr"][QString(elname.c_str())].toString().toUInt();
+unsigned int AtomSettings::get_atom_elnr(const std::string& elname) const {
+    const unsigned int elnr = this->find_elnr(elname);
+    return elnr < MAX_ELEMENTS ? elnr : 0;
 }
 
     /**
@@ -161,40 +258,6 @@ unsigned int AtomSettings::get_atom_elnr(const std::string& elname){
      *
      * @return     Atomic mass in amu
      */
-double AtomSettings::get_atom_mass(const std::string& elname){
-    return this->root["atoms"]["masses"][QString(elname.c_str())].toString().toDouble();
-}
-
-    /**
-     * @brief      Get atomic mass from element number (amu)
-     *
-     * @param[in]  elnr  Element number
-     *
-     * @return     Atomic mass in amu
-     */
-double AtomSettings::get_atom_mass_from_elnr(unsigned int elnr) {
-    return this->masses[elnr];
-}
-
-    /**
-     * @brief      Get the maximum bond distance between two atoms
-     *
-     * @param[in]  atoma  The atoma
-     * @param[in]  atomb  The atomb
-     *
-     * @return     The bond distance.
-     */
-double AtomSettings::get_bond_distance(int atoma, int atomb) {
-    return this->bond_distances[atoma][atomb];
-}
-
-    /**
-     * @brief      Gets the name from element number.
-     *
-     * @param[in]  elnr  The elnr
-     *
-     * @return     The name from elnr.
-     */
-std::string AtomSettings::get_name_from_elnr(unsigned int elnr) {
-    return this->root["atoms"]["nr2element"][QString::number(elnr)].toString().toStdString();
+double AtomSettings::get_atom_mass(const std::string& elname) const {
+    return this->get_atom_mass_from_elnr(this->find_elnr(elname));
 }
@@ -41,16 +41,25 @@
 
 /**
  * @brief      Class holding information about atoms in the periodic table
+ *
+ * The element data is compiled into the program (generated from atoms.json)
+ * and copied into flat tables indexed by atomic number upon construction,
+ * after which an optional atoms.json in the user configuration folder can
+ * override colors, radii, masses and bond cutoffs. All getters only read
+ * these tables, such that they can be used concurrently from multiple threads.
  */
 class AtomSettings {
-private:
-    std::string settings_file;
-    QJsonDocument root;
-    QFile qf;
+public:
+    static constexpr unsigned int MAX_ELEMENTS = 121;   // size of the per-element tables
 
-    std::vector<std::vector<double>> bond_distances;
-    std::vector<float> radii;
-    std::vector<double> masses;
+private:
+    std::vector<std::string> names;         // element symbols
+    std::vector<QVector3D> colors;          // default colors
+    std::vector<float> radii;               // atomic radii
+    std::vector<double> masses;             // atomic masses (amu)
+    std::vector<double> bond_distances;     // bond cutoffs (MAX_ELEMENTS x MAX_ELEMENTS)
+    double max_bond_distance = 0.0;         // largest bond cutoff
+    std::unordered_map<std::string, unsigned int> elnr_lookup;  // element symbol to atomic number
 
 public:
 
@@ -73,7 +82,7 @@ public:
      *
      * @return     Color of the atom
      */
-    glm::vec3 get_atom_color(const std::string& elname);
+    glm::vec3 get_atom_color(const std::string& elname) const;
 
     /**
      * @brief      Get the default color for an atom
@@ -82,7 +91,18 @@ public:
      *
      * @return     Color of the atom
      */
-    QVector3D get_atom_color_qvector(const std::string& elname);
+    QVector3D get_atom_color_qvector(const std::string& elname) const;
+
+    /**
+     * @brief      Get the default color for an atom
+     *
+     * @param[in]  elnr  Element number
+     *
+     * @return     Color of the atom
+     */
+    inline const QVector3D& get_atom_color_from_elnr(unsigned int elnr) const {
+        return this->colors[elnr < MAX_ELEMENTS ? elnr : 0];
+    }
 
     /**
      * @brief      Get the atomic radius of an element
@@ -91,7 +111,7 @@ public:
      *
      * @return     atomic radius
      */
-    float get_atom_radius(const std::string& elname);
+    float get_atom_radius(const std::string& elname) const;
 
     /**
      * @brief      Get the atomic radius of an element
@@ -100,16 +120,18 @@ public:
      *
      * @return     atomic radius
      */
-    float get_atom_radius_from_elnr(unsigned int elnr);
+    inline float get_atom_radius_from_elnr(unsigned int elnr) const {
+        return elnr < MAX_ELEMENTS ? this->radii[elnr] : 0.0f;
+    }
 
     /**
      * @brief      Get element number of an element
      *
      * @param[in]  elname  Element name
      *
-     * @return     The atom elnr.
+     * @return     The atom elnr (zero if the element is unknown).
      */
-    unsigned int get_atom_elnr(const std::string& elname);
+    unsigned int get_atom_elnr(const std::string& elname) const;
 
     /**
      * @brief      Get atomic mass of an element (amu)
@@ -118,7 +140,7 @@ public:
      *
      * @return     Atomic mass in amu
      */
-    double get_atom_mass(const std::string& elname);
+    double get_atom_mass(const std::string& elname) const;
 
     /**
      * @brief      Get atomic mass from element number (amu)
@@ -127,7 +149,9 @@ public:
      *
      * @return     Atomic mass in amu
      */
-    double get_atom_mass_from_elnr(unsigned int elnr);
+    inline double get_atom_mass_from_elnr(unsigned int elnr) const {
+        return elnr < MAX_ELEMENTS ? this->masses[elnr] : 0.0;
+    }
 
     /**
      * @brief      Get the maximum bond distance between two atoms
@@ -137,16 +161,30 @@ public:
      *
      * @return     The bond distance.
      */
-    double get_bond_distance(int atoma, int atomb);
+    inline double get_bond_distance(unsigned int atoma, unsigned int atomb) const {
+        return this->bond_distances[atoma * MAX_ELEMENTS + atomb];
+    }
+
+    /**
+     * @brief      Get the largest bond distance over all element pairs
+     *
+     * @return     The maximum bond distance.
+     */
+    inline double get_max_bond_distance() const {
+        return this->max_bond_distance;
+    }
 
     /**
      * @brief      Gets the name from element number.
      *
      * @param[in]  elnr  The elnr
      *
-     * @return     The name from elnr.
+     * @return     The name from elnr (empty if the element is unknown).
      */
-    std::string get_name_from_elnr(unsigned int elnr);
+    inline const std::string& get_name_from_elnr(unsigned int elnr) const {
+        static const std::string unknown;
+        return elnr < MAX_ELEMENTS ? this->names[elnr] : unknown;
+    }
 
 private:
     /**
@@ -155,10 +193,31 @@ private:
     AtomSettings();
 
     /**
-     * @brief      Load the JSON file and parse its contents
+     * @brief      Fill the element tables from the embedded periodic table
      */
     void load();
 
+    /**
+     * @brief      Apply user-defined element properties
+     *
+     * @param[in]  filename  Path to the override file
+     */
+    void load_overrides(const QString& filename);
+
+    /**
+     * @brief      Set the bond cutoffs for all pairs of elements
+     */
+    void set_bond_distances();
+
+    /**
+     * @brief      Get the atomic number of an element, if known
+     *
+     * @param[in]  elname  Element name
+     *
+     * @return     The atomic number or MAX_ELEMENTS if the element is unknown
+     */
+    unsigned int find_elnr(const std::string& elname) const;
+
     // delete copy constructor
     /**
      * @brief AtomSettings.
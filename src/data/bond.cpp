@@ -20,38 +20,53 @@
 
 #include "bond.h"
 
+#include <cmath>
+
 /**
- * @brief Bond.
+ * @brief      Constructs a new instance.
  *
- * @param _atom1 Parameter _atom1.
- * @param _atom2 Parameter _atom2.
- * @param _atom1_idx Parameter _atom1_idx.
- * @param param Parameter param.
- * @param param Parameter param.
- * @param param Parameter param.
- * @param param Parameter param.
+ * @param[in]  _atom1_idx  Index of the first atom
+ * @param[in]  _atom2_idx  Index of the second atom
+ * @param[in]  _image      Lattice image of atom2 with respect to atom1
  */
-Bond::Bond(const Atom& _atom1, const Atom& _atom2, unsigned int _atom1_idx, unsigned int _atom2_idx) :
-atom1(_atom1),
-atom2(_atom2),
+Bond::Bond(unsigned int _atom1_idx, unsigned int _atom2_idx, const std::array<int, 3>& _image) :
 atom1_idx(_atom1_idx),
-atom2_idx(_atom2_idx) {
-    auto v = this->atom2.get_pos_qtvec() - this->atom1.get_pos_qtvec();
+atom2_idx(_atom2_idx),
+image(_image) {
+
+}
 
-    this->direction = v.normalized();
-    this->length = v.length();
+    /**
+     * @brief      Calculate the geometry of a bond between two positions
+     *
+     * @param[in]  start        Position of the first atom
+     * @param[in]  end          Position of the second atom
+     * @param[in]  translation  Translation towards the bonded image of the second atom
+     *
+     * @return     The bond geometry.
+     */
+BondGeometry Bond::calculate_geometry(const QVector3D& start, const QVector3D& end, const QVector3D& translation) {
+    BondGeometry geometry;
+    geometry.start = start;
+    geometry.end = end;
+
+    auto v = end + translation - start;
+    geometry.direction = v.normalized();
+    geometry.length = v.length();
 
     // avoid gimball locking
-    if (fabs(this->direction[2]) > .999) {
-        if(this->direction[2] < 0.0) {
-            this->axis = QVector3D(0.0, 1.0, 0.0);
-            this->angle = -M_PI;
+    if (fabs(geometry.direction[2]) > .999) {
+        if(geometry.direction[2] < 0.0) {
+            geometry.axis = QVector3D(0.0, 1.0, 0.0);
+            geometry.angle = -M_PI;
         } else {
-            this->axis = QVector3D(0.0, 0.0, 1.0);
-            this->angle = 0.0;
+            geometry.axis = QVector3D(0.0, 0.0, 1.0);
+            geometry.angle = 0.0;
         }
     } else {
-        this->axis = QVector3D::crossProduct(QVector3D(0.0, 0.0, 1.0), this->direction);
-        this->angle = std::acos(this->direction[2]);
+        geometry.axis = QVector3D::crossProduct(QVector3D(0.0, 0.0, 1.0), geometry.direction);
+        geometry.angle = std::acos(geometry.direction[2]);
     }
+
+    return geometry;
 }
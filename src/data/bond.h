@@ -20,36 +20,63 @@
 
 #pragma once
 
-#include "atom.h"
+#include <array>
+
+#include <QVector3D>
+
+/**
+ * @brief      Orientation of a bond as used for rendering
+ */
+struct BondGeometry {
+    QVector3D start;        // position of atom1
+    QVector3D end;          // position of atom2 (not of its periodic image)
+    QVector3D direction;    // unit vector from atom1 towards (the image of) atom2
+    QVector3D axis;         // rotation axis mapping the z-axis onto direction
+    double angle = 0.0;     // rotation angle (radians)
+    double length = 0.0;    // length of the bond
+};
 
 /**
  * @brief Bond class.
+ *
+ * A bond only stores the indices of the atoms it connects; its geometry is
+ * derived from the current atom positions when needed.
  */
 class Bond {
 public:
-    // atom 1
-    Atom atom1;
-    Atom atom2;
     unsigned int atom1_idx;
     unsigned int atom2_idx;
 
-    // length of the bond
-    double length;
+    // lattice translation of atom2 (bonds across the unit cell boundary)
+    std::array<int, 3> image = {0, 0, 0};
 
-    // bond orientation
-    QVector3D direction;
-    QVector3D axis;
-    double angle;
+    /**
+     * @brief      Constructs a new instance.
+     *
+     * @param[in]  _atom1_idx  Index of the first atom
+     * @param[in]  _atom2_idx  Index of the second atom
+     * @param[in]  _image      Lattice image of atom2 with respect to atom1
+     */
+    Bond(unsigned int _atom1_idx, unsigned int _atom2_idx, const std::array<int, 3>& _image = {0, 0, 0});
 
-/**
- * @brief Bond.
- *
- * @param _atom1 Parameter _atom1.
- * @param _atom2 Parameter _atom2.
- * @param _atom1_idx Parameter _atom1_idx.
- * @param _atom2_idx Parameter _atom2_idx.
- */
-    Bond(const Atom& _atom1, const Atom& _atom2, unsigned int _atom1_idx, unsigned int _atom2_idx);
+    /**
+     * @brief      Whether this bond crosses the unit cell boundary
+     *
+     * @return     True if atom2 is a periodic image
+     */
+    inline bool is_periodic() const {
+        return this->image[0] != 0 || this->image[1] != 0 || this->image[2] != 0;
+    }
 
-private:
+    /**
+     * @brief      Calculate the geometry of a bond between two positions
+     *
+     * @param[in]  start        Position of the first atom
+     * @param[in]  end          Position of the second atom
+     * @param[in]  translation  Translation towards the bonded image of the second atom
+     *
+     * @return     The bond geometry.
+     */
+    static BondGeometry calculate_geometry(const QVector3D& start, const QVector3D& end,
+                                           const QVector3D& translation = QVector3D(0.0, 0.0, 0.0));
 };
@@ -0,0 +1,76 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "bond_graph.h"
+
+/**
+ * @brief      Constructs a new instance.
+ */
+BondGraph::BondGraph() {
+
+}
+
+    /**
+     * @brief      Build the adjacency from a list of bonds
+     *
+     * @param[in]  nr_atoms  Number of atoms
+     * @param[in]  bonds     The bonds
+     */
+void BondGraph::build(size_t nr_atoms, const std::vector<Bond>& bonds) {
+    // count the degree of every atom; a bond of an atom with its own
+    // periodic image is listed once
+    this->offsets.assign(nr_atoms + 1, 0);
+    for(const auto& bond : bonds) {
+        this->offsets[bond.atom1_idx + 1]++;
+        if(bond.atom2_idx != bond.atom1_idx) {
+            this->offsets[bond.atom2_idx + 1]++;
+        }
+    }
+
+    for(size_t i=0; i<nr_atoms; i++) {
+        this->offsets[i+1] += this->offsets[i];
+    }
+
+    this->neighbours.resize(this->offsets.back());
+    this->bond_indices.resize(this->offsets.back());
+    std::vector<unsigned int> fill(this->offsets.begin(), this->offsets.end() - 1);
+    for(unsigned int i=0; i<bonds.size(); i++) {
+        const auto& bond = bonds[i];
+
+        unsigned int k = fill[bond.atom1_idx]++;
+        this->neighbours[k] = bond.atom2_idx;
+        this->bond_indices[k] = i;
+
+        if(bond.atom2_idx != bond.atom1_idx) {
+            k = fill[bond.atom2_idx]++;
+            this->neighbours[k] = bond.atom1_idx;
+            this->bond_indices[k] = i;
+        }
+    }
+}
+
+    /**
+     * @brief      Remove all entries
+     */
+void BondGraph::clear() {
+    this->offsets.clear();
+    this->neighbours.clear();
+    this->bond_indices.clear();
+}
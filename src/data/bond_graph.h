@@ -0,0 +1,148 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "bond.h"
+
+/**
+ * @brief      Neighbour adjacency of the bond graph in compressed sparse
+ *             row (CSR) format
+ *
+ * For every atom, the indices of the bonded atoms and of the corresponding
+ * bonds are stored contiguously, such that the neighbours of an atom can be
+ * visited in O(degree).
+ */
+class BondGraph {
+public:
+    /**
+     * @brief      Contiguous range of indices
+     */
+    class Range {
+    private:
+        const unsigned int* first;
+        const unsigned int* last;
+
+    public:
+        Range(const unsigned int* _first, const unsigned int* _last) :
+        first(_first),
+        last(_last) {}
+
+        inline const unsigned int* begin() const {
+            return this->first;
+        }
+
+        inline const unsigned int* end() const {
+            return this->last;
+        }
+
+        inline size_t size() const {
+            return this->last - this->first;
+        }
+
+        inline bool empty() const {
+            return this->first == this->last;
+        }
+
+        inline unsigned int operator[](size_t i) const {
+            return this->first[i];
+        }
+    };
+
+private:
+    std::vector<unsigned int> offsets;      // offsets into neighbours per atom (size: nr atoms + 1)
+    std::vector<unsigned int> neighbours;   // indices of bonded atoms
+    std::vector<unsigned int> bond_indices; // indices of the bonds (parallel to neighbours)
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    BondGraph();
+
+    /**
+     * @brief      Build the adjacency from a list of bonds
+     *
+     * @param[in]  nr_atoms  Number of atoms
+     * @param[in]  bonds     The bonds
+     */
+    void build(size_t nr_atoms, const std::vector<Bond>& bonds);
+
+    /**
+     * @brief      Remove all entries
+     */
+    void clear();
+
+    /**
+     * @brief      Gets the number of atoms in the graph.
+     *
+     * @return     The number of atoms.
+     */
+    inline size_t get_nr_atoms() const {
+        return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+    }
+
+    /**
+     * @brief      Gets the memory used by the adjacency.
+     *
+     * @return     The memory usage in bytes.
+     */
+    inline size_t get_memory_usage() const {
+        return sizeof(BondGraph) +
+               (this->offsets.capacity() + this->neighbours.capacity() + this->bond_indices.capacity()) * sizeof(unsigned int);
+    }
+
+    /**
+     * @brief      Gets the number of bonds of an atom
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The degree.
+     */
+    inline size_t get_degree(unsigned int idx) const {
+        return this->offsets[idx+1] - this->offsets[idx];
+    }
+
+    /**
+     * @brief      Gets the atoms bonded to an atom
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The neighbouring atom indices.
+     */
+    inline Range get_neighbours(unsigned int idx) const {
+        return Range(this->neighbours.data() + this->offsets[idx],
+                     this->neighbours.data() + this->offsets[idx+1]);
+    }
+
+    /**
+     * @brief      Gets the bonds of an atom
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The bond indices, in the same order as get_neighbours().
+     */
+    inline Range get_bonds(unsigned int idx) const {
+        return Range(this->bond_indices.data() + this->offsets[idx],
+                     this->bond_indices.data() + this->offsets[idx+1]);
+    }
+};
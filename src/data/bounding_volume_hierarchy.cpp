@@ -0,0 +1,239 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "bounding_volume_hierarchy.h"
+
+#include <limits>
+#include <numeric>
+
+/**
+ * @brief      Constructs a new instance.
+ */
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() {
+
+}
+
+    /**
+     * @brief      Update the hierarchy for a new set of boxes
+     *
+     * The hierarchy is refitted if the number of boxes is unchanged and
+     * rebuilt otherwise, or when refitting degraded its quality.
+     *
+     * @param[in]  _boxes  The boxes
+     */
+void BoundingVolumeHierarchy::update(const std::vector<Box>& _boxes) {
+    if(_boxes.size() != this->boxes.size() || this->nodes.empty()) {
+        this->build(_boxes);
+        return;
+    }
+
+    this->refit(_boxes);
+
+    // boxes that moved apart make the nodes grow and overlap, rebuild once
+    // the nodes have become considerably larger than after building
+    if(this->get_total_area() > 2.0f * this->build_area) {
+        this->build(_boxes);
+    }
+}
+
+    /**
+     * @brief      Build the hierarchy from scratch
+     *
+     * @param[in]  _boxes  The boxes
+     */
+void BoundingVolumeHierarchy::build(const std::vector<Box>& _boxes) {
+    this->clear();
+
+    if(_boxes.empty()) {
+        return;
+    }
+
+    this->boxes = _boxes;
+    this->items.resize(this->boxes.size());
+    std::iota(this->items.begin(), this->items.end(), 0);
+
+    this->nodes.reserve(4 * (this->boxes.size() / LEAF_SIZE + 1));
+    this->nodes.push_back({this->get_bounds(0, this->items.size()), 0, (unsigned int)this->items.size(), 0});
+    this->split(0);
+
+    this->build_area = this->get_total_area();
+}
+
+    /**
+     * @brief      Remove all boxes
+     */
+void BoundingVolumeHierarchy::clear() {
+    this->nodes.clear();
+    this->items.clear();
+    this->boxes.clear();
+    this->build_area = 0.0f;
+}
+
+    /**
+     * @brief      Extract the frustum planes of a projection matrix
+     *
+     * The planes follow from adding the fourth row of the matrix to, or
+     * subtracting it from, the other rows (Gribb and Hartmann).
+     *
+     * @param[in]  mvp   Model, view and projection matrix
+     *
+     * @return     The frustum.
+     */
+BoundingVolumeHierarchy::Frustum BoundingVolumeHierarchy::get_frustum(const QMatrix4x4& mvp) {
+    const QVector4D w = mvp.row(3);
+
+    Frustum frustum;
+    for(unsigned int i=0; i<3; i++) {
+        const QVector4D r = mvp.row(i);
+        const QVector4D lower = w + r;
+        const QVector4D upper = w - r;
+        frustum[2*i]   = {lower.x(), lower.y(), lower.z(), lower.w()};
+        frustum[2*i+1] = {upper.x(), upper.y(), upper.z(), upper.w()};
+    }
+
+    return frustum;
+}
+
+    /**
+     * @brief      Refit the nodes to the boxes without changing the hierarchy
+     *
+     * Children are always stored after their parent, hence visiting the
+     * nodes back to front updates the children before their parents.
+     *
+     * @param[in]  _boxes  The boxes
+     */
+void BoundingVolumeHierarchy::refit(const std::vector<Box>& _boxes) {
+    this->boxes = _boxes;
+
+    for(size_t i=this->nodes.size(); i-- > 0;) {
+        Node& node = this->nodes[i];
+        if(node.left == 0) {
+            node.box = this->get_bounds(node.first, node.count);
+            continue;
+        }
+
+        const Box& left = this->nodes[node.left].box;
+        const Box& right = this->nodes[node.left + 1].box;
+        for(unsigned int j=0; j<3; j++) {
+            node.box.lo[j] = std::min(left.lo[j], right.lo[j]);
+            node.box.hi[j] = std::max(left.hi[j], right.hi[j]);
+        }
+    }
+}
+
+    /**
+     * @brief      Recursively split a node
+     *
+     * The items are divided in two halves at the median of their centers
+     * along the axis in which the centers are spread the most.
+     *
+     * @param[in]  idx   Node index
+     */
+void BoundingVolumeHierarchy::split(unsigned int idx) {
+    const unsigned int first = this->nodes[idx].first;
+    const unsigned int count = this->nodes[idx].count;
+    if(count <= LEAF_SIZE) {
+        return;
+    }
+
+    // twice the center of a box, which suffices for comparisons
+    auto get_center = [this](unsigned int item, unsigned int axis) {
+        return this->boxes[item].lo[axis] + this->boxes[item].hi[axis];
+    };
+
+    std::array<float, 3> lo = {std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max()};
+    std::array<float, 3> hi = {std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest()};
+    for(unsigned int i=first; i<first+count; i++) {
+        for(unsigned int j=0; j<3; j++) {
+            lo[j] = std::min(lo[j], get_center(this->items[i], j));
+            hi[j] = std::max(hi[j], get_center(this->items[i], j));
+        }
+    }
+
+    unsigned int axis = 0;
+    for(unsigned int j=1; j<3; j++) {
+        if(hi[j] - lo[j] > hi[axis] - lo[axis]) {
+            axis = j;
+        }
+    }
+
+    const unsigned int half = count / 2;
+    auto begin = this->items.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [&](unsigned int a, unsigned int b) {
+        return get_center(a, axis) < get_center(b, axis);
+    });
+
+    const unsigned int left = this->nodes.size();
+    this->nodes.push_back({this->get_bounds(first, half), first, half, 0});
+    this->nodes.push_back({this->get_bounds(first + half, count - half), first + half, count - half, 0});
+    this->nodes[idx].left = left;
+
+    this->split(left);
+    this->split(left + 1);
+}
+
+    /**
+     * @brief      Get the bounds of a range of the sorted items
+     *
+     * @param[in]  first  First item
+     * @param[in]  count  Number of items
+     *
+     * @return     The bounds.
+     */
+BoundingVolumeHierarchy::Box BoundingVolumeHierarchy::get_bounds(unsigned int first, unsigned int count) const {
+    Box bounds;
+    bounds.lo = {std::numeric_limits<float>::max(),
+                 std::numeric_limits<float>::max(),
+                 std::numeric_limits<float>::max()};
+    bounds.hi = {std::numeric_limits<float>::lowest(),
+                 std::numeric_limits<float>::lowest(),
+                 std::numeric_limits<float>::lowest()};
+
+    for(unsigned int i=first; i<first+count; i++) {
+        const Box& box = this->boxes[this->items[i]];
+        for(unsigned int j=0; j<3; j++) {
+            bounds.lo[j] = std::min(bounds.lo[j], box.lo[j]);
+            bounds.hi[j] = std::max(bounds.hi[j], box.hi[j]);
+        }
+    }
+
+    return bounds;
+}
+
+    /**
+     * @brief      Summed surface area of all nodes
+     *
+     * @return     The area.
+     */
+float BoundingVolumeHierarchy::get_total_area() const {
+    float area = 0.0f;
+    for(const Node& node : this->nodes) {
+        const float dx = node.box.hi[0] - node.box.lo[0];
+        const float dy = node.box.hi[1] - node.box.lo[1];
+        const float dz = node.box.hi[2] - node.box.lo[2];
+        area += 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    return area;
+}
@@ -0,0 +1,246 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QMatrix4x4>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief      Bounding volume hierarchy over axis-aligned boxes
+ *
+ * The boxes are split at the median of their centers along the longest
+ * axis of the node, such that every node covers a contiguous range of the
+ * sorted items. When the boxes move, the hierarchy is refitted rather than
+ * rebuilt until the refitted nodes have grown too much.
+ */
+class BoundingVolumeHierarchy {
+public:
+    /**
+     * @brief      Axis-aligned box
+     */
+    struct Box {
+        std::array<float, 3> lo;    // lower corner
+        std::array<float, 3> hi;    // upper corner
+    };
+
+    // planes (normal and offset) of a view frustum; a point p lies inside
+    // when dot(normal, p) + offset >= 0 holds for all planes
+    typedef std::array<std::array<float, 4>, 6> Frustum;
+
+private:
+    static constexpr unsigned int LEAF_SIZE = 8;    // maximum number of items in a leaf
+
+    /**
+     * @brief      Node of the hierarchy
+     */
+    struct Node {
+        Box box;                    // bounds of all items in the node
+        unsigned int first;         // first item in the sorted items
+        unsigned int count;         // number of items
+        unsigned int left;          // index of the left child (right child follows), zero for leaves
+    };
+
+    std::vector<Node> nodes;            // nodes, the root first and children after their parent
+    std::vector<unsigned int> items;    // item indices sorted by node
+    std::vector<Box> boxes;             // box per item
+    float build_area = 0.0f;            // summed surface area of the nodes after building
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    BoundingVolumeHierarchy();
+
+    /**
+     * @brief      Update the hierarchy for a new set of boxes
+     *
+     * The hierarchy is refitted if the number of boxes is unchanged and
+     * rebuilt otherwise, or when refitting degraded its quality.
+     *
+     * @param[in]  _boxes  The boxes
+     */
+    void update(const std::vector<Box>& _boxes);
+
+    /**
+     * @brief      Build the hierarchy from scratch
+     *
+     * @param[in]  _boxes  The boxes
+     */
+    void build(const std::vector<Box>& _boxes);
+
+    /**
+     * @brief      Remove all boxes
+     */
+    void clear();
+
+    /**
+     * @brief      Gets the number of items.
+     *
+     * @return     The number of items.
+     */
+    inline size_t get_nr_items() const {
+        return this->boxes.size();
+    }
+
+    /**
+     * @brief      Gets the memory used by the hierarchy.
+     *
+     * @return     The memory usage in bytes.
+     */
+    inline size_t get_memory_usage() const {
+        return this->nodes.capacity() * sizeof(Node) + this->items.capacity() * sizeof(unsigned int) +
+               this->boxes.capacity() * sizeof(Box);
+    }
+
+    /**
+     * @brief      Extract the frustum planes of a projection matrix
+     *
+     * To test boxes translated over a vector, pass the matrix multiplied
+     * by that translation.
+     *
+     * @param[in]  mvp   Model, view and projection matrix
+     *
+     * @return     The frustum.
+     */
+    static Frustum get_frustum(const QMatrix4x4& mvp);
+
+    /**
+     * @brief      Loop over all items whose box intersects a frustum
+     *
+     * Subtrees entirely inside the frustum are visited without further
+     * tests; boxes straddling a plane are conservatively reported.
+     *
+     * @param[in]  frustum  The frustum
+     * @param[in]  func     Callback receiving the item index
+     */
+    template<typename Func>
+    void cull(const Frustum& frustum, Func&& func) const {
+        if(this->nodes.empty()) {
+            return;
+        }
+
+        // stack of nodes with the planes these still straddle
+        std::array<std::pair<unsigned int, uint8_t>, 64> stack;
+        unsigned int depth = 0;
+        stack[depth++] = {0, 0x3F};
+
+        while(depth > 0) {
+            const auto entry = stack[--depth];
+            const Node& node = this->nodes[entry.first];
+
+            uint8_t mask = entry.second;
+            if(!this->test(node.box, frustum, mask)) {
+                continue;
+            }
+
+            if(mask == 0) {
+                for(unsigned int i=node.first; i<node.first+node.count; i++) {
+                    func(this->items[i]);
+                }
+            } else if(node.left == 0) {
+                for(unsigned int i=node.first; i<node.first+node.count; i++) {
+                    uint8_t item_mask = mask;
+                    if(this->test(this->boxes[this->items[i]], frustum, item_mask)) {
+                        func(this->items[i]);
+                    }
+                }
+            } else {
+                stack[depth++] = {node.left + 1, mask};
+                stack[depth++] = {node.left, mask};
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief      Refit the nodes to the boxes without changing the hierarchy
+     *
+     * @param[in]  _boxes  The boxes
+     */
+    void refit(const std::vector<Box>& _boxes);
+
+    /**
+     * @brief      Recursively split a node
+     *
+     * @param[in]  idx   Node index
+     */
+    void split(unsigned int idx);
+
+    /**
+     * @brief      Get the bounds of a range of the sorted items
+     *
+     * @param[in]  first  First item
+     * @param[in]  count  Number of items
+     *
+     * @return     The bounds.
+     */
+    Box get_bounds(unsigned int first, unsigned int count) const;
+
+    /**
+     * @brief      Summed surface area of all nodes
+     *
+     * @return     The area.
+     */
+    float get_total_area() const;
+
+    /**
+     * @brief      Test a box against the frustum planes in a mask
+     *
+     * @param[in]  box      The box
+     * @param[in]  frustum  The frustum
+     * @param      mask     Planes to test; planes the box lies entirely
+     *                      inside of are removed from the mask
+     *
+     * @return     False if the box is entirely outside the frustum
+     */
+    static inline bool test(const Box& box, const Frustum& frustum, uint8_t& mask) {
+        for(unsigned int i=0; i<6; i++) {
+            if(!(mask & (1 << i))) {
+                continue;
+            }
+
+            // corners furthest along and against the plane normal
+            const auto& plane = frustum[i];
+            float dmax = plane[3];
+            float dmin = plane[3];
+            for(unsigned int j=0; j<3; j++) {
+                const float lo = plane[j] * box.lo[j];
+                const float hi = plane[j] * box.hi[j];
+                dmax += std::max(lo, hi);
+                dmin += std::min(lo, hi);
+            }
+
+            if(dmax < 0.0f) {
+                return false;
+            }
+            if(dmin >= 0.0f) {
+                mask &= ~(1 << i);
+            }
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,132 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "cell_list.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief      Constructs a new instance.
+ */
+CellList::CellList() {
+
+}
+
+    /**
+     * @brief      Sort atoms into the grid
+     *
+     * @param[in]  atoms   The atoms
+     * @param[in]  radius  Search radius (minimum edge length of a cell)
+     */
+void CellList::build(const std::vector<Atom>& atoms, double radius) {
+    this->clear();
+
+    if(atoms.empty()) {
+        return;
+    }
+
+    this->cellsize = std::max(radius, 1e-3);
+
+    // establish bounding box
+    std::array<double, 3> minc = {std::numeric_limits<double>::max(),
+                                  std::numeric_limits<double>::max(),
+                                  std::numeric_limits<double>::max()};
+    std::array<double, 3> maxc = {std::numeric_limits<double>::lowest(),
+                                  std::numeric_limits<double>::lowest(),
+                                  std::numeric_limits<double>::lowest()};
+    for(const auto& atom : atoms) {
+        minc[0] = std::min(minc[0], atom.x);
+        minc[1] = std::min(minc[1], atom.y);
+        minc[2] = std::min(minc[2], atom.z);
+        maxc[0] = std::max(maxc[0], atom.x);
+        maxc[1] = std::max(maxc[1], atom.y);
+        maxc[2] = std::max(maxc[2], atom.z);
+    }
+    this->origin = minc;
+
+    // sparse systems (e.g. a few molecules in a large vacuum) would produce
+    // a huge number of empty cells; grow the cells until the grid has at
+    // most a few cells per atom
+    const size_t maxcells = std::max<size_t>(64, 4 * atoms.size());
+    for(;;) {
+        size_t nrtotal = 1;
+        for(unsigned int i=0; i<3; i++) {
+            this->nrcells[i] = (int)std::floor((maxc[i] - minc[i]) / this->cellsize) + 1;
+            nrtotal *= this->nrcells[i];
+        }
+
+        if(nrtotal <= maxcells) {
+            break;
+        }
+
+        this->cellsize *= 1.25;
+    }
+
+    // counting sort of the atoms over the cells
+    const size_t nrtotal = (size_t)this->nrcells[0] * this->nrcells[1] * this->nrcells[2];
+    this->cell_start.assign(nrtotal + 1, 0);
+    this->atom_cell.resize(atoms.size());
+    for(unsigned int i=0; i<atoms.size(); i++) {
+        const auto c = this->get_cell_coordinates(atoms[i].x, atoms[i].y, atoms[i].z);
+        this->atom_cell[i] = (c[2] * this->nrcells[1] + c[1]) * this->nrcells[0] + c[0];
+        this->cell_start[this->atom_cell[i] + 1]++;
+    }
+
+    for(size_t i=0; i<nrtotal; i++) {
+        this->cell_start[i+1] += this->cell_start[i];
+    }
+
+    this->cell_atoms.resize(atoms.size());
+    std::vector<unsigned int> fill(this->cell_start.begin(), this->cell_start.end() - 1);
+    for(unsigned int i=0; i<atoms.size(); i++) {
+        this->cell_atoms[fill[this->atom_cell[i]]++] = i;
+    }
+}
+
+    /**
+     * @brief      Remove all atoms from the grid
+     */
+void CellList::clear() {
+    this->cell_start.clear();
+    this->cell_atoms.clear();
+    this->atom_cell.clear();
+    this->nrcells = {1, 1, 1};
+}
+
+    /**
+     * @brief      Get the (clamped) cell coordinates of a point
+     *
+     * @param[in]  x     x coordinate
+     * @param[in]  y     y coordinate
+     * @param[in]  z     z coordinate
+     *
+     * @return     The cell coordinates.
+     */
+std::array<int, 3> CellList::get_cell_coordinates(double x, double y, double z) const {
+    const std::array<double, 3> p = {x, y, z};
+    std::array<int, 3> c;
+    for(unsigned int i=0; i<3; i++) {
+        const double f = std::floor((p[i] - this->origin[i]) / this->cellsize);
+        c[i] = (int)std::clamp(f, 0.0, (double)(this->nrcells[i] - 1));
+    }
+    return c;
+}
@@ -0,0 +1,144 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "atom.h"
+
+/**
+ * @brief      Uniform grid (cell list) for fixed-radius neighbour searches
+ *
+ * Space is divided into cubic cells with an edge length of at least the
+ * search radius, such that all neighbours of a point are found in the
+ * 27 cells surrounding the cell containing that point.
+ */
+class CellList {
+private:
+    double cellsize = 1.0;                  // edge length of a single cell
+    std::array<double, 3> origin = {0.0, 0.0, 0.0};  // lower corner of the grid
+    std::array<int, 3> nrcells = {1, 1, 1}; // number of cells per direction
+
+    std::vector<unsigned int> cell_start;   // offsets into cell_atoms per cell (size: nr cells + 1)
+    std::vector<unsigned int> cell_atoms;   // atom indices sorted by cell
+    std::vector<unsigned int> atom_cell;    // cell index for each atom
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    CellList();
+
+    /**
+     * @brief      Sort atoms into the grid
+     *
+     * @param[in]  atoms   The atoms
+     * @param[in]  radius  Search radius (minimum edge length of a cell)
+     */
+    void build(const std::vector<Atom>& atoms, double radius);
+
+    /**
+     * @brief      Remove all atoms from the grid
+     */
+    void clear();
+
+    /**
+     * @brief      Gets the number of atoms stored in the grid.
+     *
+     * @return     The number of atoms.
+     */
+    inline size_t get_nr_atoms() const {
+        return this->atom_cell.size();
+    }
+
+    /**
+     * @brief      Loop over all atoms in the cells surrounding a point
+     *
+     * Visits every atom that could lie within one cell size of the point;
+     * the caller is responsible for the exact distance test.
+     *
+     * @param[in]  x     x coordinate
+     * @param[in]  y     y coordinate
+     * @param[in]  z     z coordinate
+     * @param[in]  func  Callback receiving the atom index
+     */
+    template<typename Func>
+    void for_each_candidate(double x, double y, double z, Func&& func) const {
+        if(this->atom_cell.empty()) {
+            return;
+        }
+
+        const auto c = this->get_cell_coordinates(x, y, z);
+        this->for_each_candidate_in_cell(c, func);
+    }
+
+    /**
+     * @brief      Loop over all atoms in the cells surrounding an atom in the grid
+     *
+     * @param[in]  idx   Atom index
+     * @param[in]  func  Callback receiving the atom index (includes idx itself)
+     */
+    template<typename Func>
+    void for_each_candidate(unsigned int idx, Func&& func) const {
+        const unsigned int cell = this->atom_cell[idx];
+        const int cx = cell % this->nrcells[0];
+        const int cy = (cell / this->nrcells[0]) % this->nrcells[1];
+        const int cz = cell / (this->nrcells[0] * this->nrcells[1]);
+        this->for_each_candidate_in_cell({cx, cy, cz}, func);
+    }
+
+private:
+    /**
+     * @brief      Get the (clamped) cell coordinates of a point
+     *
+     * Points outside the grid are mapped onto the boundary cells, which is
+     * safe because the cell size is never smaller than the search radius.
+     *
+     * @param[in]  x     x coordinate
+     * @param[in]  y     y coordinate
+     * @param[in]  z     z coordinate
+     *
+     * @return     The cell coordinates.
+     */
+    std::array<int, 3> get_cell_coordinates(double x, double y, double z) const;
+
+    /**
+     * @brief      Loop over atoms in the 27 cells surrounding a cell
+     *
+     * @param[in]  c     Cell coordinates
+     * @param[in]  func  Callback receiving the atom index
+     */
+    template<typename Func>
+    void for_each_candidate_in_cell(const std::array<int, 3>& c, Func& func) const {
+        for(int z=std::max(c[2]-1, 0); z<=std::min(c[2]+1, this->nrcells[2]-1); z++) {
+            for(int y=std::max(c[1]-1, 0); y<=std::min(c[1]+1, this->nrcells[1]-1); y++) {
+                for(int x=std::max(c[0]-1, 0); x<=std::min(c[0]+1, this->nrcells[0]-1); x++) {
+                    const unsigned int cell = (z * this->nrcells[1] + y) * this->nrcells[0] + x;
+                    for(unsigned int k=this->cell_start[cell]; k<this->cell_start[cell+1]; k++) {
+                        func(this->cell_atoms[k]);
+                    }
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,125 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief      Vector with copy-on-write semantics
+ *
+ * Copies of a CowVector share the same storage; the storage is only
+ * duplicated when a copy that shares it is written to. Read access is
+ * provided via the const interface only, such that reading never triggers
+ * a copy; use write() to obtain a mutable reference.
+ */
+template<typename T>
+class CowVector {
+private:
+    std::shared_ptr<std::vector<T>> storage;   // shared storage (null if empty)
+
+public:
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    /**
+     * @brief      Constructs a new instance.
+     */
+    CowVector() {}
+
+    /**
+     * @brief      Constructs a new instance from a vector
+     *
+     * @param[in]  v     The vector
+     */
+    CowVector(std::vector<T> v) :
+    storage(std::make_shared<std::vector<T>>(std::move(v))) {}
+
+    /**
+     * @brief      Get the underlying vector
+     *
+     * @return     The vector.
+     */
+    inline const std::vector<T>& get() const {
+        static const std::vector<T> empty;
+        return this->storage ? *this->storage : empty;
+    }
+
+    /**
+     * @brief      Get a mutable reference to the vector, detaching it from
+     *             any copies sharing the same storage
+     *
+     * @return     The vector.
+     */
+    std::vector<T>& write() {
+        if(!this->storage) {
+            this->storage = std::make_shared<std::vector<T>>();
+        } else if(this->storage.use_count() > 1) {
+            this->storage = std::make_shared<std::vector<T>>(*this->storage);
+        }
+        return *this->storage;
+    }
+
+    /**
+     * @brief      Release the storage
+     */
+    inline void clear() {
+        this->storage.reset();
+    }
+
+    /**
+     * @brief      Whether two vectors share the same storage
+     *
+     * @param[in]  other  The other vector
+     *
+     * @return     True if shared
+     */
+    inline bool shares_storage(const CowVector& other) const {
+        return this->storage == other.storage;
+    }
+
+    inline size_t size() const {
+        return this->get().size();
+    }
+
+    inline bool empty() const {
+        return this->get().empty();
+    }
+
+    inline const T& operator[](size_t idx) const {
+        return (*this->storage)[idx];
+    }
+
+    inline const T& front() const {
+        return this->get().front();
+    }
+
+    inline const T& back() const {
+        return this->get().back();
+    }
+
+    inline const_iterator begin() const {
+        return this->get().begin();
+    }
+
+    inline const_iterator end() const {
+        return this->get().end();
+    }
+};
@@ -0,0 +1,179 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "instance_data.h"
+
+#include <algorithm>
+
+#include "atom_settings.h"
+#include "structure.h"
+
+/**
+ * @brief      Constructs a new instance.
+ */
+AtomInstances::AtomInstances() {
+
+}
+
+    /**
+     * @brief      Fill the instances from a structure
+     *
+     * The hierarchy of the previous instances of the structure (if any) is
+     * refitted rather than rebuilt.
+     *
+     * @param[in]  structure  The structure
+     * @param[in]  previous   The previous instances, nullptr if none
+     */
+void AtomInstances::build(const Structure& structure, const AtomInstances* previous) {
+    const AtomSettings& settings = AtomSettings::get();
+
+    this->instances.clear();
+    this->instances.reserve(structure.get_nr_atoms());
+    this->moving.clear();
+
+    // selected atoms are told apart in the silhouette by their rank
+    uint32_t rank = 10;
+    for(const Atom& atom : structure.get_atoms()) {
+        AtomInstance instance;
+        instance.position[0] = (float)atom.x;
+        instance.position[1] = (float)atom.y;
+        instance.position[2] = (float)atom.z;
+        instance.element = atom.atnr < AtomSettings::MAX_ELEMENTS ? atom.atnr : 0;
+        instance.flags = (uint32_t)(atom.select & 0x03) << ATOM_INSTANCE_SELECT_SHIFT;
+        if(atom.select == 1 || atom.select == 2) {
+            instance.flags |= (++rank) << ATOM_INSTANCE_RANK_SHIFT;
+        }
+        if(!atom.selective_dynamics[0] || !atom.selective_dynamics[1] || !atom.selective_dynamics[2]) {
+            instance.flags |= ATOM_INSTANCE_FROZEN;
+        }
+
+        // the vertex shader applies the transposition to these atoms
+        if(atom.select == 1) {
+            this->moving.push_back(this->instances.size());
+        }
+
+        this->instances.push_back(instance);
+    }
+
+    // fit the hierarchy to the bounding boxes of the atoms
+    std::vector<BoundingVolumeHierarchy::Box> boxes(this->instances.size());
+    for(unsigned int i=0; i<this->instances.size(); i++) {
+        const float radius = settings.get_atom_radius_from_elnr(this->instances[i].element);
+        for(unsigned int j=0; j<3; j++) {
+            boxes[i].lo[j] = this->instances[i].position[j] - radius;
+            boxes[i].hi[j] = this->instances[i].position[j] + radius;
+        }
+    }
+
+    if(previous) {
+        this->bvh = previous->bvh;
+    }
+    this->bvh.update(boxes);
+}
+
+    /**
+     * @brief      Gets the memory used by the instances.
+     *
+     * @return     The memory usage in bytes.
+     */
+size_t AtomInstances::get_memory_usage() const {
+    return sizeof(AtomInstances) + this->instances.capacity() * sizeof(AtomInstance) +
+           this->moving.capacity() * sizeof(unsigned int) + this->bvh.get_memory_usage();
+}
+
+/**
+ * @brief      Constructs a new instance.
+ */
+BondInstances::BondInstances() {
+
+}
+
+    /**
+     * @brief      Fill the instances from a structure
+     *
+     * The hierarchy of the previous instances of the structure (if any) is
+     * refitted rather than rebuilt.
+     *
+     * @param[in]  structure  The structure
+     * @param[in]  previous   The previous instances, nullptr if none
+     */
+void BondInstances::build(const Structure& structure, const BondInstances* previous) {
+    auto get_element = [](const Atom& atom) {
+        return atom.atnr < AtomSettings::MAX_ELEMENTS ? (uint32_t)atom.atnr : 0u;
+    };
+    auto is_frozen = [](const Atom& atom) {
+        return !atom.selective_dynamics[0] || !atom.selective_dynamics[1] || !atom.selective_dynamics[2];
+    };
+
+    const MatrixUnitcell unitcell = structure.get_unitcell().transpose();
+
+    this->instances.resize(structure.get_nr_bonds());
+    for(unsigned int i=0; i<this->instances.size(); i++) {
+        const Bond& bond = structure.get_bond(i);
+        const BondGeometry geometry = structure.get_bond_geometry(i);
+        const Atom& atom1 = structure.get_atom(bond.atom1_idx);
+        const Atom& atom2 = structure.get_atom(bond.atom2_idx);
+
+        VectorPosition translation = VectorPosition::Zero();
+        if(bond.is_periodic()) {
+            translation = unitcell * VectorPosition(bond.image[0], bond.image[1], bond.image[2]);
+        }
+
+        BondInstance& instance = this->instances[i];
+        for(unsigned int j=0; j<3; j++) {
+            instance.start[j] = geometry.start[j];
+            instance.end[j] = geometry.end[j];
+            instance.translation[j] = (float)translation[j];
+        }
+
+        instance.atoms = get_element(atom1) | (get_element(atom2) << BOND_INSTANCE_ELEMENT2_SHIFT);
+        if(is_frozen(atom1)) {
+            instance.atoms |= BOND_INSTANCE_FROZEN1;
+        }
+        if(is_frozen(atom2)) {
+            instance.atoms |= BOND_INSTANCE_FROZEN2;
+        }
+    }
+
+    // fit the hierarchy to the bounding boxes of both halves
+    std::vector<BoundingVolumeHierarchy::Box> boxes(this->instances.size());
+    for(unsigned int i=0; i<this->instances.size(); i++) {
+        const BondInstance& instance = this->instances[i];
+        for(unsigned int j=0; j<3; j++) {
+            const float half = 0.5f * (instance.end[j] + instance.translation[j] - instance.start[j]);
+            boxes[i].lo[j] = std::min({instance.start[j], instance.start[j] + half, instance.end[j] - half, instance.end[j]}) - BOND_RADIUS;
+            boxes[i].hi[j] = std::max({instance.start[j], instance.start[j] + half, instance.end[j] - half, instance.end[j]}) + BOND_RADIUS;
+        }
+    }
+
+    if(previous) {
+        this->bvh = previous->bvh;
+    }
+    this->bvh.update(boxes);
+}
+
+    /**
+     * @brief      Gets the memory used by the instances.
+     *
+     * @return     The memory usage in bytes.
+     */
+size_t BondInstances::get_memory_usage() const {
+    return sizeof(BondInstances) + this->instances.capacity() * sizeof(BondInstance) + this->bvh.get_memory_usage();
+}
@@ -0,0 +1,183 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bounding_volume_hierarchy.h"
+
+class Structure;
+
+/**
+ * @brief      Per-atom data for instanced drawing of the atoms
+ */
+struct AtomInstance {
+    float position[3];      // cartesian position
+    uint32_t element;       // atomic number (index in the element texture)
+    uint32_t flags;         // see ATOM_INSTANCE_* below
+};
+
+enum : uint32_t {
+    ATOM_INSTANCE_EXPANSION = 0x01,     // bit 0: atom belongs to the periodicity expansion
+    ATOM_INSTANCE_FROZEN = 0x02,        // bit 1: at least one direction is frozen
+    ATOM_INSTANCE_SELECT_SHIFT = 2,     // bits 2-3: selection state (0, 1 or 2)
+    ATOM_INSTANCE_RANK_SHIFT = 8        // bits 8-31: silhouette index of selected atoms
+};
+
+/**
+ * @brief      Per-bond data for instanced drawing of the bonds
+ */
+struct BondInstance {
+    float start[3];         // position of atom1
+    float end[3];           // position of atom2 (not of its periodic image)
+    float translation[3];   // translation from atom2 onto the image bonded to atom1
+    uint32_t atoms;         // elements and frozen state of both atoms, see BOND_INSTANCE_* below
+};
+
+enum : uint32_t {
+    BOND_INSTANCE_ELEMENT_MASK = 0xFF,      // bits 0-7: atomic number of atom1
+    BOND_INSTANCE_ELEMENT2_SHIFT = 8,       // bits 8-15: atomic number of atom2
+    BOND_INSTANCE_FROZEN1 = 0x10000,        // bit 16: atom1 has at least one frozen direction
+    BOND_INSTANCE_FROZEN2 = 0x20000         // bit 17: atom2 has at least one frozen direction
+};
+
+/**
+ * @brief      Instances of the central atoms of a structure for drawing
+ *
+ * Derived from a structure like its atom arrays (see
+ * Structure::get_atom_instances), such that frames of a trajectory can be
+ * prepared ahead of being shown and the renderer only uploads these.
+ */
+class AtomInstances {
+private:
+    std::vector<AtomInstance> instances;        // atoms in the central unit cell
+    std::vector<unsigned int> moving;           // instances displaced by the transposition
+    BoundingVolumeHierarchy bvh;                // hierarchy over the instances
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    AtomInstances();
+
+    /**
+     * @brief      Fill the instances from a structure
+     *
+     * The hierarchy of the previous instances of the structure (if any) is
+     * refitted rather than rebuilt.
+     *
+     * @param[in]  structure  The structure
+     * @param[in]  previous   The previous instances, nullptr if none
+     */
+    void build(const Structure& structure, const AtomInstances* previous);
+
+    /**
+     * @brief      Gets the instances.
+     *
+     * @return     The instances.
+     */
+    inline const std::vector<AtomInstance>& get_instances() const {
+        return this->instances;
+    }
+
+    /**
+     * @brief      Gets the instances of the atoms moved by the transposition.
+     *
+     * @return     The instance indices.
+     */
+    inline const std::vector<unsigned int>& get_moving() const {
+        return this->moving;
+    }
+
+    /**
+     * @brief      Gets the hierarchy over the instances.
+     *
+     * @return     The hierarchy.
+     */
+    inline const BoundingVolumeHierarchy& get_bvh() const {
+        return this->bvh;
+    }
+
+    /**
+     * @brief      Gets the memory used by the instances.
+     *
+     * @return     The memory usage in bytes.
+     */
+    size_t get_memory_usage() const;
+};
+
+/**
+ * @brief      Instances of the bonds of a structure for drawing
+ *
+ * Derived from a structure like its atom instances (see
+ * Structure::get_bond_instances).
+ */
+class BondInstances {
+public:
+    static constexpr float BOND_RADIUS = 0.15f;     // radius of the bonds
+
+private:
+    std::vector<BondInstance> instances;        // one instance per bond
+    BoundingVolumeHierarchy bvh;                // hierarchy over the instances
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    BondInstances();
+
+    /**
+     * @brief      Fill the instances from a structure
+     *
+     * The hierarchy of the previous instances of the structure (if any) is
+     * refitted rather than rebuilt.
+     *
+     * @param[in]  structure  The structure
+     * @param[in]  previous   The previous instances, nullptr if none
+     */
+    void build(const Structure& structure, const BondInstances* previous);
+
+    /**
+     * @brief      Gets the instances.
+     *
+     * @return     The instances.
+     */
+    inline const std::vector<BondInstance>& get_instances() const {
+        return this->instances;
+    }
+
+    /**
+     * @brief      Gets the hierarchy over the instances.
+     *
+     * @return     The hierarchy.
+     */
+    inline const BoundingVolumeHierarchy& get_bvh() const {
+        return this->bvh;
+    }
+
+    /**
+     * @brief      Gets the memory used by the instances.
+     *
+     * @return     The memory usage in bytes.
+     */
+    size_t get_memory_usage() const;
+};
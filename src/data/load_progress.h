@@ -0,0 +1,127 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "structure.h"
+#include "trajectory.h"
+
+/**
+ * @brief      Progress of a file being loaded in a background thread
+ *
+ * Shared between the thread that loads a file and the thread that displays
+ * it. The loader reports the number of bytes it has processed and makes
+ * complete ionic steps available as soon as it has read them by publishing
+ * the trajectory it is filling; the display thread polls these and may
+ * request the loader to stop.
+ */
+class LoadProgress {
+private:
+    std::atomic<size_t> bytes_processed = 0;    // number of bytes processed
+    std::atomic<size_t> bytes_total = 0;        // total number of bytes to process
+    std::atomic<bool> cancelled = false;        // whether the loader should stop
+
+    std::mutex trajectory_mutex;                // guards trajectory
+    std::shared_ptr<Trajectory> trajectory;     // trajectory being filled (if any)
+
+public:
+    /**
+     * @brief      Set the progress
+     *
+     * @param[in]  processed  Number of bytes processed
+     * @param[in]  total      Total number of bytes to process
+     */
+    inline void set_progress(size_t processed, size_t total) {
+        this->bytes_total = total;
+        this->bytes_processed = processed;
+    }
+
+    /**
+     * @brief      Raise the progress from concurrent tasks
+     *
+     * Tasks finishing out of order may report their counts in any order;
+     * a count not higher than the one already reported is ignored, so the
+     * progress never moves backwards.
+     *
+     * @param[in]  processed  Number of units processed
+     * @param[in]  total      Total number of units to process
+     */
+    inline void advance_progress(size_t processed, size_t total) {
+        this->bytes_total = total;
+        size_t reported = this->bytes_processed.load();
+        while(processed > reported &&
+              !this->bytes_processed.compare_exchange_weak(reported, processed)) {}
+    }
+
+    /**
+     * @brief      Gets the progress as a fraction between zero and one.
+     *
+     * @return     The progress.
+     */
+    inline double get_fraction() const {
+        const size_t total = this->bytes_total;
+        return total > 0 ? std::min(1.0, (double)this->bytes_processed / (double)total) : 0.0;
+    }
+
+    /**
+     * @brief      Request the loader to stop
+     */
+    inline void cancel() {
+        this->cancelled = true;
+    }
+
+    /**
+     * @brief      Determines if the loader was requested to stop.
+     *
+     * @return     True if cancelled, False otherwise.
+     */
+    inline bool is_cancelled() const {
+        return this->cancelled;
+    }
+
+    /**
+     * @brief      Publish the trajectory that is being filled
+     *
+     * Frames become accessible as soon as the loader adds them to the
+     * trajectory.
+     *
+     * @param[in]  _trajectory  The trajectory
+     */
+    inline void set_trajectory(const std::shared_ptr<Trajectory>& _trajectory) {
+        std::lock_guard<std::mutex> lock(this->trajectory_mutex);
+        this->trajectory = _trajectory;
+    }
+
+    /**
+     * @brief      Gets the trajectory that is being filled.
+     *
+     * @return     The trajectory, nullptr if none
+     */
+    inline std::shared_ptr<Trajectory> get_trajectory() {
+        std::lock_guard<std::mutex> lock(this->trajectory_mutex);
+        return this->trajectory;
+    }
+};
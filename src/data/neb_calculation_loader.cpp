@@ -20,13 +20,16 @@
 
 #include "neb_calculation_loader.h"
 
+#include <QDebug>
 #include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
 #include <QObject>
+#include <QStringList>
 
 #include <algorithm>
 
+#include "parallel.h"
 #include "structure_loader.h"
 
 /**
@@ -83,36 +86,85 @@ bool NebCalculationLoader::load(const QString& root_directory, QString* error_me
         return false;
     }
 
-    StructureLoader structure_loader;
-    for(size_t i = 1; i + 1 < image_directories.size(); ++i) {
+    // the endpoints are often only given as POSCAR; intermediate images
+    // always require an OUTCAR
+    std::vector<QString> outcar_paths;
+    std::vector<QString> image_names;
+    for(size_t i = 0; i < image_directories.size(); ++i) {
         const QString outcar_path = QDir(image_directories[i].absoluteFilePath()).filePath("OUTCAR");
         const QFileInfo outcar_info(outcar_path);
+        const bool is_endpoint = (i == 0 || i + 1 == image_directories.size());
 
         if(!outcar_info.exists() || !outcar_info.isFile()) {
+            if(is_endpoint) {
+                qDebug() << "Skipping NEB endpoint" << image_directories[i].fileName() << "without OUTCAR";
+                continue;
+            }
+
             if(error_message) {
                 *error_message = QObject::tr("Folder '%1' does not contain an OUTCAR file.")
                                      .arg(image_directories[i].fileName());
             }
-            structures_.clear();
             return false;
         }
 
+        outcar_paths.push_back(outcar_path);
+        image_names.push_back(image_directories[i].fileName());
+    }
+
+    // parse the images concurrently; every task writes only its own slot
+    std::vector<std::shared_ptr<Structure>> images(outcar_paths.size());
+    std::vector<std::string> errors(outcar_paths.size());
+    std::vector<std::string> filenames(outcar_paths.size());
+    for(size_t i = 0; i < outcar_paths.size(); ++i) {
+        filenames[i] = outcar_paths[i].toStdString();
+    }
+
+    std::atomic<size_t> nr_read = 0;
+    Parallel::for_each(filenames.size(), [&](size_t i) {
+        if(cancelled_) {
+            return;
+        }
+
         try {
-            auto final_structure = structure_loader.load_outcar_last(outcar_path.toStdString());
-            structures_.push_back(final_structure);
+            StructureLoader structure_loader;
+            images[i] = structure_loader.load_outcar_last(filenames[i]);
         } catch (const std::exception& e) {
-            if(error_message) {
-                *error_message = QObject::tr("Failed to read OUTCAR in folder '%1': %2")
-                                     .arg(image_directories[i].fileName(), e.what());
-            }
-            structures_.clear();
-            return false;
+            errors[i] = e.what();
+        }
+
+        if(progress_) {
+            progress_->advance_progress(nr_read.fetch_add(1) + 1, filenames.size());
+        }
+    }, MAX_CONCURRENT_READS);
+
+    if(cancelled_) {
+        if(error_message) {
+            *error_message = QObject::tr("Loading of the NEB calculation was cancelled.");
+        }
+        return false;
+    }
+
+    QStringList failures;
+    for(size_t i = 0; i < images.size(); ++i) {
+        if(!errors[i].empty()) {
+            failures << QObject::tr("Failed to read OUTCAR in folder '%1': %2")
+                            .arg(image_names[i], QString::fromStdString(errors[i]));
         }
     }
 
+    if(!failures.isEmpty()) {
+        if(error_message) {
+            *error_message = failures.join("\n");
+        }
+        return false;
+    }
+
+    structures_ = std::move(images);
+
     if(structures_.empty()) {
         if(error_message) {
-            *error_message = QObject::tr("No intermediate NEB images were found.");
+            *error_message = QObject::tr("No NEB images were found.");
         }
         return false;
     }
@@ -22,9 +22,11 @@
 
 #include <QString>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
+#include "load_progress.h"
 #include "structure.h"
 
 /**
@@ -35,11 +37,38 @@ public:
 /**
  * @brief load.
  *
+ * Reads the final structure of every image folder, including the endpoints
+ * 00 and NN when these contain an OUTCAR. The images are parsed on a small
+ * pool of threads; the structures are always stored in folder order.
+ *
  * @param root_directory Parameter root_directory.
  * @param error_message Parameter error_message.
  */
     bool load(const QString& root_directory, QString* error_message = nullptr);
 
+    /**
+     * @brief cancel.
+     *
+     * Request a running load() (in another thread) to stop; images that are
+     * not yet being read are skipped and load() returns false. The request
+     * may also precede load() and is never withdrawn; use a new loader for
+     * every load.
+     */
+    void cancel() {
+        cancelled_ = true;
+    }
+
+    /**
+     * @brief set_progress.
+     *
+     * Report the number of images read to a progress monitor.
+     *
+     * @param progress The progress monitor (must outlive the loads).
+     */
+    void set_progress(LoadProgress* progress) {
+        progress_ = progress;
+    }
+
     /**
      * @brief structures.
      *
@@ -49,6 +78,10 @@ public:
     }
 
 private:
+    static constexpr int MAX_CONCURRENT_READS = 4;   // number of OUTCAR files read simultaneously
+
     std::vector<std::shared_ptr<Structure>> structures_;
+    std::atomic<bool> cancelled_ = false;
+    LoadProgress* progress_ = nullptr;    // optional progress monitor
 };
 
@@ -0,0 +1,997 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "outcar_parser.h"
+#include "parallel.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief      Grab the next line (without the newline character)
+ *
+ * @param      cur   Start of the line (advanced to the start of the next line)
+ * @param[in]  end   End of the buffer
+ * @param      line  The line
+ *
+ * @return     False if the end of the buffer has been reached
+ */
+inline bool next_line(const char*& cur, const char* end, std::string_view& line) {
+    if(cur >= end) {
+        return false;
+    }
+
+    const char* nl = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+    if(nl == nullptr) {
+        nl = end;
+    }
+
+    line = std::string_view(cur, nl - cur);
+    cur = (nl < end) ? nl + 1 : end;
+    return true;
+}
+
+/**
+ * @brief      Grab the next line; an empty line is returned at the end of the buffer
+ *
+ * @param      cur   Start of the line (advanced to the start of the next line)
+ * @param[in]  end   End of the buffer
+ *
+ * @return     The line
+ */
+inline std::string_view read_line(const char*& cur, const char* end) {
+    std::string_view line;
+    next_line(cur, end, line);
+    return line;
+}
+
+/**
+ * @brief      Grab the previous line (without the newline character)
+ *
+ * @param      cur    Start of the line following the line (moved to the start of the line)
+ * @param[in]  begin  Start of the region to scan
+ * @param[in]  end    End of the buffer
+ * @param      line   The line
+ *
+ * @return     False if the start of the region has been reached
+ */
+inline bool previous_line(const char*& cur, const char* begin, const char* end, std::string_view& line) {
+    if(cur <= begin) {
+        return false;
+    }
+
+    // the newline preceding cur terminates the line, unless cur is the end of a
+    // buffer that does not end with a newline
+    const char* stop = cur;
+    if(stop < end || stop[-1] == '\n') {
+        stop--;
+    }
+
+    const char* start = stop;
+    while(start > begin && start[-1] != '\n') {
+        start--;
+    }
+
+    line = std::string_view(start, stop - start);
+    cur = start;
+    return true;
+}
+
+/**
+ * @brief      Whether a character is matched by \s
+ */
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+/**
+ * @brief      Whether a character is a decimal digit
+ */
+inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief      Whether a character can be part of a floating point token ([0-9eE.+-])
+ */
+inline bool is_number_char(char c) {
+    return is_digit(c) || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+/**
+ * @brief      Advance over whitespace
+ *
+ * @param      p     Current position
+ * @param[in]  e     End of the line
+ *
+ * @return     Number of characters skipped
+ */
+inline size_t skip_space(const char*& p, const char* e) {
+    const char* start = p;
+    while(p < e && is_space(*p)) {
+        p++;
+    }
+    return p - start;
+}
+
+/**
+ * @brief      Get the first non-blank character of a line
+ *
+ * @param[in]  line  The line
+ *
+ * @return     The character, zero for a blank line
+ */
+inline char first_character(std::string_view line) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+    return (p < e) ? *p : '\0';
+}
+
+/**
+ * @brief      Consume a literal
+ *
+ * @param      p        Current position (advanced on success)
+ * @param[in]  e        End of the line
+ * @param[in]  literal  The literal
+ *
+ * @return     True if the literal was found at p
+ */
+inline bool consume(const char*& p, const char* e, std::string_view literal) {
+    if((size_t)(e - p) < literal.size() || std::memcmp(p, literal.data(), literal.size()) != 0) {
+        return false;
+    }
+    p += literal.size();
+    return true;
+}
+
+/**
+ * @brief      Convert a complete token to a double
+ *
+ * Mirrors QString::toDouble: a token that is not entirely a number yields zero.
+ *
+ * @param[in]  token  The token
+ *
+ * @return     The value
+ */
+double token_to_double(std::string_view token) {
+    const char* p = token.data();
+    const char* e = p + token.size();
+    if(p < e && *p == '+') {
+        p++;
+    }
+
+    double value = 0.0;
+    const auto res = std::from_chars(p, e, value);
+    if(res.ec != std::errc() || res.ptr != e) {
+        return 0.0;
+    }
+    return value;
+}
+
+/**
+ * @brief      Parse the next number on a line (strtod semantics)
+ *
+ * @param      p      Current position (advanced past the number on success)
+ * @param[in]  e      End of the line
+ * @param      value  The value
+ *
+ * @return     True if a number was parsed
+ */
+inline bool parse_double(const char*& p, const char* e, double& value) {
+    const char* q = p;
+    skip_space(q, e);
+    if(q < e && *q == '+') {
+        q++;
+    }
+
+    const auto res = std::from_chars(q, e, value);
+    if(res.ec != std::errc()) {
+        return false;
+    }
+    p = res.ptr;
+    return true;
+}
+
+/**
+ * @brief      Parse six whitespace separated numbers
+ *
+ * @param[in]  line  The line
+ * @param      c     The values
+ *
+ * @return     True if all six numbers could be parsed
+ */
+inline bool parse_six_columns(std::string_view line, double c[6]) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    for(unsigned int i=0; i<6; i++) {
+        if(!parse_double(p, e, c[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief      Match ^\s*vasp.([0-9]).([0-9]+).([0-9]+)
+ *
+ * @param[in]  line     The line
+ * @param      version  Version, major and minor number
+ *
+ * @return     True on a match
+ */
+bool match_vasp_version(std::string_view line, unsigned int version[3]) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+    if(!consume(p, e, "vasp") || e - p < 2 || !is_digit(p[1])) {
+        return false;
+    }
+    version[0] = p[1] - '0';
+    p += 2;
+
+    // any character followed by [0-9]+ any character [0-9]+; the first run of
+    // digits is taken as long as possible while still allowing a match
+    if(p == e) {
+        return false;
+    }
+    p++;
+    const char* digits = p;
+    while(p < e && is_digit(*p)) {
+        p++;
+    }
+    for(const char* q = p; q > digits; q--) {
+        if(q + 1 < e && is_digit(q[1])) {
+            std::from_chars(digits, q, version[1]);
+            const char* minor = q + 1;
+            const char* r = minor;
+            while(r < e && is_digit(*r)) {
+                r++;
+            }
+            std::from_chars(minor, r, version[2]);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief      Match ^\s*(VRHFIN\s+=)([A-Za-z]+)\s*:
+ *
+ * @param[in]  line     The line
+ * @param      element  The element
+ *
+ * @return     True on a match
+ */
+bool match_element(std::string_view line, std::string_view& element) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+    if(!consume(p, e, "VRHFIN") || skip_space(p, e) == 0 || !consume(p, e, "=")) {
+        return false;
+    }
+
+    const char* start = p;
+    while(p < e && ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))) {
+        p++;
+    }
+    if(p == start) {
+        return false;
+    }
+    element = std::string_view(start, p - start);
+
+    skip_space(p, e);
+    return p < e && *p == ':';
+}
+
+/**
+ * @brief      Match ^\s*(ions per type =\s+)([0-9 ]+)\s*$
+ *
+ * @param[in]  line    The line
+ * @param      counts  The number of ions per element
+ *
+ * @return     True on a match
+ */
+bool match_ions_per_type(std::string_view line, std::vector<unsigned int>& counts) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+    if(!consume(p, e, "ions per type =") || skip_space(p, e) == 0) {
+        return false;
+    }
+
+    const char* start = p;
+    while(p < e && (is_digit(*p) || *p == ' ')) {
+        p++;
+    }
+    const char* stop = p;
+    skip_space(p, e);
+    if(p != e) {
+        return false;
+    }
+
+    counts.clear();
+    for(p = start; p < stop;) {
+        if(*p == ' ') {
+            p++;
+            continue;
+        }
+        unsigned int count = 0;
+        p = std::from_chars(p, stop, count).ptr;
+        counts.push_back(count);
+    }
+    return true;
+}
+
+/**
+ * @brief      Match ^\s+energy  without entropy=\s+([0-9.-]+)\s+energy\(sigma->0\) =\s+([0-9.-]+)
+ *
+ * @param[in]  line    The line
+ * @param      energy  The energy (sigma->0)
+ *
+ * @return     True on a match
+ */
+bool match_energy(std::string_view line, double& energy) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    if(skip_space(p, e) == 0 || !consume(p, e, "energy  without entropy=") || skip_space(p, e) == 0) {
+        return false;
+    }
+
+    const char* start = p;
+    while(p < e && (is_digit(*p) || *p == '.' || *p == '-')) {
+        p++;
+    }
+    if(p == start || skip_space(p, e) == 0 || !consume(p, e, "energy(sigma->0) =") || skip_space(p, e) == 0) {
+        return false;
+    }
+
+    start = p;
+    while(p < e && (is_digit(*p) || *p == '.' || *p == '-')) {
+        p++;
+    }
+    if(p == start) {
+        return false;
+    }
+
+    energy = token_to_double(std::string_view(start, p - start));
+    return true;
+}
+
+/**
+ * @brief      Match ^\s*[0-9]+\s+f(/i)?\s*=\s*([0-9eE.+-]+)\s+THz
+ *
+ * @param[in]  line        The line
+ * @param      eigenvalue  The frequency (negative for imaginary modes)
+ *
+ * @return     True on a match
+ */
+bool match_frequency_mode(std::string_view line, double& eigenvalue) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+
+    const char* start = p;
+    while(p < e && is_digit(*p)) {
+        p++;
+    }
+    if(p == start || skip_space(p, e) == 0 || !consume(p, e, "f")) {
+        return false;
+    }
+    const bool imaginary = consume(p, e, "/i");
+    skip_space(p, e);
+    if(!consume(p, e, "=")) {
+        return false;
+    }
+    skip_space(p, e);
+
+    start = p;
+    while(p < e && is_number_char(*p)) {
+        p++;
+    }
+    const char* stop = p;
+    if(stop == start || skip_space(p, e) == 0 || !consume(p, e, "THz")) {
+        return false;
+    }
+
+    eigenvalue = token_to_double(std::string_view(start, stop - start));
+    if(imaginary) {
+        eigenvalue *= -1.0;
+    }
+    return true;
+}
+
+/**
+ * @brief      Match ^\s*(?:[0-9]+\s+)?([0-9eE.+-]+)\s+ ... (six columns)\s*$
+ *
+ * @param[in]  line  The line
+ * @param      v     Last three columns
+ *
+ * @return     True on a match
+ */
+bool match_eigenvector(std::string_view line, double v[3]) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+
+    // the columns cannot contain whitespace, hence the line has to consist
+    // of either six numbers or an integer followed by six numbers
+    std::string_view tokens[7];
+    unsigned int nr_tokens = 0;
+    skip_space(p, e);
+    while(p < e) {
+        if(nr_tokens == 7) {
+            return false;
+        }
+        const char* start = p;
+        while(p < e && is_number_char(*p)) {
+            p++;
+        }
+        if(p == start || (p < e && !is_space(*p))) {
+            return false;
+        }
+        tokens[nr_tokens++] = std::string_view(start, p - start);
+        skip_space(p, e);
+    }
+
+    if(nr_tokens == 7) {
+        for(char c : tokens[0]) {
+            if(!is_digit(c)) {
+                return false;
+            }
+        }
+    } else if(nr_tokens != 6) {
+        return false;
+    }
+
+    for(unsigned int i=0; i<3; i++) {
+        v[i] = token_to_double(tokens[nr_tokens - 3 + i]);
+    }
+    return true;
+}
+
+/**
+ * @brief      Match ^\s*<keyword>
+ *
+ * @param[in]  line     The line
+ * @param[in]  keyword  The keyword
+ *
+ * @return     True on a match
+ */
+inline bool match_keyword(std::string_view line, std::string_view keyword) {
+    const char* p = line.data();
+    const char* e = p + line.size();
+    skip_space(p, e);
+    return consume(p, e, keyword);
+}
+}
+
+/**
+ * @brief      Constructs a new instance.
+ *
+ * @param[in]  data  The file contents (must outlive the parser)
+ * @param[in]  size  The number of bytes
+ */
+OutcarParser::OutcarParser(const char* data, size_t size) :
+begin(data),
+cur(data),
+end(data + size) {
+
+}
+
+    /**
+     * @brief      Throw if the monitored load was cancelled
+     */
+void OutcarParser::check_cancelled() const {
+    if(this->progress->is_cancelled()) {
+        throw std::runtime_error("Loading of OUTCAR was cancelled.");
+    }
+}
+
+    /**
+     * @brief      Scan the buffer (phase one of parse())
+     *
+     * Reads the header, the energies and the eigenmodes and records the
+     * offset of every block of atomic positions.
+     *
+     * @param      scan  The result
+     */
+void OutcarParser::scan(Scan& scan) {
+    Header& header = scan.header;
+    std::vector<std::pair<size_t, double>> energies;   // offset and value
+    std::vector<size_t>& block_offsets = scan.block_offsets;
+    std::vector<ParsedEigenmode>& parsed_eigenmodes = scan.eigenmodes;
+
+    bool reading_mode_eigenvectors = false;
+
+    this->cur = this->begin;
+    std::string_view line;
+    const char* next_report = this->begin;
+    while(next_line(this->cur, this->end, line)) { // loop over all the lines in the file
+        if(this->progress && this->cur >= next_report) {
+            this->check_cancelled();
+            this->progress->set_progress(this->cur - this->begin, 2 * this->size());
+            next_report = this->cur + PROGRESS_INTERVAL;
+        }
+
+        if(reading_mode_eigenvectors) {
+            double v[3];
+            if(match_eigenvector(line, v)) {
+                parsed_eigenmodes.back().eigenvectors.emplace_back(v[0], v[1], v[2]);
+
+                if(parsed_eigenmodes.back().eigenvectors.size() == header.nr_atoms) {
+                    reading_mode_eigenvectors = false;
+                    qDebug() << "Completed eigenmode" << parsed_eigenmodes.size()
+                             << "with" << header.nr_atoms << "eigenvectors.";
+                }
+
+                continue;
+            }
+
+            if(!parsed_eigenmodes.back().eigenvectors.empty()) {
+                reading_mode_eigenvectors = false;
+            }
+        }
+
+        const char first = first_character(line);
+        if(first == '\0') {
+            continue;
+        }
+
+        if(is_digit(first)) {
+            double eigenvalue = 0.0;
+            if(match_frequency_mode(line, eigenvalue)) {
+                parsed_eigenmodes.push_back({eigenvalue, {}});
+                reading_mode_eigenvectors = true;
+
+                qDebug() << "Detected frequency mode" << parsed_eigenmodes.size()
+                         << "(THz):" << eigenvalue;
+            }
+            continue;
+        }
+
+        if(header.readstate != OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS) {
+            this->read_header_line(line, first, header);
+            continue;
+        }
+
+        /*
+         * Collect the energy of the state and the atomic positions and
+         * forces
+         */
+        if(first == 'e') {
+            double energy = 0.0;
+            if(match_energy(line, energy)) {
+                energies.emplace_back(line.data() - this->begin, energy);
+            }
+        } else if(first == 'P' && match_keyword(line, "POSITION")) {
+            read_line(this->cur, this->end); // skip dashed line
+
+            // only record where the atoms are; these lines are parsed in phase two
+            block_offsets.push_back(this->cur - this->begin);
+            for(unsigned int i=0; i<header.nr_atoms; i++) {
+                read_line(this->cur, this->end);
+            }
+        }
+    }
+
+    // energies are sometimes given either before or after the coordinates; the
+    // layout is detected from whichever comes first, after which each ionic
+    // step takes the energy found between its coordinates and those of the
+    // preceding (energy first) or following (coordinates first) step
+    const bool energy_first = !energies.empty() && !block_offsets.empty() &&
+                              energies.front().first < block_offsets.front();
+    std::vector<double>& step_energies = scan.energies;
+    step_energies.resize(block_offsets.size());
+    size_t k = 0;
+    for(size_t i=0; i<block_offsets.size(); i++) {
+        const size_t lower = energy_first ? (i > 0 ? block_offsets[i-1] : 0) : block_offsets[i];
+        const size_t upper = energy_first ? block_offsets[i] :
+                             (i+1 < block_offsets.size() ? block_offsets[i+1] : std::numeric_limits<size_t>::max());
+
+        while(k < energies.size() && energies[k].first < lower) {
+            k++;
+        }
+        if(k == energies.size() || energies[k].first >= upper) {
+            throw std::runtime_error("No energy found for ionic step " + std::to_string(i+1) + " in OUTCAR.");
+        }
+        while(k + 1 < energies.size() && energies[k+1].first < upper) {
+            k++;
+        }
+
+        step_energies[i] = energies[k].second;
+        k++;
+    }
+}
+
+    /**
+     * @brief      Parse all ionic steps (and eigenmodes) from the buffer
+     *
+     * @return     Structures
+     */
+std::vector<std::shared_ptr<Structure>> OutcarParser::parse() {
+    Scan scan;
+    this->scan(scan);
+    return this->parse(scan);
+}
+
+    /**
+     * @brief      Parse the ionic steps (and eigenmodes) found by a scan
+     *
+     * @param[in]  scan  The scan of this buffer
+     *
+     * @return     Structures
+     */
+std::vector<std::shared_ptr<Structure>> OutcarParser::parse(const Scan& scan) {
+    const Header& header = scan.header;
+    const std::vector<size_t>& block_offsets = scan.block_offsets;
+    const std::vector<double>& step_energies = scan.energies;
+    const std::vector<ParsedEigenmode>& parsed_eigenmodes = scan.eigenmodes;
+
+    // phase two: parse the ionic steps; when progress is monitored, this is
+    // done in batches such that progress is reported and cancellation is
+    // checked in between
+    const std::vector<unsigned int> element_numbers = block_offsets.empty() ?
+        std::vector<unsigned int>() : this->get_element_numbers(header);
+    const size_t batch_size = this->progress ? PROGRESS_BATCH_SIZE : std::max<size_t>(block_offsets.size(), 1);
+
+    // for frequency calculations only the first ionic step is kept as reference structure
+    const size_t nr_steps = parsed_eigenmodes.empty() ? block_offsets.size() : std::min<size_t>(block_offsets.size(), 1);
+    std::vector<std::shared_ptr<Structure>> structures(nr_steps);
+    for(size_t b=0; b<structures.size(); b+=batch_size) {
+        const size_t n = std::min(batch_size, structures.size() - b);
+        Parallel::for_each(n, [&](size_t i) {
+            structures[b+i] = this->parse_ionic_step(block_offsets[b+i], header, element_numbers);
+            structures[b+i]->set_energy(step_energies[b+i]);
+        });
+
+        if(this->progress) {
+            this->check_cancelled();
+            const size_t processed = (b + n < structures.size()) ? block_offsets[b + n] : this->size();
+            this->progress->set_progress(this->size() + processed, 2 * this->size());
+        }
+    }
+    qDebug() << "Parsed" << structures.size() << "ionic structures from OUTCAR.";
+
+    if(!parsed_eigenmodes.empty()) {
+        if(structures.empty()) {
+            throw std::runtime_error("Encountered eigenmodes in OUTCAR without atomic structures.");
+        }
+
+        qDebug() << "Frequency calculation detected. Ionic structures found:" << block_offsets.size()
+                 << "; eigenmodes parsed:" << parsed_eigenmodes.size();
+
+        auto reference_structure = structures.front();
+        reference_structure->clear_eigenmodes();
+
+        unsigned int nr_added_modes = 0;
+        for(const auto& mode : parsed_eigenmodes) {
+            if(mode.eigenvectors.size() != header.nr_atoms) {
+                qDebug() << "Skipping incomplete eigenmode, expected" << header.nr_atoms
+                         << "vectors but found" << mode.eigenvectors.size();
+                continue;
+            }
+
+            reference_structure->add_eigenmode(mode.eigenvalue, mode.eigenvectors);
+            nr_added_modes++;
+        }
+
+        qDebug() << "Stored" << nr_added_modes << "eigenmodes on first ionic structure.";
+    }
+
+    return structures;
+}
+
+    /**
+     * @brief      Index the ionic steps for a trajectory
+     *
+     * Performs the scan of parse(), after which only the forces of every
+     * ionic step are read to obtain its RMS force. The frames are added to
+     * the trajectory in batches; their locator is the offset of the block
+     * of atomic positions (see parse_frame()).
+     *
+     * @param      trajectory  The trajectory
+     * @param      scan        The scan (output), to be passed to parse()
+     *                         when no frames were indexed
+     *
+     * @return     False if the buffer holds eigenmodes (use parse() instead)
+     */
+bool OutcarParser::index(Trajectory& trajectory, Scan& scan) {
+    this->scan(scan);
+    if(!scan.eigenmodes.empty()) {
+        return false;
+    }
+
+    // the header is kept for parse_frame(); this happens before any frame
+    // is made available through the trajectory
+    this->frame_header = scan.header;
+    this->frame_element_numbers = scan.block_offsets.empty() ?
+        std::vector<unsigned int>() : this->get_element_numbers(scan.header);
+
+    const size_t nr_steps = scan.block_offsets.size();
+    const size_t batch_size = this->progress ? PROGRESS_BATCH_SIZE : std::max<size_t>(nr_steps, 1);
+    std::vector<Trajectory::Frame> frames(nr_steps);
+    for(size_t b=0; b<nr_steps; b+=batch_size) {
+        const size_t n = std::min(batch_size, nr_steps - b);
+        Parallel::for_each(n, [&](size_t i) {
+            Trajectory::Frame& frame = frames[b+i];
+            frame.locator = scan.block_offsets[b+i];
+            frame.energy = scan.energies[b+i];
+            frame.rms_force = this->read_rms_force(frame.locator, scan.header);
+        });
+
+        if(this->progress) {
+            this->check_cancelled();
+            const size_t processed = (b + n < nr_steps) ? scan.block_offsets[b + n] : this->size();
+            this->progress->set_progress(this->size() + processed, 2 * this->size());
+        }
+
+        trajectory.add_frames({frames.begin() + b, frames.begin() + b + n});
+    }
+    qDebug() << "Indexed" << nr_steps << "ionic structures from OUTCAR.";
+
+    return true;
+}
+
+    /**
+     * @brief      Parse a single ionic step after index()
+     *
+     * @param[in]  offset  Locator of the frame given by index()
+     *
+     * @return     The structure (without energy)
+     */
+std::shared_ptr<Structure> OutcarParser::parse_frame(size_t offset) const {
+    return this->parse_ionic_step(offset, this->frame_header, this->frame_element_numbers);
+}
+
+    /**
+     * @brief      Prepare parse_frame() for frames indexed earlier
+     *
+     * Only the header is read from the buffer.
+     */
+void OutcarParser::read_frame_header() {
+    Header header;
+    this->read_header(header);
+
+    this->frame_header = header;
+    this->frame_element_numbers = this->get_element_numbers(header);
+}
+
+    /**
+     * @brief      Parse the final ionic step from the buffer
+     *
+     * The header is read from the start of the buffer, after which the
+     * buffer is scanned backwards from its end for the last block of atomic
+     * positions and the last energy. For a memory-mapped file, only the
+     * pages holding the header and the final ionic step are read.
+     *
+     * @return     Structure
+     */
+std::shared_ptr<Structure> OutcarParser::parse_last() {
+    Header header;
+    this->read_header(header);
+
+    // scan backwards up to the end of the header
+    std::string_view line;
+    const char* header_end = this->cur;
+    const char* p = this->end;
+    const char* block = nullptr;
+    bool has_energy = false;
+    double last_energy = 0.0;
+    while((block == nullptr || !has_energy) && previous_line(p, header_end, this->end, line)) {
+        const char first = first_character(line);
+        if(first == 'e' && !has_energy) {
+            has_energy = match_energy(line, last_energy);
+        } else if(first == 'P' && block == nullptr && match_keyword(line, "POSITION")) {
+            block = line.data();
+        }
+    }
+
+    if(block == nullptr) {
+        throw std::runtime_error("OUTCAR does not contain ionic images.");
+    }
+
+    // skip the POSITION line and the dashed line
+    this->cur = block;
+    read_line(this->cur, this->end);
+    if(!next_line(this->cur, this->end, line)) {
+        throw std::runtime_error("Unexpected end-of-file before final ionic coordinates.");
+    }
+
+    auto structure = this->parse_ionic_step(this->cur - this->begin, header, this->get_element_numbers(header));
+    if(structure->get_nr_atoms() != header.nr_atoms) {
+        throw std::runtime_error("Invalid or incomplete atomic position lines in final ionic structure.");
+    }
+
+    if(has_energy) {
+        structure->set_energy(last_energy);
+    }
+
+    return structure;
+}
+
+    /**
+     * @brief      Read the header from the start of the buffer
+     *
+     * Stops at the end of the header, i.e. once the ionic steps start.
+     *
+     * @param      header  The header
+     */
+void OutcarParser::read_header(Header& header) {
+    this->cur = this->begin;
+    std::string_view line;
+    while(header.readstate != OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS &&
+          next_line(this->cur, this->end, line)) {
+        const char first = first_character(line);
+        if(first != '\0' && !is_digit(first)) {
+            this->read_header_line(line, first, header);
+        }
+    }
+
+    if(header.readstate != OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS) {
+        throw std::runtime_error("OUTCAR does not contain ionic images.");
+    }
+}
+
+    /**
+     * @brief      Process a line of the header
+     *
+     * @param[in]  line    The line
+     * @param[in]  first   First non-blank character of the line
+     * @param      header  The header
+     */
+void OutcarParser::read_header_line(std::string_view line, char first, Header& header) {
+    switch(header.readstate) {
+        case OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS:
+            /*
+             * Collect the vasp version, the elements and the number of ions
+             * of each element type
+             */
+            if(first == 'v') {
+                unsigned int version[3];
+                if(match_vasp_version(line, version)) {
+                    header.vasp_version = version[0];
+                    qDebug() << "Detected VASP: " << version[0] << "." << version[1] << "." << version[2];
+                }
+            } else if(first == 'V') {
+                std::string_view element;
+                if(match_element(line, element)) {
+                    header.elements.emplace_back(element);
+                    qDebug() << "Captured element:" << QString(header.elements.back().c_str());
+                }
+            } else if(first == 'i') {
+                std::vector<unsigned int> counts;
+                if(match_ions_per_type(line, counts)) {
+                    for(unsigned int count : counts) {
+                        header.nr_atoms_per_elm.push_back(count);
+                        header.nr_atoms += count;
+                    }
+
+                    header.readstate = OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS;
+
+                    // check if a vasp version has been identified, if not, terminate
+                    if(!(header.vasp_version == 4 || header.vasp_version == 5 || header.vasp_version == 6)) {
+                        throw std::runtime_error("Invalid VASP version encountered: " + std::to_string(header.vasp_version));
+                    }
+                }
+            }
+        break;
+        case OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS:
+            /*
+             * Collect the dimensions of the unit cell. Note that if an IBRION=3 calculation is
+             * being run, this is not gathered by this class. It is assumed that each state
+             * has the same unit cell. (that means, IBRION != 3 calculations)
+             */
+            if(first == 'd' && match_keyword(line, "direct lattice vectors")) {
+                for(unsigned int i=0; i<3; i++) {
+                    double c[6];
+                    if(parse_six_columns(read_line(this->cur, this->end), c)) {
+                        header.unitcell(i,0) = c[0];
+                        header.unitcell(i,1) = c[1];
+                        header.unitcell(i,2) = c[2];
+                    }
+                }
+
+                header.readstate = OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS;
+            }
+        break;
+        default:
+        break;
+    }
+}
+
+    /**
+     * @brief      Get the atomic number of each ion type
+     *
+     * @param[in]  header  The header
+     *
+     * @return     The atomic numbers
+     */
+std::vector<unsigned int> OutcarParser::get_element_numbers(const Header& header) const {
+    if(header.elements.size() < header.nr_atoms_per_elm.size()) {
+        throw std::runtime_error("Number of elements does not match number of ion types in OUTCAR.");
+    }
+
+    std::vector<unsigned int> element_numbers;
+    for(unsigned int i=0; i<header.nr_atoms_per_elm.size(); i++) {
+        element_numbers.push_back(AtomSettings::get().get_atom_elnr(header.elements[i]));
+    }
+    return element_numbers;
+}
+
+    /**
+     * @brief      Parse the atomic positions and forces of a single ionic step
+     *
+     * @param[in]  offset           Offset of the first atom line in the buffer
+     * @param[in]  header           The header
+     * @param[in]  element_numbers  Atomic number of each ion type
+     *
+     * @return     The structure
+     */
+std::shared_ptr<Structure> OutcarParser::parse_ionic_step(size_t offset,
+                                                          const Header& header,
+                                                          const std::vector<unsigned int>& element_numbers) const {
+    const char* p = this->begin + offset;
+    auto structure = std::make_shared<Structure>(header.unitcell);
+
+    for(unsigned i=0; i<header.nr_atoms_per_elm.size(); i++) {
+        for(unsigned int j=0; j<header.nr_atoms_per_elm[i]; j++) {
+            double c[6];
+            if(parse_six_columns(read_line(p, this->end), c)) {
+                structure->add_atom(element_numbers[i], c[0], c[1], c[2], c[3], c[4], c[5]);
+            }
+        }
+    }
+
+    return structure;
+}
+
+    /**
+     * @brief      Calculate the root mean square force of a single ionic step
+     *
+     * Gives the same result as Structure::get_rms_force() on the structure
+     * obtained from parse_ionic_step().
+     *
+     * @param[in]  offset  Offset of the first atom line in the buffer
+     * @param[in]  header  The header
+     *
+     * @return     The root mean square force
+     */
+double OutcarParser::read_rms_force(size_t offset, const Header& header) const {
+    const char* p = this->begin + offset;
+    double sum = 0.0;
+    unsigned int nr_forces = 0;
+
+    for(unsigned i=0; i<header.nr_atoms_per_elm.size(); i++) {
+        for(unsigned int j=0; j<header.nr_atoms_per_elm[i]; j++) {
+            double c[6];
+            if(parse_six_columns(read_line(p, this->end), c)) {
+                sum += QVector3D(c[3], c[4], c[5]).lengthSquared();
+                nr_forces++;
+            }
+        }
+    }
+
+    return sum / (float)nr_forces;
+}
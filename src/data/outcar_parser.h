@@ -0,0 +1,269 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "atom_settings.h"
+#include "load_progress.h"
+#include "structure.h"
+
+class Trajectory;
+
+enum OutcarReadStatus {
+    VASP_OUTCAR_READ_STATE_UNDEFINED,
+    VASP_OUTCAR_READ_STATE_ELEMENTS,
+    VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT,
+    VASP_OUTCAR_READ_STATE_LATTICE_VECTORS,
+    VASP_OUTCAR_READ_STATE_ATOMS,
+    VASP_OUTCAR_READ_STATE_OPEN,
+    VASP_OUTCAR_READ_STATE_FINISHED
+};
+
+/**
+ * @brief      Parser for the contents of a VASP OUTCAR file
+ *
+ * Operates directly on a (typically memory-mapped) buffer. Lines are never
+ * copied; every line is dispatched on its first non-blank character to a
+ * hand-written matcher and numbers are converted using std::from_chars.
+ * The matchers accept exactly the lines accepted by the regular expressions
+ * this parser replaces.
+ *
+ * Parsing proceeds in two phases: a serial scan over the buffer reads the
+ * header, the energies and the eigenmodes and records the offset of every
+ * block of atomic positions, after which the ionic steps are parsed
+ * concurrently. Energies are matched to the ionic steps by their offsets.
+ */
+class OutcarParser {
+private:
+    /**
+     * @brief      Contents of the header of an OUTCAR file
+     */
+    struct Header {
+        OutcarReadStatus readstate = OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS;  // section being read
+        unsigned int vasp_version = 0;                          // major version of VASP
+        unsigned int nr_atoms = 0;                              // total number of atoms
+        MatrixUnitcell unitcell = MatrixUnitcell::Zero(3,3);    // lattice vectors (row-wise)
+        std::vector<std::string> elements;                      // element of each ion type
+        std::vector<unsigned int> nr_atoms_per_elm;             // number of atoms of each ion type
+    };
+
+    /**
+     * @brief      Eigenmode read from the buffer
+     */
+    struct ParsedEigenmode {
+        double eigenvalue = 0.0;
+        std::vector<QVector3D> eigenvectors;
+    };
+
+    static constexpr size_t PROGRESS_INTERVAL = 4 * 1024 * 1024;  // bytes scanned between progress reports
+    static constexpr size_t PROGRESS_BATCH_SIZE = 64;              // ionic steps parsed between progress reports
+
+    const char* begin;  // start of the buffer
+    const char* cur;    // start of the next line
+    const char* end;    // one past the last character of the buffer
+
+    LoadProgress* progress = nullptr;   // optional progress monitor
+
+    Header frame_header;                            // header used by parse_frame()
+    std::vector<unsigned int> frame_element_numbers;    // atomic numbers used by parse_frame()
+
+public:
+    /**
+     * @brief      Result of the scan over the buffer
+     */
+    struct Scan {
+        Header header;                              // the header
+        std::vector<size_t> block_offsets;          // offset of the first atom of each ionic step
+        std::vector<double> energies;               // energy of each ionic step
+        std::vector<ParsedEigenmode> eigenmodes;    // eigenmodes (frequency calculations only)
+    };
+
+    /**
+     * @brief      Constructs a new instance.
+     *
+     * @param[in]  data  The file contents (must outlive the parser)
+     * @param[in]  size  The number of bytes
+     */
+    OutcarParser(const char* data, size_t size);
+
+    /**
+     * @brief      Parse all ionic steps (and eigenmodes) from the buffer
+     *
+     * @return     Structures
+     */
+    std::vector<std::shared_ptr<Structure>> parse();
+
+    /**
+     * @brief      Parse the ionic steps (and eigenmodes) found by a scan
+     *
+     * Performs only the second phase of parse(). For frequency
+     * calculations, only the reference structure is parsed.
+     *
+     * @param[in]  scan  The scan of this buffer
+     *
+     * @return     Structures
+     */
+    std::vector<std::shared_ptr<Structure>> parse(const Scan& scan);
+
+    /**
+     * @brief      Index the ionic steps for a trajectory
+     *
+     * Performs the scan of parse(), after which only the forces of every
+     * ionic step are read to obtain its RMS force. The frames are added to
+     * the trajectory in batches; their locator is the offset of the block
+     * of atomic positions (see parse_frame()).
+     *
+     * @param      trajectory  The trajectory
+     * @param      scan        The scan (output), to be passed to parse()
+     *                         when no frames were indexed
+     *
+     * @return     False if the buffer holds eigenmodes (use parse() instead)
+     */
+    bool index(Trajectory& trajectory, Scan& scan);
+
+    /**
+     * @brief      Parse a single ionic step after index()
+     *
+     * Also available after read_frame_header(). May be called from any
+     * thread while index() is still running, for frames that have been
+     * added to the trajectory.
+     *
+     * @param[in]  offset  Locator of the frame given by index()
+     *
+     * @return     The structure (without energy)
+     */
+    std::shared_ptr<Structure> parse_frame(size_t offset) const;
+
+    /**
+     * @brief      Prepare parse_frame() for frames indexed earlier
+     *
+     * Replaces index() when the frames of the buffer are already known
+     * (e.g. from the structure cache); only the header is read.
+     */
+    void read_frame_header();
+
+    /**
+     * @brief      Monitor the progress of parse() and index()
+     *
+     * The buffer is traversed twice, hence the progress is reported as
+     * twice the size of the buffer. The monitor can stop the parser, in
+     * which case parse() and index() throw.
+     *
+     * @param      _progress  The progress monitor (must outlive the parser)
+     */
+    inline void set_progress(LoadProgress* _progress) {
+        this->progress = _progress;
+    }
+
+    /**
+     * @brief      Parse the final ionic step from the buffer
+     *
+     * The header is read from the start of the buffer, after which the
+     * buffer is scanned backwards from its end for the last block of atomic
+     * positions and the last energy. For a memory-mapped file, only the
+     * pages holding the header and the final ionic step are read.
+     *
+     * @return     Structure
+     */
+    std::shared_ptr<Structure> parse_last();
+
+private:
+    /**
+     * @brief      Gets the size of the buffer.
+     *
+     * @return     The number of bytes.
+     */
+    inline size_t size() const {
+        return this->end - this->begin;
+    }
+
+    /**
+     * @brief      Throw if the monitored load was cancelled
+     */
+    void check_cancelled() const;
+
+    /**
+     * @brief      Scan the buffer (phase one of parse())
+     *
+     * Reads the header, the energies and the eigenmodes and records the
+     * offset of every block of atomic positions.
+     *
+     * @param      scan  The result
+     */
+    void scan(Scan& scan);
+
+    /**
+     * @brief      Read the header from the start of the buffer
+     *
+     * Stops at the end of the header, i.e. once the ionic steps start.
+     *
+     * @param      header  The header
+     */
+    void read_header(Header& header);
+
+    /**
+     * @brief      Process a line of the header
+     *
+     * @param[in]  line    The line
+     * @param[in]  first   First non-blank character of the line
+     * @param      header  The header
+     */
+    void read_header_line(std::string_view line, char first, Header& header);
+
+    /**
+     * @brief      Get the atomic number of each ion type
+     *
+     * @param[in]  header  The header
+     *
+     * @return     The atomic numbers
+     */
+    std::vector<unsigned int> get_element_numbers(const Header& header) const;
+
+    /**
+     * @brief      Parse the atomic positions and forces of a single ionic step
+     *
+     * @param[in]  offset           Offset of the first atom line in the buffer
+     * @param[in]  header           The header
+     * @param[in]  element_numbers  Atomic number of each ion type
+     *
+     * @return     The structure
+     */
+    std::shared_ptr<Structure> parse_ionic_step(size_t offset,
+                                                const Header& header,
+                                                const std::vector<unsigned int>& element_numbers) const;
+
+    /**
+     * @brief      Calculate the root mean square force of a single ionic step
+     *
+     * Gives the same result as Structure::get_rms_force() on the structure
+     * obtained from parse_ionic_step().
+     *
+     * @param[in]  offset  Offset of the first atom line in the buffer
+     * @param[in]  header  The header
+     *
+     * @return     The root mean square force
+     */
+    double read_rms_force(size_t offset, const Header& header) const;
+};
@@ -0,0 +1,172 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#ifdef ATOM_ARCHITECT_PARALLEL
+#include <omp.h>
+#endif
+
+/**
+ * @brief      Helpers for data-parallel loops over atoms
+ *
+ * A range is always split into chunks of CHUNK_SIZE elements, irrespective
+ * of the number of threads, and partial results are combined in the order
+ * of the chunks. Reductions therefore give bitwise identical results for
+ * every thread count, including builds without ATOM_ARCHITECT_PARALLEL in
+ * which all chunks are processed serially.
+ */
+class Parallel {
+public:
+    static constexpr size_t CHUNK_SIZE = 4096;  // number of elements per chunk
+
+    /**
+     * @brief      Gets the number of threads used for parallel loops.
+     *
+     * @return     The number of threads.
+     */
+    static inline int get_nr_threads() {
+#ifdef ATOM_ARCHITECT_PARALLEL
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    /**
+     * @brief      Process a range in chunks
+     *
+     * @param[in]  n     Number of elements
+     * @param[in]  func  Function receiving the begin and end of a chunk
+     */
+    template<typename Func>
+    static void for_chunks(size_t n, Func&& func) {
+        const long long nr_chunks = (long long)Parallel::get_nr_chunks(n);
+
+#ifdef ATOM_ARCHITECT_PARALLEL
+        #pragma omp parallel for schedule(static) if(nr_chunks > 1)
+#endif
+        for(long long c=0; c<nr_chunks; c++) {
+            func((size_t)c * CHUNK_SIZE, std::min(n, (size_t)(c+1) * CHUNK_SIZE));
+        }
+    }
+
+    /**
+     * @brief      Process independent tasks
+     *
+     * Intended for coarse-grained work items (e.g. ionic steps or files)
+     * of varying cost; the tasks are handed out one at a time.
+     *
+     * @param[in]  n            Number of tasks
+     * @param[in]  func         Function receiving the index of a task
+     * @param[in]  max_threads  Upper bound on the number of threads (zero
+     *                          for no bound), e.g. to limit concurrent I/O
+     */
+    template<typename Func>
+    static void for_each(size_t n, Func&& func, int max_threads = 0) {
+#ifdef ATOM_ARCHITECT_PARALLEL
+        const int nr_threads = max_threads > 0 ? std::min(max_threads, Parallel::get_nr_threads())
+                                               : Parallel::get_nr_threads();
+        #pragma omp parallel for schedule(dynamic) num_threads(nr_threads) if(n > 1)
+#else
+        (void)max_threads;
+#endif
+        for(long long i=0; i<(long long)n; i++) {
+            func((size_t)i);
+        }
+    }
+
+    /**
+     * @brief      Reduce a range in chunks
+     *
+     * @param[in]  n        Number of elements
+     * @param[in]  init     Initial value of the reduction
+     * @param[in]  func     Function receiving the begin and end of a chunk and
+     *                      returning the partial result of that chunk
+     * @param[in]  combine  Function combining two partial results; the
+     *                      result of the earlier chunk is the first argument
+     *
+     * @return     The reduction.
+     */
+    template<typename T, typename Func, typename Combine>
+    static T reduce(size_t n, T init, Func&& func, Combine&& combine) {
+        std::vector<T> partial(Parallel::get_nr_chunks(n), init);
+        Parallel::for_chunks(n, [&](size_t begin, size_t end) {
+            partial[begin / CHUNK_SIZE] = func(begin, end);
+        });
+
+        T result = init;
+        for(const T& p : partial) {
+            result = combine(result, p);
+        }
+        return result;
+    }
+
+    /**
+     * @brief      Collect the output of a range in chunks
+     *
+     * The output of the chunks is concatenated in order, hence the result
+     * is identical to that of a serial loop.
+     *
+     * @param[in]  n     Number of elements
+     * @param[in]  func  Function receiving the begin and end of a chunk and
+     *                   a vector to append its output to
+     *
+     * @return     The concatenated output.
+     */
+    template<typename T, typename Func>
+    static std::vector<T> gather(size_t n, Func&& func) {
+        std::vector<std::vector<T>> partial(Parallel::get_nr_chunks(n));
+        Parallel::for_chunks(n, [&](size_t begin, size_t end) {
+            func(begin, end, partial[begin / CHUNK_SIZE]);
+        });
+
+        if(partial.size() == 1) {
+            return std::move(partial.front());
+        }
+
+        size_t total = 0;
+        for(const auto& p : partial) {
+            total += p.size();
+        }
+
+        std::vector<T> result;
+        result.reserve(total);
+        for(const auto& p : partial) {
+            result.insert(result.end(), p.begin(), p.end());
+        }
+        return result;
+    }
+
+private:
+    /**
+     * @brief      Gets the number of chunks for a range.
+     *
+     * @param[in]  n     Number of elements
+     *
+     * @return     The number of chunks.
+     */
+    static inline size_t get_nr_chunks(size_t n) {
+        return (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    }
+};
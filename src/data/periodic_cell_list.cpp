@@ -0,0 +1,148 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "periodic_cell_list.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief      Constructs a new instance.
+ */
+PeriodicCellList::PeriodicCellList() :
+unitcell(MatrixUnitcell::Identity()),
+inverse(MatrixUnitcell::Identity()) {
+
+}
+
+    /**
+     * @brief      Check whether a unit cell can be used for periodic searches
+     *
+     * @param[in]  unitcell  The unitcell
+     *
+     * @return     True if the unit cell has a non-vanishing volume
+     */
+bool PeriodicCellList::is_valid_unitcell(const MatrixUnitcell& unitcell) {
+    return std::fabs(unitcell.determinant()) > 1e-6;
+}
+
+    /**
+     * @brief      Sort atoms into the periodic grid
+     *
+     * @param[in]  atoms     The atoms
+     * @param[in]  unitcell  The unitcell
+     * @param[in]  radius    Search radius
+     */
+void PeriodicCellList::build(const std::vector<Atom>& atoms, const MatrixUnitcell& _unitcell, double radius) {
+    this->clear();
+
+    if(atoms.empty() || !PeriodicCellList::is_valid_unitcell(_unitcell)) {
+        return;
+    }
+
+    this->unitcell = _unitcell;
+    this->inverse = this->unitcell.transpose().inverse();
+    radius = std::max(radius, 1e-3);
+
+    // the perpendicular width of the cell along lattice vector i is given
+    // by the volume divided by the area of the face spanned by j and k;
+    // for cells narrower than the search radius, scan multiple images
+    const double volume = std::fabs(this->unitcell.determinant());
+    for(unsigned int i=0; i<3; i++) {
+        const VectorPosition b = this->unitcell.row((i+1) % 3).transpose();
+        const VectorPosition c = this->unitcell.row((i+2) % 3).transpose();
+        const double width = volume / b.cross(c).norm();
+
+        this->nrbins[i] = std::clamp((int)std::floor(width / radius), 1, 1024);
+        const double binwidth = width / (double)this->nrbins[i];
+        this->range[i] = std::max(1, (int)std::ceil(radius / binwidth - 1e-9));
+    }
+
+    // keep the number of bins proportional to the number of atoms
+    const size_t maxbins = std::max<size_t>(64, 4 * atoms.size());
+    while((size_t)this->nrbins[0] * this->nrbins[1] * this->nrbins[2] > maxbins) {
+        const int i = (int)(std::max_element(this->nrbins.begin(), this->nrbins.end()) - this->nrbins.begin());
+        this->nrbins[i] = std::max(1, this->nrbins[i] / 2);
+        this->range[i] = 1;
+    }
+
+    // counting sort of the atoms over the bins
+    const size_t nrtotal = (size_t)this->nrbins[0] * this->nrbins[1] * this->nrbins[2];
+    this->bin_start.assign(nrtotal + 1, 0);
+    this->atom_bin.resize(atoms.size());
+    this->atom_shift.resize(atoms.size());
+    for(unsigned int i=0; i<atoms.size(); i++) {
+        std::array<int, 3> bin;
+        this->locate(atoms[i].x, atoms[i].y, atoms[i].z, bin, this->atom_shift[i]);
+        this->atom_bin[i] = (bin[2] * this->nrbins[1] + bin[1]) * this->nrbins[0] + bin[0];
+        this->bin_start[this->atom_bin[i] + 1]++;
+    }
+
+    for(size_t i=0; i<nrtotal; i++) {
+        this->bin_start[i+1] += this->bin_start[i];
+    }
+
+    this->bin_atoms.resize(atoms.size());
+    std::vector<unsigned int> fill(this->bin_start.begin(), this->bin_start.end() - 1);
+    for(unsigned int i=0; i<atoms.size(); i++) {
+        this->bin_atoms[fill[this->atom_bin[i]]++] = i;
+    }
+}
+
+    /**
+     * @brief      Remove all atoms from the grid
+     */
+void PeriodicCellList::clear() {
+    this->bin_start.clear();
+    this->bin_atoms.clear();
+    this->atom_bin.clear();
+    this->atom_shift.clear();
+    this->nrbins = {1, 1, 1};
+    this->range = {1, 1, 1};
+}
+
+    /**
+     * @brief      Cartesian translation corresponding to a lattice image
+     *
+     * @param[in]  image  The image (in units of the lattice vectors)
+     *
+     * @return     The translation vector.
+     */
+VectorPosition PeriodicCellList::get_image_translation(const std::array<int, 3>& image) const {
+    return this->unitcell.transpose() * VectorPosition(image[0], image[1], image[2]);
+}
+
+    /**
+     * @brief      Find the bin of a point and the translation wrapping it into the cell
+     *
+     * @param[in]  x      x coordinate
+     * @param[in]  y      y coordinate
+     * @param[in]  z      z coordinate
+     * @param      bin    The bin coordinates
+     * @param      shift  The lattice translation
+     */
+void PeriodicCellList::locate(double x, double y, double z, std::array<int, 3>& bin, std::array<int, 3>& shift) const {
+    const VectorPosition direct = this->inverse * VectorPosition(x, y, z);
+    for(unsigned int i=0; i<3; i++) {
+        const double s = std::floor(direct[i]);
+        shift[i] = (int)s;
+        bin[i] = std::clamp((int)((direct[i] - s) * this->nrbins[i]), 0, this->nrbins[i] - 1);
+    }
+}
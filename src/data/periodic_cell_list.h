@@ -0,0 +1,204 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "atom.h"
+#include "matrixmath.h"
+
+/**
+ * @brief      Cell list for fixed-radius neighbour searches in a periodic,
+ *             possibly triclinic, unit cell
+ *
+ * Atoms are binned on their fractional coordinates. The number of bins
+ * along each lattice vector is chosen such that the perpendicular width of
+ * a bin is at least the search radius; neighbours are then found in the
+ * adjacent bins, wrapping around the cell faces. Every candidate is reported
+ * together with the lattice translation (image) that has to be applied to
+ * it, hence no periodic copies of the atoms are ever created.
+ */
+class PeriodicCellList {
+private:
+    MatrixUnitcell unitcell;                // lattice vectors (row-wise)
+    MatrixUnitcell inverse;                 // inverse of the transposed unit cell
+    std::array<int, 3> nrbins = {1, 1, 1};  // number of bins per lattice vector
+    std::array<int, 3> range = {1, 1, 1};   // number of neighbouring bins to scan
+
+    std::vector<unsigned int> bin_start;    // offsets into bin_atoms per bin (size: nr bins + 1)
+    std::vector<unsigned int> bin_atoms;    // atom indices sorted by bin
+    std::vector<unsigned int> atom_bin;     // bin index for each atom
+    std::vector<std::array<int, 3>> atom_shift; // lattice translation that wraps each atom into the cell
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    PeriodicCellList();
+
+    /**
+     * @brief      Check whether a unit cell can be used for periodic searches
+     *
+     * @param[in]  unitcell  The unitcell
+     *
+     * @return     True if the unit cell has a non-vanishing volume
+     */
+    static bool is_valid_unitcell(const MatrixUnitcell& unitcell);
+
+    /**
+     * @brief      Sort atoms into the periodic grid
+     *
+     * @param[in]  atoms     The atoms
+     * @param[in]  unitcell  The unitcell
+     * @param[in]  radius    Search radius
+     */
+    void build(const std::vector<Atom>& atoms, const MatrixUnitcell& unitcell, double radius);
+
+    /**
+     * @brief      Remove all atoms from the grid
+     */
+    void clear();
+
+    /**
+     * @brief      Gets the number of atoms stored in the grid.
+     *
+     * @return     The number of atoms.
+     */
+    inline size_t get_nr_atoms() const {
+        return this->atom_bin.size();
+    }
+
+    /**
+     * @brief      Cartesian translation corresponding to a lattice image
+     *
+     * @param[in]  image  The image (in units of the lattice vectors)
+     *
+     * @return     The translation vector.
+     */
+    VectorPosition get_image_translation(const std::array<int, 3>& image) const;
+
+    /**
+     * @brief      Loop over all periodic images of atoms around a point
+     *
+     * The callback receives the atom index and the lattice image that must be
+     * added to the stored position of that atom; the caller is responsible
+     * for the exact distance test.
+     *
+     * @param[in]  x     x coordinate
+     * @param[in]  y     y coordinate
+     * @param[in]  z     z coordinate
+     * @param[in]  func  Callback receiving the atom index and image
+     */
+    template<typename Func>
+    void for_each_candidate(double x, double y, double z, Func&& func) const {
+        if(this->atom_bin.empty()) {
+            return;
+        }
+
+        std::array<int, 3> bin;
+        std::array<int, 3> shift;
+        this->locate(x, y, z, bin, shift);
+        this->for_each_candidate_in_bin(bin, shift, func);
+    }
+
+    /**
+     * @brief      Loop over all periodic images of atoms around an atom in the grid
+     *
+     * @param[in]  idx   Atom index
+     * @param[in]  func  Callback receiving the atom index and image (includes
+     *                   idx itself with a zero image)
+     */
+    template<typename Func>
+    void for_each_candidate(unsigned int idx, Func&& func) const {
+        const unsigned int b = this->atom_bin[idx];
+        const std::array<int, 3> bin = {
+            (int)(b % this->nrbins[0]),
+            (int)((b / this->nrbins[0]) % this->nrbins[1]),
+            (int)(b / (this->nrbins[0] * this->nrbins[1]))
+        };
+        this->for_each_candidate_in_bin(bin, this->atom_shift[idx], func);
+    }
+
+private:
+    /**
+     * @brief      Find the bin of a point and the translation wrapping it into the cell
+     *
+     * @param[in]  x      x coordinate
+     * @param[in]  y      y coordinate
+     * @param[in]  z      z coordinate
+     * @param      bin    The bin coordinates
+     * @param      shift  The lattice translation
+     */
+    void locate(double x, double y, double z, std::array<int, 3>& bin, std::array<int, 3>& shift) const;
+
+    /**
+     * @brief      Floor division of a bin coordinate
+     *
+     * @param[in]  a     Bin coordinate (may lie outside the grid)
+     * @param[in]  n     Number of bins
+     *
+     * @return     Number of cell translations
+     */
+    static inline int floor_div(int a, int n) {
+        return (a >= 0) ? a / n : -((-a + n - 1) / n);
+    }
+
+    /**
+     * @brief      Loop over atoms in the bins surrounding a bin
+     *
+     * @param[in]  bin    Bin coordinates of the query point
+     * @param[in]  shift  Lattice translation that wrapped the query point
+     * @param[in]  func   Callback receiving the atom index and image
+     */
+    template<typename Func>
+    void for_each_candidate_in_bin(const std::array<int, 3>& bin, const std::array<int, 3>& shift, Func& func) const {
+        for(int dz=-this->range[2]; dz<=this->range[2]; dz++) {
+            const int cz = bin[2] + dz;
+            const int sz = floor_div(cz, this->nrbins[2]);
+            const int bz = cz - sz * this->nrbins[2];
+            for(int dy=-this->range[1]; dy<=this->range[1]; dy++) {
+                const int cy = bin[1] + dy;
+                const int sy = floor_div(cy, this->nrbins[1]);
+                const int by = cy - sy * this->nrbins[1];
+                for(int dx=-this->range[0]; dx<=this->range[0]; dx++) {
+                    const int cx = bin[0] + dx;
+                    const int sx = floor_div(cx, this->nrbins[0]);
+                    const int bx = cx - sx * this->nrbins[0];
+
+                    const unsigned int b = (bz * this->nrbins[1] + by) * this->nrbins[0] + bx;
+                    for(unsigned int k=this->bin_start[b]; k<this->bin_start[b+1]; k++) {
+                        const unsigned int j = this->bin_atoms[k];
+                        const auto& sj = this->atom_shift[j];
+
+                        // image relative to the stored (unwrapped) coordinates
+                        const std::array<int, 3> image = {
+                            sx - sj[0] + shift[0],
+                            sy - sj[1] + shift[1],
+                            sz - sj[2] + shift[2]
+                        };
+                        func(j, image);
+                    }
+                }
+            }
+        }
+    }
+};
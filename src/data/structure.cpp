@@ -22,7 +22,39 @@
 #include <algorithm>
 #include <unordered_set>
 
+#include "parallel.h"
+
 bool Structure::debug_logging_enabled = true;
+std::atomic<uint64_t> Structure::generation_counter{0};
+
+namespace {
+/**
+ * @brief      Whether a pair of atoms (with a lattice image) should be considered
+ *
+ * Every periodic pair is encountered twice, as (i, j, image) and as
+ * (j, i, -image); only one of these is accepted, as is a self-pair with
+ * its own image.
+ *
+ * @param[in]  i      First atom index
+ * @param[in]  j      Second atom index
+ * @param[in]  image  Lattice image of the second atom
+ *
+ * @return     True if the pair is unique
+ */
+inline bool is_unique_pair(unsigned int i, unsigned int j, const std::array<int, 3>& image) {
+    if(i != j) {
+        return i < j;
+    }
+
+    for(unsigned int k=0; k<3; k++) {
+        if(image[k] != 0) {
+            return image[k] > 0;
+        }
+    }
+
+    return false;
+}
+}
 
 /**
  * @brief      Constructs a new instance.
@@ -37,6 +69,7 @@ unitcell(_unitcell) {
      */
 Structure::Structure(const Fragment& fragment) {
     this->unitcell = MatrixUnitcell::Identity() * 5.0f;
+    this->periodic = false;     // the box only serves as a frame for the fragment
     this->atoms = fragment.atoms;
     this->center();
     this->construct_bonds();
@@ -47,7 +80,8 @@ Structure::Structure(const Fragment& fragment) {
      */
 Structure::Structure(unsigned int elnr) {
     this->unitcell = MatrixUnitcell::Identity() * 2.5f;
-    this->atoms.emplace_back(elnr, 0.0, 0.0, 0.0);
+    this->periodic = false;
+    this->atoms.write().emplace_back(elnr, 0.0, 0.0, 0.0);
     this->center();
 }
 
@@ -76,7 +110,7 @@ void Structure::add_eigenmode(double eigenvalue, const std::vector<QVector3D>& e
         throw std::runtime_error("Eigenmode vector size does not match number of atoms.");
     }
 
-    this->eigenmodes.push_back({eigenvalue, eigenvectors});
+    this->eigenmodes.write().push_back({eigenvalue, eigenvectors});
 }
 
     /**
@@ -88,9 +122,10 @@ void Structure::add_eigenmode(double eigenvalue, const std::vector<QVector3D>& e
      * @param[in]  z     z coordinate
      */
 void Structure::add_atom(unsigned int atnr, double x, double y, double z) {
-    this->atoms.emplace_back(atnr, x, y, z);
+    this->atoms.write().emplace_back(atnr, x, y, z);
     this->transpose_atom(this->atoms.size() - 1, QMatrix4x4());
-    this->radii.push_back(AtomSettings::get().get_atom_radius(AtomSettings::get().get_name_from_elnr(atnr)));
+    this->radii.write().push_back(AtomSettings::get().get_atom_radius_from_elnr(atnr));
+    this->mark_geometry_changed();
 }
 
     /**
@@ -106,7 +141,7 @@ void Structure::add_atom(unsigned int atnr, double x, double y, double z) {
      */
 void Structure::add_atom(unsigned int atnr, double x, double y, double z, double fx, double fy, double fz) {
     this->add_atom(atnr, x, y, z);
-    this->forces.push_back(QVector3D(fx, fy, fz));
+    this->forces.write().push_back(QVector3D(fx, fy, fz));
 }
 
     /**
@@ -122,7 +157,8 @@ void Structure::add_atom(unsigned int atnr, double x, double y, double z, double
      */
 void Structure::add_atom(unsigned int atnr, double x, double y, double z, bool sx, bool sy, bool sz) {
     this->add_atom(atnr, x, y, z);
-    this->atoms.back().selective_dynamics = {sx, sy, sz};
+    this->atoms.write().back().selective_dynamics = {sx, sy, sz};
+    this->mark_selection_changed();
 }
 
     /**
@@ -133,18 +169,21 @@ void Structure::delete_atoms() {
 
     // check if forces are known
     if(this->forces.size() == this->atoms.size()) {
+        auto& forces = this->forces.write();
         for(unsigned int idx : this->primary_buffer) {
             if(idx < this->get_nr_atoms()) {
-                this->forces.erase(this->forces.begin() + idx);
+                forces.erase(forces.begin() + idx);
             }
         }
     }
 
+    auto& atoms = this->atoms.write();
     for(unsigned int idx : this->primary_buffer) {
-        if(idx < this->get_nr_atoms()) {
-            this->atoms.erase(this->atoms.begin() + idx);
+        if(idx < atoms.size()) {
+            atoms.erase(atoms.begin() + idx);
         }
     }
+    this->mark_geometry_changed();
 
     // update contents
     this->update();
@@ -160,15 +199,34 @@ void Structure::commit_transposition(const QMatrix4x4& transposition) {
     moved_indices.reserve(this->primary_buffer.size());
     for(unsigned int idx : this->primary_buffer) {
         if(idx < this->get_nr_atoms()) {
-            this->transpose_atom(idx, transposition);
             moved_indices.push_back(idx);
         }
     }
 
+    // transform the moved atoms and place them back inside the unit cell
+    // in a single pass
+    std::vector<double> px(moved_indices.size());
+    std::vector<double> py(moved_indices.size());
+    std::vector<double> pz(moved_indices.size());
+    for(unsigned int k=0; k<moved_indices.size(); k++) {
+        const QVector3D newpos = transposition.map(this->atoms[moved_indices[k]].get_pos_qtvec());
+        px[k] = newpos[0];
+        py[k] = newpos[1];
+        pz[k] = newpos[2];
+    }
+    AtomArrays::wrap_positions(px.data(), py.data(), pz.data(), moved_indices.size(), this->unitcell);
+    for(unsigned int k=0; k<moved_indices.size(); k++) {
+        Atom& atom = this->atoms.write()[moved_indices[k]];
+        atom.x = px[k];
+        atom.y = py[k];
+        atom.z = pz[k];
+    }
+
+    this->preview_mask.clear();
+
     // update contents
     if(!moved_indices.empty()) {
-        this->update_bonds_for_atoms(moved_indices, nullptr);
-        this->build_expansion();
+        this->update_moved_atoms(moved_indices);
     }
 }
 
@@ -191,6 +249,12 @@ void Structure::preview_bonds_for_transposition(const QMatrix4x4& transposition)
     }
 
     if(!moved_indices.empty()) {
+        this->preview_transposition = transposition;
+        this->preview_mask.assign(this->atoms.size(), false);
+        for(unsigned int idx : moved_indices) {
+            this->preview_mask[idx] = true;
+        }
+
         this->update_bonds_for_atoms(moved_indices, &transposition);
     }
 }
@@ -199,62 +263,238 @@ void Structure::preview_bonds_for_transposition(const QMatrix4x4& transposition)
      * @brief      Center the structure at the origin
      */
 void Structure::center() {
-    double sumx = 0.0;
-    double sumy = 0.0;
-    double sumz = 0.0;
+    if(this->atoms.empty()) {
+        return;
+    }
+
+    // sum the double precision coordinates; the single precision atom
+    // arrays would shift the structure by their rounding error
+    const std::vector<Atom>& src = this->atoms.get();
+    const VectorPosition sum = Parallel::reduce(src.size(), VectorPosition(VectorPosition::Zero()),
+        [&src](size_t begin, size_t end) {
+            VectorPosition s = VectorPosition::Zero();
+            for(size_t i=begin; i<end; i++) {
+                s += VectorPosition(src[i].x, src[i].y, src[i].z);
+            }
+            return s;
+        },
+        [](const VectorPosition& a, const VectorPosition& b) {
+            return VectorPosition(a + b);
+        });
+    const double n = (double)this->atoms.size();
+    const auto cv = get_center_vector();
+    const double dx = sum[0] / n + cv[0];
+    const double dy = sum[1] / n + cv[1];
+    const double dz = sum[2] / n + cv[2];
+
+    auto& atoms = this->atoms.write();
+    Parallel::for_chunks(atoms.size(), [&](size_t begin, size_t end) {
+        for(size_t i=begin; i<end; i++) {
+            atoms[i].x -= dx;
+            atoms[i].y -= dy;
+            atoms[i].z -= dz;
+        }
+    });
+
+    this->mark_geometry_changed();
+}
 
-    #pragma omp parallel for reduction(+: sumx)
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        sumx += this->atoms[i].x;
+    /**
+     * @brief      Get the largest distance from the origin
+     *
+     * @return     The largest distance.
+     */
+QVector3D Structure::get_largest_distance() const {
+    if(this->atoms.empty()) {
+        return QVector3D(0.0, 0.0, 0.0);
     }
 
-    #pragma omp parallel for reduction(+: sumy)
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        sumy += this->atoms[i].y;
+    return this->atoms[this->get_atom_arrays().find_furthest_from_origin()].get_pos_qtvec();
+}
+
+    /**
+     * @brief      Get the atoms as contiguous arrays
+     *
+     * @return     The atom arrays.
+     */
+const AtomArrays& Structure::get_atom_arrays() const {
+    this->refresh_atom_arrays();
+    return *this->atom_arrays;
+}
+
+    /**
+     * @brief      Get the instances of the atoms for drawing
+     *
+     * Rebuilt when the atoms, the cell or the selection have changed; the
+     * instances are shared such that the renderer can keep them.
+     *
+     * @return     The atom instances.
+     */
+std::shared_ptr<const AtomInstances> Structure::get_atom_instances() const {
+    const Generations& built = this->atom_instances_generations;
+    if(!this->atom_instances ||
+       built.geometry != this->generations.geometry ||
+       built.cell != this->generations.cell ||
+       built.selection != this->generations.selection) {
+        auto instances = std::make_shared<AtomInstances>();
+        instances->build(*this, this->atom_instances.get());
+        this->atom_instances = instances;
+        this->atom_instances_generations = this->generations;
     }
 
-    #pragma omp parallel for reduction(+: sumz)
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        sumz += this->atoms[i].z;
+    return this->atom_instances;
+}
+
+    /**
+     * @brief      Get the instances of the bonds for drawing
+     *
+     * Rebuilt when the atoms, the bonds, the cell or the selection have
+     * changed; the instances are shared such that the renderer can keep
+     * them.
+     *
+     * @return     The bond instances.
+     */
+std::shared_ptr<const BondInstances> Structure::get_bond_instances() const {
+    const Generations& built = this->bond_instances_generations;
+    if(!this->bond_instances ||
+       built.geometry != this->generations.geometry ||
+       built.topology != this->generations.topology ||
+       built.cell != this->generations.cell ||
+       built.selection != this->generations.selection) {
+        auto instances = std::make_shared<BondInstances>();
+        instances->build(*this, this->bond_instances.get());
+        this->bond_instances = instances;
+        this->bond_instances_generations = this->generations;
     }
 
-    sumx /= (float)this->atoms.size();
-    sumy /= (float)this->atoms.size();
-    sumz /= (float)this->atoms.size();
+    return this->bond_instances;
+}
 
-    auto cv = get_center_vector();
+    /**
+     * @brief      Get the lattice translation of a periodic image
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The translation.
+     */
+VectorPosition Structure::get_image_translation(unsigned int image) const {
+    return this->unitcell.transpose() * Structure::get_image_coefficients(image);
+}
+
+    /**
+     * @brief      Get the lattice coefficients of a periodic image
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The coefficients, each -1, 0 or 1.
+     */
+VectorPosition Structure::get_image_coefficients(unsigned int image) {
+    // index over all 27 cells, skipping the central one
+    const unsigned int cell = image < Structure::NR_IMAGES / 2 ? image : image + 1;
+    return VectorPosition((int)(cell % 3) - 1, (int)((cell / 3) % 3) - 1, (int)(cell / 9) - 1);
+}
 
-    #pragma omp parallel for
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        this->atoms[i].x -= sumx + cv[0];
-        this->atoms[i].y -= sumy + cv[1];
-        this->atoms[i].z -= sumz + cv[2];
+    /**
+     * @brief      Get the atomtype of the atoms in a periodic image
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The ATOM_EXPANSION_XY and ATOM_EXPANSION_Z bits.
+     */
+unsigned int Structure::get_image_atomtype(unsigned int image) {
+    const unsigned int cell = image < Structure::NR_IMAGES / 2 ? image : image + 1;
+
+    unsigned int atomtype = 0;
+    if(cell / 9 != 1) {
+        atomtype |= (1 << ATOM_EXPANSION_Z);
+    }
+    if(cell % 9 != 4) {
+        atomtype |= (1 << ATOM_EXPANSION_XY);
     }
+
+    return atomtype;
 }
 
     /**
-     * @brief      Get the largest distance from the origin
+     * @brief      Get the position of an atom in the unit cell or in a
+     *             periodic image
      *
-     * @return     The largest distance.
+     * @param[in]  idx   The index (see get_image_translation())
+     *
+     * @return     The position.
      */
-QVector3D Structure::get_largest_distance() const {
-    unsigned int idx = 0;
-    float dist = -1.0f;
-
-    #pragma omp parallel for
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        float vdist = this->atoms[i].get_pos_qtvec().lengthSquared();
-
-        if(vdist > dist) {
-            #pragma omp critical
-            {
-                dist = vdist;
-                idx = i;
-            }
-        }
+QVector3D Structure::get_atom_position(unsigned int idx) const {
+    const unsigned int n = this->get_nr_atoms();
+    if(idx < n) {
+        return this->atoms[idx].get_pos_qtvec();
     }
 
-    return this->atoms[idx].get_pos_qtvec();
+    const unsigned int image = idx / n - 1;
+    if(image >= Structure::NR_IMAGES) {
+        throw std::out_of_range("Atom index exceeds the periodic images.");
+    }
+
+    const VectorPosition dp = this->get_image_translation(image);
+    return this->atoms[idx % n].get_pos_qtvec() + QVector3D((float)dp[0], (float)dp[1], (float)dp[2]);
+}
+
+    /**
+     * @brief      Get the geometry of a bond from the current atom positions
+     *
+     * @param[in]  idx   The bond index
+     *
+     * @return     The bond geometry.
+     */
+BondGeometry Structure::get_bond_geometry(unsigned int idx) const {
+    const Bond& bond = this->bonds[idx];
+    QVector3D translation(0.0, 0.0, 0.0);
+    if(bond.is_periodic()) {
+        const VectorPosition t = this->unitcell.transpose() * VectorPosition(bond.image[0], bond.image[1], bond.image[2]);
+        translation = QVector3D(t[0], t[1], t[2]);
+    }
+
+    return Bond::calculate_geometry(this->get_preview_position(bond.atom1_idx),
+                                    this->get_preview_position(bond.atom2_idx),
+                                    translation);
+}
+
+    /**
+     * @brief      Get the bond adjacency of the atoms
+     *
+     * @return     The bond graph.
+     */
+const BondGraph& Structure::get_bond_graph() const {
+    if(!this->bond_graph || this->bond_graph_topology != this->generations.topology) {
+        auto graph = std::make_shared<BondGraph>();
+        graph->build(this->atoms.size(), this->bonds.get());
+        this->bond_graph = graph;
+        this->bond_graph_topology = this->generations.topology;
+    }
+
+    return *this->bond_graph;
+}
+
+    /**
+     * @brief      Gets the memory used by the derived atom arrays, bond graph
+     *             and instances, counting only those that have been built.
+     *
+     * @return     The memory usage in bytes.
+     */
+size_t Structure::get_derived_memory_usage() const {
+    size_t usage = 0;
+    if(this->atom_arrays) {
+        usage += this->atom_arrays->get_memory_usage();
+    }
+    if(this->bond_graph) {
+        usage += this->bond_graph->get_memory_usage();
+    }
+    if(this->atom_instances) {
+        usage += this->atom_instances->get_memory_usage();
+    }
+    if(this->bond_instances) {
+        usage += this->bond_instances->get_memory_usage();
+    }
+    return usage;
 }
 
     /**
@@ -263,6 +503,8 @@ QVector3D Structure::get_largest_distance() const {
      * @return     String holding comma seperated list of elements
      */
 std::string Structure::get_elements_string() const {
+    this->count_elements();
+
     std::string result;
 
     for(const auto& item : this->element_types) {
@@ -292,9 +534,15 @@ QVector3D Structure::get_center_vector() const {
      * @brief      Update data based on contents;
      */
 void Structure::update() {
-    this->count_elements();
-    this->construct_bonds();
-    this->build_expansion();
+    // bonds of previewed atoms do not match the stored positions
+    const bool previewed = !this->preview_mask.empty();
+    this->preview_mask.clear();
+
+    if(previewed ||
+       this->bonds_geometry != this->generations.geometry ||
+       this->bonds_cell != this->generations.cell) {
+        this->construct_bonds();
+    }
 }
 
     /**
@@ -305,11 +553,17 @@ void Structure::update() {
 void Structure::select_atom(unsigned int idx) {
     unsigned int select = 0;
     if(idx < this->get_nr_atoms()) {
-        this->atoms[idx].select_atom();
-        select = this->atoms[idx].select;
+        Atom& atom = this->atoms.write()[idx];
+        atom.select_atom();
+        select = atom.select;
     } else {
-        this->atoms_expansion[idx - this->get_nr_atoms()].select_atom();
-        select = this->atoms_expansion[idx - this->get_nr_atoms()].select;
+        // atoms in the periodic images only exist through their selection
+        select = (this->image_selection[idx] + 1) % 3;
+        if(select == 0) {
+            this->image_selection.erase(idx);
+        } else {
+            this->image_selection[idx] = select;
+        }
     }
 
     if(select == 1) {   // add to first buffer
@@ -320,6 +574,8 @@ void Structure::select_atom(unsigned int idx) {
     } else { // remove from second buffer
         this->secondary_buffer.erase(std::remove(this->secondary_buffer.begin(), this->secondary_buffer.end(), idx), this->secondary_buffer.end());
     }
+
+    this->mark_selection_changed();
 }
 
     /**
@@ -334,11 +590,7 @@ QVector3D Structure::get_position_primary_buffer() const {
 
     QVector3D ctr(0.0, 0.0, 0.0);
     for(unsigned int idx : this->primary_buffer) {
-        if(idx >= this->get_nr_atoms()) {
-            ctr += this->atoms_expansion[idx - this->get_nr_atoms()].get_pos_qtvec();
-        } else {
-            ctr += this->atoms[idx].get_pos_qtvec();
-        }
+        ctr += this->get_atom_position(idx);
     }
     ctr /= (float)this->primary_buffer.size();
 
@@ -357,11 +609,7 @@ QVector3D Structure::get_position_secondary_buffer() const {
 
     QVector3D ctr(0.0, 0.0, 0.0);
     for(unsigned int idx : this->secondary_buffer) {
-        if(idx >= this->get_nr_atoms()) {
-            ctr += this->atoms_expansion[idx - this->get_nr_atoms()].get_pos_qtvec();
-        } else {
-            ctr += this->atoms[idx].get_pos_qtvec();
-        }
+        ctr += this->get_atom_position(idx);
     }
     ctr /= (float)this->secondary_buffer.size();
 
@@ -372,24 +620,27 @@ QVector3D Structure::get_position_secondary_buffer() const {
      * @brief      Clear the selection_buffers
      */
 void Structure::clear_selection() {
+    // avoid detaching shared atoms if nothing is selected
+    if(this->primary_buffer.empty() && this->secondary_buffer.empty()) {
+        return;
+    }
+
     for(unsigned int idx : this->primary_buffer) {
-        if(idx >= this->get_nr_atoms()) {
-            this->atoms_expansion[idx - this->get_nr_atoms()].select = 0;
-        } else {
-            this->atoms[idx].select = 0;
+        if(idx < this->get_nr_atoms()) {
+            this->atoms.write()[idx].select = 0;
         }
     }
 
     for(unsigned int idx : this->secondary_buffer) {
-        if(idx >= this->get_nr_atoms()) {
-            this->atoms_expansion[idx - this->get_nr_atoms()].select = 0;
-        } else {
-            this->atoms[idx].select = 0;
+        if(idx < this->get_nr_atoms()) {
+            this->atoms.write()[idx].select = 0;
         }
     }
 
+    this->image_selection.clear();
     this->primary_buffer.clear();
     this->secondary_buffer.clear();
+    this->mark_selection_changed();
 }
 
     /**
@@ -400,10 +651,12 @@ void Structure::select_all_atoms() {
     this->clear_selection();
 
     // fill primary buffer with all atoms in the unit cell
-    for(unsigned int i=0; i<this->get_nr_atoms(); i++) {
-        this->atoms[i].select_atom();
+    auto& atoms = this->atoms.write();
+    for(unsigned int i=0; i<atoms.size(); i++) {
+        atoms[i].select_atom();
         this->primary_buffer.push_back(i);
     }
+    this->mark_selection_changed();
 }
 
     /**
@@ -416,9 +669,10 @@ void Structure::invert_selection() {
     this->select_all_atoms();
 
     for(unsigned int idx : list) {
-        this->atoms[idx].select = 0;
+        this->atoms.write()[idx].select = 0;
         this->primary_buffer.erase(std::remove(this->primary_buffer.begin(), this->primary_buffer.end(), idx), this->primary_buffer.end());
     }
+    this->mark_selection_changed();
 }
 
     /**
@@ -427,9 +681,10 @@ void Structure::invert_selection() {
 void Structure::set_frozen() {
     for(unsigned int idx : this->primary_buffer) {
         for(unsigned int j=0; j<3; j++) {
-            this->atoms[idx].selective_dynamics[j] = false;
+            this->atoms.write()[idx].selective_dynamics[j] = false;
         }
     }
+    this->mark_selection_changed();
 }
 
     /**
@@ -438,9 +693,10 @@ void Structure::set_frozen() {
 void Structure::set_unfrozen() {
     for(unsigned int idx : this->primary_buffer) {
         for(unsigned int j=0; j<3; j++) {
-            this->atoms[idx].selective_dynamics[j] = true;
+            this->atoms.write()[idx].selective_dynamics[j] = true;
         }
     }
+    this->mark_selection_changed();
 }
 
     /**
@@ -491,13 +747,18 @@ QString Structure::get_selection_string() const {
 }
 
     /**
-     * @brief      Count the number of elements
+     * @brief      Count the number of elements if the counts are outdated
      */
-void Structure::count_elements() {
+void Structure::count_elements() const {
+    if(this->elements_geometry == this->generations.geometry) {
+        return;
+    }
+
+    this->elements_geometry = this->generations.geometry;
     this->element_types.clear();
 
     for(const auto& atom : this->atoms) {
-        std::string atomname = AtomSettings::get().get_name_from_elnr(atom.atnr);
+        const std::string& atomname = AtomSettings::get().get_name_from_elnr(atom.atnr);
         auto got = this->element_types.find(atomname);
         if(got != this->element_types.end()) {
             got->second++;
@@ -514,25 +775,51 @@ void Structure::construct_bonds() {
     if(Structure::debug_logging_enabled) {
         qDebug() << "Building bonds";
     }
-    this->bonds.clear();
-
-    for(unsigned int i=0; i<this->atoms.size(); i++) {
-        const auto& atom1 = this->atoms[i];
-        for(unsigned int j=i+1; j<this->atoms.size(); j++) {
-            const auto& atom2 = this->atoms[j];
-            double maxdist2 = AtomSettings::get().get_bond_distance(atom1.atnr, atom2.atnr);
+    // only atoms in neighbouring cells can be bonded; the atoms are
+    // distributed over the threads and the bonds are collected in order
+    const double maxdist = AtomSettings::get().get_max_bond_distance();
+    const auto& atoms = this->atoms.get();
+    if(this->use_periodic_bonds()) {
+        this->cell_list.reset();
+        this->build_periodic_cell_list(maxdist);
+
+        const PeriodicCellList& grid = *this->periodic_cell_list;
+        this->bonds = CowVector<Bond>(Parallel::gather<Bond>(atoms.size(), [&](size_t begin, size_t end, std::vector<Bond>& out) {
+            for(unsigned int i=begin; i<end; i++) {
+                grid.for_each_candidate(i, [&](unsigned int j, const std::array<int, 3>& image) {
+                    if(!is_unique_pair(i, j, image)) {
+                        return;
+                    }
 
-            double dist2 = atom1.dist(atom2);
+                    this->add_bond_if_bonded(out, atoms[i], atoms[j], i, j, image);
+                });
+            }
+        }));
+    } else {
+        this->periodic_cell_list.reset();
+        this->build_cell_list(maxdist);
+
+        const CellList& grid = *this->cell_list;
+        this->bonds = CowVector<Bond>(Parallel::gather<Bond>(atoms.size(), [&](size_t begin, size_t end, std::vector<Bond>& out) {
+            for(unsigned int i=begin; i<end; i++) {
+                grid.for_each_candidate(i, [&](unsigned int j) {
+                    if(j <= i) {
+                        return;
+                    }
 
-            // check if atoms are bonded
-            if(dist2 < maxdist2) {
-                this->bonds.emplace_back(atom1, atom2, i, j);
+                    this->add_bond_if_bonded(out, atoms[i], atoms[j], i, j);
+                });
             }
-        }
+        }));
     }
+
     if(Structure::debug_logging_enabled) {
         qDebug() << bonds.size() << " bonds were found.";
     }
+
+    this->bonds_geometry = this->generations.geometry;
+    this->bonds_cell = this->generations.cell;
+    this->mark_topology_changed();
 }
 
 /**
@@ -558,80 +845,195 @@ void Structure::update_bonds_for_atoms(const std::vector<unsigned int>& atom_ind
         return;
     }
 
-    this->bonds.erase(
-        std::remove_if(this->bonds.begin(), this->bonds.end(),
+    auto& bonds = this->bonds.write();
+    bonds.erase(
+        std::remove_if(bonds.begin(), bonds.end(),
                        [&moved](const Bond& bond) {
                            return moved.count(bond.atom1_idx) > 0 ||
                                   moved.count(bond.atom2_idx) > 0;
                        }),
-        this->bonds.end()
+        bonds.end()
     );
+    this->mark_topology_changed();
+
+    // when committing, the stored positions have changed and the grid is
+    // outdated; for a preview the grid still reflects the stored positions
+    const double maxdist = AtomSettings::get().get_max_bond_distance();
+    const bool periodic_bonds = this->use_periodic_bonds();
+    if(periodic_bonds) {
+        if(!transposition || !this->periodic_cell_list || this->periodic_cell_list->get_nr_atoms() != this->atoms.size()) {
+            this->build_periodic_cell_list(maxdist);
+        }
+    } else {
+        if(!transposition || !this->cell_list || this->cell_list->get_nr_atoms() != this->atoms.size()) {
+            this->build_cell_list(maxdist);
+        }
+    }
 
-    auto build_atom = [&](unsigned int idx) {
-        Atom atom = this->atoms[idx];
-        if(transposition && moved.count(idx) > 0) {
-            auto newpos = transposition->map(atom.get_pos_qtvec());
-            atom.x = newpos.x();
-            atom.y = newpos.y();
-            atom.z = newpos.z();
+    // collect the (possibly previewed) positions of the moved atoms
+    std::vector<unsigned int> moved_indices(moved.begin(), moved.end());
+    std::sort(moved_indices.begin(), moved_indices.end());
+    std::vector<Atom> moved_atoms;
+    moved_atoms.reserve(moved_indices.size());
+    for(unsigned int idx : moved_indices) {
+        moved_atoms.push_back(this->atoms[idx]);
+        if(transposition) {
+            auto newpos = transposition->map(moved_atoms.back().get_pos_qtvec());
+            moved_atoms.back().x = newpos.x();
+            moved_atoms.back().y = newpos.y();
+            moved_atoms.back().z = newpos.z();
         }
-        return atom;
-    };
-
-    for(unsigned int i : moved) {
-        const auto atom1 = build_atom(i);
-        for(unsigned int j=0; j<this->atoms.size(); j++) {
-            if(i == j) {
-                continue;
-            }
+    }
 
-            if(moved.count(j) > 0 && j < i) {
-                continue;
-            }
+    if(periodic_bonds) {
+        // bonds between moved and stationary atoms
+        for(unsigned int k=0; k<moved_indices.size(); k++) {
+            const auto& atom1 = moved_atoms[k];
+            this->periodic_cell_list->for_each_candidate(atom1.x, atom1.y, atom1.z,
+                [&](unsigned int j, const std::array<int, 3>& image) {
+                    if(moved.count(j) == 0) {
+                        this->add_bond_if_bonded(bonds, atom1, this->atoms[j], moved_indices[k], j, image);
+                    }
+                });
+        }
 
-            const auto atom2 = build_atom(j);
-            double maxdist2 = AtomSettings::get().get_bond_distance(atom1.atnr, atom2.atnr);
-            double dist2 = atom1.dist(atom2);
+        // bonds among the moved atoms themselves
+        PeriodicCellList moved_cells;
+        moved_cells.build(moved_atoms, this->unitcell, maxdist);
+        for(unsigned int k=0; k<moved_indices.size(); k++) {
+            moved_cells.for_each_candidate(k, [&](unsigned int l, const std::array<int, 3>& image) {
+                if(is_unique_pair(k, l, image)) {
+                    this->add_bond_if_bonded(bonds, moved_atoms[k], moved_atoms[l], moved_indices[k], moved_indices[l], image);
+                }
+            });
+        }
+    } else {
+        for(unsigned int k=0; k<moved_indices.size(); k++) {
+            const auto& atom1 = moved_atoms[k];
+            this->cell_list->for_each_candidate(atom1.x, atom1.y, atom1.z, [&](unsigned int j) {
+                if(moved.count(j) == 0) {
+                    this->add_bond_if_bonded(bonds, atom1, this->atoms[j], moved_indices[k], j);
+                }
+            });
+        }
 
-            if(dist2 < maxdist2) {
-                this->bonds.emplace_back(atom1, atom2, i, j);
-            }
+        CellList moved_cells;
+        moved_cells.build(moved_atoms, maxdist);
+        for(unsigned int k=0; k<moved_indices.size(); k++) {
+            moved_cells.for_each_candidate(k, [&](unsigned int l) {
+                if(l > k) {
+                    this->add_bond_if_bonded(bonds, moved_atoms[k], moved_atoms[l], moved_indices[k], moved_indices[l]);
+                }
+            });
         }
     }
 }
 
     /**
-     * @brief      Expand unit cell
+     * @brief      Update the derived data after a subset of atoms has moved
+     *
+     * @param[in]  atom_indices  Indices of atoms that moved
      */
-void Structure::build_expansion() {
-    this->atoms_expansion.clear();
+void Structure::update_moved_atoms(const std::vector<unsigned int>& atom_indices) {
+    // the bonds remain up to date if these were up to date before the move
+    const bool bonds_current = this->bonds_geometry == this->generations.geometry &&
+                               this->bonds_cell == this->generations.cell;
+    this->mark_geometry_changed();
+    this->update_bonds_for_atoms(atom_indices, nullptr);
+    if(bonds_current) {
+        this->bonds_geometry = this->generations.geometry;
+    }
+}
 
-    VectorPosition p;
-    for(int z=-1; z<=1; z++) {
-        p[2] = z;
-        for(int y=-1; y<=1; y++) {
-            p[1] = y;
-            for(int x=-1; x<=1; x++) {
-                p[0] = x;
-                if(!(x == 0 && y == 0 && z == 0)) {
-                    VectorPosition dp = this->unitcell.transpose() * p;
-                    for(const auto& atom : this->atoms) {
-                        unsigned int atomtype = 0;
-                        if(z != 0) {
-                            atomtype |= (1 << ATOM_EXPANSION_Z);
-                        }
+    /**
+     * @brief      Build the neighbour grid used for bond construction
+     *
+     * @param[in]  radius  Search radius
+     */
+void Structure::build_cell_list(double radius) {
+    // the grid may be shared with copies of this structure, hence a new
+    // grid is created rather than rebuilding the current one
+    auto grid = std::make_shared<CellList>();
+    grid->build(this->atoms.get(), radius);
+    this->cell_list = grid;
+}
 
-                        if(x != 0 || y != 0) {
-                            atomtype |= (1 << ATOM_EXPANSION_XY);
-                        }
+    /**
+     * @brief      Build the neighbour grid used for bonds across cell boundaries
+     *
+     * @param[in]  radius  Search radius
+     */
+void Structure::build_periodic_cell_list(double radius) {
+    auto grid = std::make_shared<PeriodicCellList>();
+    grid->build(this->atoms.get(), this->unitcell, radius);
+    this->periodic_cell_list = grid;
+}
 
-                        this->atoms_expansion.emplace_back(atom.atnr, atom.x, atom.y, atom.z, atomtype);
-                        this->atoms_expansion.back().translate(dp[0], dp[1], dp[2]);
-                    }
-                }
-            }
-        }
+    /**
+     * @brief      Whether bonds should be searched using periodic boundary conditions
+     *
+     * @return     True if the structure is periodic and has a valid unit cell
+     */
+bool Structure::use_periodic_bonds() const {
+    return this->periodic && PeriodicCellList::is_valid_unitcell(this->unitcell);
+}
+
+    /**
+     * @brief      Get the position of an atom, including a previewed transposition
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The position.
+     */
+QVector3D Structure::get_preview_position(unsigned int idx) const {
+    if(idx < this->preview_mask.size() && this->preview_mask[idx]) {
+        return this->preview_transposition.map(this->atoms[idx].get_pos_qtvec());
     }
+
+    return this->atoms[idx].get_pos_qtvec();
+}
+
+    /**
+     * @brief      Add a bond between two atoms if they are within bonding distance
+     *
+     * @param      bonds  Bonds to add the bond to
+     * @param[in]  atom1  First atom
+     * @param[in]  atom2  Second atom
+     * @param[in]  idx1   Index of the first atom
+     * @param[in]  idx2   Index of the second atom
+     * @param[in]  image  Lattice image of the second atom
+     */
+void Structure::add_bond_if_bonded(std::vector<Bond>& bonds,
+                                   const Atom& atom1, const Atom& atom2,
+                                   unsigned int idx1, unsigned int idx2,
+                                   const std::array<int, 3>& image) const {
+    VectorPosition translation = VectorPosition::Zero();
+    if(image[0] != 0 || image[1] != 0 || image[2] != 0) {
+        translation = this->unitcell.transpose() * VectorPosition(image[0], image[1], image[2]);
+    }
+
+    const double dx = atom2.x + translation[0] - atom1.x;
+    const double dy = atom2.y + translation[1] - atom1.y;
+    const double dz = atom2.z + translation[2] - atom1.z;
+    const double dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+    // check if atoms are bonded
+    if(dist < AtomSettings::get().get_bond_distance(atom1.atnr, atom2.atnr)) {
+        bonds.emplace_back(idx1, idx2, image);
+    }
+}
+
+    /**
+     * @brief      Rebuild the atom arrays if they are outdated
+     */
+void Structure::refresh_atom_arrays() const {
+    if(this->atom_arrays) {
+        return;
+    }
+
+    auto arrays = std::make_shared<AtomArrays>();
+    arrays->assign(this->atoms.get());
+    this->atom_arrays = arrays;
 }
 
     /**
@@ -641,12 +1043,12 @@ void Structure::build_expansion() {
      * @param[in]  transposition  The transposition
      */
 void Structure::transpose_atom(unsigned int idx, const QMatrix4x4& transposition) {
-    QMatrix4x4 unitcellmatrix(this->get_matrix3x3(this->unitcell));
+    this->update_cell_matrices();
     auto pos = this->atoms[idx].get_pos_qtvec();
     QVector3D newpos = transposition.map(pos);
 
     // convert to direct coordinates and replace atom within the unitcell
-    QVector3D direct = unitcellmatrix.transposed().inverted().map(newpos);
+    QVector3D direct = this->cartesian_to_cell.map(newpos);
     for(unsigned int i=0; i<3; i++) {
         direct[i] = std::fmod(direct[i], 1.0f);
         if(direct[i] < 0.0f) {
@@ -655,12 +1057,26 @@ void Structure::transpose_atom(unsigned int idx, const QMatrix4x4& transposition
     }
 
     // calculate back to cartesian coordinates
-    newpos = unitcellmatrix.transposed().map(direct);
+    newpos = this->cell_to_cartesian.map(direct);
 
     // update atom coordinates
-    this->atoms[idx].x = newpos[0];
-    this->atoms[idx].y = newpos[1];
-    this->atoms[idx].z = newpos[2];
+    Atom& atom = this->atoms.write()[idx];
+    atom.x = newpos[0];
+    atom.y = newpos[1];
+    atom.z = newpos[2];
+}
+
+    /**
+     * @brief      Rebuild the conversion matrices of the unit cell if outdated
+     */
+void Structure::update_cell_matrices() const {
+    if(this->cell_matrices_cell == this->generations.cell) {
+        return;
+    }
+
+    this->cell_to_cartesian = QMatrix4x4(this->get_matrix3x3(this->unitcell)).transposed();
+    this->cartesian_to_cell = this->cell_to_cartesian.inverted();
+    this->cell_matrices_cell = this->generations.cell;
 }
 
     /**
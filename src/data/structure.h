@@ -24,47 +24,106 @@
 #include <QVector3D>
 #include <QMatrix4x4>
 #include <QGenericMatrix>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <QString>
 
 #include "atom_settings.h"
 #include "matrixmath.h"
 #include "atom.h"
+#include "atom_arrays.h"
 #include "bond.h"
+#include "bond_graph.h"
+#include "cell_list.h"
+#include "cow_vector.h"
+#include "periodic_cell_list.h"
 #include "fragment.h"
+#include "instance_data.h"
 
 /**
  * @brief      This class describes a chemical structure.
  */
 class Structure {
 
+    friend class StructureHistory;  // replays edits directly on the atoms
+    friend class StructureCache;    // restores cached atoms without wrapping them again
+
 public:
     struct Eigenmode {
         double eigenvalue = 0.0;
         std::vector<QVector3D> eigenvectors;
     };
 
+    /**
+     * @brief      Generation counters of the contents of a structure
+     *
+     * A counter receives a new value whenever the corresponding part of the
+     * structure changes. Values are unique over all structures, such that
+     * caches outside of this class (e.g. vertex buffers or charts) can use
+     * them as keys; copies share the values of their original until modified.
+     */
+    struct Generations {
+        uint64_t geometry = 0;      // number, elements and positions of the atoms
+        uint64_t topology = 0;      // bonds
+        uint64_t cell = 0;          // unit cell and periodicity
+        uint64_t selection = 0;     // selection and frozen state of the atoms
+    };
+
+    static constexpr unsigned int NR_IMAGES = 26;   // number of periodic images surrounding the unit cell
+
 private:
-    std::vector<Atom> atoms;            // atoms in the structure
-    std::vector<Bond> bonds;            // bonds between the atoms
+    // the per-atom data and all data derived from it are shared between
+    // copies of a structure and only duplicated upon modification, such
+    // that copying a structure is cheap
+    CowVector<Atom> atoms;              // atoms in the structure
+    CowVector<Bond> bonds;              // bonds between the atoms
+    mutable std::shared_ptr<const BondGraph> bond_graph;        // neighbour adjacency of the bonds
+    std::shared_ptr<const CellList> cell_list;                  // neighbour grid used for bond construction
+    std::shared_ptr<const PeriodicCellList> periodic_cell_list; // neighbour grid used for bonds across cell boundaries
+    bool periodic = true;               // whether bonds are formed across cell boundaries
+
+    // generations of the contents and the generations the derived data was built for
+    Generations generations = Structure::create_generations();  // current generations
+    uint64_t bonds_geometry = 0;        // geometry generation of the bonds (zero if outdated)
+    uint64_t bonds_cell = 0;            // cell generation of the bonds
+    mutable uint64_t elements_geometry = 0;     // geometry generation of the element counts
+    mutable uint64_t bond_graph_topology = 0;   // topology generation of the bond graph
+
+    // conversion between cartesian and direct coordinates, rebuilt when the cell changes
+    mutable QMatrix4x4 cell_to_cartesian;       // transposed unit cell
+    mutable QMatrix4x4 cartesian_to_cell;       // inverse of the transposed unit cell
+    mutable uint64_t cell_matrices_cell = 0;    // cell generation of the matrices (zero if outdated)
 
     double energy = 0.0;                // energy of the structure (if known, zero otherwise)
-    std::vector<QVector3D> forces;      // forces on the atoms (if known, empty array otherwise)
-    std::vector<Eigenmode> eigenmodes;  // vibrational eigenmodes (if known, empty array otherwise)
+    CowVector<QVector3D> forces;        // forces on the atoms (if known, empty array otherwise)
+    CowVector<Eigenmode> eigenmodes;    // vibrational eigenmodes (if known, empty array otherwise)
+
+    // contiguous copies of the atoms for the vectorised kernels, rebuilt on demand
+    mutable std::shared_ptr<const AtomArrays> atom_arrays;     // arrays for the atoms (null if outdated)
 
-    std::vector<Atom> atoms_expansion;  // atoms in the unit cell expansion
-    std::vector<Bond> bonds_expansion;  // bonds in the unit cell expansion
+    // instances for drawing, rebuilt on demand such that frames can be prepared ahead of being shown
+    mutable std::shared_ptr<const AtomInstances> atom_instances;   // instances of the atoms
+    mutable Generations atom_instances_generations;                // generations of the atom instances
+    mutable std::shared_ptr<const BondInstances> bond_instances;   // instances of the bonds
+    mutable Generations bond_instances_generations;                // generations of the bond instances
+
+    // atoms that are being moved but have not been committed yet
+    QMatrix4x4 preview_transposition;           // transposition applied to the previewed atoms
+    std::vector<bool> preview_mask;             // whether an atom is being previewed (empty if none)
 
     MatrixUnitcell unitcell;            // matrix describing the unit cell
-    std::vector<double> radii;          // radii of the atoms
+    CowVector<double> radii;            // radii of the atoms
 
-    std::unordered_map<std::string, unsigned int> element_types;    // elements present in the structure
+    mutable std::unordered_map<std::string, unsigned int> element_types;    // elements present in the structure
 
     // atom selection buffers
     std::vector<unsigned int> primary_buffer;   // primary selection buffer
     std::vector<unsigned int> secondary_buffer; // secondary selection buffer
+    std::unordered_map<unsigned int, unsigned int> image_selection;    // selection state of selected atoms in the periodic images
 
     static bool debug_logging_enabled;
+    static std::atomic<uint64_t> generation_counter;    // last handed out generation
 
 public:
     /**
@@ -151,7 +210,7 @@ public:
      * @return     The eigenmodes.
      */
     inline const auto& get_eigenmodes() const {
-        return this->eigenmodes;
+        return this->eigenmodes.get();
     }
 
     /**
@@ -176,7 +235,7 @@ public:
      * @return     The atoms.
      */
     inline const auto& get_atoms() const {
-        return this->atoms;
+        return this->atoms.get();
     }
 
     /**
@@ -185,25 +244,87 @@ public:
      * @return     The atoms.
      */
     inline const auto& get_bonds() const {
-        return this->bonds;
+        return this->bonds.get();
     }
 
     /**
-     * @brief      Get all atoms from the structure
+     * @brief      Get the atoms as contiguous arrays
      *
-     * @return     The atoms.
+     * @return     The atom arrays.
      */
-    inline const auto& get_atoms_expansion() const {
-        return this->atoms_expansion;
-    }
+    const AtomArrays& get_atom_arrays() const;
 
     /**
-     * @brief      Get all bonds from the structure
+     * @brief      Get the instances of the atoms for drawing
      *
-     * @return     The atoms.
+     * Rebuilt when the atoms, the cell or the selection have changed; the
+     * instances are shared such that the renderer can keep them.
+     *
+     * @return     The atom instances.
+     */
+    std::shared_ptr<const AtomInstances> get_atom_instances() const;
+
+    /**
+     * @brief      Get the instances of the bonds for drawing
+     *
+     * Rebuilt when the atoms, the bonds, the cell or the selection have
+     * changed; the instances are shared such that the renderer can keep
+     * them.
+     *
+     * @return     The bond instances.
+     */
+    std::shared_ptr<const BondInstances> get_bond_instances() const;
+
+    /**
+     * @brief      Get the lattice translation of a periodic image
+     *
+     * The periodic images surrounding the unit cell are ordered over z, y
+     * and x, each running from -1 to 1. The atoms in the images are not
+     * stored; atom i in image k is addressed by the index (k+1)*n+i, with
+     * n the number of atoms in the unit cell.
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The translation.
      */
-    inline const auto& get_bonds_expansion() const {
-        return this->bonds_expansion;
+    VectorPosition get_image_translation(unsigned int image) const;
+
+    /**
+     * @brief      Get the lattice coefficients of a periodic image
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The coefficients, each -1, 0 or 1.
+     */
+    static VectorPosition get_image_coefficients(unsigned int image);
+
+    /**
+     * @brief      Get the atomtype of the atoms in a periodic image
+     *
+     * @param[in]  image  The image (below NR_IMAGES)
+     *
+     * @return     The ATOM_EXPANSION_XY and ATOM_EXPANSION_Z bits.
+     */
+    static unsigned int get_image_atomtype(unsigned int image);
+
+    /**
+     * @brief      Get the position of an atom in the unit cell or in a
+     *             periodic image
+     *
+     * @param[in]  idx   The index (see get_image_translation())
+     *
+     * @return     The position.
+     */
+    QVector3D get_atom_position(unsigned int idx) const;
+
+    /**
+     * @brief      Get the selection state of the atoms in the periodic images
+     *
+     * @return     Selection state (1 or 2) by atom index; atoms that are not
+     *             selected are absent
+     */
+    inline const auto& get_image_selection() const {
+        return this->image_selection;
     }
 
     /**
@@ -228,6 +349,55 @@ public:
         return this->bonds[idx];
     }
 
+    /**
+     * @brief      Get the geometry of a bond from the current atom positions
+     *
+     * Atoms that are being moved (see preview_bonds_for_transposition) are
+     * taken at their previewed positions.
+     *
+     * @param[in]  idx   The bond index
+     *
+     * @return     The bond geometry.
+     */
+    BondGeometry get_bond_geometry(unsigned int idx) const;
+
+    /**
+     * @brief      Get the bond adjacency of the atoms
+     *
+     * @return     The bond graph.
+     */
+    const BondGraph& get_bond_graph() const;
+
+    /**
+     * @brief      Gets the memory used by the derived atom arrays, bond graph
+     *             and instances, counting only those that have been built.
+     *
+     * @return     The memory usage in bytes.
+     */
+    size_t get_derived_memory_usage() const;
+
+    /**
+     * @brief      Gets the number of bonds of an atom
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The degree.
+     */
+    inline size_t get_degree(unsigned int idx) const {
+        return this->get_bond_graph().get_degree(idx);
+    }
+
+    /**
+     * @brief      Gets the atoms bonded to an atom
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The neighbouring atom indices.
+     */
+    inline BondGraph::Range get_neighbours(unsigned int idx) const {
+        return this->get_bond_graph().get_neighbours(idx);
+    }
+
     /**
      * @brief      Gets the unitcell.
      *
@@ -237,6 +407,38 @@ public:
         return this->unitcell;
     }
 
+    /**
+     * @brief      Whether bonds are formed across the unit cell boundaries
+     *
+     * @return     True if periodic
+     */
+    inline bool is_periodic() const {
+        return this->periodic;
+    }
+
+    /**
+     * @brief      Set whether bonds are formed across the unit cell boundaries
+     *
+     * Call update() afterwards to rebuild the bonds.
+     *
+     * @param[in]  _periodic  Periodicity flag
+     */
+    inline void set_periodic(bool _periodic) {
+        if(this->periodic != _periodic) {
+            this->periodic = _periodic;
+            this->mark_cell_changed();
+        }
+    }
+
+    /**
+     * @brief      Gets the generation counters.
+     *
+     * @return     The generations.
+     */
+    inline const Generations& get_generations() const {
+        return this->generations;
+    }
+
     /**
      * @brief      Gets the atomic radius.
      *
@@ -334,20 +536,22 @@ public:
     }
 
     /**
-     * @brief clone_for_view.
+     * @brief      Create a copy of this structure for a separate view
      *
+     * The atoms and derived data are shared with this structure until
+     * either of the two is modified; the selection is not copied. Bonds are
+     * not derived here but once the copy is displayed (see update()), such
+     * that a trajectory can be cloned without deriving data for frames that
+     * are never shown.
+     *
+     * @return     The copy.
      */
     std::shared_ptr<Structure> clone_for_view() const {
         auto c = std::make_shared<Structure>(*this);
 
         // HARD RESET of view state
         c->clear_selection();
-        c->bonds.clear();
-        c->atoms_expansion.clear();
-        c->element_types.clear();
-
-        // rebuild derived state once
-        c->update();
+        c->preview_mask.clear();
 
         return c;
     }
@@ -376,7 +580,10 @@ public:
     std::string get_elements_string() const;
 
     /**
-     * @brief      Update data based on contents;
+     * @brief      Update data based on contents
+     *
+     * Only the derived data whose generations are outdated is rebuilt,
+     * hence calling this function on an unmodified structure is cheap.
      */
     void update();
 
@@ -460,9 +667,63 @@ public:
 
 private:
     /**
-     * @brief      Count the number of elements
+     * @brief      Get a new, unique, generation
+     *
+     * @return     The generation.
+     */
+    static inline uint64_t next_generation() {
+        return ++Structure::generation_counter;
+    }
+
+    /**
+     * @brief      Get a set of new generations for a new structure
+     *
+     * @return     The generations.
+     */
+    static inline Generations create_generations() {
+        Generations g;
+        g.geometry = Structure::next_generation();
+        g.topology = Structure::next_generation();
+        g.cell = Structure::next_generation();
+        g.selection = Structure::next_generation();
+        return g;
+    }
+
+    /**
+     * @brief      Mark the atoms as moved, added or removed
+     */
+    inline void mark_geometry_changed() {
+        this->generations.geometry = Structure::next_generation();
+        this->invalidate_atom_arrays();
+    }
+
+    /**
+     * @brief      Mark the bonds as changed
+     */
+    inline void mark_topology_changed() {
+        this->generations.topology = Structure::next_generation();
+    }
+
+    /**
+     * @brief      Mark the unit cell or periodicity as changed
+     */
+    inline void mark_cell_changed() {
+        this->generations.cell = Structure::next_generation();
+        this->invalidate_atom_arrays();
+    }
+
+    /**
+     * @brief      Mark the selection or frozen state of the atoms as changed
+     */
+    inline void mark_selection_changed() {
+        this->generations.selection = Structure::next_generation();
+        this->invalidate_atom_arrays();
+    }
+
+    /**
+     * @brief      Count the number of elements if the counts are outdated
      */
-    void count_elements();
+    void count_elements() const;
 
     /**
      * @brief      Construct the bonds
@@ -478,9 +739,68 @@ private:
                                 const QMatrix4x4* transposition);
 
     /**
-     * @brief      Expand unit cell
+     * @brief      Update the derived data after a subset of atoms has moved
+     *
+     * @param[in]  atom_indices  Indices of atoms that moved
+     */
+    void update_moved_atoms(const std::vector<unsigned int>& atom_indices);
+
+    /**
+     * @brief      Build the neighbour grid used for bond construction
+     *
+     * @param[in]  radius  Search radius
      */
-    void build_expansion();
+    void build_cell_list(double radius);
+
+    /**
+     * @brief      Build the neighbour grid used for bonds across cell boundaries
+     *
+     * @param[in]  radius  Search radius
+     */
+    void build_periodic_cell_list(double radius);
+
+    /**
+     * @brief      Whether bonds should be searched using periodic boundary conditions
+     *
+     * @return     True if the structure is periodic and has a valid unit cell
+     */
+    bool use_periodic_bonds() const;
+
+    /**
+     * @brief      Get the position of an atom, including a previewed transposition
+     *
+     * @param[in]  idx   Atom index
+     *
+     * @return     The position.
+     */
+    QVector3D get_preview_position(unsigned int idx) const;
+
+    /**
+     * @brief      Add a bond between two atoms if they are within bonding distance
+     *
+     * @param      bonds  Bonds to add the bond to
+     * @param[in]  atom1  First atom
+     * @param[in]  atom2  Second atom
+     * @param[in]  idx1   Index of the first atom
+     * @param[in]  idx2   Index of the second atom
+     * @param[in]  image  Lattice image of the second atom
+     */
+    void add_bond_if_bonded(std::vector<Bond>& bonds,
+                            const Atom& atom1, const Atom& atom2,
+                            unsigned int idx1, unsigned int idx2,
+                            const std::array<int, 3>& image = {0, 0, 0}) const;
+
+    /**
+     * @brief      Mark the atom arrays as outdated
+     */
+    inline void invalidate_atom_arrays() {
+        this->atom_arrays.reset();
+    }
+
+    /**
+     * @brief      Rebuild the atom arrays if they are outdated
+     */
+    void refresh_atom_arrays() const;
 
     /**
      * @brief      Transpose single atom
@@ -490,6 +810,11 @@ private:
      */
     void transpose_atom(unsigned int idx, const QMatrix4x4& transposition);
 
+    /**
+     * @brief      Rebuild the conversion matrices of the unit cell if outdated
+     */
+    void update_cell_matrices() const;
+
     /**
      * @brief      Gets the unitcell matrix.
      *
@@ -0,0 +1,615 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "structure_cache.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <stdexcept>
+
+#include "atom_settings.h"
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'A', 'A', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+constexpr uint64_t FINGERPRINT_SAMPLES = 16;            // number of sampled blocks
+constexpr uint64_t FINGERPRINT_BLOCK_SIZE = 64 * 1024;  // size of a sampled block
+
+/*
+ * Layout of an entry; every record is padded to a multiple of eight bytes
+ *
+ *  CacheHeader
+ *  path (path_length bytes)
+ *
+ * followed for structures by
+ *
+ *  number of frames of each set (nr_records sets, uint64_t each)
+ *  per frame: CachedFrame, CachedAtom[nr_atoms], QVector3D[nr_forces] and
+ *             per eigenmode its eigenvalue, number of vectors and the vectors
+ *
+ * or for the frame index of a trajectory by
+ *
+ *  CachedIndexFrame[nr_records]
+ */
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    uint64_t file_size;
+    int64_t file_mtime;
+    uint64_t fingerprint;
+    uint64_t path_length;
+    uint64_t nr_records;
+};
+
+struct CachedFrame {
+    double unitcell[9];
+    double energy;
+    uint64_t nr_atoms;
+    uint64_t nr_forces;
+    uint64_t nr_eigenmodes;
+    uint64_t periodic;
+};
+
+struct CachedAtom {
+    double x, y, z;
+    uint32_t atnr;
+    uint32_t selective_dynamics;    // bit i is set if direction i is free
+};
+
+struct CachedIndexFrame {
+    uint64_t locator;
+    double energy;
+    double rms_force;
+};
+
+static_assert(sizeof(QVector3D) == 3 * sizeof(float), "QVector3D is expected to hold three packed floats");
+
+/**
+ * @brief      FNV-1a hash
+ *
+ * @param[in]  data  The data
+ * @param[in]  n     Number of bytes
+ * @param[in]  h     Hash to continue from
+ *
+ * @return     The hash
+ */
+uint64_t hash_bytes(const void* data, size_t n, uint64_t h = 14695981039346656037ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<n; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * @brief      Sequential writer of cache entries
+ */
+class CacheWriter {
+public:
+    std::vector<char> buffer;
+
+    template<typename T>
+    void write(const T* data, size_t n) {
+        const size_t bytes = sizeof(T) * n;
+        const size_t offset = this->buffer.size();
+        this->buffer.resize(offset + ((bytes + 7) & ~(size_t)7), 0);
+        if(bytes > 0) {
+            std::memcpy(this->buffer.data() + offset, data, bytes);
+        }
+    }
+};
+
+/**
+ * @brief      Sequential reader of (memory-mapped) cache entries
+ */
+class CacheReader {
+private:
+    const char* p;
+    const char* end;
+
+public:
+    CacheReader(const char* data, size_t size) : p(data), end(data + size) {}
+
+    template<typename T>
+    void read(T* out, size_t n) {
+        if(n > (size_t)(this->end - this->p) / sizeof(T)) {
+            throw std::runtime_error("Truncated cache entry.");
+        }
+        const size_t bytes = sizeof(T) * n;
+        const size_t padded = std::min((bytes + 7) & ~(size_t)7, (size_t)(this->end - this->p));
+        if(bytes > 0) {
+            std::memcpy(out, this->p, bytes);
+        }
+        this->p += padded;
+    }
+
+    template<typename T>
+    void read_vector(std::vector<T>& v, uint64_t n) {
+        if(n > (uint64_t)(this->end - this->p) / sizeof(T)) {
+            throw std::runtime_error("Truncated cache entry.");
+        }
+        v.resize(n);
+        this->read(v.data(), n);
+    }
+};
+
+/**
+ * @brief      Write the header of an entry
+ *
+ * @param      writer      The writer
+ * @param[in]  key         The key of the file
+ * @param[in]  format      The loader that produced the entry
+ * @param[in]  nr_records  The number of records (sets or frames)
+ * @param[in]  version     The version of the cache
+ */
+void write_header(CacheWriter& writer,
+                  const StructureCache::FileKey& key,
+                  StructureCacheFormat format,
+                  uint64_t nr_records,
+                  uint32_t version) {
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = version;
+    header.format = (uint32_t)format;
+    header.file_size = key.size;
+    header.file_mtime = key.mtime;
+    header.fingerprint = key.fingerprint;
+    header.path_length = key.path.size();
+    header.nr_records = nr_records;
+    writer.write(&header, 1);
+    writer.write(key.path.data(), key.path.size());
+}
+
+/**
+ * @brief      Read the header of an entry and verify that it belongs to a file
+ *
+ * @param      reader      The reader
+ * @param[in]  key         The key of the file
+ * @param[in]  format      The loader that produced the entry
+ * @param[in]  version     The version of the cache
+ * @param      nr_records  The number of records (output)
+ *
+ * @return     True if the entry belongs to the file
+ */
+bool read_header(CacheReader& reader,
+                 const StructureCache::FileKey& key,
+                 StructureCacheFormat format,
+                 uint32_t version,
+                 uint64_t& nr_records) {
+    CacheHeader header;
+    reader.read(&header, 1);
+    if(std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+       header.version != version ||
+       header.format != (uint32_t)format ||
+       header.file_size != key.size ||
+       header.file_mtime != key.mtime ||
+       header.fingerprint != key.fingerprint ||
+       header.path_length != key.path.size()) {
+        return false;
+    }
+
+    std::vector<char> path;
+    reader.read_vector(path, header.path_length);
+    if(!std::equal(path.begin(), path.end(), key.path.begin())) {
+        return false;
+    }
+
+    nr_records = header.nr_records;
+    return true;
+}
+
+}
+
+/**
+ * @brief      Constructs a new instance.
+ */
+StructureCache::StructureCache() :
+directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/structures") {
+
+}
+
+    /**
+     * @brief      Set the maximum total size of the cache
+     *
+     * @param[in]  bytes  The size limit in bytes
+     */
+void StructureCache::set_size_limit(uint64_t bytes) {
+    this->size_limit = bytes;
+    this->evict();
+}
+
+    /**
+     * @brief      Identify a file
+     *
+     * @param[in]  filename  The filename
+     * @param      key       The key (output)
+     *
+     * @return     False if the cache is bypassed or the file cannot be read
+     */
+bool StructureCache::identify(const std::string& filename, FileKey& key) const {
+    if(!this->enabled) {
+        return false;
+    }
+
+    const QFileInfo info(QString(filename.c_str()));
+    if(!info.isFile()) {
+        return false;
+    }
+
+    key.path = info.canonicalFilePath().toStdString();
+    key.size = (uint64_t)info.size();
+    key.mtime = info.lastModified().toMSecsSinceEpoch();
+
+    QFile file(info.canonicalFilePath());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // hash the whole file when small, otherwise a set of evenly spaced blocks
+    uint64_t h = hash_bytes(&key.size, sizeof(key.size));
+    if(key.size <= FINGERPRINT_SAMPLES * FINGERPRINT_BLOCK_SIZE) {
+        const QByteArray contents = file.readAll();
+        h = hash_bytes(contents.constData(), contents.size(), h);
+    } else {
+        for(uint64_t i=0; i<FINGERPRINT_SAMPLES; i++) {
+            const uint64_t offset = (key.size - FINGERPRINT_BLOCK_SIZE) * i / (FINGERPRINT_SAMPLES - 1);
+            if(!file.seek((qint64)offset)) {
+                return false;
+            }
+            const QByteArray block = file.read(FINGERPRINT_BLOCK_SIZE);
+            h = hash_bytes(block.constData(), block.size(), h);
+        }
+    }
+    key.fingerprint = h;
+
+    return true;
+}
+
+    /**
+     * @brief      Load the structures of a file from the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param      sets    The structures (output)
+     *
+     * @return     True on a cache hit
+     */
+bool StructureCache::load(const FileKey& key,
+                          StructureCacheFormat format,
+                          StructureSets& sets) {
+    return this->read_entry(key, format, [&](CacheReader& reader, uint64_t nr_sets) {
+        std::vector<uint64_t> nr_frames;
+        reader.read_vector(nr_frames, nr_sets);
+
+        StructureSets result(nr_sets);
+        std::vector<CachedAtom> cached_atoms;
+        for(uint64_t i=0; i<nr_sets; i++) {
+            for(uint64_t j=0; j<nr_frames[i]; j++) {
+                CachedFrame frame;
+                reader.read(&frame, 1);
+
+                MatrixUnitcell unitcell;
+                for(unsigned int k=0; k<9; k++) {
+                    unitcell(k / 3, k % 3) = frame.unitcell[k];
+                }
+
+                auto structure = std::make_shared<Structure>(unitcell);
+                structure->periodic = frame.periodic != 0;
+                structure->energy = frame.energy;
+
+                // the positions have already been wrapped into the unit cell
+                // by the loader, hence the atoms are restored as is
+                reader.read_vector(cached_atoms, frame.nr_atoms);
+                std::vector<Atom> atoms;
+                std::vector<double> radii;
+                atoms.reserve(cached_atoms.size());
+                radii.reserve(cached_atoms.size());
+                for(const CachedAtom& a : cached_atoms) {
+                    atoms.emplace_back(a.atnr, a.x, a.y, a.z);
+                    atoms.back().selective_dynamics = {
+                        (a.selective_dynamics & 1) != 0,
+                        (a.selective_dynamics & 2) != 0,
+                        (a.selective_dynamics & 4) != 0
+                    };
+                    radii.push_back(AtomSettings::get().get_atom_radius_from_elnr(a.atnr));
+                }
+                structure->atoms = CowVector<Atom>(std::move(atoms));
+                structure->radii = CowVector<double>(std::move(radii));
+
+                std::vector<QVector3D> forces;
+                reader.read_vector(forces, frame.nr_forces);
+                if(!forces.empty()) {
+                    structure->forces = CowVector<QVector3D>(std::move(forces));
+                }
+
+                for(uint64_t k=0; k<frame.nr_eigenmodes; k++) {
+                    double eigenvalue = 0.0;
+                    uint64_t nr_vectors = 0;
+                    reader.read(&eigenvalue, 1);
+                    reader.read(&nr_vectors, 1);
+
+                    std::vector<QVector3D> eigenvectors;
+                    reader.read_vector(eigenvectors, nr_vectors);
+                    structure->add_eigenmode(eigenvalue, eigenvectors);
+                }
+
+                structure->mark_geometry_changed();
+                structure->mark_topology_changed();
+                structure->mark_selection_changed();
+
+                result[i].push_back(structure);
+            }
+        }
+
+        sets = std::move(result);
+    });
+}
+
+    /**
+     * @brief      Store the structures of a file in the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the structures
+     * @param[in]  sets    The structures
+     */
+void StructureCache::store(const FileKey& key,
+                           StructureCacheFormat format,
+                           const StructureSets& sets) {
+    if(!this->enabled) {
+        return;
+    }
+
+    CacheWriter writer;
+    write_header(writer, key, format, sets.size(), CACHE_VERSION);
+
+    std::vector<uint64_t> nr_frames;
+    for(const auto& set : sets) {
+        nr_frames.push_back(set.size());
+    }
+    writer.write(nr_frames.data(), nr_frames.size());
+
+    std::vector<CachedAtom> cached_atoms;
+    for(const auto& set : sets) {
+        for(const auto& structure : set) {
+            const auto& atoms = structure->get_atoms();
+            const auto& forces = structure->forces.get();
+            const auto& eigenmodes = structure->get_eigenmodes();
+
+            CachedFrame frame;
+            for(unsigned int k=0; k<9; k++) {
+                frame.unitcell[k] = structure->get_unitcell()(k / 3, k % 3);
+            }
+            frame.energy = structure->get_energy();
+            frame.nr_atoms = atoms.size();
+            frame.nr_forces = forces.size();
+            frame.nr_eigenmodes = eigenmodes.size();
+            frame.periodic = structure->is_periodic() ? 1 : 0;
+            writer.write(&frame, 1);
+
+            cached_atoms.resize(atoms.size());
+            for(size_t k=0; k<atoms.size(); k++) {
+                const Atom& a = atoms[k];
+                cached_atoms[k] = {a.x, a.y, a.z, a.atnr,
+                                   (a.selective_dynamics[0] ? 1u : 0u) |
+                                   (a.selective_dynamics[1] ? 2u : 0u) |
+                                   (a.selective_dynamics[2] ? 4u : 0u)};
+            }
+            writer.write(cached_atoms.data(), cached_atoms.size());
+            writer.write(forces.data(), forces.size());
+
+            for(const auto& mode : eigenmodes) {
+                const uint64_t nr_vectors = mode.eigenvectors.size();
+                writer.write(&mode.eigenvalue, 1);
+                writer.write(&nr_vectors, 1);
+                writer.write(mode.eigenvectors.data(), mode.eigenvectors.size());
+            }
+        }
+    }
+
+    this->write_entry(key, format, writer.buffer);
+}
+
+    /**
+     * @brief      Load the frame index of a trajectory from the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param      frames  The frames (output)
+     *
+     * @return     True on a cache hit
+     */
+bool StructureCache::load_index(const FileKey& key,
+                                StructureCacheFormat format,
+                                std::vector<Trajectory::Frame>& frames) {
+    return this->read_entry(key, format, [&](CacheReader& reader, uint64_t nr_frames) {
+        std::vector<CachedIndexFrame> cached_frames;
+        reader.read_vector(cached_frames, nr_frames);
+
+        std::vector<Trajectory::Frame> result(cached_frames.size());
+        for(size_t i=0; i<cached_frames.size(); i++) {
+            result[i].locator = (size_t)cached_frames[i].locator;
+            result[i].energy = cached_frames[i].energy;
+            result[i].rms_force = cached_frames[i].rms_force;
+        }
+
+        frames = std::move(result);
+    });
+}
+
+    /**
+     * @brief      Store the frame index of a trajectory in the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the frames
+     * @param[in]  frames  The frames
+     */
+void StructureCache::store_index(const FileKey& key,
+                                 StructureCacheFormat format,
+                                 const std::vector<Trajectory::Frame>& frames) {
+    if(!this->enabled) {
+        return;
+    }
+
+    CacheWriter writer;
+    write_header(writer, key, format, frames.size(), CACHE_VERSION);
+
+    std::vector<CachedIndexFrame> cached_frames(frames.size());
+    for(size_t i=0; i<frames.size(); i++) {
+        cached_frames[i] = {(uint64_t)frames[i].locator, frames[i].energy, frames[i].rms_force};
+    }
+    writer.write(cached_frames.data(), cached_frames.size());
+
+    this->write_entry(key, format, writer.buffer);
+}
+
+    /**
+     * @brief      Read an entry belonging to a file
+     *
+     * The entry is memory-mapped and its header verified, after which its
+     * records are read by a callback. Corrupt entries are removed.
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param[in]  read    Callback receiving the reader (positioned after
+     *                     the header) and the number of records
+     *
+     * @return     True on a cache hit
+     */
+template<typename Func>
+bool StructureCache::read_entry(const FileKey& key, StructureCacheFormat format, Func&& read) {
+    const QString entry = this->get_entry_path(key, format);
+    QFile file(entry);
+    if(!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    try {
+        QByteArray contents;
+        const char* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+        size_t size = (size_t)file.size();
+        if(data == nullptr) {
+            contents = file.readAll();
+            data = contents.constData();
+            size = (size_t)contents.size();
+        }
+
+        // verify that the entry belongs to this file
+        CacheReader reader(data, size);
+        uint64_t nr_records = 0;
+        if(!read_header(reader, key, format, CACHE_VERSION, nr_records)) {
+            return false;
+        }
+
+        read(reader, nr_records);
+    } catch(const std::exception& e) {
+        qDebug() << "Discarding corrupt structure cache entry" << entry << ":" << e.what();
+        file.close();
+        QFile::remove(entry);
+        return false;
+    }
+
+    // mark the entry as recently used
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    qDebug() << "Loaded" << QString(key.path.c_str()) << "from the structure cache";
+
+    return true;
+}
+
+    /**
+     * @brief      Write an entry, replacing any previous entry of the file
+     *
+     * The path of an entry depends only on the loader and the path of the
+     * file, so an entry written for an earlier version of the file is
+     * overwritten. Entries exceeding the size limit are not written (and
+     * such a stale entry is removed). Afterwards, the least recently used
+     * entries are evicted.
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param[in]  buffer  The contents of the entry
+     */
+void StructureCache::write_entry(const FileKey& key, StructureCacheFormat format, const std::vector<char>& buffer) {
+    const QString entry = this->get_entry_path(key, format);
+    if(buffer.size() > this->size_limit) {
+        QFile::remove(entry);
+        return;
+    }
+
+    // write to a temporary file that atomically replaces the entry, such
+    // that concurrent readers never observe a partially written entry
+    QDir().mkpath(this->directory);
+    QSaveFile file(entry);
+    if(!file.open(QIODevice::WriteOnly) ||
+       file.write(buffer.data(), (qint64)buffer.size()) != (qint64)buffer.size() ||
+       !file.commit()) {
+        qDebug() << "Could not write structure cache entry" << entry;
+        return;
+    }
+
+    this->evict();
+}
+
+    /**
+     * @brief      Path of the entry belonging to a file
+     *
+     * @param[in]  key     The key
+     * @param[in]  format  The loader
+     *
+     * @return     The path
+     */
+QString StructureCache::get_entry_path(const FileKey& key, StructureCacheFormat format) const {
+    const uint32_t version = CACHE_VERSION;
+    const uint32_t fmt = (uint32_t)format;
+
+    uint64_t h = hash_bytes(&version, sizeof(version));
+    h = hash_bytes(&fmt, sizeof(fmt), h);
+    h = hash_bytes(key.path.data(), key.path.size(), h);
+
+    return this->directory + "/" + QString::number((qulonglong)h, 16).rightJustified(16, '0') + ".cache";
+}
+
+    /**
+     * @brief      Remove least recently used entries until the size limit is met
+     */
+void StructureCache::evict() {
+    std::lock_guard<std::mutex> lock(this->eviction_mutex);
+
+    // entries are sorted from most to least recently used
+    const QDir dir(this->directory);
+    const QFileInfoList entries = dir.entryInfoList(QStringList{"*.cache"}, QDir::Files, QDir::Time);
+
+    uint64_t total = 0;
+    for(const QFileInfo& entry : entries) {
+        total += (uint64_t)entry.size();
+        if(total > this->size_limit) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
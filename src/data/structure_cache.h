@@ -0,0 +1,232 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "structure.h"
+#include "trajectory.h"
+
+// sets of structures (e.g. the images of an NEB calculation), each holding one or more frames
+typedef std::vector<std::vector<std::shared_ptr<Structure>>> StructureSets;
+
+enum StructureCacheFormat {
+    STRUCTURE_CACHE_FORMAT_GEOMETRY,        // single structure (POSCAR, .geo, .xyz)
+    STRUCTURE_CACHE_FORMAT_OUTCAR,          // all ionic steps of an OUTCAR
+    STRUCTURE_CACHE_FORMAT_YAML,            // PyMKMKit YAML
+    STRUCTURE_CACHE_FORMAT_NEB_BIN,         // NEB binary package
+    STRUCTURE_CACHE_FORMAT_OUTCAR_INDEX     // frame index of an OUTCAR trajectory
+};
+
+/**
+ * @brief      Persistent cache of parsed structure files
+ *
+ * Parsed files are stored in a compact binary form in the cache directory
+ * of the application. On subsequent loads an entry is memory-mapped and
+ * deserialized, which is much cheaper than parsing the text again.
+ * Entries are addressed by a hash over the cache version, the loader and
+ * the canonical path, such that each file has a single entry. The header
+ * of each entry holds the size and modification time of the file and a
+ * fingerprint of its contents, and is verified before use; an entry of a
+ * file that has changed since is a miss and is overwritten by the next
+ * write. The fingerprint samples a fixed number of blocks spread over the
+ * file such that it remains cheap for very large files. Besides
+ * structures, an entry can hold the frame index of a trajectory whose
+ * frames are decoded from the file on demand.
+ *
+ * The total size of the cache is bounded; when it is exceeded, the least
+ * recently used entries are removed (the modification time of an entry is
+ * refreshed on every hit).
+ */
+class StructureCache {
+private:
+    QString directory;                  // directory holding the entries
+    bool enabled = true;                // whether the cache is consulted at all
+    uint64_t size_limit = 2048ull * 1024 * 1024;    // maximum total size of the entries in bytes
+    std::mutex eviction_mutex;          // serializes pruning of the cache directory
+
+    static constexpr uint32_t CACHE_VERSION = 2;    // increment when the layout or parsers change
+
+public:
+    /**
+     * @brief      Get the cache
+     *
+     * @return     The cache
+     */
+    static StructureCache& get() {
+        static StructureCache cache_instance;
+        return cache_instance;
+    }
+
+    /**
+     * @brief      Enable or bypass the cache
+     *
+     * @param[in]  _enabled  Whether the cache is used
+     */
+    inline void set_enabled(bool _enabled) {
+        this->enabled = _enabled;
+    }
+
+    /**
+     * @brief      Whether the cache is used
+     *
+     * @return     True if enabled
+     */
+    inline bool is_enabled() const {
+        return this->enabled;
+    }
+
+    /**
+     * @brief      Set the maximum total size of the cache
+     *
+     * @param[in]  bytes  The size limit in bytes
+     */
+    void set_size_limit(uint64_t bytes);
+
+    /**
+     * @brief      Identification of a source file
+     */
+    struct FileKey {
+        std::string path;           // canonical path
+        uint64_t size = 0;          // size in bytes
+        int64_t mtime = 0;          // modification time (ms since epoch)
+        uint64_t fingerprint = 0;   // hash over sampled contents
+    };
+
+    /**
+     * @brief      Identify a file
+     *
+     * The key should be obtained before the file is parsed, such that a
+     * file that changes while being parsed is not stored under its new key.
+     *
+     * @param[in]  filename  The filename
+     * @param      key       The key (output)
+     *
+     * @return     False if the cache is bypassed or the file cannot be read
+     */
+    bool identify(const std::string& filename, FileKey& key) const;
+
+    /**
+     * @brief      Load the structures of a file from the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param      sets    The structures (output)
+     *
+     * @return     True on a cache hit
+     */
+    bool load(const FileKey& key,
+              StructureCacheFormat format,
+              StructureSets& sets);
+
+    /**
+     * @brief      Store the structures of a file in the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the structures
+     * @param[in]  sets    The structures
+     */
+    void store(const FileKey& key,
+               StructureCacheFormat format,
+               const StructureSets& sets);
+
+    /**
+     * @brief      Load the frame index of a trajectory from the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param      frames  The frames (output)
+     *
+     * @return     True on a cache hit
+     */
+    bool load_index(const FileKey& key,
+                    StructureCacheFormat format,
+                    std::vector<Trajectory::Frame>& frames);
+
+    /**
+     * @brief      Store the frame index of a trajectory in the cache
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the frames
+     * @param[in]  frames  The frames
+     */
+    void store_index(const FileKey& key,
+                     StructureCacheFormat format,
+                     const std::vector<Trajectory::Frame>& frames);
+
+private:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    StructureCache();
+
+    /**
+     * @brief      Path of the entry belonging to a file
+     *
+     * @param[in]  key     The key
+     * @param[in]  format  The loader
+     *
+     * @return     The path
+     */
+    QString get_entry_path(const FileKey& key, StructureCacheFormat format) const;
+
+    /**
+     * @brief      Read an entry belonging to a file
+     *
+     * The entry is memory-mapped and its header verified, after which its
+     * records are read by a callback. Corrupt entries are removed.
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param[in]  read    Callback receiving the reader (positioned after
+     *                     the header) and the number of records
+     *
+     * @return     True on a cache hit
+     */
+    template<typename Func>
+    bool read_entry(const FileKey& key, StructureCacheFormat format, Func&& read);
+
+    /**
+     * @brief      Write an entry, replacing any previous entry of the file
+     *
+     * The path of an entry depends only on the loader and the path of the
+     * file, so an entry written for an earlier version of the file is
+     * overwritten. Entries exceeding the size limit are not written (and
+     * such a stale entry is removed). Afterwards, the least recently used
+     * entries are evicted.
+     *
+     * @param[in]  key     The key of the file
+     * @param[in]  format  The loader that produced the entry
+     * @param[in]  buffer  The contents of the entry
+     */
+    void write_entry(const FileKey& key, StructureCacheFormat format, const std::vector<char>& buffer);
+
+    /**
+     * @brief      Remove least recently used entries until the size limit is met
+     */
+    void evict();
+};
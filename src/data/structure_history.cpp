@@ -0,0 +1,386 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "structure_history.h"
+
+namespace {
+/**
+ * @brief      Copy of an atom without its selection state
+ *
+ * @param[in]  atom  The atom
+ *
+ * @return     The atom.
+ */
+inline Atom without_selection(const Atom& atom) {
+    Atom copy = atom;
+    copy.select = 0;
+    return copy;
+}
+}
+
+/**
+ * @brief      Constructs a new instance.
+ */
+StructureHistory::StructureHistory() {
+
+}
+
+    /**
+     * @brief      Start a new history for a structure
+     *
+     * @param[in]  _structure  The structure
+     */
+void StructureHistory::reset(const std::shared_ptr<Structure>& _structure) {
+    this->structure = _structure;
+    this->steps.clear();
+    this->position = 0;
+    this->memory_usage = 0;
+    this->pending = false;
+    this->pending_atoms.clear();
+    this->pending_forces.clear();
+    this->pending_primary.clear();
+    this->pending_secondary.clear();
+}
+
+    /**
+     * @brief      Record the current state before an edit is made
+     */
+void StructureHistory::begin_step() {
+    if(!this->structure) {
+        return;
+    }
+
+    this->finish_step();
+
+    // discard the steps that were undone
+    while(this->steps.size() > this->position) {
+        this->memory_usage -= this->steps.back().get_memory_usage();
+        this->steps.pop_back();
+    }
+
+    const Structure& s = *this->structure;
+    this->pending_atoms = s.atoms;
+    this->pending_forces = s.forces;
+    this->pending_primary = s.primary_buffer;
+    this->pending_secondary = s.secondary_buffer;
+    this->pending = true;
+}
+
+    /**
+     * @brief      Undo the last step
+     *
+     * @return     True if a step was undone
+     */
+bool StructureHistory::undo() {
+    this->finish_step();
+
+    if(this->position == 0) {
+        return false;
+    }
+
+    this->position--;
+    this->apply(this->steps[this->position], false);
+
+    return true;
+}
+
+    /**
+     * @brief      Redo the last undone step
+     *
+     * @return     True if a step was redone
+     */
+bool StructureHistory::redo() {
+    this->finish_step();
+
+    if(this->position >= this->steps.size()) {
+        return false;
+    }
+
+    this->apply(this->steps[this->position], true);
+    this->position++;
+
+    return true;
+}
+
+    /**
+     * @brief      Sets the memory limit.
+     *
+     * @param[in]  bytes  Maximum number of bytes used by the journal
+     */
+void StructureHistory::set_memory_limit(size_t bytes) {
+    this->memory_limit = bytes;
+    this->enforce_memory_limit();
+}
+
+    /**
+     * @brief      Turn the pending state into a step
+     */
+void StructureHistory::finish_step() {
+    if(!this->pending) {
+        return;
+    }
+    this->pending = false;
+
+    const Structure& s = *this->structure;
+    Step step;
+    step.primary_old = std::move(this->pending_primary);
+    step.secondary_old = std::move(this->pending_secondary);
+    step.primary_new = s.primary_buffer;
+    step.secondary_new = s.secondary_buffer;
+
+    // if the atoms still share their storage, the edit did not touch them
+    bool delta = this->pending_atoms.shares_storage(s.atoms) ||
+                 this->build_delta(this->pending_atoms.get(), s.atoms.get(), step);
+
+    if(delta) {
+        // forces are only ever removed together with their atoms
+        if(!step.removed_idx.empty() && this->pending_forces.size() == this->pending_atoms.size()) {
+            for(unsigned int idx : step.removed_idx) {
+                step.removed_forces.push_back(this->pending_forces[idx]);
+            }
+        }
+
+        if(s.forces.size() != this->pending_forces.size() - step.removed_forces.size()) {
+            delta = false;
+        }
+    }
+
+    // store a keyframe if the edit cannot be expressed compactly
+    if(delta && step.get_memory_usage() > (this->pending_atoms.size() + s.atoms.size()) * sizeof(Atom)) {
+        delta = false;
+    }
+
+    if(!delta) {
+        Step keyframe;
+        keyframe.keyframe = true;
+        keyframe.atoms_old = std::move(this->pending_atoms);
+        keyframe.forces_old = std::move(this->pending_forces);
+        keyframe.forces_new = s.forces;
+        keyframe.primary_old = std::move(step.primary_old);
+        keyframe.secondary_old = std::move(step.secondary_old);
+        keyframe.primary_new = std::move(step.primary_new);
+        keyframe.secondary_new = std::move(step.secondary_new);
+        step = std::move(keyframe);
+
+        step.atoms_new = s.atoms;
+    }
+
+    this->pending_atoms.clear();
+    this->pending_forces.clear();
+
+    if(step.is_empty()) {
+        return;
+    }
+
+    this->memory_usage += step.get_memory_usage();
+    this->steps.push_back(std::move(step));
+    this->position = this->steps.size();
+    this->enforce_memory_limit();
+}
+
+    /**
+     * @brief      Build the delta between two atom lists
+     *
+     * Every edit either modifies atoms in place, removes atoms or appends
+     * atoms at the end; other changes are reported as not expressible.
+     *
+     * @param[in]  before  The atoms before the edit
+     * @param[in]  after   The atoms after the edit
+     * @param      step    The step
+     *
+     * @return     False if the edit cannot be expressed as a delta
+     */
+bool StructureHistory::build_delta(const std::vector<Atom>& before, const std::vector<Atom>& after, Step& step) const {
+    if(after.size() < before.size()) {
+        // atoms were removed; match the remaining atoms in order
+        size_t j = 0;
+        for(unsigned int i=0; i<before.size(); i++) {
+            if(j < after.size() && StructureHistory::is_same_atom(before[i], after[j])) {
+                j++;
+            } else {
+                step.removed_idx.push_back(i);
+                step.removed_atoms.push_back(without_selection(before[i]));
+            }
+        }
+
+        return j == after.size() && step.removed_idx.size() == before.size() - after.size();
+    }
+
+    for(unsigned int i=0; i<before.size(); i++) {
+        if(!StructureHistory::is_same_atom(before[i], after[i])) {
+            step.modified_idx.push_back(i);
+            step.modified_old.push_back(without_selection(before[i]));
+            step.modified_new.push_back(without_selection(after[i]));
+        }
+    }
+
+    for(size_t i=before.size(); i<after.size(); i++) {
+        step.appended_atoms.push_back(without_selection(after[i]));
+    }
+
+    return true;
+}
+
+    /**
+     * @brief      Apply a step to the structure
+     *
+     * @param[in]  step     The step
+     * @param[in]  forward  True to redo, false to undo
+     */
+void StructureHistory::apply(const Step& step, bool forward) {
+    Structure& s = *this->structure;
+
+    // the selection refers to the current atoms, hence clear it first
+    s.clear_selection();
+    if(!s.preview_mask.empty()) {
+        s.preview_mask.clear();
+        s.bonds_geometry = 0;
+    }
+
+    if(step.keyframe) {
+        s.atoms = forward ? step.atoms_new : step.atoms_old;
+        s.forces = forward ? step.forces_new : step.forces_old;
+
+        // the keyframe holds the selection state at the time it was taken
+        for(unsigned int i=0; i<s.atoms.size(); i++) {
+            if(s.atoms[i].select != 0) {
+                s.atoms.write()[i].select = 0;
+            }
+        }
+    } else if(forward) {
+        auto& atoms = s.atoms.write();
+        const bool has_forces = !step.removed_forces.empty();
+        for(auto it = step.removed_idx.rbegin(); it != step.removed_idx.rend(); ++it) {
+            atoms.erase(atoms.begin() + *it);
+            if(has_forces) {
+                s.forces.write().erase(s.forces.write().begin() + *it);
+            }
+        }
+
+        for(unsigned int k=0; k<step.modified_idx.size(); k++) {
+            atoms[step.modified_idx[k]] = step.modified_new[k];
+        }
+
+        atoms.insert(atoms.end(), step.appended_atoms.begin(), step.appended_atoms.end());
+    } else {
+        auto& atoms = s.atoms.write();
+        atoms.erase(atoms.end() - step.appended_atoms.size(), atoms.end());
+
+        for(unsigned int k=0; k<step.modified_idx.size(); k++) {
+            atoms[step.modified_idx[k]] = step.modified_old[k];
+        }
+
+        const bool has_forces = !step.removed_forces.empty();
+        for(unsigned int k=0; k<step.removed_idx.size(); k++) {
+            atoms.insert(atoms.begin() + step.removed_idx[k], step.removed_atoms[k]);
+            if(has_forces) {
+                s.forces.write().insert(s.forces.write().begin() + step.removed_idx[k], step.removed_forces[k]);
+            }
+        }
+    }
+
+    // rebuild the derived data; when atoms only moved, only their bonds
+    // have to be updated
+    if(!step.keyframe && step.removed_idx.empty() && step.appended_atoms.empty()) {
+        if(!step.modified_idx.empty()) {
+            s.update_moved_atoms(step.modified_idx);
+        }
+    } else {
+        s.mark_geometry_changed();
+        s.update();
+    }
+
+    // restore the selection
+    s.primary_buffer = forward ? step.primary_new : step.primary_old;
+    s.secondary_buffer = forward ? step.secondary_new : step.secondary_old;
+    for(unsigned int k=0; k<2; k++) {
+        const auto& buffer = (k == 0) ? s.primary_buffer : s.secondary_buffer;
+        for(unsigned int idx : buffer) {
+            if(idx < s.atoms.size()) {
+                s.atoms.write()[idx].select = k + 1;
+            } else if(idx < (Structure::NR_IMAGES + 1) * s.atoms.size()) {
+                s.image_selection[idx] = k + 1;
+            }
+        }
+    }
+    s.mark_selection_changed();
+}
+
+    /**
+     * @brief      Discard the oldest steps until the memory limit is met
+     *
+     * The most recent step is always kept.
+     */
+void StructureHistory::enforce_memory_limit() {
+    while(this->memory_usage > this->memory_limit && this->steps.size() > 1) {
+        if(this->position > 0) {
+            this->memory_usage -= this->steps.front().get_memory_usage();
+            this->steps.pop_front();
+            this->position--;
+        } else {
+            this->memory_usage -= this->steps.back().get_memory_usage();
+            this->steps.pop_back();
+        }
+    }
+}
+
+    /**
+     * @brief      Compare the persistent state of two atoms
+     *
+     * @param[in]  a     First atom
+     * @param[in]  b     Second atom
+     *
+     * @return     True if equal (the selection state is ignored)
+     */
+bool StructureHistory::is_same_atom(const Atom& a, const Atom& b) {
+    return a.atnr == b.atnr &&
+           a.x == b.x && a.y == b.y && a.z == b.z &&
+           a.atomtype == b.atomtype &&
+           a.selective_dynamics == b.selective_dynamics;
+}
+
+    /**
+     * @brief      Whether the step does not change anything
+     *
+     * @return     True if empty
+     */
+bool StructureHistory::Step::is_empty() const {
+    if(this->keyframe) {
+        return false;
+    }
+
+    return this->removed_idx.empty() && this->modified_idx.empty() && this->appended_atoms.empty() &&
+           this->primary_old == this->primary_new && this->secondary_old == this->secondary_new;
+}
+
+    /**
+     * @brief      Estimate the memory used by this step
+     *
+     * @return     Number of bytes
+     */
+size_t StructureHistory::Step::get_memory_usage() const {
+    return sizeof(Step) +
+           (this->removed_atoms.size() + this->modified_old.size() + this->modified_new.size() +
+            this->appended_atoms.size() + this->atoms_old.size() + this->atoms_new.size()) * sizeof(Atom) +
+           (this->removed_forces.size() + this->forces_old.size() + this->forces_new.size()) * sizeof(QVector3D) +
+           (this->removed_idx.size() + this->modified_idx.size() +
+            this->primary_old.size() + this->secondary_old.size() +
+            this->primary_new.size() + this->secondary_new.size()) * sizeof(unsigned int);
+}
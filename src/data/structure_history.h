@@ -0,0 +1,207 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "structure.h"
+
+/**
+ * @brief      Undo/redo history of a structure stored as a journal of deltas
+ *
+ * Rather than storing a full copy of the structure for every edit, only the
+ * atoms that changed are recorded: modified atoms with their old and new
+ * state, removed atoms with their original index and appended atoms. The
+ * history operates on a single (live) structure; undo and redo replay the
+ * deltas in place. Edits that cannot be expressed compactly are stored as a
+ * keyframe holding the full atom list before and after the edit. When the
+ * journal exceeds its memory limit, the oldest steps are discarded.
+ */
+class StructureHistory {
+private:
+    /**
+     * @brief      Single step in the history
+     */
+    struct Step {
+        bool keyframe = false;                      // whether the full atom lists are stored
+
+        // delta representation
+        std::vector<unsigned int> removed_idx;      // indices (before the step, ascending) of removed atoms
+        std::vector<Atom> removed_atoms;            // removed atoms
+        std::vector<QVector3D> removed_forces;      // forces on the removed atoms (if known)
+        std::vector<unsigned int> modified_idx;     // indices (after removal) of modified atoms
+        std::vector<Atom> modified_old;             // state of the modified atoms before the step
+        std::vector<Atom> modified_new;             // state of the modified atoms after the step
+        std::vector<Atom> appended_atoms;           // atoms appended to the end
+
+        // keyframe representation (shares storage with the structure)
+        CowVector<Atom> atoms_old;                  // atoms before the step
+        CowVector<Atom> atoms_new;                  // atoms after the step
+        CowVector<QVector3D> forces_old;            // forces before the step
+        CowVector<QVector3D> forces_new;            // forces after the step
+
+        // selection buffers before and after the step
+        std::vector<unsigned int> primary_old;
+        std::vector<unsigned int> secondary_old;
+        std::vector<unsigned int> primary_new;
+        std::vector<unsigned int> secondary_new;
+
+        /**
+         * @brief      Whether the step does not change anything
+         *
+         * @return     True if empty
+         */
+        bool is_empty() const;
+
+        /**
+         * @brief      Estimate the memory used by this step
+         *
+         * @return     Number of bytes
+         */
+        size_t get_memory_usage() const;
+    };
+
+    std::shared_ptr<Structure> structure;   // the live structure
+
+    std::deque<Step> steps;                 // recorded steps
+    size_t position = 0;                    // number of steps currently applied
+    size_t memory_usage = 0;                // memory used by the steps (bytes)
+    size_t memory_limit = 256 * 1024 * 1024;// maximum memory used by the steps (bytes)
+
+    // state captured at the start of an edit, turned into a step once the
+    // edit is finished; the atoms are shared with the structure until the
+    // edit modifies them
+    bool pending = false;
+    CowVector<Atom> pending_atoms;
+    CowVector<QVector3D> pending_forces;
+    std::vector<unsigned int> pending_primary;
+    std::vector<unsigned int> pending_secondary;
+
+public:
+    /**
+     * @brief      Constructs a new instance.
+     */
+    StructureHistory();
+
+    /**
+     * @brief      Start a new history for a structure
+     *
+     * @param[in]  _structure  The structure
+     */
+    void reset(const std::shared_ptr<Structure>& _structure);
+
+    /**
+     * @brief      Gets the structure.
+     *
+     * @return     The structure.
+     */
+    inline const std::shared_ptr<Structure>& get_structure() const {
+        return this->structure;
+    }
+
+    /**
+     * @brief      Record the current state before an edit is made
+     *
+     * Any steps that were undone are discarded.
+     */
+    void begin_step();
+
+    /**
+     * @brief      Undo the last step
+     *
+     * @return     True if a step was undone
+     */
+    bool undo();
+
+    /**
+     * @brief      Redo the last undone step
+     *
+     * @return     True if a step was redone
+     */
+    bool redo();
+
+    /**
+     * @brief      Sets the memory limit.
+     *
+     * @param[in]  bytes  Maximum number of bytes used by the journal
+     */
+    void set_memory_limit(size_t bytes);
+
+    /**
+     * @brief      Gets the memory usage.
+     *
+     * @return     The memory used by the journal (bytes).
+     */
+    inline size_t get_memory_usage() const {
+        return this->memory_usage;
+    }
+
+    /**
+     * @brief      Gets the number of recorded steps.
+     *
+     * @return     The number of steps.
+     */
+    inline size_t get_nr_steps() const {
+        return this->steps.size();
+    }
+
+private:
+    /**
+     * @brief      Turn the pending state into a step
+     */
+    void finish_step();
+
+    /**
+     * @brief      Build the delta between two atom lists
+     *
+     * @param[in]  before  The atoms before the edit
+     * @param[in]  after   The atoms after the edit
+     * @param      step    The step
+     *
+     * @return     False if the edit cannot be expressed as a delta
+     */
+    bool build_delta(const std::vector<Atom>& before, const std::vector<Atom>& after, Step& step) const;
+
+    /**
+     * @brief      Apply a step to the structure
+     *
+     * @param[in]  step     The step
+     * @param[in]  forward  True to redo, false to undo
+     */
+    void apply(const Step& step, bool forward);
+
+    /**
+     * @brief      Discard the oldest steps until the memory limit is met
+     */
+    void enforce_memory_limit();
+
+    /**
+     * @brief      Compare the persistent state of two atoms
+     *
+     * @param[in]  a     First atom
+     * @param[in]  b     Second atom
+     *
+     * @return     True if equal (the selection state is ignored)
+     */
+    static bool is_same_atom(const Atom& a, const Atom& b);
+};
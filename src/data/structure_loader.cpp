@@ -20,6 +20,8 @@
 
 #include "structure_loader.h"
 
+#include <QFile>
+
 #include <Eigen/Eigenvalues>
 
 #include <algorithm>
@@ -28,6 +30,40 @@
 #include <cstdio>
 
 namespace {
+/**
+ * @brief      Read-only view of the contents of a file
+ *
+ * The file is memory-mapped, falling back to reading it when mapping is
+ * not supported; the mapping is released when the file is closed.
+ */
+class MappedFile {
+private:
+    QFile file;
+    QByteArray contents;
+
+public:
+    const char* data = nullptr;     // contents of the file
+    size_t size = 0;                // number of bytes
+
+    MappedFile(const std::string& filename) : file(QString(filename.c_str())) {
+        if(!this->file.open(QIODevice::ReadOnly)) {
+            throw std::runtime_error("Could not open " + filename);
+        }
+
+        this->size = (size_t)this->file.size();
+        if(this->size > 0) {
+            const uchar* mapped = this->file.map(0, this->file.size());
+            if(mapped != nullptr) {
+                this->data = reinterpret_cast<const char*>(mapped);
+            } else {
+                this->contents = this->file.readAll();
+                this->data = this->contents.constData();
+                this->size = (size_t)this->contents.size();
+            }
+        }
+    }
+};
+
 /**
  * @brief leading_spaces.
  *
@@ -41,48 +77,6 @@ int leading_spaces(const std::string& value) {
     return count;
 }
 
-/**
- * @brief contains_token.
- *
- * @param line Parameter line.
- * @param token Parameter token.
- */
-inline bool contains_token(const std::string& line, const char* token) {
-    return line.find(token) != std::string::npos;
-}
-
-/**
- * @brief parse_six_columns.
- *
- * @param line Parameter line.
- * @param c1 Parameter c1.
- * @param c2 Parameter c2.
- * @param c3 Parameter c3.
- * @param c4 Parameter c4.
- * @param c5 Parameter c5.
- * @param c6 Parameter c6.
- */
-inline bool parse_six_columns(const std::string& line,
-                              double& c1,
-                              double& c2,
-                              double& c3,
-                              double& c4,
-                              double& c5,
-                              double& c6)
-{
-    const char* p = line.c_str();
-    char* end;
-
-    c1 = std::strtod(p, &end); if (p == end) return false; p = end;
-    c2 = std::strtod(p, &end); if (p == end) return false; p = end;
-    c3 = std::strtod(p, &end); if (p == end) return false; p = end;
-    c4 = std::strtod(p, &end); if (p == end) return false; p = end;
-    c5 = std::strtod(p, &end); if (p == end) return false; p = end;
-    c6 = std::strtod(p, &end); if (p == end) return false;
-
-    return true;
-}
-
 }
 
     /**
@@ -90,6 +84,37 @@ inline bool parse_six_columns(const std::string& line,
      */
 StructureLoader::StructureLoader(){}
 
+    /**
+     * @brief      Load structures via the structure cache
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  format    The cache format of the loader
+     * @param[in]  parse     Function parsing the file on a cache miss
+     *
+     * @return     The structures
+     */
+template<typename Func>
+StructureSets StructureLoader::load_cached(const std::string& filename, StructureCacheFormat format, Func&& parse) {
+    StructureCache& cache = StructureCache::get();
+
+    StructureCache::FileKey key;
+    const bool cacheable = cache.identify(filename, key);
+
+    StructureSets sets;
+    if(!(cacheable && cache.load(key, format, sets))) {
+        sets = parse();
+        if(cacheable) {
+            cache.store(key, format, sets);
+        }
+    }
+
+    if(this->progress) {
+        this->progress->set_progress(1, 1);
+    }
+
+    return sets;
+}
+
     /**
      * @brief      Load a file
      *
@@ -106,14 +131,20 @@ std::shared_ptr<Structure> StructureLoader::load_file(const std::string& filenam
     if(qfi.fileName().startsWith("POSCAR") || 
        qfi.fileName().startsWith("CONTCAR") || 
        qfi.completeSuffix() == "vasp") {
-        structure = this->load_poscar(filename);
+        structure = this->load_cached(filename, STRUCTURE_CACHE_FORMAT_GEOMETRY, [&]() -> StructureSets {
+            return {{this->load_poscar(filename)}};
+        }).front().front();
     } else if(qfi.fileName().startsWith("OUTCAR")) {
         structure = this->load_outcar(filename).back();
     } else if(qfi.completeSuffix() == "geo") {
-        structure = this->load_geo(filename);
+        structure = this->load_cached(filename, STRUCTURE_CACHE_FORMAT_GEOMETRY, [&]() -> StructureSets {
+            return {{this->load_geo(filename)}};
+        }).front().front();
     }  else if(qfi.completeSuffix() == "xyz") {
         qDebug() << "Opening .xyz file";
-        structure = this->load_xyz(filename);
+        structure = this->load_cached(filename, STRUCTURE_CACHE_FORMAT_GEOMETRY, [&]() -> StructureSets {
+            return {{this->load_xyz(filename)}};
+        }).front().front();
     } else if(qfi.completeSuffix() == "yaml" || qfi.completeSuffix() == "yml") {
         structure = this->load_yaml(filename).back();
     }
@@ -135,6 +166,127 @@ std::shared_ptr<Structure> StructureLoader::load_file(const std::string& filenam
      * @return     Structures
      */
 std::vector<std::shared_ptr<Structure>> StructureLoader::load_yaml(const std::string& filename) {
+    return this->load_cached(filename, STRUCTURE_CACHE_FORMAT_YAML, [&]() -> StructureSets {
+        return {this->parse_yaml(filename)};
+    }).front();
+}
+
+    /**
+     * @brief      Load structure from OUTCAR file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Structures
+     */
+std::vector<std::shared_ptr<Structure>> StructureLoader::load_outcar(const std::string& filename) {
+    return this->load_cached(filename, STRUCTURE_CACHE_FORMAT_OUTCAR, [&]() -> StructureSets {
+        return {this->parse_outcar(filename)};
+    }).front();
+}
+
+    /**
+     * @brief      Load the ionic steps of an OUTCAR file as a trajectory
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     The trajectory
+     */
+std::shared_ptr<Trajectory> StructureLoader::load_outcar_trajectory(const std::string& filename) {
+    qDebug() << "Indexing OUTCAR: " << QString(filename.c_str());
+    auto file = std::make_shared<const MappedFile>(filename);
+    auto parser = std::make_shared<OutcarParser>(file->data, file->size);
+
+    // the decoder keeps the mapping and the header read by the parser alive
+    auto trajectory = std::make_shared<Trajectory>([file, parser](size_t offset) {
+        return parser->parse_frame(offset);
+    });
+
+    if(this->progress) {
+        this->progress->set_trajectory(trajectory);
+    }
+
+    StructureCache& cache = StructureCache::get();
+    StructureCache::FileKey key;
+    const bool cacheable = cache.identify(filename, key);
+
+    // a file indexed before only requires its header to be read; frequency
+    // calculations are cached as their single reference structure
+    std::vector<Trajectory::Frame> frames;
+    StructureSets sets;
+    if(cacheable && cache.load_index(key, STRUCTURE_CACHE_FORMAT_OUTCAR_INDEX, frames)) {
+        if(!frames.empty()) {
+            parser->read_frame_header();
+        }
+        trajectory->add_frames(frames);
+    } else if(cacheable && cache.load(key, STRUCTURE_CACHE_FORMAT_OUTCAR, sets) &&
+              sets.size() == 1 && sets.front().size() == 1) {
+        trajectory = std::make_shared<Trajectory>(sets.front());
+    } else {
+        // the scan made while indexing is reused for frequency calculations
+        OutcarParser::Scan scan;
+        parser->set_progress(this->progress);
+        if(parser->index(*trajectory, scan)) {
+            if(cacheable) {
+                cache.store_index(key, STRUCTURE_CACHE_FORMAT_OUTCAR_INDEX, trajectory->get_frames());
+            }
+        } else {
+            const auto structures = parser->parse(scan);
+            if(cacheable) {
+                cache.store(key, STRUCTURE_CACHE_FORMAT_OUTCAR, {structures});
+            }
+            trajectory = std::make_shared<Trajectory>(structures);
+        }
+        parser->set_progress(nullptr);
+    }
+
+    if(this->progress) {
+        this->progress->set_trajectory(trajectory);
+        this->progress->set_progress(1, 1);
+    }
+
+    return trajectory;
+}
+
+    /**
+     * @brief      Load only the final ionic structure from an OUTCAR file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Last ionic structure
+     */
+std::shared_ptr<Structure> StructureLoader::load_outcar_last(const std::string& filename) {
+    // the structure cache is bypassed: its fingerprint samples blocks over
+    // the whole file, which reads more than parsing the final step does
+    auto structure = this->parse_outcar_last(filename);
+
+    if(this->progress) {
+        this->progress->set_progress(1, 1);
+    }
+
+    return structure;
+}
+
+    /**
+     * @brief      Load NEB binary
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Bundled set of structures
+     */
+std::vector<std::vector<std::shared_ptr<Structure>>> StructureLoader::load_neb_bin(const std::string& filename) {
+    return this->load_cached(filename, STRUCTURE_CACHE_FORMAT_NEB_BIN, [&]() -> StructureSets {
+        return this->parse_neb_bin(filename);
+    });
+}
+
+    /**
+     * @brief      Parse structure + vibrational data from pymkmkit YAML file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Structures
+     */
+std::vector<std::shared_ptr<Structure>> StructureLoader::parse_yaml(const std::string& filename) {
     qDebug() << "Loading PyMKMKit YAML file: " << QString(filename.c_str());
 
     std::ifstream infile(filename);
@@ -757,496 +909,44 @@ std::shared_ptr<Structure> StructureLoader::load_poscar(const std::string& filen
 }
 
     /**
-     * @brief      Load structure from OUTCAR file
+     * @brief      Parse all ionic steps from an OUTCAR file
      *
      * @param[in]  filename  The filename
      *
      * @return     Structures
      */
-std::vector<std::shared_ptr<Structure>> StructureLoader::load_outcar(const std::string& filename) {
+std::vector<std::shared_ptr<Structure>> StructureLoader::parse_outcar(const std::string& filename) {
     qDebug() << "Loading OUTCAR: " << QString(filename.c_str());
-    std::ifstream infile(filename);
-
-    if(!infile.is_open()) {
-        throw std::runtime_error("Could not open " + filename);
-    }
-
-    struct ParsedEigenmode {
-        double eigenvalue = 0.0;
-        std::vector<QVector3D> eigenvectors;
-    };
-
-    // vasp version
-    unsigned int vasp_version = 0;
-
-    // current reading state
-    unsigned int readstate = 0;
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS);
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT);
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_OPEN);
-
-    // number of atoms and number of states
-    unsigned int nr_atoms = 0;
-    unsigned int nr_states = 0;
-
-    MatrixUnitcell unitcell = MatrixUnitcell::Zero(3,3);
-    std::vector<double> energies;
-    std::vector<std::string> elements;
-    std::vector<unsigned int> nr_atoms_per_elm;
-    std::vector<ParsedEigenmode> parsed_eigenmodes;
-
-    bool reading_mode_eigenvectors = false;
-
-    /*
-    * Define all the regex patterns
-    */
-    static QRegularExpression whitespace("\\s+");
-    static QRegularExpression regex_vasp_version("^\\s*vasp.([0-9]).([0-9]+).([0-9]+).*$");
-    static QRegularExpression regex_element("^\\s*(VRHFIN\\s+=)([A-Za-z]+)\\s*:.*$");
-    static QRegularExpression regex_ions_per_element("^\\s*(ions per type =\\s+)([0-9 ]+)\\s*$");
-    static QRegularExpression regex_lattice_vectors("^\\s*direct lattice vectors.*$");
-    static QRegularExpression regex_atoms("^\\s*POSITION.*$");
-    static QRegularExpression regex_grab_energy("^\\s+energy  without entropy=\\s+([0-9.-]+)\\s+energy\\(sigma->0\\) =\\s+([0-9.-]+).*$");
-    static QRegularExpression regex_frequency_mode("^\\s*[0-9]+\\s+f(/i)?\\s*=\\s*([0-9eE.+-]+)\\s+THz.*$");
-    static QRegularExpression regex_frequency_eigenvector(
-        "^\\s*(?:[0-9]+\\s+)?([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s*$");
-
-    std::string line;
-
-    std::vector<std::shared_ptr<Structure>> structures;
-
-    while(std::getline(infile, line)) { // loop over all the lines in the file
-        const QString qline(line.c_str());
-
-        if(reading_mode_eigenvectors) {
-            QRegularExpressionMatch mode_vector_match = regex_frequency_eigenvector.match(qline);
-            if(mode_vector_match.hasMatch()) {
-                parsed_eigenmodes.back().eigenvectors.emplace_back(
-                    mode_vector_match.captured(4).toDouble(),
-                    mode_vector_match.captured(5).toDouble(),
-                    mode_vector_match.captured(6).toDouble()
-                );
-
-                if(parsed_eigenmodes.back().eigenvectors.size() == nr_atoms) {
-                    reading_mode_eigenvectors = false;
-                    qDebug() << "Completed eigenmode" << parsed_eigenmodes.size()
-                             << "with" << nr_atoms << "eigenvectors.";
-                }
-
-                continue;
-            }
-
-            if(!parsed_eigenmodes.back().eigenvectors.empty()) {
-                reading_mode_eigenvectors = false;
-            }
-        }
-
-        if(contains_token(line, "THz")) {
-            QRegularExpressionMatch frequency_mode_match = regex_frequency_mode.match(qline);
-            if(frequency_mode_match.hasMatch()) {
-            double eigenvalue = frequency_mode_match.captured(2).toDouble();
-            if(frequency_mode_match.captured(1) == "/i") {
-                eigenvalue *= -1.0;
-            }
-
-            parsed_eigenmodes.push_back({eigenvalue, {}});
-            reading_mode_eigenvectors = true;
-
-            qDebug() << "Detected frequency mode" << parsed_eigenmodes.size()
-                     << "(THz):" << eigenvalue;
-            continue;
-            }
-        }
+    const MappedFile file(filename);
 
-        /*
-         * Collect the vasp version (4 or 5)
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS) ) {
-            // get the elements and put these in an array
-            if(contains_token(line, "vasp.")) {
-                QRegularExpressionMatch match = regex_vasp_version.match(qline);
-                if (match.hasMatch()) {
-
-                    vasp_version = match.captured(1).toUInt();
-                    unsigned int version_major = match.captured(2).toUInt();
-                    unsigned int version_minor = match.captured(3).toUInt();
-
-                    qDebug() << "Detected VASP: " << vasp_version << "." << version_major << "." << version_minor;
-
-                    continue;
-                }
-            }
-        }
-
-        /*
-         * Collect the elements
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS) ) {
-            if(contains_token(line, "VRHFIN")) {
-                QRegularExpressionMatch match = regex_element.match(qline);
-                if (match.hasMatch()) {
-                    elements.push_back(match.captured(2).toStdString());
-
-                    qDebug() << "Captured element:" << match.captured(2);
-
-                    continue;
-                }
-            }
-        }
-
-        /*
-         * Collect the number of ions of each element type
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT) ) {
-            if(contains_token(line, "ions per type")) {
-                QRegularExpressionMatch match = regex_ions_per_element.match(qline);
-                if (match.hasMatch()) {
-                    QString subline = match.captured(2);
-                    QStringList pieces = subline.split(whitespace);
-                    for(unsigned int i=0; i<pieces.size(); i++) {
-                        nr_atoms_per_elm.push_back(pieces[i].toUInt());
-                        nr_atoms += pieces[i].toUInt();
-                    }
-
-                    // remove ions state and elements state
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS);
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT);
-                    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS);
-
-                    // check if a vasp version has been identified, if not, terminate
-                    if(!(vasp_version == 4 || vasp_version == 5 || vasp_version == 6)) {
-                        throw std::runtime_error("Invalid VASP version encountered: " + QString::number(vasp_version).toStdString());
-                    }
-
-                    continue;
-                }
-            }
-        }
-
-        /*
-         * Collect the dimensions of the unit cell. Note that if an IBRION=3 calculation is
-         * being run, this is not gathered by this class. It is assumed that each state
-         * has the same unit cell. (that means, IBRION != 3 calculations)
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS) ) {
-            // get the dimensionality of the unit cell
-            if(contains_token(line, "direct lattice vectors")) {
-                QRegularExpressionMatch match = regex_lattice_vectors.match(qline);
-                if (match.hasMatch()) {
-
-                    // grab next tree lines
-                    for(unsigned int i=0; i<3; i++) {
-                        std::getline(infile, line);
-                        double x, y, z, d4, d5, d6;
-                        if(parse_six_columns(line, x, y, z, d4, d5, d6)) {
-                            unitcell(i,0) = x;
-                            unitcell(i,1) = y;
-                            unitcell(i,2) = z;
-                        }
-                    }
-
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS);
-                    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS);
-
-                    continue;
-                }
-            }
-        }
-
-        /*
-         * Collect the energy of the state
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS) ) {
-            if(contains_token(line, "energy  without entropy=")) {
-                QRegularExpressionMatch match = regex_grab_energy.match(qline);
-                if (match.hasMatch()) {
-
-                    energies.push_back(match.captured(2).toDouble());
-
-                    if(vasp_version == 5) {
-                        nr_states++;
-                    }
-
-                    continue;
-                }
-            }
-        }
-
-        /*
-         * Collect the atomic positions and forces for this state
-         */
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS) ) {
-
-            if(!contains_token(line, "POSITION")) {
-                continue;
-            }
-
-            QRegularExpressionMatch match = regex_atoms.match(qline);
-            if (match.hasMatch()) {
-                std::getline(infile, line); // skip dashed line
-
-                // create a new structure
-                structures.push_back(std::make_shared<Structure>(unitcell));
-                qDebug() << "Parsed ionic structure" << structures.size() << "from OUTCAR.";
-
-                for(unsigned i=0; i<nr_atoms_per_elm.size(); i++) {
-                    for(unsigned int j=0; j<nr_atoms_per_elm[i]; j++) {
-                        std::getline(infile, line);
-                        double x, y, z, fx, fy, fz;
-                        if(parse_six_columns(line, x, y, z, fx, fy, fz)) {
-
-                            unsigned int atnr = AtomSettings::get().get_atom_elnr(elements[i]);
-                            structures.back()->add_atom(atnr, x, y, z, fx, fy, fz);
-                        }
-                    }
-                }
-
-                if(vasp_version == 4) {
-                    nr_states++;
-                }
-
-                continue;
-            }
-        }
-    }
-
-    // energies are sometimes given either before or after the coordinates, hence, only
-    // set the energies after everything has been parsed
-    if(energies.size() != structures.size()) {
-        throw std::runtime_error("Number of energies does not match number of structures.");
-    }
-
-    for(unsigned int i=0; i<energies.size(); i++) {
-        structures[i]->set_energy(energies[i]);
-    }
-
-    if(!parsed_eigenmodes.empty()) {
-        if(structures.empty()) {
-            throw std::runtime_error("Encountered eigenmodes in OUTCAR without atomic structures.");
-        }
-
-        qDebug() << "Frequency calculation detected. Ionic structures parsed:" << structures.size()
-                 << "; eigenmodes parsed:" << parsed_eigenmodes.size();
-
-        // For frequency calculations, keep only the first ionic structure as reference geometry.
-        auto reference_structure = structures.front();
-        reference_structure->clear_eigenmodes();
-
-        unsigned int nr_added_modes = 0;
-        for(const auto& mode : parsed_eigenmodes) {
-            if(mode.eigenvectors.size() != nr_atoms) {
-                qDebug() << "Skipping incomplete eigenmode, expected" << nr_atoms
-                         << "vectors but found" << mode.eigenvectors.size();
-                continue;
-            }
-
-            reference_structure->add_eigenmode(mode.eigenvalue, mode.eigenvectors);
-            nr_added_modes++;
-        }
-
-        qDebug() << "Stored" << nr_added_modes << "eigenmodes on first ionic structure.";
-
-        structures = {reference_structure};
-
-        if(!energies.empty()) {
-            structures.front()->set_energy(energies.front());
-        }
-    }
-
-    return structures;
+    OutcarParser parser(file.data, file.size);
+    parser.set_progress(this->progress);
+    return parser.parse();
 }
 
     /**
-     * @brief      Load only the final ionic structure from an OUTCAR file
+     * @brief      Parse only the final ionic structure from an OUTCAR file
      *
      * @param[in]  filename  The filename
      *
      * @return     Last ionic structure
      */
-std::shared_ptr<Structure> StructureLoader::load_outcar_last(const std::string& filename) {
+std::shared_ptr<Structure> StructureLoader::parse_outcar_last(const std::string& filename) {
     qDebug() << "Loading final ionic step from OUTCAR: " << QString(filename.c_str());
-    std::ifstream infile(filename);
+    const MappedFile file(filename);
 
-    if(!infile.is_open()) {
-        throw std::runtime_error("Could not open " + filename);
-    }
-
-    unsigned int vasp_version = 0;
-
-    unsigned int readstate = 0;
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS);
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT);
-    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_OPEN);
-
-    unsigned int nr_atoms = 0;
-
-    MatrixUnitcell unitcell = MatrixUnitcell::Zero(3,3);
-    std::vector<std::string> elements;
-    std::vector<unsigned int> nr_atoms_per_elm;
-
-    bool has_energy = false;
-    double last_energy = 0.0;
-
-    std::streampos last_atoms_block_start = std::streampos(-1);
-
-    static QRegularExpression regex_vasp_version("^\\s*vasp.([0-9]).([0-9]+).([0-9]+).*$");
-    static QRegularExpression regex_element("^\\s*(VRHFIN\\s+=)([A-Za-z]+)\\s*:.*$");
-    static QRegularExpression regex_ions_per_element("^\\s*(ions per type =\\s+)([0-9 ]+)\\s*$");
-    static QRegularExpression regex_lattice_vectors("^\\s*direct lattice vectors.*$");
-    static QRegularExpression regex_atoms("^\\s*POSITION.*$");
-    static QRegularExpression regex_grab_energy("^\\s+energy  without entropy=\\s+([0-9.-]+)\\s+energy\\(sigma->0\\) =\\s+([0-9.-]+).*$");
-
-    std::string line;
-    while(true) {
-        const std::streampos line_start = infile.tellg();
-        if(!std::getline(infile, line)) {
-            break;
-        }
-
-        const QString qline(line.c_str());
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS)) {
-            if(contains_token(line, "vasp.")) {
-                QRegularExpressionMatch match = regex_vasp_version.match(qline);
-                if(match.hasMatch()) {
-                    vasp_version = match.captured(1).toUInt();
-                    continue;
-                }
-            }
-        }
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS)) {
-            if(contains_token(line, "VRHFIN")) {
-                QRegularExpressionMatch match = regex_element.match(qline);
-                if(match.hasMatch()) {
-                    elements.push_back(match.captured(2).toStdString());
-                    continue;
-                }
-            }
-        }
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT)) {
-            if(contains_token(line, "ions per type")) {
-                QRegularExpressionMatch match = regex_ions_per_element.match(qline);
-                if(match.hasMatch()) {
-                    QStringList pieces = match.captured(2).split(" ", Qt::SkipEmptyParts);
-                    nr_atoms_per_elm.clear();
-                    nr_atoms = 0;
-
-                    for(unsigned int i=0; i<pieces.size(); i++) {
-                        nr_atoms_per_elm.push_back(pieces[i].toUInt());
-                        nr_atoms += pieces[i].toUInt();
-                    }
-
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ELEMENTS);
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT);
-                    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS);
-
-                    if(!(vasp_version == 4 || vasp_version == 5 || vasp_version == 6)) {
-                        throw std::runtime_error("Invalid VASP version encountered: " + QString::number(vasp_version).toStdString());
-                    }
-
-                    continue;
-                }
-            }
-        }
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS)) {
-            if(contains_token(line, "direct lattice vectors")) {
-                QRegularExpressionMatch match = regex_lattice_vectors.match(qline);
-                if(match.hasMatch()) {
-                    for(unsigned int i=0; i<3; i++) {
-                        if(!std::getline(infile, line)) {
-                            throw std::runtime_error("Unexpected end-of-file while reading OUTCAR lattice vectors.");
-                        }
-
-                        double x, y, z, d4, d5, d6;
-                        if(parse_six_columns(line, x, y, z, d4, d5, d6)) {
-                            unitcell(i,0) = x;
-                            unitcell(i,1) = y;
-                            unitcell(i,2) = z;
-                        }
-                    }
-
-                    readstate &= ~(1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_LATTICE_VECTORS);
-                    readstate |= (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS);
-
-                    continue;
-                }
-            }
-        }
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS)) {
-            if(contains_token(line, "energy  without entropy=")) {
-                QRegularExpressionMatch match = regex_grab_energy.match(qline);
-                if(match.hasMatch()) {
-                    last_energy = match.captured(2).toDouble();
-                    has_energy = true;
-                    continue;
-                }
-            }
-        }
-
-        if(readstate & (1 << OutcarReadStatus::VASP_OUTCAR_READ_STATE_ATOMS)) {
-            if(contains_token(line, "POSITION")) {
-                QRegularExpressionMatch match = regex_atoms.match(qline);
-                if(match.hasMatch()) {
-                    last_atoms_block_start = line_start;
-                }
-            }
-        }
-    }
-
-    if(last_atoms_block_start == std::streampos(-1)) {
-        throw std::runtime_error("OUTCAR does not contain ionic images.");
-    }
-
-    infile.clear();
-    infile.seekg(last_atoms_block_start);
-    if(!infile.good()) {
-        throw std::runtime_error("Failed to seek to final ionic structure in OUTCAR.");
-    }
-
-    if(!std::getline(infile, line) || !regex_atoms.match(QString(line.c_str())).hasMatch()) {
-        throw std::runtime_error("Failed to read final ionic structure header from OUTCAR.");
-    }
-
-    if(!std::getline(infile, line)) {
-        throw std::runtime_error("Unexpected end-of-file before final ionic coordinates.");
-    }
-
-    auto final_structure = std::make_shared<Structure>(unitcell);
-    for(unsigned int i=0; i<nr_atoms_per_elm.size(); i++) {
-        for(unsigned int j=0; j<nr_atoms_per_elm[i]; j++) {
-            if(!std::getline(infile, line)) {
-                throw std::runtime_error("Unexpected end-of-file while reading final ionic coordinates.");
-            }
-
-            double x, y, z, fx, fy, fz;
-            if(!parse_six_columns(line, x, y, z, fx, fy, fz)) {
-                throw std::runtime_error("Invalid atomic position line in final ionic structure.");
-            }
-
-            unsigned int atnr = AtomSettings::get().get_atom_elnr(elements[i]);
-            final_structure->add_atom(atnr, x, y, z, fx, fy, fz);
-        }
-    }
-
-    if(has_energy) {
-        final_structure->set_energy(last_energy);
-    }
-
-    return final_structure;
+    OutcarParser parser(file.data, file.size);
+    return parser.parse_last();
 }
 
     /**
-     * @brief      Load NEB binary
+     * @brief      Parse NEB binary
      *
      * @param[in]  filename  The filename
      *
      * @return     Bundled set of structures
      */
-std::vector<std::vector<std::shared_ptr<Structure>>> StructureLoader::load_neb_bin(const std::string& filename) {
+std::vector<std::vector<std::shared_ptr<Structure>>> StructureLoader::parse_neb_bin(const std::string& filename) {
     std::ifstream infile(filename, std::ios::in | std::ios::binary);
 
     uint32_t datatype = 0;
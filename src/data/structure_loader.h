@@ -25,23 +25,21 @@
 #include <fstream>
 
 #include "atom_settings.h"
+#include "load_progress.h"
+#include "outcar_parser.h"
 #include "structure.h"
-
-enum OutcarReadStatus {
-    VASP_OUTCAR_READ_STATE_UNDEFINED,
-    VASP_OUTCAR_READ_STATE_ELEMENTS,
-    VASP_OUTCAR_READ_STATE_IONS_PER_ELEMENT,
-    VASP_OUTCAR_READ_STATE_LATTICE_VECTORS,
-    VASP_OUTCAR_READ_STATE_ATOMS,
-    VASP_OUTCAR_READ_STATE_OPEN,
-    VASP_OUTCAR_READ_STATE_FINISHED
-};
+#include "structure_cache.h"
+#include "trajectory.h"
 
 /**
  * @brief StructureLoader class.
+ *
+ * The public loaders consult the StructureCache before parsing a file and
+ * store the parsed structures in it afterwards.
  */
 class StructureLoader {
 private:
+    LoadProgress* progress = nullptr;   // optional progress monitor
 
 public:
     /**
@@ -49,6 +47,19 @@ public:
      */
     StructureLoader();
 
+    /**
+     * @brief      Monitor the progress of subsequent loads
+     *
+     * Used when loading in a background thread; OUTCAR files report the
+     * number of bytes processed while parsing (trajectories are published
+     * before they are filled), other files only report completion.
+     *
+     * @param      _progress  The progress monitor (must outlive the loads)
+     */
+    inline void set_progress(LoadProgress* _progress) {
+        this->progress = _progress;
+    }
+
     /**
      * @brief      Load a file
      *
@@ -67,9 +78,28 @@ public:
      */
     std::vector<std::shared_ptr<Structure>> load_outcar(const std::string& filename);
 
+    /**
+     * @brief      Load the ionic steps of an OUTCAR file as a trajectory
+     *
+     * Only the energy and RMS force of every ionic step are kept in memory;
+     * the steps themselves are parsed from the (memory-mapped) file when
+     * requested. The trajectory is published via the progress monitor
+     * before it is filled. Frequency calculations yield a trajectory
+     * holding the reference structure. The frame index is kept in the
+     * structure cache, such that reopening the file only reads its header.
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     The trajectory
+     */
+    std::shared_ptr<Trajectory> load_outcar_trajectory(const std::string& filename);
+
     /**
      * @brief      Load only the final ionic structure from an OUTCAR file
      *
+     * Only the header and the final ionic step are read; the structure
+     * cache is not used.
+     *
      * @param[in]  filename  The filename
      *
      * @return     Last ionic structure
@@ -95,6 +125,54 @@ public:
     std::vector<std::vector<std::shared_ptr<Structure>>> load_neb_bin(const std::string& filename);
 
 private:
+    /**
+     * @brief      Load structures via the structure cache
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  format    The cache format of the loader
+     * @param[in]  parse     Function parsing the file on a cache miss
+     *
+     * @return     The structures
+     */
+    template<typename Func>
+    StructureSets load_cached(const std::string& filename, StructureCacheFormat format, Func&& parse);
+
+    /**
+     * @brief      Parse structure + vibrational data from pymkmkit YAML file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Structures
+     */
+    std::vector<std::shared_ptr<Structure>> parse_yaml(const std::string& filename);
+
+    /**
+     * @brief      Parse all ionic steps from an OUTCAR file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Structures
+     */
+    std::vector<std::shared_ptr<Structure>> parse_outcar(const std::string& filename);
+
+    /**
+     * @brief      Parse only the final ionic structure from an OUTCAR file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Last ionic structure
+     */
+    std::shared_ptr<Structure> parse_outcar_last(const std::string& filename);
+
+    /**
+     * @brief      Parse NEB binary
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     Bundled set of structures
+     */
+    std::vector<std::vector<std::shared_ptr<Structure>>> parse_neb_bin(const std::string& filename);
+
     /**
      * @brief      Load structure from .geo file
      *
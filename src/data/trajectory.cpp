@@ -0,0 +1,415 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "trajectory.h"
+
+#include <QDebug>
+
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+std::atomic<size_t> Trajectory::default_cache_limit{512ull * 1024 * 1024};
+
+/**
+ * @brief      Constructs a trajectory holding resident frames
+ *
+ * @param[in]  structures  The frames
+ */
+Trajectory::Trajectory(const std::vector<std::shared_ptr<Structure>>& structures) :
+cache_limit(Trajectory::default_cache_limit) {
+    this->add_structures(structures);
+}
+
+/**
+ * @brief      Constructs a trajectory decoding its frames on demand
+ *
+ * @param[in]  decoder  The decoder (called from any thread)
+ */
+Trajectory::Trajectory(Decoder _decoder) :
+decoder(std::move(_decoder)),
+cache_limit(Trajectory::default_cache_limit) {
+
+}
+
+/**
+ * @brief      Destroys the object.
+ */
+Trajectory::~Trajectory() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->prefetch_stop = true;
+    }
+    this->prefetch_wake.notify_one();
+
+    if(this->prefetcher) {
+        this->prefetcher->wait();
+    }
+}
+
+    /**
+     * @brief      Gets the number of frames.
+     *
+     * @return     The number of frames.
+     */
+size_t Trajectory::size() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->frames.size();
+}
+
+    /**
+     * @brief      Gets the energy of a frame.
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The energy.
+     */
+double Trajectory::get_energy(size_t idx) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->frames.at(idx).energy;
+}
+
+    /**
+     * @brief      Gets the root mean square force of a frame.
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The root mean square force.
+     */
+double Trajectory::get_rms_force(size_t idx) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->frames.at(idx).rms_force;
+}
+
+    /**
+     * @brief      Gets the resident data of all frames.
+     *
+     * @return     The frames.
+     */
+std::vector<Trajectory::Frame> Trajectory::get_frames() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->frames;
+}
+
+    /**
+     * @brief      Get a frame, decoding it if it is not cached
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The frame.
+     */
+std::shared_ptr<Structure> Trajectory::get_frame(size_t idx) {
+    size_t locator = 0;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(idx >= this->frames.size()) {
+            throw std::out_of_range("Frame " + std::to_string(idx) + " is not part of the trajectory.");
+        }
+
+        // a frame that is being prepared in the background is ready shortly
+        this->frame_prepared.wait(lock, [&]() {
+            return this->preparing.count(idx) == 0;
+        });
+
+        if(!this->decoder) {
+            return this->resident[idx];
+        }
+
+        auto got = this->cache.find(idx);
+        if(got != this->cache.end()) {
+            this->lru.splice(this->lru.begin(), this->lru, got->second.lru_pos);
+            return got->second.structure;
+        }
+
+        locator = this->frames[idx].locator;
+    }
+
+    // decode without holding the lock such that other frames remain accessible
+    auto structure = this->decoder(locator);
+    structure->set_energy(this->get_energy(idx));
+    Trajectory::prepare(*structure);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto got = this->cache.find(idx);
+    if(got != this->cache.end()) {     // decoded concurrently by another thread
+        return got->second.structure;
+    }
+
+    this->insert(idx, structure, false);
+
+    return structure;
+}
+
+    /**
+     * @brief      Whether a frame can be shown without decoding it or
+     *             deriving its bonds
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     True if the frame has been prepared.
+     */
+bool Trajectory::is_prepared(size_t idx) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(idx >= this->frames.size() || this->preparing.count(idx) > 0) {
+        return false;
+    }
+
+    return this->decoder ? this->cache.count(idx) > 0 : this->prepared[idx];
+}
+
+    /**
+     * @brief      Get a frame only if it can be shown without decoding it
+     *             or deriving its bonds
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The frame, or a null pointer if it is not prepared.
+     */
+std::shared_ptr<Structure> Trajectory::get_prepared_frame(size_t idx) const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(idx >= this->frames.size() || this->preparing.count(idx) > 0) {
+        return nullptr;
+    }
+
+    if(!this->decoder) {
+        return this->prepared[idx] ? this->resident[idx] : nullptr;
+    }
+
+    auto got = this->cache.find(idx);
+    return got != this->cache.end() ? got->second.structure : nullptr;
+}
+
+    /**
+     * @brief      Prepare the frames following a frame in the background
+     *
+     * @param[in]  idx    The frame being shown
+     * @param[in]  step   Step between the frames that are shown
+     * @param[in]  count  Number of frames to prepare
+     */
+void Trajectory::prefetch(size_t idx, int step, size_t count) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->prefetch_queue.clear();
+    const size_t n = this->frames.size();
+    const size_t stride = (size_t)std::abs(step);
+    if(stride == 0) {
+        return;
+    }
+
+    // stop before returning to the frame being shown
+    for(size_t i=1; i<=count && i*stride < n; i++) {
+        const size_t offset = i * stride;
+        const size_t next = (step >= 0) ? (idx + offset) % n : (idx + n - offset) % n;
+        if(this->decoder ? this->cache.count(next) > 0 : this->prepared[next]) {
+            continue;
+        }
+
+        this->prefetch_queue.emplace_back(next, this->decoder ? nullptr : this->resident[next]->clone_for_view());
+    }
+
+    if(this->prefetch_queue.empty()) {
+        return;
+    }
+
+    if(!this->prefetcher) {
+        this->prefetcher.reset(QThread::create([this]() {
+            this->run_prefetcher();
+        }));
+        this->prefetcher->start(QThread::LowPriority);
+    }
+    this->prefetch_wake.notify_one();
+}
+
+    /**
+     * @brief      Append frames to be decoded on demand
+     *
+     * @param[in]  new_frames  The frames
+     */
+void Trajectory::add_frames(const std::vector<Frame>& new_frames) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(!this->decoder) {
+        throw std::logic_error("Cannot add frames without decoder to a trajectory.");
+    }
+    this->frames.insert(this->frames.end(), new_frames.begin(), new_frames.end());
+}
+
+    /**
+     * @brief      Append resident frames
+     *
+     * @param[in]  structures  The frames
+     */
+void Trajectory::add_structures(const std::vector<std::shared_ptr<Structure>>& structures) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(this->decoder) {
+        throw std::logic_error("Cannot add resident frames to a decoded trajectory.");
+    }
+
+    for(const auto& structure : structures) {
+        Frame frame;
+        frame.locator = this->frames.size();
+        frame.energy = structure->get_energy();
+        frame.rms_force = structure->get_rms_force();
+        this->frames.push_back(frame);
+        this->resident.push_back(structure);
+        this->prepared.push_back(false);
+    }
+}
+
+    /**
+     * @brief      Sets the maximum memory used by the cached frames.
+     *
+     * @param[in]  bytes  The limit in bytes
+     */
+void Trajectory::set_cache_limit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->cache_limit = bytes;
+    this->evict();
+}
+
+    /**
+     * @brief      Gets the memory used by the cached frames.
+     *
+     * @return     The memory usage in bytes.
+     */
+size_t Trajectory::get_cache_usage() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->cache_usage;
+}
+
+    /**
+     * @brief      Estimate the memory used by a frame
+     *
+     * Covers the atoms, forces and radii, the bonds, and the atom arrays
+     * and bond graph when these have been built. Frames are prepared
+     * before they are inserted, so the arrays are included; data derived
+     * after insertion (once a frame is shown) is not accounted for.
+     *
+     * @param[in]  structure  The frame
+     *
+     * @return     The memory usage in bytes.
+     */
+size_t Trajectory::estimate_size(const Structure& structure) {
+    return sizeof(Structure) +
+           structure.get_nr_atoms() * (sizeof(Atom) + sizeof(QVector3D) + sizeof(double)) +
+           structure.get_bonds().size() * sizeof(Bond) +
+           structure.get_derived_memory_usage();
+}
+
+    /**
+     * @brief      Build the data of a frame that is derived when it is shown
+     *
+     * @param      structure  The frame
+     */
+void Trajectory::prepare(Structure& structure) {
+    structure.update();
+    structure.get_atom_arrays();
+    structure.get_atom_instances();
+    structure.get_bond_instances();
+}
+
+    /**
+     * @brief      Insert a decoded frame in the cache
+     *
+     * @param[in]  idx         The index
+     * @param[in]  structure   The frame
+     * @param[in]  prefetched  Whether the frame is inserted ahead of being shown
+     */
+void Trajectory::insert(size_t idx, const std::shared_ptr<Structure>& structure, bool prefetched) {
+    // keep the shown frame in front such that it is the last to be evicted
+    const auto pos = (prefetched && !this->lru.empty()) ? std::next(this->lru.begin()) : this->lru.begin();
+
+    CacheEntry& entry = this->cache[idx];
+    entry.structure = structure;
+    entry.size = Trajectory::estimate_size(*structure);
+    entry.lru_pos = this->lru.insert(pos, idx);
+    this->cache_usage += entry.size;
+    this->evict();
+}
+
+    /**
+     * @brief      Prepare the requested frames until asked to stop
+     */
+void Trajectory::run_prefetcher() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while(true) {
+        this->prefetch_wake.wait(lock, [this]() {
+            return this->prefetch_stop || !this->prefetch_queue.empty();
+        });
+
+        if(this->prefetch_stop) {
+            return;
+        }
+
+        const size_t idx = this->prefetch_queue.front().first;
+        std::shared_ptr<Structure> structure = this->prefetch_queue.front().second;
+        this->prefetch_queue.pop_front();
+
+        // skip frames that have been decoded in the meantime
+        if(this->decoder ? this->cache.count(idx) > 0 : this->prepared[idx]) {
+            continue;
+        }
+
+        const size_t locator = this->frames[idx].locator;
+        const double energy = this->frames[idx].energy;
+        this->preparing.insert(idx);
+        lock.unlock();
+
+        try {
+            if(this->decoder) {
+                structure = this->decoder(locator);
+                structure->set_energy(energy);
+            }
+            Trajectory::prepare(*structure);
+        } catch(const std::exception& e) {
+            qDebug() << "Could not prefetch frame" << idx << ":" << e.what();
+            structure.reset();
+        }
+
+        lock.lock();
+        this->preparing.erase(idx);
+        if(structure) {
+            if(!this->decoder) {
+                this->resident[idx] = structure;
+                this->prepared[idx] = true;
+            } else if(this->cache.count(idx) == 0) {
+                this->insert(idx, structure, true);
+            }
+        }
+        this->frame_prepared.notify_all();
+    }
+}
+
+    /**
+     * @brief      Remove the least recently used frames until the cache fits
+     *
+     * The most recently used frame is always kept. Requires the mutex to
+     * be held.
+     */
+void Trajectory::evict() {
+    while(this->cache_usage > this->cache_limit && this->lru.size() > 1) {
+        const size_t idx = this->lru.back();
+        this->lru.pop_back();
+
+        auto got = this->cache.find(idx);
+        this->cache_usage -= got->second.size;
+        this->cache.erase(got);
+    }
+}
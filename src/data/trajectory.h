@@ -0,0 +1,291 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QThread>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "structure.h"
+
+/**
+ * @brief      Sequence of frames (e.g. the ionic steps of an OUTCAR)
+ *
+ * Only a few scalars per frame are kept resident, such that the complete
+ * energy and force series can be shown without holding every frame in
+ * memory. The frames themselves are either kept resident (small series,
+ * e.g. NEB images) or decoded on demand by a decoder, in which case the
+ * most recently used frames are kept in a cache bounded in size.
+ *
+ * Frames may be appended while the trajectory is being read; all functions
+ * are thread-safe. Frames ahead of the one being shown can be prepared
+ * (decoded and their bonds, atom arrays and instances for drawing
+ * derived) on a low priority thread, see prefetch().
+ */
+class Trajectory {
+public:
+    /**
+     * @brief      Resident data of a frame
+     */
+    struct Frame {
+        size_t locator = 0;         // passed to the decoder (e.g. an offset in a file)
+        double energy = 0.0;        // energy of the frame
+        double rms_force = 0.0;     // root mean square force of the frame
+    };
+
+    // function decoding the frame with the given locator
+    typedef std::function<std::shared_ptr<Structure>(size_t)> Decoder;
+
+private:
+    /**
+     * @brief      Decoded frame held in the cache
+     */
+    struct CacheEntry {
+        std::shared_ptr<Structure> structure;   // the frame
+        size_t size = 0;                        // estimated memory usage in bytes
+        std::list<size_t>::iterator lru_pos;    // position in the recently used list
+    };
+
+    Decoder decoder;                                        // null if the frames are resident
+    std::vector<Frame> frames;                              // resident data of all frames
+    std::vector<std::shared_ptr<Structure>> resident;       // the frames (only without decoder)
+    std::vector<bool> prepared;                             // whether the derived data of a resident frame is built
+
+    std::list<size_t> lru;                                  // cached frames, most recently used first
+    std::unordered_map<size_t, CacheEntry> cache;           // cached frames by index
+    size_t cache_usage = 0;                                 // memory used by the cached frames (bytes)
+    size_t cache_limit;                                     // maximum memory used by the cached frames (bytes)
+
+    // frames ahead of the shown frame are prepared by a separate thread
+    std::unique_ptr<QThread> prefetcher;                    // prefetch thread (null until first used)
+    std::deque<std::pair<size_t, std::shared_ptr<Structure>>> prefetch_queue; // frames to prepare (with a copy if resident)
+    std::unordered_set<size_t> preparing;                   // frames being prepared by the prefetch thread
+    bool prefetch_stop = false;                             // whether the prefetch thread should exit
+    std::condition_variable prefetch_wake;                  // signals a new request to the prefetch thread
+    std::condition_variable frame_prepared;                 // signals that a frame has been prepared
+
+    mutable std::mutex mutex;                               // guards all of the above
+
+    static std::atomic<size_t> default_cache_limit;         // cache limit of new trajectories (bytes)
+
+public:
+    /**
+     * @brief      Constructs a trajectory holding resident frames
+     *
+     * @param[in]  structures  The frames
+     */
+    Trajectory(const std::vector<std::shared_ptr<Structure>>& structures);
+
+    /**
+     * @brief      Constructs a trajectory decoding its frames on demand
+     *
+     * @param[in]  decoder  The decoder (called from any thread)
+     */
+    Trajectory(Decoder decoder);
+
+    /**
+     * @brief      Destroys the object.
+     */
+    ~Trajectory();
+
+    /**
+     * @brief      Gets the number of frames.
+     *
+     * @return     The number of frames.
+     */
+    size_t size() const;
+
+    /**
+     * @brief      Gets the energy of a frame.
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The energy.
+     */
+    double get_energy(size_t idx) const;
+
+    /**
+     * @brief      Gets the root mean square force of a frame.
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The root mean square force.
+     */
+    double get_rms_force(size_t idx) const;
+
+    /**
+     * @brief      Gets the resident data of all frames.
+     *
+     * @return     The frames.
+     */
+    std::vector<Frame> get_frames() const;
+
+    /**
+     * @brief      Get a frame, decoding it if it is not cached
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The frame.
+     */
+    std::shared_ptr<Structure> get_frame(size_t idx);
+
+    /**
+     * @brief      Whether a frame can be shown without decoding it or
+     *             deriving its bonds
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     True if the frame has been prepared.
+     */
+    bool is_prepared(size_t idx) const;
+
+    /**
+     * @brief      Get a frame only if it can be shown without decoding it
+     *             or deriving its bonds
+     *
+     * Does not block on frames being prepared in the background and does
+     * not change the order in which cached frames are evicted.
+     *
+     * @param[in]  idx   The index
+     *
+     * @return     The frame, or a null pointer if it is not prepared.
+     */
+    std::shared_ptr<Structure> get_prepared_frame(size_t idx) const;
+
+    /**
+     * @brief      Prepare the frames following a frame in the background
+     *
+     * Decodes the frames and derives their bonds, atom arrays and the
+     * instances for drawing (see AtomInstances) on a low priority thread,
+     * such that showing them afterwards only requires get_frame() to
+     * return a cached frame and the renderer to upload its instances. A
+     * previous request that has not been completed is abandoned. Frames
+     * wrap around at the ends of the trajectory.
+     *
+     * Resident frames are copied by the calling thread, such that the
+     * prefetch thread never accesses a frame that is being shown; call
+     * this function from the thread showing the frames.
+     *
+     * @param[in]  idx    The frame being shown
+     * @param[in]  step   Step between the frames that are shown (e.g. +1,
+     *                    -1, or larger when frames are skipped)
+     * @param[in]  count  Number of frames to prepare
+     */
+    void prefetch(size_t idx, int step, size_t count);
+
+    /**
+     * @brief      Append frames to be decoded on demand
+     *
+     * @param[in]  new_frames  The frames
+     */
+    void add_frames(const std::vector<Frame>& new_frames);
+
+    /**
+     * @brief      Append resident frames
+     *
+     * @param[in]  structures  The frames
+     */
+    void add_structures(const std::vector<std::shared_ptr<Structure>>& structures);
+
+    /**
+     * @brief      Determines if the frames are resident.
+     *
+     * @return     True if resident, False if decoded on demand.
+     */
+    inline bool is_resident() const {
+        return !this->decoder;
+    }
+
+    /**
+     * @brief      Sets the maximum memory used by the cached frames.
+     *
+     * @param[in]  bytes  The limit in bytes
+     */
+    void set_cache_limit(size_t bytes);
+
+    /**
+     * @brief      Gets the memory used by the cached frames.
+     *
+     * @return     The memory usage in bytes.
+     */
+    size_t get_cache_usage() const;
+
+    /**
+     * @brief      Sets the cache limit of trajectories constructed afterwards.
+     *
+     * @param[in]  bytes  The limit in bytes
+     */
+    static void set_default_cache_limit(size_t bytes) {
+        Trajectory::default_cache_limit = bytes;
+    }
+
+private:
+    /**
+     * @brief      Estimate the memory used by a frame
+     *
+     * @param[in]  structure  The frame
+     *
+     * @return     The memory usage in bytes.
+     */
+    static size_t estimate_size(const Structure& structure);
+
+    /**
+     * @brief      Build the data of a frame that is derived when it is shown
+     *
+     * @param      structure  The frame
+     */
+    static void prepare(Structure& structure);
+
+    /**
+     * @brief      Insert a decoded frame in the cache
+     *
+     * Requires the mutex to be held.
+     *
+     * @param[in]  idx         The index
+     * @param[in]  structure   The frame
+     * @param[in]  prefetched  Whether the frame is inserted ahead of being
+     *                         shown; such frames are placed behind the most
+     *                         recently used frame
+     */
+    void insert(size_t idx, const std::shared_ptr<Structure>& structure, bool prefetched);
+
+    /**
+     * @brief      Prepare the requested frames until asked to stop
+     */
+    void run_prefetcher();
+
+    /**
+     * @brief      Remove the least recently used frames until the cache fits
+     *
+     * The most recently used frame is always kept. Requires the mutex to
+     * be held.
+     */
+    void evict();
+};
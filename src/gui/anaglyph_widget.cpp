@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <QMenu>
 #include <QOpenGLContext>
+#include <QSettings>
 #include <QTimer>
 #include <QtMath>
 
@@ -85,6 +86,10 @@ AnaglyphWidget::AnaglyphWidget(QWidget* parent)
 
     setMouseTracking(true);
 
+    // ray-cast impostors are cheaper than meshes on software renderers
+    flag_impostors = QSettings().value("render/impostors", false).toBool();
+    render_detail = QSettings().value("render/detail", StructureRenderer::DETAIL_DEFAULT).toInt();
+
     // These can help avoid Qt painting a background behind/composited with the GL buffer.
     // (Safe for typical QOpenGLWidget usage.)
     setAutoFillBackground(false);
@@ -124,6 +129,7 @@ QSize AnaglyphWidget::sizeHint() const
 void AnaglyphWidget::cleanup()
 {
     makeCurrent();
+    structure_renderer.reset();     // releases its buffers and textures in this context
     doneCurrent();
 }
 
@@ -153,6 +159,8 @@ void AnaglyphWidget::initializeGL()
         qDebug() << "Draw unitcell disabled";
         structure_renderer->disable_draw_unitcell();
     }
+    structure_renderer->set_impostors(flag_impostors);
+    structure_renderer->set_detail(render_detail);
 
     qDebug() << "Build Framebuffers";
     build_framebuffers();
@@ -280,6 +288,7 @@ void AnaglyphWidget::set_active_highlight(bool active)
 void AnaglyphWidget::set_structure_conservative(const std::shared_ptr<Structure>& s)
 {
     structure = s;
+    structure->update();    // views derive bonds only once shown
     user_action->set_structure(structure);
     update();
 }
@@ -610,6 +619,49 @@ void AnaglyphWidget::set_stereo(QString stereo_name)
     update();
 }
 
+    /**
+     * @brief      Set whether atoms and bonds are drawn as ray-cast impostors
+     *
+     * @param[in]  impostors  Whether to use impostors rather than meshes
+     */
+void AnaglyphWidget::set_impostors(bool impostors)
+{
+    flag_impostors = impostors;
+    if (structure_renderer) {
+        structure_renderer->set_impostors(impostors);
+    }
+    update();
+}
+
+    /**
+     * @brief      Set the level of detail of the atom and bond meshes
+     *
+     * @param[in]  detail  The detail, between StructureRenderer::DETAIL_MIN and DETAIL_MAX
+     */
+void AnaglyphWidget::set_render_detail(int detail)
+{
+    render_detail = detail;
+    if (structure_renderer) {
+        structure_renderer->set_detail(detail);
+    }
+    update();
+}
+
+    /**
+     * @brief      Set the frames to keep on the GPU during playback
+     *
+     * The frames are uploaded when drawing next, such that the frames that
+     * come up are shown without transferring their instances.
+     *
+     * @param[in]  frames  The frames ahead of the shown frame, empty when playback stops
+     */
+void AnaglyphWidget::set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames)
+{
+    if (structure_renderer) {
+        structure_renderer->set_playback_frames(frames);
+    }
+}
+
 /* PRIVATE */
 
     /**
@@ -619,6 +671,14 @@ void AnaglyphWidget::load_shaders()
 {
     shader_manager->create_shader_program("model_shader", ShaderProgramType::ModelShader,
                                          ":/assets/shaders/phong.vs", ":/assets/shaders/phong.fs");
+    shader_manager->create_shader_program("atom_shader", ShaderProgramType::AtomShader,
+                                         ":/assets/shaders/atom.vs", ":/assets/shaders/atom.fs");
+    shader_manager->create_shader_program("bond_shader", ShaderProgramType::BondShader,
+                                         ":/assets/shaders/bond.vs", ":/assets/shaders/bond.fs");
+    shader_manager->create_shader_program("atom_impostor_shader", ShaderProgramType::AtomImpostorShader,
+                                         ":/assets/shaders/atom_impostor.vs", ":/assets/shaders/atom_impostor.fs");
+    shader_manager->create_shader_program("bond_impostor_shader", ShaderProgramType::BondImpostorShader,
+                                         ":/assets/shaders/bond_impostor.vs", ":/assets/shaders/bond_impostor.fs");
     shader_manager->create_shader_program("axes_shader", ShaderProgramType::AxesShader,
                                          ":/assets/shaders/axes.vs", ":/assets/shaders/axes.fs");
     shader_manager->create_shader_program("unitcell_shader", ShaderProgramType::UnitcellShader,
@@ -788,61 +848,54 @@ int AnaglyphWidget::get_atom_raycast(const QVector3D& ray_origin, const QVector3
     const auto vec_ctr = structure->get_center_vector();
     QMatrix4x4 model;
 
-    // Base atoms
-    for (unsigned int i = 0; i < structure->get_nr_atoms(); ++i) {
-        const Atom& atom = structure->get_atom(i);
-
-        model.setToIdentity();
-        model *= scene->rotation_matrix;
-        model.translate(vec_ctr);
-
-        const QVector3D pos = model.map(atom.get_pos_qtvec());
-
-        const float radius = AtomSettings::get().get_atom_radius_from_elnr(atom.atnr);
-        const float b = QVector3D::dotProduct(ray_vector, ray_origin - pos);
-        const float c = QVector3D::dotProduct(ray_origin - pos, ray_origin - pos) - (radius * radius);
-
-        if (b * b >= c) { // hit
-            if (pos[1] < best_y) {
-                selected_atom = int(i);
-                best_y = pos[1];
-            }
-        }
+    // Base atoms; the model matrix is rigid, hence the ray is transformed into
+    // the frame of the atoms instead of transforming every atom
+    model.setToIdentity();
+    model *= scene->rotation_matrix;
+    model.translate(vec_ctr);
+    QMatrix4x4 model_inv = model.inverted();
+
+    int hit = structure->get_atom_arrays().raycast(model_inv.map(ray_origin),
+                                                   model_inv.mapVector(ray_vector),
+                                                   model.row(1).toVector3D(),
+                                                   model(1,3),
+                                                   best_y);
+    if (hit >= 0) {
+        selected_atom = hit;
     }
 
-    // Expanded atoms
-    const auto& exp = structure->get_atoms_expansion();
-    for (unsigned int i = 0; i < exp.size(); ++i) {
-        const auto& atom = exp[i];
-
-        const bool is_xy = (atom.atomtype & (1 << ATOM_EXPANSION_XY));
-        const bool is_z  = (atom.atomtype & (1 << ATOM_EXPANSION_Z)); // FIXED: was (1 < ATOM_EXPANSION_Z)
-
-        // Keep original intent but make it readable
-        const bool show_this =
-            (flag_show_periodicity_xy && flag_show_periodicity_z && (is_xy || is_z)) ||
-            (flag_show_periodicity_xy && is_xy && !is_z) ||
-            (flag_show_periodicity_z  && is_z  && !is_xy);
+    // Periodic images; the central atoms are tested against the ray shifted
+    // back over the lattice translation of every shown image
+    if (!flag_show_periodicity_xy && !flag_show_periodicity_z) {
+        return selected_atom;
+    }
 
-        if (!show_this) {
+    model.setToIdentity();
+    model *= (scene->arcball_rotation * scene->rotation_matrix);
+    model.translate(vec_ctr);
+    model_inv = model.inverted();
+
+    const QVector3D local_origin = model_inv.map(ray_origin);
+    const QVector3D local_direction = model_inv.mapVector(ray_vector);
+    const QVector3D depth_axis = model.row(1).toVector3D();
+    const unsigned int nr_atoms = structure->get_nr_atoms();
+    for (unsigned int image = 0; image < Structure::NR_IMAGES; ++image) {
+        const unsigned int atomtype = Structure::get_image_atomtype(image);
+        const bool is_xy = (atomtype & (1 << ATOM_EXPANSION_XY));
+        const bool is_z  = (atomtype & (1 << ATOM_EXPANSION_Z));
+        if ((is_xy && !flag_show_periodicity_xy) || (is_z && !flag_show_periodicity_z)) {
             continue;
         }
 
-        model.setToIdentity();
-        model *= (scene->arcball_rotation * scene->rotation_matrix);
-        model.translate(vec_ctr);
-
-        const QVector3D pos = model.map(atom.get_pos_qtvec());
-
-        const float radius = AtomSettings::get().get_atom_radius_from_elnr(atom.atnr);
-        const float b = QVector3D::dotProduct(ray_vector, ray_origin - pos);
-        const float c = QVector3D::dotProduct(ray_origin - pos, ray_origin - pos) - (radius * radius);
-
-        if (b * b >= c) {
-            if (pos[1] < best_y) {
-                selected_atom = int(i) + int(structure->get_nr_atoms());
-                best_y = pos[1];
-            }
+        const VectorPosition dp = structure->get_image_translation(image);
+        const QVector3D translation((float)dp[0], (float)dp[1], (float)dp[2]);
+        hit = structure->get_atom_arrays().raycast(local_origin - translation,
+                                                   local_direction,
+                                                   depth_axis,
+                                                   model(1,3) + QVector3D::dotProduct(depth_axis, translation),
+                                                   best_y);
+        if (hit >= 0) {
+            selected_atom = int((image + 1) * nr_atoms) + hit;
         }
     }
 
@@ -123,6 +123,8 @@ private:
     // visualization settings
     bool flag_show_periodicity_xy = false;          // whether to show periodicity in the xy direction
     bool flag_show_periodicity_z = false;           // whether to shwo periodicity in the z direction
+    bool flag_impostors = false;                    // whether to draw atoms and bonds as ray-cast impostors
+    int render_detail = StructureRenderer::DETAIL_DEFAULT;  // level of detail of the atom and bond meshes
 
     std::shared_ptr<UserAction> user_action;        // object that stores current action of the user on a structure
     bool allow_selection = true;                    // whether selecting atoms is possible
@@ -187,6 +189,27 @@ public:
  */
     void set_stereo(QString stereo_name);
 
+    /**
+     * @brief      Set whether atoms and bonds are drawn as ray-cast impostors
+     *
+     * @param[in]  impostors  Whether to use impostors rather than meshes
+     */
+    void set_impostors(bool impostors);
+
+    /**
+     * @brief      Set the level of detail of the atom and bond meshes
+     *
+     * @param[in]  detail  The detail, between StructureRenderer::DETAIL_MIN and DETAIL_MAX
+     */
+    void set_render_detail(int detail);
+
+    /**
+     * @brief      Set the frames to keep on the GPU during playback
+     *
+     * @param[in]  frames  The frames ahead of the shown frame, empty when playback stops
+     */
+    void set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames);
+
 /**
  * @brief set_active_highlight.
  *
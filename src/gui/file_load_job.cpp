@@ -0,0 +1,188 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "file_load_job.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "../data/structure_loader.h"
+
+/**
+ * @brief FileLoadJob.
+ *
+ * @param filename Parameter filename.
+ * @param parent Parameter parent (also the parent of the progress dialog).
+ */
+FileLoadJob::FileLoadJob(const QString& filename, QWidget* parent)
+    : QObject(parent),
+      filename_(filename),
+      progress_(std::make_shared<LoadProgress>())
+{
+    dialog_ = new QProgressDialog(tr("Loading %1...").arg(QFileInfo(filename).fileName()),
+                                  tr("Cancel"), 0, progress_resolution_, parent);
+    dialog_->setWindowTitle(tr("Opening file"));
+    dialog_->setWindowModality(Qt::NonModal);
+    dialog_->setMinimumDuration(500);
+    dialog_->setAutoClose(false);
+    dialog_->setAutoReset(false);
+    dialog_->setValue(0);
+    connect(dialog_, &QProgressDialog::canceled, this, &FileLoadJob::cancel);
+
+    poll_timer_.setInterval(poll_interval_);
+    connect(&poll_timer_, &QTimer::timeout, this, &FileLoadJob::poll);
+    connect(&watcher_, &QFutureWatcher<Result>::finished, this, &FileLoadJob::complete);
+}
+
+/**
+ * @brief ~FileLoadJob.
+ *
+ */
+FileLoadJob::~FileLoadJob()
+{
+    // the worker only holds on to the progress object and the loader; let
+    // it stop early
+    progress_->cancel();
+    if(neb_loader_) {
+        neb_loader_->cancel();
+    }
+    delete dialog_;
+}
+
+/**
+ * @brief Start loading; the job deletes itself once the worker is done.
+ *
+ */
+void FileLoadJob::start()
+{
+    const std::string filename = filename_.toStdString();
+    const bool is_outcar = filename_.contains("OUTCAR", Qt::CaseInsensitive);
+    const std::shared_ptr<LoadProgress> progress = progress_;
+
+    watcher_.setFuture(QtConcurrent::run([filename, is_outcar, progress]() {
+        Result result;
+        try {
+            StructureLoader sl;
+            sl.set_progress(progress.get());
+            result.trajectory = is_outcar ? sl.load_outcar_trajectory(filename)
+                                          : std::make_shared<Trajectory>(sl.load_yaml(filename));
+        } catch (const std::exception& e) {
+            result.error = QString(e.what());
+        }
+        return result;
+    }));
+
+    poll_timer_.start();
+}
+
+/**
+ * @brief Start loading the NEB calculation in the directory given as
+ * filename; the job deletes itself once the worker is done.
+ *
+ */
+void FileLoadJob::start_neb_calculation()
+{
+    const QString directory = filename_;
+    const std::shared_ptr<LoadProgress> progress = progress_;
+    const std::shared_ptr<NebCalculationLoader> loader = std::make_shared<NebCalculationLoader>();
+    loader->set_progress(progress.get());
+    neb_loader_ = loader;
+
+    watcher_.setFuture(QtConcurrent::run([directory, loader, progress]() {
+        Result result;
+        try {
+            QString error_message;
+            if(loader->load(directory, &error_message)) {
+                result.trajectory = std::make_shared<Trajectory>(loader->structures());
+            } else {
+                result.error = error_message;
+            }
+        } catch (const std::exception& e) {
+            result.error = QString(e.what());
+        }
+        return result;
+    }));
+
+    poll_timer_.start();
+}
+
+/**
+ * @brief cancel.
+ *
+ * Stop the worker; no further signals are emitted.
+ */
+void FileLoadJob::cancel()
+{
+    if(cancelled_) {
+        return;
+    }
+
+    qDebug() << "Cancelled loading of" << filename_;
+    cancelled_ = true;
+    progress_->cancel();
+    if(neb_loader_) {
+        neb_loader_->cancel();
+    }
+    poll_timer_.stop();
+    dialog_->hide();
+}
+
+/**
+ * @brief poll.
+ *
+ */
+void FileLoadJob::poll()
+{
+    if(cancelled_) {
+        return;
+    }
+
+    dialog_->setValue((int)(progress_->get_fraction() * progress_resolution_));
+
+    const auto trajectory = progress_->get_trajectory();
+    if(trajectory && trajectory->size() > nr_frames_reported_) {
+        nr_frames_reported_ = trajectory->size();
+        emit trajectory_updated(trajectory);
+    }
+}
+
+/**
+ * @brief complete.
+ *
+ */
+void FileLoadJob::complete()
+{
+    poll_timer_.stop();
+    dialog_->hide();
+    this->deleteLater();
+
+    if(cancelled_) {
+        return;
+    }
+
+    const Result result = watcher_.result();
+    if(!result.error.isEmpty()) {
+        emit failed(result.error);
+        return;
+    }
+
+    emit finished(result.trajectory);
+}
@@ -0,0 +1,138 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QString>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+#include "../data/load_progress.h"
+#include "../data/neb_calculation_loader.h"
+#include "../data/structure.h"
+#include "../data/trajectory.h"
+
+/**
+ * @brief FileLoadJob class.
+ *
+ * Loads an OUTCAR or YAML file on a worker thread while a progress dialog
+ * with a cancel button is shown. The ionic steps of an OUTCAR are indexed
+ * into a trajectory that can be shown while the remainder of the file is
+ * still being read. The images of a NEB calculation are loaded from a
+ * directory in the same way, yielding a trajectory of resident frames.
+ * All signals are emitted from the GUI thread.
+ */
+class FileLoadJob : public QObject {
+    Q_OBJECT
+
+public:
+/**
+ * @brief FileLoadJob.
+ *
+ * @param filename Parameter filename.
+ * @param parent Parameter parent (also the parent of the progress dialog).
+ */
+    FileLoadJob(const QString& filename, QWidget* parent);
+
+    /**
+     * @brief ~FileLoadJob.
+     *
+     */
+    ~FileLoadJob();
+
+    /**
+     * @brief Start loading; the job deletes itself once the worker is done.
+     *
+     */
+    void start();
+
+    /**
+     * @brief Start loading the NEB calculation in the directory given as
+     * filename; the job deletes itself once the worker is done.
+     *
+     */
+    void start_neb_calculation();
+
+public slots:
+/**
+ * @brief cancel.
+ *
+ * Stop the worker; no further signals are emitted.
+ */
+    void cancel();
+
+signals:
+/**
+ * @brief Frames have been added to the trajectory being loaded.
+ *
+ * @param trajectory The trajectory (frames may still be added to it).
+ */
+    void trajectory_updated(const std::shared_ptr<Trajectory>& trajectory);
+
+/**
+ * @brief The file has been loaded.
+ *
+ * @param trajectory All frames in the file.
+ */
+    void finished(const std::shared_ptr<Trajectory>& trajectory);
+
+/**
+ * @brief The file could not be loaded.
+ *
+ * @param message Parameter message.
+ */
+    void failed(const QString& message);
+
+private slots:
+/**
+ * @brief poll.
+ *
+ */
+    void poll();
+/**
+ * @brief complete.
+ *
+ */
+    void complete();
+
+private:
+    struct Result {
+        std::shared_ptr<Trajectory> trajectory;
+        QString error;
+    };
+
+    QString filename_;
+    std::shared_ptr<LoadProgress> progress_;
+    std::shared_ptr<NebCalculationLoader> neb_loader_;    // loader of a NEB calculation (if any)
+    QFutureWatcher<Result> watcher_;
+    QTimer poll_timer_;
+    QPointer<QProgressDialog> dialog_;    // owned by the parent widget, removed with the job
+    bool cancelled_ = false;
+    size_t nr_frames_reported_ = 0;   // size of the trajectory when last reported
+
+    static constexpr int poll_interval_ = 100;        // ms between progress updates
+    static constexpr int progress_resolution_ = 1000; // steps of the progress bar
+};
@@ -24,6 +24,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QSettings>
+#include <QSignalBlocker>
 
 /**
  * @brief      Constructs the object.
@@ -114,6 +115,7 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     QAction *editorActionCameraPerspective = new QAction(editorMenuCameraMode);
     QAction *editorActionCameraOrthographic = new QAction(editorMenuCameraMode);
     QAction *editorActionResetView = new QAction(editorMenuView);
+    QAction *editorActionImpostors = new QAction(editorMenuView);
 
     QMenu *editorMenuProjection = new QMenu(tr("Projection"), editorMenuView);
     QAction *editorActionProjectionTwoDimensional = new QAction(editorMenuProjection);
@@ -155,6 +157,8 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     editorActionCameraOrthographic->setShortcut(Qt::CTRL | Qt::Key_5);
     editorActionResetView->setText(tr("Reset view"));
     editorActionResetView->setShortcut(Qt::CTRL | Qt::Key_0);
+    editorActionImpostors->setText(tr("Ray-cast atoms and bonds"));
+    editorActionImpostors->setCheckable(true);
 
     editorActionProjectionTwoDimensional->setText(tr("Two-dimensional"));
     editorActionProjectionAnaglyphRedCyan->setText(tr("Anaglyph (red/cyan)"));
@@ -190,6 +194,7 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
 
     editorMenuView->addMenu(editorMenuProjection);
     editorMenuView->addMenu(editorMenuCamera);
+    editorMenuView->addAction(editorActionImpostors);
     editorMenuView->addSeparator();
     editorMenuView->addAction(editorActionResetView);
     editorMenuCamera->addMenu(editorMenuCameraAlign);
@@ -269,6 +274,7 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     QAction *analysisActionCameraPerspective = new QAction(analysisMenuCameraMode);
     QAction *analysisActionCameraOrthographic = new QAction(analysisMenuCameraMode);
     QAction *analysisActionResetView = new QAction(analysisMenuView);
+    QAction *analysisActionImpostors = new QAction(analysisMenuView);
 
     QMenu *analysisMenuProjection = new QMenu(tr("Projection"), analysisMenuView);
     QAction *analysisActionProjectionTwoDimensional = new QAction(analysisMenuProjection);
@@ -315,6 +321,8 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     analysisActionCameraOrthographic->setShortcut(Qt::CTRL | Qt::Key_5);
     analysisActionResetView->setText(tr("Reset view"));
     analysisActionResetView->setShortcut(Qt::CTRL | Qt::Key_0);
+    analysisActionImpostors->setText(tr("Ray-cast atoms and bonds"));
+    analysisActionImpostors->setCheckable(true);
 
     analysisActionProjectionTwoDimensional->setText(tr("Two-dimensional"));
     analysisActionProjectionAnaglyphRedCyan->setText(tr("Anaglyph (red/cyan)"));
@@ -349,6 +357,7 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
 
     analysisMenuView->addMenu(analysisMenuProjection);
     analysisMenuView->addMenu(analysisMenuCamera);
+    analysisMenuView->addAction(analysisActionImpostors);
     analysisMenuView->addSeparator();
     analysisMenuView->addAction(analysisActionResetView);
     analysisMenuCamera->addMenu(analysisMenuCameraAlign);
@@ -523,6 +532,23 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     connect(analysisActionResetView, &QAction::triggered,
             structureAnalysis->viewer()->get_anaglyph_widget(), &AnaglyphWidget::reset_view);
 
+    // the render mode applies to both viewports and is remembered between
+    // sessions; the viewports read the stored mode upon construction
+    const bool impostors = QSettings().value("render/impostors", false).toBool();
+    editorActionImpostors->setChecked(impostors);
+    analysisActionImpostors->setChecked(impostors);
+    auto set_impostors = [this, editorActionImpostors, analysisActionImpostors](bool enabled) {
+        const QSignalBlocker editor_blocker(editorActionImpostors);
+        const QSignalBlocker analysis_blocker(analysisActionImpostors);
+        editorActionImpostors->setChecked(enabled);
+        analysisActionImpostors->setChecked(enabled);
+        this->anaglyph_widget->set_impostors(enabled);
+        this->structureAnalysis->viewer()->get_anaglyph_widget()->set_impostors(enabled);
+        QSettings().setValue("render/impostors", enabled);
+    };
+    connect(editorActionImpostors, &QAction::toggled, this, set_impostors);
+    connect(analysisActionImpostors, &QAction::toggled, this, set_impostors);
+
     this->active_panel_timer_ = new QTimer(this);
     this->active_panel_timer_->setInterval(40);
     connect(this->active_panel_timer_, &QTimer::timeout, this, &InterfaceWindow::update_active_panel_from_cursor);
@@ -550,6 +576,11 @@ InterfaceWindow::InterfaceWindow(MainWindow *mw)
     connect(anaglyph_widget->get_user_action().get(),
             SIGNAL(signal_decrement_structure_stack_pointer()),
             this, SLOT(decrement_structure_stack_pointer()));
+
+    // memory available to the undo history
+    QSettings settings;
+    const unsigned int undo_memory_mb = settings.value("editor/undoMemoryLimitMB", 256).toUInt();
+    this->structure_history.set_memory_limit((size_t)undo_memory_mb * 1024 * 1024);
 }
 
 /**
@@ -649,52 +680,30 @@ void InterfaceWindow::open_file(const QString& filename)
         filename.endsWith(".yaml", Qt::CaseInsensitive) ||
         filename.endsWith(".yml", Qt::CaseInsensitive)) {
 
-        StructureLoader sl;
-        std::vector<std::shared_ptr<Structure>> structures;
-
-        try {
-            if(filename.contains("OUTCAR", Qt::CaseInsensitive)) {
-                structures = sl.load_outcar(filename.toStdString());
-            } else {
-                structures = sl.load_yaml(filename.toStdString());
+        // the analysis panels show the ionic steps while the file is being
+        // read; the editor receives the first structure once loading is done
+        FileLoadJob* job = structureAnalysis->load_file(filename);
+        connect(job, &FileLoadJob::finished, this,
+                [this](const std::shared_ptr<Trajectory>& trajectory) {
+            if (!trajectory || trajectory->size() == 0) {
+                QMessageBox::warning(this,
+                    tr("Empty optimization"),
+                    tr("No structures found in selected file."));
+                return;
             }
-        } catch (const std::exception& e) {
-            QMessageBox::critical(this,
-                tr("Exception encountered"),
-                tr(e.what()));
-            return;
-        }
 
-        if (structures.empty()) {
-            QMessageBox::warning(this,
-                tr("Empty optimization"),
-                tr("No structures found in selected file."));
-            return;
-        }
+            // ---- Also sync editor + info to first structure ----
+            // copy the frame shown in the analysis panel, such that the editor
+            // shares its atoms and bonds instead of deriving these again
+            const auto shown = structureAnalysis->first_structure();
+            const auto structure = shown ? shown->clone_for_view() : trajectory->get_frame(0)->clone_for_view();
+            structure_history.reset(structure);
 
-        // ---- Update analysis panels ----
-        if (structures.size() == 1 && structures.front()->get_nr_eigenmodes() > 0) {
-            structureAnalysis->set_frequency_structure(structures.front()->clone_for_view());
-        } else {
-            std::vector<std::shared_ptr<Structure>> geometry_structures;
-            geometry_structures.reserve(structures.size());
+            emit new_file_loaded();
 
-            for (const auto& s : structures) {
-                geometry_structures.push_back(s->clone_for_view());
-            }
-
-            structureAnalysis->set_structures(geometry_structures);
-        }
-
-        // ---- Also sync editor + info to first structure ----
-        structure_stack.clear();
-        structure_stack.push_back(structures.front());
-        structure_stack_pointer = 0;
-
-        emit new_file_loaded();
-
-        anaglyph_widget->set_structure(structures.front());
-        structure_info_widget->set_structure(structures.front());
+            anaglyph_widget->set_structure(structure);
+            structure_info_widget->set_structure(structure);
+        });
 
         return;
     }
@@ -713,9 +722,7 @@ void InterfaceWindow::open_file(const QString& filename)
         return;
     }
 
-    structure_stack.clear();
-    structure_stack.push_back(structure);
-    structure_stack_pointer = 0;
+    structure_history.reset(structure);
 
     emit new_file_loaded();
 
@@ -759,9 +766,7 @@ void InterfaceWindow::open_editor_file()
         return;
     }
 
-    structure_stack.clear();
-    structure_stack.push_back(structure);
-    structure_stack_pointer = 0;
+    structure_history.reset(structure);
 
     emit new_file_loaded();
 
@@ -816,9 +821,10 @@ void InterfaceWindow::open_analysis_neb_calculation()
 
     settings.setValue("ui/lastLoadDir", folder);
 
-    NebCalculationLoader neb_loader;
-    QString error_message;
-    if(!neb_loader.load(folder, &error_message)) {
+    // the images are read in the background; the progress dialog of the
+    // job allows the load to be cancelled
+    FileLoadJob* job = new FileLoadJob(folder, this);
+    connect(job, &FileLoadJob::failed, this, [this](const QString& error_message) {
         QMessageBox message_box(this);
         message_box.setIcon(QMessageBox::Critical);
         message_box.setWindowTitle(tr("Could not open NEB calculation"));
@@ -826,18 +832,18 @@ void InterfaceWindow::open_analysis_neb_calculation()
         message_box.setInformativeText(error_message);
         message_box.setStyleSheet("QLabel{min-width: 420px; font-weight: normal;}");
         message_box.exec();
-        return;
-    }
-
-    std::vector<std::shared_ptr<Structure>> geometry_structures;
-    const auto& loaded_structures = neb_loader.structures();
-    geometry_structures.reserve(loaded_structures.size());
+    });
+    connect(job, &FileLoadJob::finished, this, [this](const std::shared_ptr<Trajectory>& trajectory) {
+        std::vector<std::shared_ptr<Structure>> geometry_structures;
+        geometry_structures.reserve(trajectory->size());
 
-    for(const auto& structure : loaded_structures) {
-        geometry_structures.push_back(structure->clone_for_view());
-    }
+        for(size_t i=0; i<trajectory->size(); i++) {
+            geometry_structures.push_back(trajectory->get_frame(i)->clone_for_view());
+        }
 
-    structureAnalysis->set_structures(geometry_structures, StructureAnalysisViewer::SeriesKind::NEB);
+        structureAnalysis->set_structures(geometry_structures, StructureAnalysisViewer::SeriesKind::NEB);
+    });
+    job->start_neb_calculation();
 }
 
 /**
@@ -872,20 +878,33 @@ void InterfaceWindow::set_camera_mode(QAction* action) {
     this->anaglyph_widget->get_user_action()->set_camera_mode(action->data().toInt());
 }
 
+    /**
+     * @brief      Set the level of detail of the atom and bond meshes in
+     *             the editor and analysis viewers
+     *
+     * @param[in]  detail  The detail
+     */
+void InterfaceWindow::set_render_detail(int detail) {
+    this->anaglyph_widget->set_render_detail(detail);
+    this->structureAnalysis->viewer()->get_anaglyph_widget()->set_render_detail(detail);
+}
+
     /**
      * @brief      Loads a default structure file.
      */
 void InterfaceWindow::load_default_file() {
-    // do not load default file if a file is already loaded (via CLI)
-    if(this->structure_stack.size() != 0) {
+    // do not load default file if a file is already loaded or being loaded (via CLI)
+    if(this->structure_history.get_structure() || this->structureAnalysis->is_loading()) {
         return;
     }
 
     qDebug() << "Opening default file";
     const std::string filename = "OUTCAR";
-    QTemporaryDir tmp_dir;
-    QFile::copy(":/assets/structures/" + tr(filename.c_str()), tmp_dir.path() + "/" + filename.c_str());
-    this->open_file(tmp_dir.path() + "/" + filename.c_str());
+
+    // the file is read in the background, hence the directory has to outlive this call
+    this->default_file_dir = std::make_unique<QTemporaryDir>();
+    QFile::copy(":/assets/structures/" + tr(filename.c_str()), this->default_file_dir->path() + "/" + filename.c_str());
+    this->open_file(this->default_file_dir->path() + "/" + filename.c_str());
 }
 
     /**
@@ -980,54 +999,40 @@ void InterfaceWindow::update_selection_label(const QString& text) {
 }
 
     /**
-     * @brief Grab the latest structure and push it to the stack and
-     *        create a new copy on the stack
+     * @brief Record the current state of the structure before it is edited
      */
 void InterfaceWindow::push_structure() {
-    // Current structure as used by the renderer/user action
+    // edits are made in place on the structure used by the renderer/user
+    // action; the history only records what changes
     auto current = this->anaglyph_widget->get_structure();
     if(!current) return;
 
-    // If we undid before, drop redo history
-    this->structure_stack.resize(this->structure_stack_pointer + 1);
-
-    // Push a NEW snapshot of the current state
-    this->structure_stack.push_back(std::make_shared<Structure>(*current));
-    this->structure_stack_pointer++;
-
-    // Make the newly pushed snapshot the active one everywhere
-    this->anaglyph_widget->set_structure_conservative(this->structure_stack[this->structure_stack_pointer]);
-    this->structure_info_widget->set_structure(this->structure_stack[this->structure_stack_pointer]);
+    if(current != this->structure_history.get_structure()) {
+        this->structure_history.reset(current);
+    }
 
-    // Also ensure UserAction uses the same shared_ptr (critical!)
-    this->anaglyph_widget->get_user_action()->set_structure(this->structure_stack[this->structure_stack_pointer]);
+    this->structure_history.begin_step();
 }
 
     /**
-     * @brief Increment the stack pointer
+     * @brief Redo the last undone edit
      */
 void InterfaceWindow::increment_structure_stack_pointer() {
-    if(this->structure_stack_pointer < (this->structure_stack.size() - 1)) {
-        this->structure_stack_pointer++;
-
-        auto s = this->structure_stack[this->structure_stack_pointer];
+    if(this->structure_history.redo()) {
+        auto s = this->structure_history.get_structure();
         this->anaglyph_widget->set_structure_conservative(s);
         this->structure_info_widget->set_structure(s);
-        this->anaglyph_widget->get_user_action()->set_structure(s);
     }
 }
 
     /**
-     * @brief Decrement the stack pointer
+     * @brief Undo the last edit
      */
 void InterfaceWindow::decrement_structure_stack_pointer() {
-    if(this->structure_stack_pointer > 0) {
-        this->structure_stack_pointer--;
-
-        auto s = this->structure_stack[this->structure_stack_pointer];
+    if(this->structure_history.undo()) {
+        auto s = this->structure_history.get_structure();
         this->anaglyph_widget->set_structure_conservative(s);
         this->structure_info_widget->set_structure(s);
-        this->anaglyph_widget->get_user_action()->set_structure(s);
     }
 }
 
@@ -1042,9 +1047,7 @@ void InterfaceWindow::load_structure_from_geometry_analysis() {
 
     auto editor_structure = structure->clone_for_view();
 
-    this->structure_stack.clear();
-    this->structure_stack.push_back(editor_structure);
-    this->structure_stack_pointer = 0;
+    this->structure_history.reset(editor_structure);
 
     emit new_file_loaded();
 
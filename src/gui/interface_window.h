@@ -35,6 +35,7 @@
 #include <QPushButton>
 #include <QTimer>
 #include <QSplitter>
+#include <QTemporaryDir>
 #include <QInputDialog>
 #include <QVector>
 
@@ -42,9 +43,9 @@
 #include "structure_analysis.h"
 #include "mainwindow.h"
 #include "../data/structure_loader.h"
-#include "../data/neb_calculation_loader.h"
 #include "structure_info_widget.h"
 #include "../data/structure_saver.h"
+#include "../data/structure_history.h"
 #include "toolbar.h"
 
 QT_BEGIN_NAMESPACE
@@ -84,8 +85,8 @@ private:
     StructureLoader structure_loader;
     StructureSaver structure_saver;
 
-    size_t structure_stack_pointer = 0;
-    std::vector<std::shared_ptr<Structure>> structure_stack;
+    StructureHistory structure_history;     // undo/redo journal of the structure in the editor
+    std::unique_ptr<QTemporaryDir> default_file_dir;    // holds the default file while it is being read
 
     QWidget *editor_panel_ = nullptr;
     QWidget *analysis_panel_ = nullptr;
@@ -124,6 +125,14 @@ public:
         return this->anaglyph_widget;
     }
 
+    /**
+     * @brief      Set the level of detail of the atom and bond meshes in
+     *             the editor and analysis viewers
+     *
+     * @param[in]  detail  The detail
+     */
+    void set_render_detail(int detail);
+
 private:
 
 
@@ -251,18 +260,17 @@ private slots:
     }
 
     /**
-     * @brief Grab the latest structure and push it to the stack and
-     *        create a new copy on the stack
+     * @brief Record the current state of the structure before it is edited
      */
     void push_structure();
 
     /**
-     * @brief Increment the stack pointer
+     * @brief Redo the last undone edit
      */
     void increment_structure_stack_pointer();
 
     /**
-     * @brief Decrement the stack pointer
+     * @brief Undo the last edit
      */
     void decrement_structure_stack_pointer();
 
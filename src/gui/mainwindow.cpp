@@ -91,6 +91,17 @@ MainWindow::MainWindow(const std::shared_ptr<QStringList> _log_messages,
     this->statusbar_projection_icon->setPixmap(QPixmap(":/assets/icon/two_dimensional_32.png").scaled(16, 16));
     statusBar()->addPermanentWidget(this->statusbar_projection_icon);
 
+    // add level of detail slider to status bar
+    this->statusbar_detail_slider = new QSlider(Qt::Horizontal);
+    this->statusbar_detail_slider->setRange(StructureRenderer::DETAIL_MIN, StructureRenderer::DETAIL_MAX);
+    this->statusbar_detail_slider->setPageStep(1);
+    this->statusbar_detail_slider->setFixedWidth(80);
+    this->statusbar_detail_slider->setToolTip(tr("Level of detail of atoms and bonds"));
+    this->statusbar_detail_slider->setValue(QSettings().value("render/detail", StructureRenderer::DETAIL_DEFAULT).toInt());
+    connect(this->statusbar_detail_slider, &QSlider::valueChanged, this, &MainWindow::set_render_detail);
+    statusBar()->addPermanentWidget(new QLabel(tr("Detail")));
+    statusBar()->addPermanentWidget(this->statusbar_detail_slider);
+
     // display status message
     statusBar()->showMessage(QString(PROGRAM_NAME) + " " + QString(PROGRAM_VERSION));
     this->statusbar_timer->start(1000);
@@ -237,6 +248,16 @@ void MainWindow::about() {
     message_box.exec();
 }
 
+/**
+ * @brief      Set the level of detail of atoms and bonds
+ *
+ * @param[in]  detail  The detail
+ */
+void MainWindow::set_render_detail(int detail) {
+    this->interface_window->set_render_detail(detail);
+    QSettings().setValue("render/detail", detail);
+}
+
 /**
  * @brief      Set stereo projection
  */
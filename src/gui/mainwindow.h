@@ -32,6 +32,7 @@
 #include <QString>
 #include <QtWidgets/QApplication>
 #include <QMimeData>
+#include <QSlider>
 #include <QTimer>
 #include <QStringList>
 
@@ -56,6 +57,7 @@ class MainWindow : public QMainWindow {
 private:
     InterfaceWindow* interface_window;
     QLabel* statusbar_projection_icon;
+    QSlider* statusbar_detail_slider;
     QTimer* statusbar_timer;
 
     // storage for log messages
@@ -110,6 +112,13 @@ private slots:
      */
     void set_stereo(QString fragment_shader);
 
+    /**
+     * @brief      Set the level of detail of atoms and bonds
+     *
+     * @param[in]  detail  The detail
+     */
+    void set_render_detail(int detail);
+
 /**
  * @brief dragEnterEvent.
  *
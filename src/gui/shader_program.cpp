@@ -76,6 +76,35 @@ void ShaderProgram::add_attributes() {
             this->m_program->bindAttributeLocation("position", 0);
             this->m_program->bindAttributeLocation("normal", 1);
         break;
+        case ShaderProgramType::AtomShader:
+        case ShaderProgramType::SilhouetteShader:
+            this->m_program->bindAttributeLocation("position", 0);
+            this->m_program->bindAttributeLocation("normal", 1);
+            this->m_program->bindAttributeLocation("instance_position", 2);
+            this->m_program->bindAttributeLocation("instance_element", 3);
+            this->m_program->bindAttributeLocation("instance_flags", 4);
+        break;
+        case ShaderProgramType::BondShader:
+            this->m_program->bindAttributeLocation("position", 0);
+            this->m_program->bindAttributeLocation("normal", 1);
+            this->m_program->bindAttributeLocation("instance_start", 2);
+            this->m_program->bindAttributeLocation("instance_end", 3);
+            this->m_program->bindAttributeLocation("instance_translation", 4);
+            this->m_program->bindAttributeLocation("instance_atoms", 5);
+        break;
+        case ShaderProgramType::AtomImpostorShader:
+            this->m_program->bindAttributeLocation("corner", 0);
+            this->m_program->bindAttributeLocation("instance_position", 2);
+            this->m_program->bindAttributeLocation("instance_element", 3);
+            this->m_program->bindAttributeLocation("instance_flags", 4);
+        break;
+        case ShaderProgramType::BondImpostorShader:
+            this->m_program->bindAttributeLocation("position", 0);
+            this->m_program->bindAttributeLocation("instance_start", 2);
+            this->m_program->bindAttributeLocation("instance_end", 3);
+            this->m_program->bindAttributeLocation("instance_translation", 4);
+            this->m_program->bindAttributeLocation("instance_atoms", 5);
+        break;
         default:
             // nothing to do
         break;
@@ -96,6 +125,44 @@ void ShaderProgram::add_uniforms() {
         this->uniforms.emplace("color", this->m_program->uniformLocation("color"));
     }
 
+    if (this->type == ShaderProgramType::AtomShader) {
+        this->uniforms.emplace("model", this->m_program->uniformLocation("model"));
+        this->uniforms.emplace("view", this->m_program->uniformLocation("view"));
+        this->uniforms.emplace("projection", this->m_program->uniformLocation("projection"));
+        this->uniforms.emplace("transposition", this->m_program->uniformLocation("transposition"));
+        this->uniforms.emplace("lightpos", this->m_program->uniformLocation("lightpos"));
+        this->uniforms.emplace("element_data", this->m_program->uniformLocation("element_data"));
+        this->uniforms.emplace("frame_atom_data", this->m_program->uniformLocation("frame_atom_data"));
+        this->uniforms.emplace("frame_base", this->m_program->uniformLocation("frame_base"));
+        this->uniforms.emplace("frame_nr_atoms", this->m_program->uniformLocation("frame_nr_atoms"));
+        this->uniforms.emplace("frame_cell", this->m_program->uniformLocation("frame_cell"));
+    }
+
+    if (this->type == ShaderProgramType::AtomImpostorShader) {
+        this->uniforms.emplace("model", this->m_program->uniformLocation("model"));
+        this->uniforms.emplace("view", this->m_program->uniformLocation("view"));
+        this->uniforms.emplace("projection", this->m_program->uniformLocation("projection"));
+        this->uniforms.emplace("transposition", this->m_program->uniformLocation("transposition"));
+        this->uniforms.emplace("lightpos", this->m_program->uniformLocation("lightpos"));
+        this->uniforms.emplace("element_data", this->m_program->uniformLocation("element_data"));
+        this->uniforms.emplace("frame_atom_data", this->m_program->uniformLocation("frame_atom_data"));
+        this->uniforms.emplace("frame_base", this->m_program->uniformLocation("frame_base"));
+        this->uniforms.emplace("frame_nr_atoms", this->m_program->uniformLocation("frame_nr_atoms"));
+        this->uniforms.emplace("frame_cell", this->m_program->uniformLocation("frame_cell"));
+        this->uniforms.emplace("silhouette", this->m_program->uniformLocation("silhouette"));
+    }
+
+    if (this->type == ShaderProgramType::BondShader || this->type == ShaderProgramType::BondImpostorShader) {
+        this->uniforms.emplace("model", this->m_program->uniformLocation("model"));
+        this->uniforms.emplace("view", this->m_program->uniformLocation("view"));
+        this->uniforms.emplace("projection", this->m_program->uniformLocation("projection"));
+        this->uniforms.emplace("lightpos", this->m_program->uniformLocation("lightpos"));
+        this->uniforms.emplace("radius", this->m_program->uniformLocation("radius"));
+        this->uniforms.emplace("element_data", this->m_program->uniformLocation("element_data"));
+        this->uniforms.emplace("frame_bond_data", this->m_program->uniformLocation("frame_bond_data"));
+        this->uniforms.emplace("frame_base", this->m_program->uniformLocation("frame_base"));
+    }
+
     if (this->type == ShaderProgramType::StereoscopicShader) {
         this->uniforms.emplace("left_eye_texture", this->m_program->uniformLocation("left_eye_texture"));
         this->uniforms.emplace("right_eye_texture", this->m_program->uniformLocation("right_eye_texture"));
@@ -121,7 +188,12 @@ void ShaderProgram::add_uniforms() {
 
     if (this->type == ShaderProgramType::SilhouetteShader) {
         this->uniforms.emplace("mvp", this->m_program->uniformLocation("mvp"));
-        this->uniforms.emplace("color", this->m_program->uniformLocation("color"));
+        this->uniforms.emplace("transposition", this->m_program->uniformLocation("transposition"));
+        this->uniforms.emplace("element_data", this->m_program->uniformLocation("element_data"));
+        this->uniforms.emplace("frame_atom_data", this->m_program->uniformLocation("frame_atom_data"));
+        this->uniforms.emplace("frame_base", this->m_program->uniformLocation("frame_base"));
+        this->uniforms.emplace("frame_nr_atoms", this->m_program->uniformLocation("frame_nr_atoms"));
+        this->uniforms.emplace("frame_cell", this->m_program->uniformLocation("frame_cell"));
     }
 
     if (this->type == ShaderProgramType::CanvasShader) {
@@ -24,6 +24,10 @@
 // set of uniforms
 enum class ShaderProgramType {
     ModelShader,
+    AtomShader,
+    BondShader,
+    AtomImpostorShader,
+    BondImpostorShader,
     StereoscopicShader,
     AxesShader,
     UnitcellShader,
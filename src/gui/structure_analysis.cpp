@@ -20,6 +20,9 @@
 
 #include "structure_analysis.h"
 
+#include <QMessageBox>
+
+#include <algorithm>
 #include <cmath>
 
 /**
@@ -41,6 +44,13 @@ StructureAnalysis::StructureAnalysis(QObject *parent)
     connect(graph_, &StructureAnalysisGraph::frequency_selected,
             this, &StructureAnalysis::select_frequency_mode);
 
+    connect(viewer_, &StructureAnalysisViewer::playback_toggled, this, &StructureAnalysis::set_playing);
+    connect(viewer_, &StructureAnalysisViewer::playback_fps_changed, this, &StructureAnalysis::set_playback_fps);
+
+    playback_timer_.setTimerType(Qt::PreciseTimer);
+    playback_timer_.setInterval(1000 / playback_fps_);
+    connect(&playback_timer_, &QTimer::timeout, this, &StructureAnalysis::tick_playback);
+
     frequency_animation_timer_.setInterval(40);
     connect(&frequency_animation_timer_, &QTimer::timeout,
             this, &StructureAnalysis::tick_frequency_animation);
@@ -59,11 +69,29 @@ void StructureAnalysis::set_structures(const std::vector<std::shared_ptr<Structu
         return;
     }
 
+    set_trajectory(std::make_shared<Trajectory>(s), series_kind);
+}
+
+/**
+ * @brief set_trajectory.
+ *
+ * @param trajectory Parameter trajectory.
+ * @param series_kind Parameter series_kind.
+ */
+void StructureAnalysis::set_trajectory(const std::shared_ptr<Trajectory>& trajectory,
+                                       StructureAnalysisViewer::SeriesKind series_kind)
+{
+    if(!trajectory || trajectory->size() == 0) {
+        return;
+    }
+
+    set_playing(false);
     mode_ = AnalysisMode::STRUCTURE_SERIES;
     current_series_kind_ = series_kind;
-    structures_ = s;
+    trajectory_ = trajectory;
     frequency_structure_.reset();
     current_index_ = 0;
+    playback_step_ = 1;
     animation_phase_ = 0.0;
     frequency_animation_timer_.stop();
     Structure::set_debug_logging_enabled(true);
@@ -75,10 +103,10 @@ void StructureAnalysis::set_structures(const std::vector<std::shared_ptr<Structu
     const auto graph_kind = (series_kind == StructureAnalysisViewer::SeriesKind::NEB)
         ? StructureAnalysisGraph::SeriesKind::NEB
         : StructureAnalysisGraph::SeriesKind::GEOMETRY_OPTIMIZATION;
-    graph_->set_structures(structures_, graph_kind);
+    graph_->set_trajectory(trajectory_, graph_kind);
 
     update_current();
-    viewer_->set_structure(structures_[current_index_]);
+    viewer_->set_structure(trajectory_->get_frame(current_index_));
 }
 
 /**
@@ -92,8 +120,9 @@ void StructureAnalysis::set_frequency_structure(const std::shared_ptr<Structure>
         return;
     }
 
+    set_playing(false);
     mode_ = AnalysisMode::FREQUENCY;
-    structures_.clear();
+    trajectory_.reset();
     frequency_structure_ = structure;
     current_index_ = 0;
     animation_phase_ = 0.0;
@@ -115,13 +144,33 @@ void StructureAnalysis::set_frequency_structure(const std::shared_ptr<Structure>
 void StructureAnalysis::update_current()
 {
     if(mode_ == AnalysisMode::STRUCTURE_SERIES) {
-        if(structures_.empty()) {
+        if(!trajectory_ || trajectory_->size() == 0) {
             return;
         }
 
-        viewer_->set_structure_conservative(structures_[current_index_]);
-        viewer_->set_index(current_index_, structures_.size());
+        std::shared_ptr<Structure> structure = trajectory_->get_frame(current_index_);
+
+        // during playback the prepared frames that come up are kept on the
+        // GPU, such that showing these only selects their positions
+        if(playback_timer_.isActive()) {
+            const size_t n = trajectory_->size();
+            const size_t stride = static_cast<size_t>(std::max(playback_step_, 1));
+            std::vector<std::shared_ptr<const Structure>> frames = {structure};
+            for(size_t j=1; j<=prefetch_frames_ && j * stride < n; j++) {
+                auto frame = trajectory_->get_prepared_frame((current_index_ + j * stride) % n);
+                if(frame) {
+                    frames.push_back(frame);
+                }
+            }
+            viewer_->set_playback_frames(frames);
+        }
+
+        viewer_->set_structure_conservative(structure);
+        viewer_->set_index(current_index_, trajectory_->size());
         graph_->set_current_index(current_index_);
+
+        // prepare the frames that are expected to be shown next
+        trajectory_->prefetch(current_index_, playback_step_, prefetch_frames_);
         return;
     }
 
@@ -183,7 +232,9 @@ std::shared_ptr<Structure> StructureAnalysis::build_frequency_frame_structure(si
 void StructureAnalysis::first()
 {
     if(mode_ == AnalysisMode::STRUCTURE_SERIES) {
+        set_playing(false);
         current_index_ = 0;
+        playback_step_ = 1;
     } else if(mode_ == AnalysisMode::FREQUENCY && frequency_structure_) {
         current_index_ = 0;
         animation_phase_ = 0.0;
@@ -202,7 +253,9 @@ void StructureAnalysis::first()
 void StructureAnalysis::prev()
 {
     if(mode_ == AnalysisMode::STRUCTURE_SERIES) {
-        current_index_ = (current_index_ == 0) ? structures_.size() - 1 : current_index_ - 1;
+        set_playing(false);
+        current_index_ = (current_index_ == 0) ? trajectory_->size() - 1 : current_index_ - 1;
+        playback_step_ = -1;
     } else if(mode_ == AnalysisMode::FREQUENCY && frequency_structure_) {
         const size_t n = frequency_structure_->get_nr_eigenmodes();
         current_index_ = (current_index_ == 0) ? n - 1 : current_index_ - 1;
@@ -222,7 +275,9 @@ void StructureAnalysis::prev()
 void StructureAnalysis::next()
 {
     if(mode_ == AnalysisMode::STRUCTURE_SERIES) {
-        current_index_ = (current_index_ + 1) % structures_.size();
+        set_playing(false);
+        current_index_ = (current_index_ + 1) % trajectory_->size();
+        playback_step_ = 1;
     } else if(mode_ == AnalysisMode::FREQUENCY && frequency_structure_) {
         const size_t n = frequency_structure_->get_nr_eigenmodes();
         current_index_ = (current_index_ + 1) % n;
@@ -242,7 +297,9 @@ void StructureAnalysis::next()
 void StructureAnalysis::last()
 {
     if(mode_ == AnalysisMode::STRUCTURE_SERIES) {
-        current_index_ = structures_.size() - 1;
+        set_playing(false);
+        current_index_ = trajectory_->size() - 1;
+        playback_step_ = -1;
     } else if(mode_ == AnalysisMode::FREQUENCY && frequency_structure_) {
         current_index_ = frequency_structure_->get_nr_eigenmodes() - 1;
         animation_phase_ = 0.0;
@@ -254,6 +311,83 @@ void StructureAnalysis::last()
     }
 }
 
+/**
+ * @brief set_playing.
+ *
+ * @param playing Parameter playing.
+ */
+void StructureAnalysis::set_playing(bool playing)
+{
+    playing = playing && mode_ == AnalysisMode::STRUCTURE_SERIES && trajectory_ && trajectory_->size() > 1;
+    viewer_->set_playing(playing);
+
+    if(!playing) {
+        playback_timer_.stop();
+        viewer_->set_playback_frames({});
+        return;
+    }
+
+    if(playback_timer_.isActive()) {
+        return;
+    }
+
+    playback_start_index_ = current_index_;
+    playback_step_ = 1;
+    playback_clock_.start();
+    playback_stall_clock_.start();
+    playback_timer_.start();
+}
+
+/**
+ * @brief set_playback_fps.
+ *
+ * @param fps Parameter fps.
+ */
+void StructureAnalysis::set_playback_fps(int fps)
+{
+    playback_fps_ = std::max(1, fps);
+    playback_timer_.setInterval(1000 / playback_fps_);
+
+    // continue at the new rate from the frame that is shown
+    playback_start_index_ = current_index_;
+    playback_clock_.restart();
+}
+
+/**
+ * @brief tick_playback.
+ *
+ * The frame to show is derived from the time since playback started, such
+ * that the frame rate does not drift when ticks are delayed. Frames that
+ * have not been prepared in time are skipped; when no prepared frame comes
+ * up for a while, the frame is decoded on the spot instead. The prepared
+ * frames ahead are uploaded to the renderer's playback window, which draws
+ * these without culling or sorting their instances.
+ */
+void StructureAnalysis::tick_playback()
+{
+    if(mode_ != AnalysisMode::STRUCTURE_SERIES || !trajectory_) {
+        set_playing(false);
+        return;
+    }
+
+    const size_t n = trajectory_->size();
+    const size_t elapsed_frames = static_cast<size_t>(playback_clock_.elapsed() * playback_fps_ / 1000);
+    const size_t target = (playback_start_index_ + elapsed_frames) % n;
+    if(target == current_index_) {
+        return;
+    }
+
+    if(!trajectory_->is_prepared(target) && playback_stall_clock_.elapsed() < max_playback_stall_) {
+        return;
+    }
+
+    // frames to prepare next are spaced by the number of frames skipped
+    playback_step_ = static_cast<int>((target + n - current_index_) % n);
+    current_index_ = target;
+    playback_stall_clock_.restart();
+    update_current();
+}
+
 /**
  * @brief tick_frequency_animation.
  *
@@ -331,32 +465,95 @@ void StructureAnalysis::set_stereo(const QString& stereo_name)
     viewer_->get_anaglyph_widget()->set_stereo(stereo_name);
 }
 
+/**
+ * @brief refresh_trajectory.
+ *
+ * Update the graph and the frame counter after frames have been added
+ * to the trajectory (e.g. while a file is being loaded).
+ */
+void StructureAnalysis::refresh_trajectory()
+{
+    if(mode_ != AnalysisMode::STRUCTURE_SERIES || !trajectory_) {
+        return;
+    }
+
+    const auto graph_kind = (current_series_kind_ == StructureAnalysisViewer::SeriesKind::NEB)
+        ? StructureAnalysisGraph::SeriesKind::NEB
+        : StructureAnalysisGraph::SeriesKind::GEOMETRY_OPTIMIZATION;
+    graph_->set_trajectory(trajectory_, graph_kind);
+
+    update_current();
+}
+
 /**
  * @brief load_file.
  *
+ * Loads the file in the background; the first ionic steps are shown while
+ * the remainder is being read. A load that is still running is cancelled.
+ *
  * @param filename Parameter filename.
+ * @return The job loading the file, nullptr for unsupported files.
+ */
+FileLoadJob* StructureAnalysis::load_file(const QString &filename)
+{
+    if(!filename.contains("OUTCAR", Qt::CaseInsensitive) &&
+       !filename.endsWith(".yaml", Qt::CaseInsensitive) &&
+       !filename.endsWith(".yml", Qt::CaseInsensitive)) {
+        return nullptr;
+    }
+
+    if(load_job_) {
+        load_job_->cancel();
+    }
+
+    load_job_ = new FileLoadJob(filename, viewer_);
+    connect(load_job_, &FileLoadJob::trajectory_updated, this, &StructureAnalysis::receive_trajectory);
+    connect(load_job_, &FileLoadJob::finished, this, &StructureAnalysis::finish_loading);
+    connect(load_job_, &FileLoadJob::failed, this, &StructureAnalysis::fail_loading);
+    load_job_->start();
+
+    return load_job_;
+}
+
+/**
+ * @brief receive_trajectory.
+ *
+ * @param trajectory Parameter trajectory.
  */
-void StructureAnalysis::load_file(const QString &filename)
+void StructureAnalysis::receive_trajectory(const std::shared_ptr<Trajectory>& trajectory)
 {
-    StructureLoader sl;
-    std::vector<std::shared_ptr<Structure>> loaded;
-
-    if(filename.contains("OUTCAR", Qt::CaseInsensitive)) {
-        loaded = sl.load_outcar(filename.toStdString());
-    } else if(filename.endsWith(".yaml", Qt::CaseInsensitive) ||
-              filename.endsWith(".yml", Qt::CaseInsensitive)) {
-        loaded = sl.load_yaml(filename.toStdString());
+    if(trajectory == trajectory_) {
+        refresh_trajectory();
     } else {
-        return;
+        set_trajectory(trajectory);
     }
+}
 
-    if(loaded.empty()) {
+/**
+ * @brief finish_loading.
+ *
+ * @param trajectory Parameter trajectory.
+ */
+void StructureAnalysis::finish_loading(const std::shared_ptr<Trajectory>& trajectory)
+{
+    if(!trajectory || trajectory->size() == 0) {
         return;
     }
 
-    if(loaded.size() == 1 && loaded.front()->get_nr_eigenmodes() > 0) {
-        set_frequency_structure(loaded.front());
-    } else {
-        set_structures(loaded, StructureAnalysisViewer::SeriesKind::GEOMETRY_OPTIMIZATION);
+    if(trajectory->size() == 1 && trajectory->get_frame(0)->get_nr_eigenmodes() > 0) {
+        set_frequency_structure(trajectory->get_frame(0)->clone_for_view());
+        return;
     }
+
+    receive_trajectory(trajectory);
+}
+
+/**
+ * @brief fail_loading.
+ *
+ * @param message Parameter message.
+ */
+void StructureAnalysis::fail_loading(const QString& message)
+{
+    QMessageBox::critical(viewer_, tr("Exception encountered"), message);
 }
@@ -22,12 +22,15 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QAction>
+#include <QPointer>
 #include <memory>
 #include <vector>
 
 #include "structure_analysis_viewer.h"
 #include "structure_analysis_graph.h"
+#include "file_load_job.h"
 #include "../data/structure_loader.h"
 
 /**
@@ -63,6 +66,18 @@ public:
      */
     void set_structures(const std::vector<std::shared_ptr<Structure>>& structures,
                         StructureAnalysisViewer::SeriesKind series_kind = StructureAnalysisViewer::SeriesKind::GEOMETRY_OPTIMIZATION);
+
+    /**
+     * @brief set_trajectory.
+     *
+     * Frames are fetched from the trajectory when these are shown; frames
+     * added to the trajectory afterwards are picked up by refresh_trajectory().
+     *
+     * @param trajectory Parameter trajectory.
+     * @param series_kind Parameter series_kind.
+     */
+    void set_trajectory(const std::shared_ptr<Trajectory>& trajectory,
+                        StructureAnalysisViewer::SeriesKind series_kind = StructureAnalysisViewer::SeriesKind::GEOMETRY_OPTIMIZATION);
 /**
  * @brief set_frequency_structure.
  *
@@ -70,13 +85,45 @@ public:
  */
     void set_frequency_structure(const std::shared_ptr<Structure>& structure);
 
+    /**
+     * @brief first_structure.
+     *
+     * @return The first frame of the series or the frequency reference
+     *         structure; nullptr if nothing is shown.
+     */
+    std::shared_ptr<Structure> first_structure() const {
+        if(mode_ == AnalysisMode::FREQUENCY) {
+            return frequency_structure_;
+        }
+        return (trajectory_ && trajectory_->size() > 0) ? trajectory_->get_frame(0) : nullptr;
+    }
+
+    /**
+     * @brief is_loading.
+     *
+     * @return Whether a file is being loaded in the background.
+     */
+    bool is_loading() const { return !load_job_.isNull(); }
+
+    /**
+     * @brief refresh_trajectory.
+     *
+     * Update the graph and the frame counter after frames have been added
+     * to the trajectory (e.g. while a file is being loaded).
+     */
+    void refresh_trajectory();
+
 public slots:
 /**
  * @brief load_file.
  *
+ * Loads the file in the background; the first ionic steps are shown while
+ * the remainder is being read. A load that is still running is cancelled.
+ *
  * @param filename Parameter filename.
+ * @return The job loading the file, nullptr for unsupported files.
  */
-    void load_file(const QString& filename);
+    FileLoadJob* load_file(const QString& filename);
 /**
  * @brief set_camera_align.
  *
@@ -117,6 +164,25 @@ private slots:
  *
  */
     void last();
+/**
+ * @brief set_playing.
+ *
+ * Start or stop the playback of the structure series.
+ *
+ * @param playing Parameter playing.
+ */
+    void set_playing(bool playing);
+/**
+ * @brief set_playback_fps.
+ *
+ * @param fps Parameter fps.
+ */
+    void set_playback_fps(int fps);
+/**
+ * @brief tick_playback.
+ *
+ */
+    void tick_playback();
 /**
  * @brief tick_frequency_animation.
  *
@@ -128,6 +194,24 @@ private slots:
  * @param index Parameter index.
  */
     void select_frequency_mode(size_t index);
+/**
+ * @brief receive_trajectory.
+ *
+ * @param trajectory Parameter trajectory.
+ */
+    void receive_trajectory(const std::shared_ptr<Trajectory>& trajectory);
+/**
+ * @brief finish_loading.
+ *
+ * @param trajectory Parameter trajectory.
+ */
+    void finish_loading(const std::shared_ptr<Trajectory>& trajectory);
+/**
+ * @brief fail_loading.
+ *
+ * @param message Parameter message.
+ */
+    void fail_loading(const QString& message);
 
 private:
     enum class AnalysisMode {
@@ -160,10 +244,21 @@ private:
 
     AnalysisMode mode_ = AnalysisMode::NONE;
     StructureAnalysisViewer::SeriesKind current_series_kind_ = StructureAnalysisViewer::SeriesKind::GEOMETRY_OPTIMIZATION;
-    std::vector<std::shared_ptr<Structure>> structures_;
+    std::shared_ptr<Trajectory> trajectory_;
     std::shared_ptr<Structure> frequency_structure_;
 
     size_t current_index_ = 0;
+    int playback_step_ = 1;                             // step between the last two frames shown
+    static constexpr size_t prefetch_frames_ = 8;       // frames prepared ahead of the shown frame
+
+    QTimer playback_timer_;
+    QElapsedTimer playback_clock_;                      // time since playback started
+    QElapsedTimer playback_stall_clock_;                // time since a frame was last shown
+    size_t playback_start_index_ = 0;                   // frame shown when playback started
+    int playback_fps_ = 30;                             // target frame rate of the playback
+    static constexpr int max_playback_stall_ = 250;     // ms to wait for a frame to be prepared
+
+    QPointer<FileLoadJob> load_job_;
 
     QTimer frequency_animation_timer_;
     double animation_phase_ = 0.0;
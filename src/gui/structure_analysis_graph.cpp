@@ -24,6 +24,9 @@
 #include <QSignalBlocker>
 #include <QHeaderView>
 
+#include <algorithm>
+#include <cmath>
+
 /**
  * @brief StructureAnalysisGraph.
  *
@@ -73,19 +76,20 @@ StructureAnalysisGraph::StructureAnalysisGraph(QWidget *parent)
 }
 
 /**
- * @brief set_structures.
+ * @brief set_trajectory.
  *
- * @param s Parameter s.
+ * @param t Parameter t.
  * @param kind Parameter kind.
  */
-void StructureAnalysisGraph::set_structures(const std::vector<std::shared_ptr<Structure>>& s,
+void StructureAnalysisGraph::set_trajectory(const std::shared_ptr<Trajectory>& t,
                                             SeriesKind kind)
 {
     series_kind_ = kind;
     title->setText(series_kind_ == SeriesKind::NEB ? "NEB ENERGY PROFILE" : "OPTIMIZATION GRAPH");
     stack->setCurrentWidget(chartview);
 
-    structures = s;
+    trajectory = t;
+    nr_frames = trajectory ? trajectory->size() : 0;
     current_index = 0;
     rebuild_chart();
 }
@@ -168,10 +172,16 @@ void StructureAnalysisGraph::rebuild_chart()
         energy->setPointLabelsVisible(false);
     }
 
-    for(size_t i = 0; i < structures.size(); ++i) {
-        energy->append(i + 1, structures[i]->get_energy());
-        force->append(i + 1, structures[i]->get_rms_force());
+    QVector<QPointF> energy_points;
+    QVector<QPointF> force_points;
+    energy_points.reserve((int)nr_frames);
+    force_points.reserve((int)nr_frames);
+    for(size_t i = 0; i < nr_frames; ++i) {
+        energy_points.append(QPointF(i + 1, trajectory->get_energy(i)));
+        force_points.append(QPointF(i + 1, trajectory->get_rms_force(i)));
     }
+    energy->replace(energy_points);
+    force->replace(force_points);
 
     chart->addSeries(energy);
     chart->addSeries(force);
@@ -184,7 +194,7 @@ void StructureAnalysisGraph::rebuild_chart()
     axisX->setLabelFormat("%.0f");
     axisX->setTickType(QValueAxis::TicksDynamic);
     axisX->setTickAnchor(1.0);
-    axisX->setTickInterval(1.0);
+    axisX->setTickInterval(std::max(1.0, std::ceil((double)nr_frames / 20.0)));    // at most ~20 ticks
 
     axisY->setTitleText(tr("Energy (eV)"));
     axisY->setLabelsColor(energy_color);
@@ -203,7 +213,7 @@ void StructureAnalysisGraph::rebuild_chart()
     force->attachAxis(axisX);
     force->attachAxis(axisY2);
 
-    axisX->setRange(1, (double)structures.size());
+    axisX->setRange(1, (double)nr_frames);
     chart->legend()->setVisible(true);
     chartview->setChart(chart);
 
@@ -216,7 +226,7 @@ void StructureAnalysisGraph::rebuild_chart()
  */
 void StructureAnalysisGraph::update_highlight()
 {
-    if(!chart || structures.empty() || current_index >= structures.size()) {
+    if(!chart || current_index >= nr_frames) {
         return;
     }
 
@@ -228,18 +238,18 @@ void StructureAnalysisGraph::update_highlight()
     auto *force = qobject_cast<QLineSeries*>(chart->series()[1]);
 
     if(energy) {
-        energy->setName(tr("Energy: %1 eV").arg(structures[current_index]->get_energy(), 0, 'f', 4));
+        energy->setName(tr("Energy: %1 eV").arg(trajectory->get_energy(current_index), 0, 'f', 4));
     }
 
     if(force) {
-        force->setName(tr("Force: %1 eV/Å").arg(structures[current_index]->get_rms_force(), 0, 'f', 4));
+        force->setName(tr("Force: %1 eV/Å").arg(trajectory->get_rms_force(current_index), 0, 'f', 4));
     }
 
     auto *s1 = new QScatterSeries();
     s1->setColor(QColor(0xff, 0x66, 0x00));
     s1->setMarkerSize(10.0);
     s1->setName(QString());
-    *s1 << QPointF(current_index + 1, structures[current_index]->get_energy());
+    *s1 << QPointF(current_index + 1, trajectory->get_energy(current_index));
 
     chart->addSeries(s1);
     s1->attachAxis(axisX);
@@ -27,6 +27,7 @@
 #include <QLabel>
 
 #include "../data/structure.h"
+#include "../data/trajectory.h"
 
 /**
  * @brief StructureAnalysisGraph class.
@@ -48,12 +49,15 @@ public:
     explicit StructureAnalysisGraph(QWidget *parent = nullptr);
 
     /**
-     * @brief set_structures.
+     * @brief set_trajectory.
      *
-     * @param structures Parameter structures.
+     * Plots the energy and force of every frame; the frames themselves are
+     * not accessed.
+     *
+     * @param trajectory Parameter trajectory.
      * @param kind Parameter kind.
      */
-    void set_structures(const std::vector<std::shared_ptr<Structure>>& structures,
+    void set_trajectory(const std::shared_ptr<Trajectory>& trajectory,
                         SeriesKind kind = SeriesKind::GEOMETRY_OPTIMIZATION);
 /**
  * @brief set_current_index.
@@ -101,7 +105,8 @@ private:
     QValueAxis *axisY = nullptr;
     QValueAxis *axisY2 = nullptr;
 
-    std::vector<std::shared_ptr<Structure>> structures;
+    std::shared_ptr<Trajectory> trajectory;
+    size_t nr_frames = 0;   // number of frames plotted
     size_t current_index = 0;
     SeriesKind series_kind_ = SeriesKind::GEOMETRY_OPTIMIZATION;
 
@@ -26,6 +26,7 @@
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QFileInfo>
+#include <QSignalBlocker>
 
 namespace {
 constexpr double THZ_TO_WAVENUMBER = 33.35640951981521;
@@ -72,6 +73,13 @@ StructureAnalysisViewer::StructureAnalysisViewer(QWidget *parent)
     button_previous = new QPushButton("<", controls);
     button_next = new QPushButton(">", controls);
     button_last = new QPushButton(">>", controls);
+    button_play = new QPushButton("Play", controls);
+    button_play->setCheckable(true);
+    spinbox_fps = new QSpinBox(controls);
+    spinbox_fps->setRange(1, 120);
+    spinbox_fps->setValue(30);
+    spinbox_fps->setSuffix(" fps");
+    spinbox_fps->setToolTip(tr("Target frame rate of the playback; frames are skipped when it cannot be met"));
     button_edit = new QPushButton("Send to editor", controls);
 
     label_structure_id = new QLabel("", controls);
@@ -81,6 +89,8 @@ StructureAnalysisViewer::StructureAnalysisViewer(QWidget *parent)
     controlsLayout->addWidget(button_previous);
     controlsLayout->addWidget(button_next);
     controlsLayout->addWidget(button_last);
+    controlsLayout->addWidget(button_play);
+    controlsLayout->addWidget(spinbox_fps);
     controlsLayout->addWidget(label_structure_id);
     controlsLayout->addWidget(label_current_energy);
     controlsLayout->addWidget(button_edit);
@@ -93,6 +103,12 @@ StructureAnalysisViewer::StructureAnalysisViewer(QWidget *parent)
     connect(button_next, &QPushButton::clicked, this, &StructureAnalysisViewer::next_requested);
     connect(button_last, &QPushButton::clicked, this, &StructureAnalysisViewer::last_requested);
     connect(button_edit, &QPushButton::clicked, this, &StructureAnalysisViewer::edit_requested);
+    connect(button_play, &QPushButton::toggled, this, [this](bool playing) {
+        button_play->setText(playing ? "Pause" : "Play");
+        emit playback_toggled(playing);
+    });
+    connect(spinbox_fps, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &StructureAnalysisViewer::playback_fps_changed);
 
     update_title();
 }
@@ -112,6 +128,18 @@ void StructureAnalysisViewer::set_header_widget(QWidget *widget)
     header_layout->insertWidget(0, widget, 0, Qt::AlignLeft);
 }
 
+/**
+ * @brief set_playing.
+ *
+ * @param playing Parameter playing.
+ */
+void StructureAnalysisViewer::set_playing(bool playing)
+{
+    const QSignalBlocker blocker(button_play);
+    button_play->setChecked(playing);
+    button_play->setText(playing ? "Pause" : "Play");
+}
+
 /**
  * @brief set_side_toolbar.
  *
@@ -137,6 +165,16 @@ void StructureAnalysisViewer::set_structure_conservative(const std::shared_ptr<S
     anaglyph_widget->set_structure_conservative(structure);
 }
 
+/**
+ * @brief set_playback_frames.
+ *
+ * @param frames Parameter frames.
+ */
+void StructureAnalysisViewer::set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames)
+{
+    anaglyph_widget->set_playback_frames(frames);
+}
+
     /**
      * @brief      Sets the structure.
      *
@@ -155,6 +193,8 @@ void StructureAnalysisViewer::set_structure(const std::shared_ptr<Structure>& st
 void StructureAnalysisViewer::set_mode(ViewerMode mode)
 {
     viewer_mode = mode;
+    button_play->setEnabled(mode == ViewerMode::STRUCTURE_SERIES);
+    spinbox_fps->setEnabled(mode == ViewerMode::STRUCTURE_SERIES);
     update_title();
 }
 
@@ -24,6 +24,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QHBoxLayout>
+#include <QSpinBox>
 
 #include "anaglyph_widget.h"
 #include "../data/structure.h"
@@ -64,6 +65,12 @@ public:
  * @param structure Parameter structure.
  */
     void set_structure_conservative(const std::shared_ptr<Structure>& structure);
+/**
+ * @brief set_playback_frames.
+ *
+ * @param frames Parameter frames.
+ */
+    void set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames);
 /**
  * @brief set_index.
  *
@@ -83,6 +90,14 @@ public:
  * @param kind Parameter kind.
  */
     void set_series_kind(SeriesKind kind);
+/**
+ * @brief set_playing.
+ *
+ * Update the play button without emitting playback_toggled().
+ *
+ * @param playing Parameter playing.
+ */
+    void set_playing(bool playing);
 /**
  * @brief set_header_widget.
  *
@@ -136,6 +151,18 @@ signals:
  *
  */
     void edit_requested();
+/**
+ * @brief playback_toggled.
+ *
+ * @param playing Parameter playing.
+ */
+    void playback_toggled(bool playing);
+/**
+ * @brief playback_fps_changed.
+ *
+ * @param fps Parameter fps.
+ */
+    void playback_fps_changed(int fps);
 
 /**
  * @brief file_dropped.
@@ -183,6 +210,8 @@ private:
     QPushButton *button_previous;
     QPushButton *button_next;
     QPushButton *button_last;
+    QPushButton *button_play;
+    QSpinBox *spinbox_fps;
     QPushButton *button_edit;
 
     QLabel *label_title;
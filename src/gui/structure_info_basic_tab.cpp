@@ -60,6 +60,16 @@ void StructureInfoBasicTab::update_data()
         return;
     }
 
+    // nothing to do when neither the atoms nor the unit cell have changed
+    const auto& generations = this->structure->get_generations();
+    if (this->shown_structure == this->structure.get() &&
+        this->shown_generations.geometry == generations.geometry &&
+        this->shown_generations.cell == generations.cell) {
+        return;
+    }
+    this->shown_structure = this->structure.get();
+    this->shown_generations = generations;
+
     this->get_label("number_of_atoms")
         ->setText(QString::number(this->structure->get_nr_atoms()));
 
@@ -41,6 +41,10 @@ private:
     // Preformatted atomic coordinates block
     QLabel* atomic_coordinates_label;
 
+    // structure and generations currently shown in the labels
+    const Structure* shown_structure = nullptr;
+    Structure::Generations shown_generations;
+
 public:
 /**
  * @brief StructureInfoBasicTab.
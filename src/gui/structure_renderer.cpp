@@ -20,6 +20,10 @@
 
 #include "structure_renderer.h"
 
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
 /**
  * @brief      Constructs a new instance.
  *
@@ -35,11 +39,20 @@ StructureRenderer::StructureRenderer(const std::shared_ptr<Scene>& _scene,
     user_action(_user_action)
 {
     qDebug() << "Constructing Structure Renderer object";
-    this->generate_sphere_coordinates(3);
-    this->generate_cylinder_coordinates(2, 18);
+    // levels of detail, from coarse to fine
+    static const unsigned int sphere_tesselation[NR_LOD_LEVELS] = {1, 2, 3, 4};
+    static const unsigned int bond_slices[NR_LOD_LEVELS] = {6, 10, 18, 32};
+    for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+        this->sphere_levels[i] = this->generate_sphere_coordinates(sphere_tesselation[i]);
+        this->bond_levels[i] = this->generate_bond_coordinates(bond_slices[i]);
+    }
+    this->generate_impostor_coordinates();
     this->generate_coordinates_unitcell(MatrixUnitcell::Ones(3,3));
     this->load_sphere_to_vao();
-    this->load_cylinder_to_vao();
+    this->load_bond_to_vao();
+    this->load_impostors_to_vao();
+    this->load_element_texture();
+    this->load_frame_textures();
     this->load_line_to_vao();
     this->load_plane_to_vao();
 
@@ -54,15 +67,10 @@ StructureRenderer::StructureRenderer(const std::shared_ptr<Scene>& _scene,
      * @param      model_shader  The model shader
      */
 void StructureRenderer::draw(const Structure *structure, bool periodicity_xy, bool periodicity_z) {
-    this->draw_atoms_regular(structure);
-
-    if(periodicity_xy || periodicity_z) {
-        this->draw_atoms_expansion(structure, periodicity_xy, periodicity_z);
-    }
+    this->update_frame_window();
 
-    if(structure->get_nr_bonds() < 5000) {
-        this->draw_bonds(structure);
-    }
+    this->draw_atoms(structure, periodicity_xy, periodicity_z);
+    this->draw_bonds(structure);
 
     if(this->flag_draw_unitcell) {
         this->draw_unitcell(structure);
@@ -77,16 +85,9 @@ void StructureRenderer::draw(const Structure *structure, bool periodicity_xy, bo
      * @param[in]  structure     The structure
      */
 void StructureRenderer::draw_silhouette(const Structure *structure) {
-    this->draw_atoms_silhouette(structure->get_atoms(), structure);
-}
+    this->update_frame_window();
 
-    /**
-     * @brief      Draws atoms in the regular unit cell.
-     *
-     * @param[in]  structure  The structure
-     */
-void StructureRenderer::draw_atoms_regular(const Structure* structure) {
-    this->draw_atoms(structure->get_atoms(), structure);
+    this->draw_atoms_silhouette(structure);
 }
 
     /**
@@ -163,252 +164,928 @@ void StructureRenderer::draw_coordinate_axes()
 
 
     /**
-     * @brief      Draws the atoms in the periodicity expansions.
+     * @brief      Set the frames to keep on the GPU during playback
+     *
+     * The instances of the frames are uploaded when drawing next, as the
+     * OpenGL context need not be current here; frames that are already in
+     * the window are not uploaded again.
+     *
+     * @param[in]  frames  The frames, empty when playback stops
+     */
+void StructureRenderer::set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames) {
+    this->playback_frames.clear();
+    for(const auto& frame : frames) {
+        if(this->playback_frames.size() == FRAME_WINDOW_SIZE) {
+            break;
+        }
+        this->playback_frames.push_back(FrameSlot{frame->get_atom_instances(), frame->get_bond_instances()});
+    }
+
+    this->playback_frames_changed = true;
+}
+
+    /**
+     * @brief      Draws the atoms in the unit cell and the periodicity expansions.
+     *
+     * The atoms are drawn as instances of the sphere (or of the impostor
+     * quad), using a single call per level of detail; the color, radius and
+     * placement of every instance is resolved in the vertex shader. During
+     * playback the positions are read from the playback window instead.
      *
      * @param[in]  structure       The structure
      * @param[in]  periodicity_xy  The periodicity xy
      * @param[in]  periodicity_z   The periodicity z
      */
-void StructureRenderer::draw_atoms_expansion(const Structure* structure, bool periodicity_xy, bool periodicity_z) {
-    this->draw_atoms(structure->get_atoms_expansion(), structure, periodicity_xy, periodicity_z);
+void StructureRenderer::draw_atoms(const Structure* structure, bool periodicity_xy, bool periodicity_z) {
+    this->update_atom_instances(structure, periodicity_xy, periodicity_z);
+    if(this->nr_central_instances == 0) {
+        return;
+    }
+
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+
+    ShaderProgram *atom_shader = this->shader_manager->get_shader_program(this->flag_impostors ? "atom_impostor_shader" : "atom_shader");
+    atom_shader->bind();
+
+    QMatrix4x4 model = (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
+    model.translate(structure->get_center_vector());    // position the center of the unitcell at the origin
+
+    const int slot = this->get_frame_slot();
+    std::array<InstanceBatch, NR_LOD_LEVELS> batches;
+    QOpenGLBuffer& vbo = this->select_atom_batches(this->scene->view * model, slot, batches);
+
+    atom_shader->set_uniform("model", model);
+    atom_shader->set_uniform("view", this->scene->view);
+    atom_shader->set_uniform("projection", this->scene->projection);
+    atom_shader->set_uniform("transposition", this->scene->transposition);
+    atom_shader->set_uniform("lightpos", QVector3D(0,-1000,1));
+    atom_shader->set_uniform("element_data", 0);
+    this->set_frame_uniforms(atom_shader, structure, slot);
+
+    this->texture_elements->bind(0);
+    this->texture_frame_atoms->bind(1);
+    if(this->flag_impostors) {
+        // impostors are exact at any size, hence all are in the first batch
+        atom_shader->set_uniform("silhouette", 0);
+        this->vao_atom_impostor.bind();
+        this->set_atom_instance_attributes(f, vbo, 0);
+        f->glDrawElementsInstanced(GL_TRIANGLES, this->impostor_quad_indices.size(), GL_UNSIGNED_INT, 0, batches[0].count);
+        this->vao_atom_impostor.release();
+    } else {
+        this->vao_sphere.bind();
+        for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+            const InstanceBatch& batch = batches[i];
+            if(batch.count == 0) {
+                continue;
+            }
+            this->set_atom_instance_attributes(f, vbo, batch.first);
+            f->glDrawElementsInstanced(GL_TRIANGLES, this->sphere_levels[i].count, GL_UNSIGNED_INT,
+                                       (void*)(this->sphere_levels[i].first * sizeof(unsigned int)), batch.count);
+        }
+        this->vao_sphere.release();
+    }
+    this->texture_frame_atoms->release(1);
+    this->texture_elements->release(0);
+
+    atom_shader->release();
 }
 
     /**
-     * @brief      Draws atoms.
+     * @brief      Draws silhouette of the atoms in the unit cell.
      *
-     * @param[in]  atoms           The atoms
      * @param[in]  structure       The structure
-     * @param[in]  periodicity_xy  The periodicity xy
-     * @param[in]  periodicity_z   The periodicity z
      */
-void StructureRenderer::draw_atoms(const std::vector<Atom>& atoms, const Structure* structure, bool periodicity_xy, bool periodicity_z) {
-    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+void StructureRenderer::draw_atoms_silhouette(const Structure* structure) {
+    // keep the expansion of the regular pass such that the instances are reused
+    this->update_atom_instances(structure, this->atom_instances_xy, this->atom_instances_z);
+    if(this->nr_central_instances == 0) {
+        return;
+    }
 
-    this->vao_sphere.bind();
+    if(this->flag_impostors) {
+        this->draw_atoms_silhouette_impostors(structure);
+        return;
+    }
 
-    ShaderProgram *model_shader = this->shader_manager->get_shader_program("model_shader");
-    model_shader->bind();
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
 
-    QMatrix4x4 model;
-    QMatrix4x4 mvp;
-
-    // set general properties
-    model_shader->set_uniform("view", this->scene->view);
-    model_shader->set_uniform("lightpos", QVector3D(0,-1000,1));
-
-    // get the vector that positions the unitcell at the origin
-    auto ctr_vector = structure->get_center_vector();
-
-    for(const Atom& atom : atoms) {
-        bool expansion_atom = false;
-
-        // settings per atom type
-        if(atom.atomtype & (1 << ATOM_CENTRAL_UNITCELL)) {
-            // regular atom
-        } else if((periodicity_xy && periodicity_z) && (atom.atomtype & (1 << ATOM_EXPANSION_XY) || atom.atomtype & (1 < ATOM_EXPANSION_Z))) {
-            expansion_atom = true;
-        } else if(periodicity_xy && atom.atomtype & (1 << ATOM_EXPANSION_XY) && !(atom.atomtype & (1 << ATOM_EXPANSION_Z))) {
-            expansion_atom = true;
-        } else if(periodicity_z && atom.atomtype & (1 << ATOM_EXPANSION_Z) && !(atom.atomtype & (1 << ATOM_EXPANSION_XY))) {
-            expansion_atom = true;
-        } else {
-            // ignore this atom
+    ShaderProgram *silhouette_shader = this->shader_manager->get_shader_program("silhouette_shader");
+    silhouette_shader->bind();
+
+    QMatrix4x4 model = (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
+    model.translate(structure->get_center_vector());    // position the center of the unitcell at the origin
+
+    const int slot = this->get_frame_slot();
+    std::array<InstanceBatch, NR_LOD_LEVELS> batches;
+    QOpenGLBuffer& vbo = this->select_atom_batches(this->scene->view * model, slot, batches);
+
+    silhouette_shader->set_uniform("mvp", (this->scene->projection) * (this->scene->view) * model);
+    silhouette_shader->set_uniform("transposition", this->scene->transposition);
+    silhouette_shader->set_uniform("element_data", 0);
+    this->set_frame_uniforms(silhouette_shader, structure, slot);
+
+    // the central atoms are at the start of every batch
+    this->texture_elements->bind(0);
+    this->texture_frame_atoms->bind(1);
+    this->vao_sphere.bind();
+    for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+        const InstanceBatch& batch = batches[i];
+        if(batch.central == 0) {
             continue;
         }
+        this->set_atom_instance_attributes(f, vbo, batch.first);
+        f->glDrawElementsInstanced(GL_TRIANGLES, this->sphere_levels[i].count, GL_UNSIGNED_INT,
+                                   (void*)(this->sphere_levels[i].first * sizeof(unsigned int)), batch.central);
+    }
+    this->vao_sphere.release();
+    this->texture_frame_atoms->release(1);
+    this->texture_elements->release(0);
+
+    silhouette_shader->release();
+}
+
+    /**
+     * @brief      Draws silhouette of the atoms in the unit cell as impostors.
+     *
+     * @param[in]  structure       The structure
+     */
+void StructureRenderer::draw_atoms_silhouette_impostors(const Structure* structure) {
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+
+    // the impostor shader also writes the silhouette encoding, such that
+    // the outline matches the ray-cast spheres
+    ShaderProgram *atom_shader = this->shader_manager->get_shader_program("atom_impostor_shader");
+    atom_shader->bind();
+
+    QMatrix4x4 model = (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
+    model.translate(structure->get_center_vector());    // position the center of the unitcell at the origin
+
+    const int slot = this->get_frame_slot();
+    std::array<InstanceBatch, NR_LOD_LEVELS> batches;
+    QOpenGLBuffer& vbo = this->select_atom_batches(this->scene->view * model, slot, batches);
+
+    atom_shader->set_uniform("model", model);
+    atom_shader->set_uniform("view", this->scene->view);
+    atom_shader->set_uniform("projection", this->scene->projection);
+    atom_shader->set_uniform("transposition", this->scene->transposition);
+    atom_shader->set_uniform("lightpos", QVector3D(0,-1000,1));
+    atom_shader->set_uniform("element_data", 0);
+    atom_shader->set_uniform("silhouette", 1);
+    this->set_frame_uniforms(atom_shader, structure, slot);
+
+    // the central atoms are at the start of the single batch
+    this->texture_elements->bind(0);
+    this->texture_frame_atoms->bind(1);
+    this->vao_atom_impostor.bind();
+    this->set_atom_instance_attributes(f, vbo, 0);
+    f->glDrawElementsInstanced(GL_TRIANGLES, this->impostor_quad_indices.size(), GL_UNSIGNED_INT, 0, batches[0].central);
+    this->vao_atom_impostor.release();
+    this->texture_frame_atoms->release(1);
+    this->texture_elements->release(0);
+
+    atom_shader->release();
+}
+
+    /**
+     * @brief      Adopt the atom instances of the structure if these have changed
+     *
+     * The structure builds the instances of its central atoms and the
+     * bounding volume hierarchy over these (see AtomInstances), ahead of
+     * being shown for prefetched frames; only the periodic images that are
+     * shown are collected here.
+     *
+     * @param[in]  structure       The structure
+     * @param[in]  periodicity_xy  Whether to include the xy expansion
+     * @param[in]  periodicity_z   Whether to include the z expansion
+     */
+void StructureRenderer::update_atom_instances(const Structure* structure, bool periodicity_xy, bool periodicity_z) {
+    std::shared_ptr<const AtomInstances> instances = structure->get_atom_instances();
+
+    if(instances == this->atom_instances &&
+       periodicity_xy == this->atom_instances_xy &&
+       periodicity_z == this->atom_instances_z) {
+        return;
+    }
+
+    this->atom_instances = instances;
+    this->nr_central_instances = instances->get_instances().size();
+
+    // the periodic images are the central atoms translated over the shown
+    // lattice vectors; the few selected atoms in these are kept apart
+    this->atom_images.clear();
+    this->atom_image_selection.clear();
+    if(periodicity_xy || periodicity_z) {
+        for(unsigned int image=0; image<Structure::NR_IMAGES; image++) {
+            const unsigned int atomtype = Structure::get_image_atomtype(image);
+            const bool expansion_xy = atomtype & (1 << ATOM_EXPANSION_XY);
+            const bool expansion_z = atomtype & (1 << ATOM_EXPANSION_Z);
+            if((expansion_xy && !periodicity_xy) || (expansion_z && !periodicity_z)) {
+                continue;
+            }
+
+            const VectorPosition dp = structure->get_image_translation(image);
+            this->atom_images.emplace_back(image, QVector3D((float)dp[0], (float)dp[1], (float)dp[2]));
+        }
+
+        this->atom_image_selection = structure->get_image_selection();
+    }
+
+    this->atom_batches_valid = false;
+
+    this->atom_instances_xy = periodicity_xy;
+    this->atom_instances_z = periodicity_z;
+}
+
+    /**
+     * @brief      Collect the visible atom instances and sort these over the
+     *             levels of detail if the view has changed
+     *
+     * The hierarchy over the central atoms is tested against the view
+     * frustum, and against the frustum shifted over every lattice vector
+     * to find the visible periodic images. The level of an atom follows
+     * from its projected radius, such that its facets deviate less than
+     * the tolerance from the true sphere; the periodic images are allowed
+     * a larger deviation. Within every level the central atoms precede the
+     * periodic images.
+     *
+     * @param[in]  modelview  The model and view matrix
+     */
+void StructureRenderer::update_atom_batches(const QMatrix4x4& modelview) {
+    const BatchView view{modelview, this->scene->projection, this->scene->canvas_height,
+                         this->detail, this->flag_impostors};
+    if(this->atom_batches_valid && view == this->atom_batches_view) {
+        return;
+    }
+
+    const QMatrix4x4 mvp = view.projection * modelview;
+    const std::vector<AtomInstance>& central = this->atom_instances->get_instances();
+    std::vector<AtomInstance> instances;
+    instances.reserve(central.size());
 
-        // set the color of the atom
-        auto col = AtomSettings::get().get_atom_color_qvector(AtomSettings::get().get_name_from_elnr(atom.atnr));
-        if(expansion_atom) { // darken atom if it belongs to a periodicity expansion
-            col = this->mix(col, QVector3D(1.0f - col[0], 1.0f - col[1], 1.0f - col[2]), 0.4);
-        } else {
+    // atoms moved by the transposition are displaced in the vertex shader,
+    // hence their stored position cannot be culled
+    for(unsigned int idx : this->atom_instances->get_moving()) {
+        instances.push_back(central[idx]);
+    }
+    const BoundingVolumeHierarchy& bvh = this->atom_instances->get_bvh();
+    bvh.cull(BoundingVolumeHierarchy::get_frustum(mvp), [&central, &instances](unsigned int idx) {
+        const AtomInstance& instance = central[idx];
+        if(((instance.flags >> ATOM_INSTANCE_SELECT_SHIFT) & 0x03) != 1) {
+            instances.push_back(instance);
+        }
+    });
+    const unsigned int nr_central = instances.size();
+
+    // atoms in the images keep their own selection state, which is looked
+    // up by their index in the structure (see Structure::get_image_translation)
+    const unsigned int nr_atoms = central.size();
+    for(const auto& image : this->atom_images) {
+        const unsigned int offset = (image.first + 1) * nr_atoms;
+        const QVector3D& translation = image.second;
+        auto add_image_instance = [&central, &instances, &translation](unsigned int idx, unsigned int select) {
+            AtomInstance instance = central[idx];
             for(unsigned int j=0; j<3; j++) {
-                if(!atom.selective_dynamics[j]) {
-                    col = this->darken(col, 0.5);
-                    break;
+                instance.position[j] += translation[j];
+            }
+            instance.flags = ATOM_INSTANCE_EXPANSION | ((select & 0x03) << ATOM_INSTANCE_SELECT_SHIFT);
+            instances.push_back(instance);
+        };
+
+        for(const auto& selected : this->atom_image_selection) {
+            if(selected.second == 1 && selected.first >= offset && selected.first < offset + nr_atoms) {
+                add_image_instance(selected.first - offset, 1);
+            }
+        }
+
+        QMatrix4x4 image_mvp = mvp;
+        image_mvp.translate(translation);
+        bvh.cull(BoundingVolumeHierarchy::get_frustum(image_mvp), [this, offset, &add_image_instance](unsigned int idx) {
+            unsigned int select = 0;
+            if(!this->atom_image_selection.empty()) {
+                const auto it = this->atom_image_selection.find(offset + idx);
+                if(it != this->atom_image_selection.end()) {
+                    select = it->second;
                 }
             }
+
+            if(select != 1) {
+                add_image_instance(idx, select);
+            }
+        });
+    }
+
+    // sort key: twice the level, plus one for the periodic images
+    std::vector<uint8_t> keys(instances.size(), 0);
+
+    if(this->flag_impostors) {
+        for(unsigned int i=nr_central; i<instances.size(); i++) {
+            keys[i] = 1;
+        }
+    } else {
+        const QVector4D depth = modelview.row(2);
+        const float scale = modelview.column(0).toVector3D().length();
+        const float pixels = scale * 0.5f * (float)view.height * view.projection(1,1);
+        const float tolerance = this->get_lod_tolerance();
+
+        for(unsigned int i=0; i<instances.size(); i++) {
+            const AtomInstance& instance = instances[i];
+            const float z = depth.x() * instance.position[0] + depth.y() * instance.position[1] +
+                            depth.z() * instance.position[2] + depth.w();
+            const float w = view.projection(3,2) * z + view.projection(3,3);
+            const float radius = w > 0.0f ? this->element_radii[instance.element] * pixels / w : std::numeric_limits<float>::max();
+
+            const bool expansion = i >= nr_central;
+            keys[i] = 2 * select_lod(this->sphere_levels, radius, expansion ? 4.0f * tolerance : tolerance) + (expansion ? 1 : 0);
         }
+    }
 
-        if(atom.select != 0) { // highlight atom if it is selected
-            col = this->lighten(col, 0.1);
+    // counting sort over the keys
+    std::array<unsigned int, 2 * NR_LOD_LEVELS> offsets{};
+    for(uint8_t key : keys) {
+        offsets[key]++;
+    }
+    unsigned int first = 0;
+    for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+        this->atom_batches[i].first = first;
+        this->atom_batches[i].count = offsets[2*i] + offsets[2*i+1];
+        this->atom_batches[i].central = offsets[2*i];
+        for(unsigned int j=2*i; j<2*i+2; j++) {
+            const unsigned int count = offsets[j];
+            offsets[j] = first;
+            first += count;
         }
+    }
 
-        double radius = AtomSettings::get().get_atom_radius_from_elnr(atom.atnr);
+    std::vector<AtomInstance> sorted(instances.size());
+    for(unsigned int i=0; i<instances.size(); i++) {
+        sorted[offsets[keys[i]]++] = instances[i];
+    }
 
-        // build model matrix
-        model.setToIdentity();
-        model *= (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
-        model.translate(ctr_vector);        // position the center of the unitcell at the origin
-        if(atom.select == 1) {
-            model *= this->scene->transposition;
-        }
-        model.translate(atom.get_pos_qtvec());
-        model.scale(radius);
+    this->vbo_atom_instances.bind();
+    this->vbo_atom_instances.allocate(sorted.data(), sorted.size() * sizeof(AtomInstance));
+    this->vbo_atom_instances.release();
 
-        // build model - view - projection matrix
-        QMatrix4x4 mvp = (this->scene->projection) * (this->scene->view) * model;
+    this->atom_batches_view = view;
+    this->atom_batches_valid = true;
+}
 
-        // set per-atom properties
-        model_shader->set_uniform("mvp", mvp);
-        model_shader->set_uniform("model", model);
-        model_shader->set_uniform("color", col);
+    /**
+     * @brief      Point the instance attributes of the bound vertex array object to atom instances
+     *
+     * OpenGL 3.3 cannot offset the instance index of a draw call, hence
+     * every batch points the attributes to its first instance.
+     *
+     * @param      f      OpenGL functions
+     * @param      vbo    The instance buffer
+     * @param[in]  first  First instance
+     */
+void StructureRenderer::set_atom_instance_attributes(QOpenGLExtraFunctions* f, QOpenGLBuffer& vbo, unsigned int first) {
+    const size_t base = first * sizeof(AtomInstance);
+
+    vbo.bind();
+    f->glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(AtomInstance), (void*)(base + offsetof(AtomInstance, position)));
+    f->glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(AtomInstance), (void*)(base + offsetof(AtomInstance, element)));
+    f->glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(AtomInstance), (void*)(base + offsetof(AtomInstance, flags)));
+    vbo.release();
+}
 
-        // draw atom
-        f->glDrawElements(GL_TRIANGLES, this->sphere_indices.size(), GL_UNSIGNED_INT, 0);
+    /**
+     * @brief      Draws bonds.
+     *
+     * The bonds are drawn as instances of the bond mesh (or of the impostor
+     * boxes), using a single call per level of detail; the orientation and
+     * the colors of both halves are resolved in the vertex shader. During
+     * playback the bonds are read from the playback window instead.
+     *
+     * @param[in]  structure  The structure
+     */
+void StructureRenderer::draw_bonds(const Structure* structure) {
+    this->update_bond_instances(structure);
+    if(this->nr_bond_instances == 0) {
+        return;
     }
 
-    this->vao_sphere.release();
-    model_shader->release();
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+
+    ShaderProgram *bond_shader = this->shader_manager->get_shader_program(this->flag_impostors ? "bond_impostor_shader" : "bond_shader");
+    bond_shader->bind();
+
+    QMatrix4x4 model = (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
+    model.translate(structure->get_center_vector());    // position the center of the unitcell at the origin
+
+    // the bonds of a frame in the playback window are all drawn at once
+    const int slot = this->get_frame_slot();
+    const bool playback = slot >= 0 && this->frame_slots[slot].bonds == this->bond_instances;
+    std::array<InstanceBatch, NR_LOD_LEVELS> batches;
+    if(playback) {
+        this->update_frame_levels(this->scene->view * model);
+        batches = std::array<InstanceBatch, NR_LOD_LEVELS>();
+        batches[this->frame_bond_level].count = this->nr_bond_instances;
+    } else {
+        this->update_bond_batches(this->scene->view * model);
+        batches = this->bond_batches;
+    }
+
+    bond_shader->set_uniform("model", model);
+    bond_shader->set_uniform("view", this->scene->view);
+    bond_shader->set_uniform("projection", this->scene->projection);
+    bond_shader->set_uniform("lightpos", QVector3D(0,-1000,1));
+    bond_shader->set_uniform("radius", BOND_RADIUS);
+    bond_shader->set_uniform("element_data", 0);
+    bond_shader->set_uniform("frame_bond_data", 2);
+    bond_shader->set_uniform("frame_base", playback ? (int)(slot * this->frame_bond_capacity) : -1);
+
+    // the instance attributes are not read during playback, and are hence
+    // disabled such that these do not run past the end of vbo_bond_instances
+    auto set_attributes = [this, f, playback](unsigned int first) {
+        if(!playback) {
+            this->set_bond_instance_attributes(f, first);
+            return;
+        }
+        for(unsigned int i=2; i<6; i++) {
+            f->glDisableVertexAttribArray(i);
+        }
+    };
+    auto restore_attributes = [f, playback]() {
+        if(!playback) {
+            return;
+        }
+        for(unsigned int i=2; i<6; i++) {
+            f->glEnableVertexAttribArray(i);
+        }
+    };
+
+    this->texture_elements->bind(0);
+    this->texture_frame_bonds->bind(2);
+    if(this->flag_impostors) {
+        this->vao_bond_impostor.bind();
+        set_attributes(0);
+        f->glDrawElementsInstanced(GL_TRIANGLES, this->impostor_box_indices.size(), GL_UNSIGNED_INT, 0, batches[0].count);
+        restore_attributes();
+        this->vao_bond_impostor.release();
+    } else {
+        this->vao_bond.bind();
+        for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+            const InstanceBatch& batch = batches[i];
+            if(batch.count == 0) {
+                continue;
+            }
+            set_attributes(batch.first);
+            f->glDrawElementsInstanced(GL_TRIANGLES, this->bond_levels[i].count, GL_UNSIGNED_INT,
+                                       (void*)(this->bond_levels[i].first * sizeof(unsigned int)), batch.count);
+        }
+        restore_attributes();
+        this->vao_bond.release();
+    }
+    this->texture_frame_bonds->release(2);
+    this->texture_elements->release(0);
+
+    bond_shader->release();
 }
 
     /**
-     * @brief      Draws silhouette of atoms.
+     * @brief      Adopt the bond instances of the structure if these have changed
      *
-     * @param[in]  atoms           The atoms
-     * @param[in]  structure       The structure
+     * The structure builds the instances and the bounding volume hierarchy
+     * over these (see BondInstances), ahead of being shown for prefetched
+     * frames.
+     *
+     * Previewing a transposition rebuilds the bonds of the moved atoms and
+     * hence changes the topology generation, such that the instances follow
+     * the atoms while these are being moved.
+     *
+     * @param[in]  structure  The structure
      */
-void StructureRenderer::draw_atoms_silhouette(const std::vector<Atom>& atoms, const Structure* structure) {
-    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+void StructureRenderer::update_bond_instances(const Structure* structure) {
+    std::shared_ptr<const BondInstances> instances = structure->get_bond_instances();
+    if(instances == this->bond_instances) {
+        return;
+    }
 
-    this->vao_sphere.bind();
+    this->bond_instances = instances;
+    this->nr_bond_instances = instances->get_instances().size();
+    this->bond_batches_valid = false;
+}
+
+    /**
+     * @brief      Collect the visible bond instances and sort these over the
+     *             levels of detail if the view has changed
+     *
+     * A bond is drawn at the level of its half closest to the viewer.
+     *
+     * @param[in]  modelview  The model and view matrix
+     */
+void StructureRenderer::update_bond_batches(const QMatrix4x4& modelview) {
+    const BatchView view{modelview, this->scene->projection, this->scene->canvas_height,
+                         this->detail, this->flag_impostors};
+    if(this->bond_batches_valid && view == this->bond_batches_view) {
+        return;
+    }
 
-    ShaderProgram *model_shader = this->shader_manager->get_shader_program("silhouette_shader");
-    model_shader->bind();
+    const std::vector<BondInstance>& bonds = this->bond_instances->get_instances();
+    std::vector<BondInstance> instances;
+    instances.reserve(bonds.size());
+    this->bond_instances->get_bvh().cull(BoundingVolumeHierarchy::get_frustum(view.projection * modelview), [&bonds, &instances](unsigned int idx) {
+        instances.push_back(bonds[idx]);
+    });
+
+    std::vector<uint8_t> levels(instances.size(), 0);
+
+    if(!this->flag_impostors) {
+        const QVector4D depth = modelview.row(2);
+        const float scale = modelview.column(0).toVector3D().length();
+        const float pixels = BOND_RADIUS * scale * 0.5f * (float)view.height * view.projection(1,1);
+        const float tolerance = this->get_lod_tolerance();
+
+        auto get_w = [&depth, &view](const float* p) {
+            const float z = depth.x() * p[0] + depth.y() * p[1] + depth.z() * p[2] + depth.w();
+            return view.projection(3,2) * z + view.projection(3,3);
+        };
+
+        for(unsigned int i=0; i<instances.size(); i++) {
+            // the halves are anchored at the atoms, also across the cell boundary
+            const BondInstance& instance = instances[i];
+            const float w = std::min(get_w(instance.start), get_w(instance.end));
+            const float radius = w > 0.0f ? pixels / w : std::numeric_limits<float>::max();
+            levels[i] = select_lod(this->bond_levels, radius, tolerance);
+        }
+    }
 
-    QMatrix4x4 model;
-    QMatrix4x4 mvp;
+    // counting sort over the levels
+    std::array<unsigned int, NR_LOD_LEVELS> offsets{};
+    for(uint8_t level : levels) {
+        offsets[level]++;
+    }
+    unsigned int first = 0;
+    for(unsigned int i=0; i<NR_LOD_LEVELS; i++) {
+        this->bond_batches[i].first = first;
+        this->bond_batches[i].count = offsets[i];
+        this->bond_batches[i].central = offsets[i];
+        offsets[i] = first;
+        first += this->bond_batches[i].count;
+    }
 
-    // get the vector that positions the unitcell at the origin
-    auto ctr_vector = structure->get_center_vector();
+    std::vector<BondInstance> sorted(instances.size());
+    for(unsigned int i=0; i<instances.size(); i++) {
+        sorted[offsets[levels[i]]++] = instances[i];
+    }
 
-    float counter = 10.0f;
-    for(const Atom& atom : atoms) {
-        if(!(atom.atomtype & (1 << ATOM_CENTRAL_UNITCELL))) {
-            continue;
+    this->vbo_bond_instances.bind();
+    this->vbo_bond_instances.allocate(sorted.data(), sorted.size() * sizeof(BondInstance));
+    this->vbo_bond_instances.release();
+
+    this->bond_batches_view = view;
+    this->bond_batches_valid = true;
+}
+
+    /**
+     * @brief      Point the instance attributes of the bound vertex array object to bond instances
+     *
+     * OpenGL 3.3 cannot offset the instance index of a draw call, hence
+     * every batch points the attributes to its first instance.
+     *
+     * @param      f      OpenGL functions
+     * @param[in]  first  First instance
+     */
+void StructureRenderer::set_bond_instance_attributes(QOpenGLExtraFunctions* f, unsigned int first) {
+    const size_t base = first * sizeof(BondInstance);
+
+    this->vbo_bond_instances.bind();
+    f->glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(BondInstance), (void*)(base + offsetof(BondInstance, start)));
+    f->glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BondInstance), (void*)(base + offsetof(BondInstance, end)));
+    f->glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(BondInstance), (void*)(base + offsetof(BondInstance, translation)));
+    f->glVertexAttribIPointer(5, 1, GL_UNSIGNED_INT, sizeof(BondInstance), (void*)(base + offsetof(BondInstance, atoms)));
+    this->vbo_bond_instances.release();
+}
+
+    /**
+     * @brief      Upload the frames to keep during playback to the free slots
+     *
+     * All slots share the elements and flags of the first frame uploaded
+     * to an empty window (the layout), such that only the positions are
+     * read from the slots; frames that differ in these are not kept.
+     */
+void StructureRenderer::update_frame_window() {
+    if(!this->playback_frames_changed) {
+        return;
+    }
+    this->playback_frames_changed = false;
+
+    auto is_pending = [this](const FrameSlot& slot) {
+        return std::any_of(this->playback_frames.begin(), this->playback_frames.end(), [&slot](const FrameSlot& frame) {
+            return frame.atoms == slot.atoms;
+        });
+    };
+
+    // free the slots of the frames that are no longer ahead
+    bool empty = true;
+    for(FrameSlot& slot : this->frame_slots) {
+        if(slot.atoms && !is_pending(slot)) {
+            slot = FrameSlot();
         }
+        empty = empty && !slot.atoms;
+    }
 
-        auto col = QVector3D(0.0f, 0.0f, 0.0f);
-        switch(atom.select) {
-            case 0:
-                col = QVector3D(0.0f, 0.0f, 0.0f);
-            break;
-            case 1:
-                counter += 1.0f;
-                col = QVector3D(counter/255.f, 0.0f, 0.25f);
-            break;
-            case 2:
-                counter += 1.0f;
-                col = QVector3D(counter/255.f, 0.f, 0.50f);
-            break;
-            default:
-                col = QVector3D(0.0f, 0.0f, 0.0f);
-            break;
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+
+    if(empty) {
+        this->frame_layout.reset();
+        if(this->playback_frames.empty()) {
+            return;
         }
 
-        double radius = AtomSettings::get().get_atom_radius_from_elnr(atom.atnr);
+        this->frame_layout = this->playback_frames.front().atoms;
+        this->frame_levels_valid = false;
+
+        const unsigned int nr_atoms = this->frame_layout->get_instances().size();
+        if(nr_atoms > this->frame_atom_capacity) {
+            this->frame_atom_capacity = nr_atoms;
+            this->vbo_frame_atoms.bind();
+            this->vbo_frame_atoms.allocate(FRAME_WINDOW_SIZE * nr_atoms * sizeof(AtomInstance));
+            this->vbo_frame_atoms.release();
 
-        // build model matrix
-        model.setToIdentity();
-        model *= (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
-        model.translate(ctr_vector);        // position the center of the unitcell at the origin
-        if(atom.select == 1) {
-            model *= this->scene->transposition;
+            this->texture_frame_atoms->bind();
+            f->glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, this->vbo_frame_atoms.bufferId());
+            this->texture_frame_atoms->release();
         }
-        model.translate(atom.get_pos_qtvec());
-        model.scale(radius);
+    }
 
-        // build model - view - projection matrix
-        QMatrix4x4 mvp = (this->scene->projection) * (this->scene->view) * model;
+    const std::vector<AtomInstance>& layout = this->frame_layout->get_instances();
+    auto matches_layout = [&layout](const FrameSlot& frame) {
+        const std::vector<AtomInstance>& atoms = frame.atoms->get_instances();
+        return std::equal(atoms.begin(), atoms.end(), layout.begin(), layout.end(), [](const AtomInstance& a, const AtomInstance& b) {
+            return a.element == b.element && a.flags == b.flags;
+        });
+    };
+
+    // the number of bonds varies between the frames; when it exceeds the
+    // slots, these are enlarged and all frames are uploaded again
+    size_t nr_bonds = 0;
+    for(const FrameSlot& frame : this->playback_frames) {
+        nr_bonds = std::max(nr_bonds, frame.bonds->get_instances().size());
+    }
+    if(nr_bonds > this->frame_bond_capacity) {
+        this->frame_bond_capacity = std::max<size_t>(nr_bonds, this->frame_bond_capacity * 3 / 2);
+        this->vbo_frame_bonds.bind();
+        this->vbo_frame_bonds.allocate(FRAME_WINDOW_SIZE * this->frame_bond_capacity * sizeof(BondInstance));
+        this->vbo_frame_bonds.release();
 
-        // set per-atom properties
-        model_shader->set_uniform("mvp", mvp);
-        model_shader->set_uniform("color", col);
+        this->texture_frame_bonds->bind();
+        f->glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, this->vbo_frame_bonds.bufferId());
+        this->texture_frame_bonds->release();
 
-        // draw atom
-        f->glDrawElements(GL_TRIANGLES, this->sphere_indices.size(), GL_UNSIGNED_INT, 0);
+        this->frame_slots.fill(FrameSlot());
     }
 
-    this->vao_sphere.release();
-    model_shader->release();
+    for(const FrameSlot& frame : this->playback_frames) {
+        if(!matches_layout(frame)) {
+            continue;
+        }
+
+        auto same = [&frame](const FrameSlot& slot) {
+            return slot.atoms == frame.atoms;
+        };
+        if(std::any_of(this->frame_slots.begin(), this->frame_slots.end(), same)) {
+            continue;
+        }
+
+        // a slot is free as there are no more frames than slots
+        auto slot = std::find_if(this->frame_slots.begin(), this->frame_slots.end(), [](const FrameSlot& other) {
+            return !other.atoms;
+        });
+        *slot = frame;
+        this->write_frame_slot(slot - this->frame_slots.begin(), frame);
+    }
 }
 
     /**
-     * @brief      Draws bonds.
+     * @brief      Write the instances of a frame to a slot of the playback window
      *
-     * @param[in]  structure  The structure
+     * @param[in]  slot   The slot
+     * @param[in]  frame  The frame
      */
-void StructureRenderer::draw_bonds(const Structure* structure) {
-    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+void StructureRenderer::write_frame_slot(unsigned int slot, const FrameSlot& frame) {
+    // the vertex shaders address the instances per word
+    static_assert(sizeof(AtomInstance) == 5 * sizeof(uint32_t), "the shaders assume five words per atom");
+    static_assert(sizeof(BondInstance) == 10 * sizeof(uint32_t), "the shaders assume ten words per bond");
+
+    const std::vector<AtomInstance>& atoms = frame.atoms->get_instances();
+    this->vbo_frame_atoms.bind();
+    this->vbo_frame_atoms.write(slot * this->frame_atom_capacity * sizeof(AtomInstance), atoms.data(), atoms.size() * sizeof(AtomInstance));
+    this->vbo_frame_atoms.release();
+
+    const std::vector<BondInstance>& bonds = frame.bonds->get_instances();
+    if(!bonds.empty()) {
+        this->vbo_frame_bonds.bind();
+        this->vbo_frame_bonds.write(slot * this->frame_bond_capacity * sizeof(BondInstance), bonds.data(), bonds.size() * sizeof(BondInstance));
+        this->vbo_frame_bonds.release();
+    }
+}
 
-    this->vao_cylinder.bind();
+    /**
+     * @brief      Get the slot of the playback window holding the shown atoms
+     *
+     * @return     The slot, -1 if the atoms are drawn from vbo_atom_instances.
+     */
+int StructureRenderer::get_frame_slot() const {
+    if(!this->frame_layout || !this->atom_instances) {
+        return -1;
+    }
 
-    ShaderProgram *model_shader = this->shader_manager->get_shader_program("model_shader");
-    model_shader->bind();
+    for(unsigned int i=0; i<FRAME_WINDOW_SIZE; i++) {
+        if(this->frame_slots[i].atoms == this->atom_instances) {
+            return i;
+        }
+    }
 
-    QMatrix4x4 model;
-    QMatrix4x4 mvp;
+    return -1;
+}
 
-    // set general properties
-    model_shader->set_uniform("view", this->scene->view);
-    model_shader->set_uniform("lightpos", QVector3D(0,-1000,1));
+    /**
+     * @brief      Fill the instances drawn from the playback window if the
+     *             shown periodic images have changed
+     *
+     * The central atoms come first, followed by all atoms of every shown
+     * periodic image; the position of an instance holds the lattice
+     * coefficients of its image, which the vertex shader adds to the
+     * position of the atom in the shown frame.
+     */
+void StructureRenderer::update_frame_instances() {
+    if(this->frame_instances_layout == this->frame_layout &&
+       this->frame_instances_xy == this->atom_instances_xy &&
+       this->frame_instances_z == this->atom_instances_z &&
+       this->frame_instances_selection == this->atom_image_selection) {
+        return;
+    }
 
-    // get the vector that positions the unitcell at the origin
-    auto ctr_vector = structure->get_center_vector();
+    const std::vector<AtomInstance>& central = this->frame_layout->get_instances();
+    const unsigned int nr_atoms = central.size();
+    std::vector<AtomInstance> instances(central);
+    instances.reserve((this->atom_images.size() + 1) * nr_atoms);
+    for(AtomInstance& instance : instances) {
+        std::fill(std::begin(instance.position), std::end(instance.position), 0.0f);
+    }
 
-    for(unsigned int i=0; i<structure->get_nr_bonds(); i++) {
-        const Bond& bond = structure->get_bond(i);
+    for(const auto& image : this->atom_images) {
+        const unsigned int offset = (image.first + 1) * nr_atoms;
+        const VectorPosition p = Structure::get_image_coefficients(image.first);
+        for(unsigned int idx=0; idx<nr_atoms; idx++) {
+            unsigned int select = 0;
+            if(!this->atom_image_selection.empty()) {
+                const auto it = this->atom_image_selection.find(offset + idx);
+                if(it != this->atom_image_selection.end()) {
+                    select = it->second;
+                }
+            }
 
-        QVector3D col;
+            AtomInstance instance = central[idx];
+            for(unsigned int j=0; j<3; j++) {
+                instance.position[j] = (float)p[j];
+            }
+            instance.flags = ATOM_INSTANCE_EXPANSION | ((select & 0x03) << ATOM_INSTANCE_SELECT_SHIFT);
+            instances.push_back(instance);
+        }
+    }
 
-        model.setToIdentity();
-        model *= (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
-        model.translate(ctr_vector);        // position the center of the unitcell at the origin
-        model.translate(bond.atom1.get_pos_qtvec());
-        model.rotate(qRadiansToDegrees(bond.angle), bond.axis);
-        model.scale(QVector3D(0.15, 0.15, bond.length * 0.5));
+    this->vbo_frame_instances.bind();
+    this->vbo_frame_instances.allocate(instances.data(), instances.size() * sizeof(AtomInstance));
+    this->vbo_frame_instances.release();
+    this->nr_frame_instances = instances.size();
 
-        QMatrix4x4 mvp = (this->scene->projection) * (this->scene->view) * model;
+    this->frame_instances_layout = this->frame_layout;
+    this->frame_instances_selection = this->atom_image_selection;
+    this->frame_instances_xy = this->atom_instances_xy;
+    this->frame_instances_z = this->atom_instances_z;
+}
 
-        model_shader->set_uniform("mvp", mvp);
-        model_shader->set_uniform("model", model);
-        col = AtomSettings::get().get_atom_color_qvector(AtomSettings::get().get_name_from_elnr(bond.atom1.atnr));
-        for(unsigned int j=0; j<3; j++) {
-            if(!bond.atom1.selective_dynamics[j]) {
-                col = this->darken(col, 0.5);
+    /**
+     * @brief      Select the levels of detail drawn during playback if the view has changed
+     *
+     * All atoms and all bonds are drawn at the level of the atom of the
+     * layout appearing largest, such that the level does not change from
+     * frame to frame and no atom is drawn coarser than outside playback.
+     *
+     * @param[in]  modelview  The model and view matrix
+     */
+void StructureRenderer::update_frame_levels(const QMatrix4x4& modelview) {
+    const BatchView view{modelview, this->scene->projection, this->scene->canvas_height,
+                         this->detail, this->flag_impostors};
+    if(this->frame_levels_valid && view == this->frame_levels_view) {
+        return;
+    }
+
+    float atom_radius = 0.0f;
+    float bond_radius = 0.0f;
+    if(!this->flag_impostors) {
+        const QVector4D depth = modelview.row(2);
+        const float scale = modelview.column(0).toVector3D().length();
+        const float pixels = scale * 0.5f * (float)view.height * view.projection(1,1);
+
+        for(const AtomInstance& instance : this->frame_layout->get_instances()) {
+            const float z = depth.x() * instance.position[0] + depth.y() * instance.position[1] +
+                            depth.z() * instance.position[2] + depth.w();
+            const float w = view.projection(3,2) * z + view.projection(3,3);
+            if(w <= 0.0f) {
+                atom_radius = bond_radius = std::numeric_limits<float>::max();
                 break;
             }
+            atom_radius = std::max(atom_radius, this->element_radii[instance.element] * pixels / w);
+            bond_radius = std::max(bond_radius, BOND_RADIUS * pixels / w);
         }
-        model_shader->set_uniform("color", col);
+    }
+
+    const float tolerance = this->get_lod_tolerance();
+    this->frame_atom_level = this->flag_impostors ? 0 : select_lod(this->sphere_levels, atom_radius, tolerance);
+    this->frame_bond_level = this->flag_impostors ? 0 : select_lod(this->bond_levels, bond_radius, tolerance);
+
+    this->frame_levels_view = view;
+    this->frame_levels_valid = true;
+}
+
+    /**
+     * @brief      Get the atom instances to draw and their distribution over the levels of detail
+     *
+     * Outside playback the visible instances are collected and sorted when
+     * the view changes; for a frame in the playback window all instances
+     * are drawn at a single level.
+     *
+     * @param[in]  modelview  The model and view matrix
+     * @param[in]  slot       Slot of the playback window holding the atoms, -1 if none
+     * @param[out] batches    The batches
+     *
+     * @return     The instance buffer.
+     */
+QOpenGLBuffer& StructureRenderer::select_atom_batches(const QMatrix4x4& modelview, int slot, std::array<InstanceBatch, NR_LOD_LEVELS>& batches) {
+    if(slot < 0) {
+        this->update_atom_batches(modelview);
+        batches = this->atom_batches;
+        return this->vbo_atom_instances;
+    }
 
-        // draw bond
-        f->glDrawElements(GL_TRIANGLES, this->cylinder_indices.size(), GL_UNSIGNED_INT, 0);
+    this->update_frame_instances();
+    this->update_frame_levels(modelview);
 
-        model.setToIdentity();
-        model *= (this->scene->arcball_rotation) * (this->scene->rotation_matrix);
-        model.translate(ctr_vector);        // position the center of the unitcell at the origin
-        model.translate(bond.atom1.get_pos_qtvec() + (bond.direction * bond.length * 0.5));
-        model.rotate(qRadiansToDegrees(bond.angle), bond.axis);
-        model.scale(QVector3D(0.15, 0.15, bond.length * 0.5));
+    batches = std::array<InstanceBatch, NR_LOD_LEVELS>();
+    batches[this->frame_atom_level].count = this->nr_frame_instances;
+    batches[this->frame_atom_level].central = this->nr_central_instances;
 
-        mvp = (this->scene->projection) * (this->scene->view) * model;
+    return this->vbo_frame_instances;
+}
 
-        model_shader->set_uniform("mvp", mvp);
-        model_shader->set_uniform("model", model);
-        col = AtomSettings::get().get_atom_color_qvector(AtomSettings::get().get_name_from_elnr(bond.atom2.atnr));
+    /**
+     * @brief      Set the uniforms selecting the shown frame in the playback window
+     *
+     * These are also set outside playback, such that the buffer texture
+     * does not share its unit with the element texture.
+     *
+     * @param      shader     The atom or silhouette shader
+     * @param[in]  structure  The structure
+     * @param[in]  slot       The slot, -1 if not playing
+     */
+void StructureRenderer::set_frame_uniforms(ShaderProgram* shader, const Structure* structure, int slot) const {
+    // the lattice vectors are the columns
+    const MatrixUnitcell& unitcell = structure->get_unitcell();
+    float values[9];
+    for(unsigned int i=0; i<3; i++) {
         for(unsigned int j=0; j<3; j++) {
-            if(!bond.atom2.selective_dynamics[j]) {
-                col = this->darken(col, 0.5);
-                break;
-            }
+            values[i*3+j] = (float)unitcell(j,i);
         }
-        model_shader->set_uniform("color", col);
+    }
+
+    shader->set_uniform("frame_atom_data", 1);
+    shader->set_uniform("frame_base", slot < 0 ? -1 : (int)(slot * this->frame_atom_capacity));
+    shader->set_uniform("frame_nr_atoms", (int)this->nr_central_instances);
+    shader->set_uniform("frame_cell", QMatrix3x3(values));
+}
+
+    /**
+     * @brief      Get the pixel tolerance for the deviation of the meshes
+     *
+     * Half a pixel at the default detail; every step halves or doubles it.
+     *
+     * @return     The tolerance.
+     */
+float StructureRenderer::get_lod_tolerance() const {
+    return 0.5f * std::ldexp(1.0f, DETAIL_DEFAULT - this->detail);
+}
 
-        // draw bond
-        f->glDrawElements(GL_TRIANGLES, this->cylinder_indices.size(), GL_UNSIGNED_INT, 0);
+    /**
+     * @brief      Select the coarsest level of detail within the tolerance
+     *
+     * @param[in]  levels     The levels of detail of the mesh
+     * @param[in]  radius     Radius of the object on screen (in pixels)
+     * @param[in]  tolerance  Tolerated deviation (in pixels)
+     *
+     * @return     The level.
+     */
+unsigned int StructureRenderer::select_lod(const std::array<MeshLevel, NR_LOD_LEVELS>& levels, float radius, float tolerance) {
+    for(unsigned int i=0; i<NR_LOD_LEVELS-1; i++) {
+        if(radius * levels[i].error <= tolerance) {
+            return i;
+        }
     }
 
-    this->vao_cylinder.release();
-    model_shader->release();
+    return NR_LOD_LEVELS - 1;
 }
 
     /**
@@ -419,7 +1096,11 @@ void StructureRenderer::draw_bonds(const Structure* structure) {
 void StructureRenderer::draw_unitcell(const Structure* structure) {
     QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
 
-    this->set_unitcell_vertices(structure->get_unitcell());
+    // only upload the vertices when the unit cell has changed
+    if(this->unitcell_generation != structure->get_generations().cell) {
+        this->set_unitcell_vertices(structure->get_unitcell());
+        this->unitcell_generation = structure->get_generations().cell;
+    }
 
     ShaderProgram *unitcell_shader = this->shader_manager->get_shader_program("unitcell_shader");
     unitcell_shader->bind();
@@ -612,11 +1293,13 @@ void StructureRenderer::draw_movement_plane(const Structure* structure) {
 }
 
     /**
-     * @brief      Generate coordinates of a sphere
+     * @brief      Generate coordinates of a sphere and append these to the sphere facets
      *
      * @param[in]  tesselation_level  The tesselation level
+     *
+     * @return     The range of the sphere in the index buffer.
      */
-void StructureRenderer::generate_sphere_coordinates(unsigned int tesselation_level) {
+StructureRenderer::MeshLevel StructureRenderer::generate_sphere_coordinates(unsigned int tesselation_level) {
     std::vector<glm::vec3> vertices;
 
     vertices.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
@@ -698,65 +1381,121 @@ void StructureRenderer::generate_sphere_coordinates(unsigned int tesselation_lev
         triangles = new_triangles;
     }
 
-    this->sphere_vertices = vertices;
-    this->sphere_normals = vertices;  // for a sphere, vertices and normals are equal
-    this->sphere_indices = triangles;
+    // the facets are closest to the center at their centroids
+    MeshLevel level;
+    level.first = this->sphere_indices.size();
+    level.count = triangles.size();
+    for (unsigned int i = 0; i < triangles.size(); i += 3) {
+        glm::vec3 centroid = (vertices[triangles[i]] + vertices[triangles[i+1]] + vertices[triangles[i+2]]) / 3.0f;
+        level.error = std::max(level.error, 1.0f - glm::length(centroid));
+    }
+
+    const unsigned int offset = this->sphere_vertices.size();
+    for (unsigned int index : triangles) {
+        this->sphere_indices.push_back(offset + index);
+    }
+    this->sphere_vertices.insert(this->sphere_vertices.end(), vertices.begin(), vertices.end());
+    this->sphere_normals.insert(this->sphere_normals.end(), vertices.begin(), vertices.end());  // for a sphere, vertices and normals are equal
+
+    return level;
 }
 
     /**
-     * @brief      Generate coordinates for a default cylinder (radius 1, height 1)
+     * @brief      Generate coordinates for a bond (radius 1, height 1) and append
+     *             these to the bond facets
+     *
+     * The bond consists of two cylinders running from z = 0 to z = 0.5 and
+     * from z = 0.5 to z = 1. The halves do not share vertices such that they
+     * can be anchored at different atoms for bonds across the cell boundary.
      *
-     * @param[in]  stack_count  The stack count
      * @param[in]  slice_count  The slice count
+     *
+     * @return     The range of the bond in the index buffer.
      */
-void StructureRenderer::generate_cylinder_coordinates(unsigned int stack_count, unsigned int slice_count) {
-    // construct vertices and normals
-    for (float stack = 0; stack < stack_count; ++stack) {
-        for (float slice = 0; slice < slice_count; ++slice) {
-            float x = std::sin(2.0f * (float) M_PI * slice / slice_count);
-            float y = std::cos(2.0f * (float) M_PI * slice / slice_count);
-            float z = stack / (stack_count - 1.0f);
-
-            this->cylinder_vertices.push_back(glm::vec3(x, y, z));
-
-            glm::vec3 normal = glm::normalize(glm::vec3(x, y, 0));
-
-            this->cylinder_normals.push_back(normal);
+StructureRenderer::MeshLevel StructureRenderer::generate_bond_coordinates(unsigned int slice_count) {
+    const unsigned int offset = this->bond_vertices.size();
+
+    // the facets are closest to the axis halfway between two slices
+    MeshLevel level;
+    level.first = this->bond_indices.size();
+    level.count = 12 * slice_count;
+    level.error = 1.0f - std::cos((float) M_PI / slice_count);
+
+    // construct vertices and normals; each half has a lower and upper ring
+    for (unsigned int half = 0; half < 2; ++half) {
+        for (unsigned int ring = 0; ring < 2; ++ring) {
+            for (float slice = 0; slice < slice_count; ++slice) {
+                float x = std::sin(2.0f * (float) M_PI * slice / slice_count);
+                float y = std::cos(2.0f * (float) M_PI * slice / slice_count);
+                float z = 0.5f * (float)(half + ring);
+
+                this->bond_vertices.push_back(glm::vec4(x, y, z, (float)half));
+                this->bond_normals.push_back(glm::normalize(glm::vec3(x, y, 0)));
+            }
         }
     }
 
     // construct indices
-    for (unsigned int stack = 0; stack < stack_count - 1; ++stack) {
+    for (unsigned int half = 0; half < 2; ++half) {
+        const unsigned int lower = offset + 2 * half * slice_count;
+        const unsigned int upper = lower + slice_count;
         for (unsigned int slice = 0; slice < slice_count; ++slice) {
-            // point 1
-            this->cylinder_indices.push_back(stack * slice_count + slice);
+            const unsigned int next = (slice + 1) % slice_count;
 
-            // point 4
-            this->cylinder_indices.push_back((stack + 1) * slice_count + slice);
+            // point 1, 4 and 3
+            this->bond_indices.push_back(lower + slice);
+            this->bond_indices.push_back(upper + slice);
+            this->bond_indices.push_back(upper + next);
 
-            // point 3
-            if (slice + 1 == slice_count) {
-                this->cylinder_indices.push_back((stack + 1) * slice_count);
-            } else {
-                this->cylinder_indices.push_back((stack + 1) * slice_count + slice + 1);
-            }
+            // point 1, 3 and 2
+            this->bond_indices.push_back(lower + slice);
+            this->bond_indices.push_back(upper + next);
+            this->bond_indices.push_back(lower + next);
+        }
+    }
 
-            // point 1
-            this->cylinder_indices.push_back(stack * slice_count + slice);
+    return level;
+}
 
-            // point 3
-            if (slice + 1 == slice_count) {
-                this->cylinder_indices.push_back((stack + 1) * slice_count);
-            } else {
-                this->cylinder_indices.push_back((stack + 1) * slice_count + slice + 1);
-            }
+    /**
+     * @brief      Generate the proxy geometry of the atom and bond impostors
+     *
+     * Atoms use a quad of unit half-width that the vertex shader turns
+     * towards the viewer. Bonds use a box around each half of the bond mesh
+     * (see generate_bond_coordinates); only the front faces are rasterized.
+     */
+void StructureRenderer::generate_impostor_coordinates() {
+    this->impostor_quad_vertices = {
+        glm::vec2(-1.0f, -1.0f),
+        glm::vec2( 1.0f, -1.0f),
+        glm::vec2( 1.0f,  1.0f),
+        glm::vec2(-1.0f,  1.0f)
+    };
+    this->impostor_quad_indices = {0, 1, 2, 0, 2, 3};
+
+    // corner i + 2j + 4k of a box lies at (2i-1, 2j-1, k); the faces are
+    // wound counter-clockwise when seen from the outside
+    static const unsigned int box_indices[36] = {
+        4, 6, 2, 4, 2, 0,   // -x
+        1, 3, 7, 1, 7, 5,   // +x
+        0, 1, 5, 0, 5, 4,   // -y
+        6, 7, 3, 6, 3, 2,   // +y
+        2, 3, 1, 2, 1, 0,   // -z
+        4, 5, 7, 4, 7, 6    // +z
+    };
+
+    this->impostor_box_vertices.clear();
+    this->impostor_box_indices.clear();
+    for (unsigned int half = 0; half < 2; ++half) {
+        for (unsigned int corner = 0; corner < 8; ++corner) {
+            float x = (corner & 1) ? 1.0f : -1.0f;
+            float y = (corner & 2) ? 1.0f : -1.0f;
+            float z = 0.5f * (float)(half + ((corner & 4) ? 1 : 0));
+            this->impostor_box_vertices.push_back(glm::vec4(x, y, z, (float)half));
+        }
 
-            // point 2
-            if (slice + 1 == slice_count) {
-                this->cylinder_indices.push_back(stack * slice_count);
-            } else {
-                this->cylinder_indices.push_back(stack * slice_count + slice + 1);
-            }
+        for (unsigned int i = 0; i < 36; ++i) {
+            this->impostor_box_indices.push_back(8 * half + box_indices[i]);
         }
     }
 }
@@ -865,7 +1604,7 @@ void StructureRenderer::set_unitcell_vertices(const MatrixUnitcell& unitcell) {
      * @brief      Load all data to a vertex array object
      */
 void StructureRenderer::load_sphere_to_vao() {
-    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
 
     this->vao_sphere.create();
     this->vao_sphere.bind();
@@ -884,6 +1623,15 @@ void StructureRenderer::load_sphere_to_vao() {
     f->glEnableVertexAttribArray(1);
     f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
+    // per-instance data, filled by update_atom_batches()
+    this->vbo_atom_instances.create();
+    this->vbo_atom_instances.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    for(unsigned int i=2; i<5; i++) {
+        f->glEnableVertexAttribArray(i);
+        f->glVertexAttribDivisor(i, 1);
+    }
+    this->set_atom_instance_attributes(f, this->vbo_atom_instances, 0);
+
     this->vbo_sphere[2] = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
     this->vbo_sphere[2].create();
     this->vbo_sphere[2].setUsagePattern(QOpenGLBuffer::StaticDraw);
@@ -896,33 +1644,150 @@ void StructureRenderer::load_sphere_to_vao() {
     /**
      * @brief      Load all data to a vertex array object
      */
-void StructureRenderer::load_cylinder_to_vao() {
-    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+void StructureRenderer::load_bond_to_vao() {
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
 
-    this->vao_cylinder.create();
-    this->vao_cylinder.bind();
+    this->vao_bond.create();
+    this->vao_bond.bind();
 
-    this->vbo_cylinder[0].create();
-    this->vbo_cylinder[0].setUsagePattern(QOpenGLBuffer::StaticDraw);
-    this->vbo_cylinder[0].bind();
-    this->vbo_cylinder[0].allocate(&this->cylinder_vertices[0][0], this->cylinder_vertices.size() * 3 * sizeof(float));
+    this->vbo_bond[0].create();
+    this->vbo_bond[0].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_bond[0].bind();
+    this->vbo_bond[0].allocate(&this->bond_vertices[0][0], this->bond_vertices.size() * 4 * sizeof(float));
     f->glEnableVertexAttribArray(0);
-    f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    f->glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
-    this->vbo_cylinder[1].create();
-    this->vbo_cylinder[1].setUsagePattern(QOpenGLBuffer::StaticDraw);
-    this->vbo_cylinder[1].bind();
-    this->vbo_cylinder[1].allocate(&this->cylinder_normals[0][0], this->cylinder_normals.size() * 3 * sizeof(float));
+    this->vbo_bond[1].create();
+    this->vbo_bond[1].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_bond[1].bind();
+    this->vbo_bond[1].allocate(&this->bond_normals[0][0], this->bond_normals.size() * 3 * sizeof(float));
     f->glEnableVertexAttribArray(1);
     f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    this->vbo_cylinder[2] = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-    this->vbo_cylinder[2].create();
-    this->vbo_cylinder[2].setUsagePattern(QOpenGLBuffer::StaticDraw);
-    this->vbo_cylinder[2].bind();
-    this->vbo_cylinder[2].allocate(&this->cylinder_indices[0], this->cylinder_indices.size() * sizeof(unsigned int));
+    // per-instance data, filled by update_bond_batches()
+    this->vbo_bond_instances.create();
+    this->vbo_bond_instances.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    for(unsigned int i=2; i<6; i++) {
+        f->glEnableVertexAttribArray(i);
+        f->glVertexAttribDivisor(i, 1);
+    }
+    this->set_bond_instance_attributes(f, 0);
 
-    this->vao_sphere.release();
+    this->vbo_bond[2] = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    this->vbo_bond[2].create();
+    this->vbo_bond[2].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_bond[2].bind();
+    this->vbo_bond[2].allocate(&this->bond_indices[0], this->bond_indices.size() * sizeof(unsigned int));
+
+    this->vao_bond.release();
+}
+
+    /**
+     * @brief      Load the impostor proxies to vertex array objects
+     *
+     * The instance attributes refer to the instance buffers of the sphere
+     * and bond meshes, hence these have to be loaded first.
+     */
+void StructureRenderer::load_impostors_to_vao() {
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+
+    // atoms
+    this->vao_atom_impostor.create();
+    this->vao_atom_impostor.bind();
+
+    this->vbo_atom_impostor[0].create();
+    this->vbo_atom_impostor[0].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_atom_impostor[0].bind();
+    this->vbo_atom_impostor[0].allocate(&this->impostor_quad_vertices[0][0], this->impostor_quad_vertices.size() * 2 * sizeof(float));
+    f->glEnableVertexAttribArray(0);
+    f->glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    for(unsigned int i=2; i<5; i++) {
+        f->glEnableVertexAttribArray(i);
+        f->glVertexAttribDivisor(i, 1);
+    }
+    this->set_atom_instance_attributes(f, this->vbo_atom_instances, 0);
+
+    this->vbo_atom_impostor[1] = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    this->vbo_atom_impostor[1].create();
+    this->vbo_atom_impostor[1].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_atom_impostor[1].bind();
+    this->vbo_atom_impostor[1].allocate(&this->impostor_quad_indices[0], this->impostor_quad_indices.size() * sizeof(unsigned int));
+
+    this->vao_atom_impostor.release();
+
+    // bonds
+    this->vao_bond_impostor.create();
+    this->vao_bond_impostor.bind();
+
+    this->vbo_bond_impostor[0].create();
+    this->vbo_bond_impostor[0].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_bond_impostor[0].bind();
+    this->vbo_bond_impostor[0].allocate(&this->impostor_box_vertices[0][0], this->impostor_box_vertices.size() * 4 * sizeof(float));
+    f->glEnableVertexAttribArray(0);
+    f->glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+
+    for(unsigned int i=2; i<6; i++) {
+        f->glEnableVertexAttribArray(i);
+        f->glVertexAttribDivisor(i, 1);
+    }
+    this->set_bond_instance_attributes(f, 0);
+
+    this->vbo_bond_impostor[1] = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    this->vbo_bond_impostor[1].create();
+    this->vbo_bond_impostor[1].setUsagePattern(QOpenGLBuffer::StaticDraw);
+    this->vbo_bond_impostor[1].bind();
+    this->vbo_bond_impostor[1].allocate(&this->impostor_box_indices[0], this->impostor_box_indices.size() * sizeof(unsigned int));
+
+    this->vao_bond_impostor.release();
+}
+
+    /**
+     * @brief      Load the colors and radii of the elements to a texture
+     */
+void StructureRenderer::load_element_texture() {
+    std::vector<float> data(4 * AtomSettings::MAX_ELEMENTS);
+    for(unsigned int i=0; i<AtomSettings::MAX_ELEMENTS; i++) {
+        const QVector3D& col = AtomSettings::get().get_atom_color_from_elnr(i);
+        data[4*i]   = col[0];
+        data[4*i+1] = col[1];
+        data[4*i+2] = col[2];
+        data[4*i+3] = AtomSettings::get().get_atom_radius_from_elnr(i);
+    }
+
+    this->element_radii.resize(AtomSettings::MAX_ELEMENTS);
+    for(unsigned int i=0; i<AtomSettings::MAX_ELEMENTS; i++) {
+        this->element_radii[i] = data[4*i+3];
+    }
+
+    this->texture_elements = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target1D);
+    this->texture_elements->setFormat(QOpenGLTexture::RGBA32F);
+    this->texture_elements->setSize(AtomSettings::MAX_ELEMENTS);
+    this->texture_elements->setMipLevels(1);
+    this->texture_elements->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    this->texture_elements->setWrapMode(QOpenGLTexture::ClampToEdge);
+    this->texture_elements->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
+    this->texture_elements->setData(QOpenGLTexture::RGBA, QOpenGLTexture::Float32, data.data());
+}
+
+    /**
+     * @brief      Create the buffer textures of the playback window
+     *
+     * The buffers are allocated once the first frames are uploaded.
+     */
+void StructureRenderer::load_frame_textures() {
+    this->vbo_frame_atoms.create();
+    this->vbo_frame_atoms.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    this->vbo_frame_bonds.create();
+    this->vbo_frame_bonds.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+
+    this->vbo_frame_instances.create();
+    this->vbo_frame_instances.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+    this->texture_frame_atoms = std::make_unique<QOpenGLTexture>(QOpenGLTexture::TargetBuffer);
+    this->texture_frame_atoms->create();
+    this->texture_frame_bonds = std::make_unique<QOpenGLTexture>(QOpenGLTexture::TargetBuffer);
+    this->texture_frame_bonds->create();
 }
 
     /**
@@ -992,40 +1857,3 @@ void StructureRenderer::load_arrow_model() {
     this->axis_model = modelloader.load_model(path.toStdString());
     this->axis_model->load_to_vao();
 }
-
-    /**
-     * @brief      Darken color
-     *
-     * @param[in]  color   The color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
-     */
-QVector3D StructureRenderer::darken(const QVector3D& color, float amount) const {
-    return amount * QVector3D(0.0, 0.0, 0.0) + (1.0 - amount) * color;
-}
-
-    /**
-     * @brief      Lighten color
-     *
-     * @param[in]  color   The color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
-     */
-QVector3D StructureRenderer::lighten(const QVector3D& color, float amount) const {
-    return amount * QVector3D(1.0, 1.0, 1.0) + (1.0 - amount) * color;
-}
-
-    /**
-     * @brief      Mix colors
-     *
-     * @param[in]  color1  First color
-     * @param[in]  color2  Second color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
-     */
-QVector3D StructureRenderer::mix(const QVector3D& color1, const QVector3D& color2, float amount) const {
-    return (1.0 - amount) * color1 + amount * color2;
-}
@@ -21,8 +21,10 @@
 #pragma once
 
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
+#include <QOpenGLTexture>
 #include <QDebug>
 #include <QMatrix4x4>
 #include <QtMath>
@@ -36,8 +38,15 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/norm.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "../data/bounding_volume_hierarchy.h"
 #include "../data/model_loader.h"
 #include "../data/structure.h"
 #include "shader_program_manager.h"
@@ -47,26 +56,144 @@
  * @brief StructureRenderer class.
  */
 class StructureRenderer {
+public:
+    // range of the detail setting; a higher detail halves the tolerated
+    // deviation (in pixels) between the meshes and the true surfaces
+    static constexpr int DETAIL_MIN = 1;
+    static constexpr int DETAIL_MAX = 5;
+    static constexpr int DETAIL_DEFAULT = 3;
+
 private:
-    // sphere facets
+    static constexpr unsigned int NR_LOD_LEVELS = 4;    // number of levels of detail of the meshes
+    static constexpr float BOND_RADIUS = BondInstances::BOND_RADIUS;   // radius of the bonds
+    static constexpr unsigned int FRAME_WINDOW_SIZE = 16;  // number of frames kept on the GPU during playback
+
+    /**
+     * @brief      Level of detail of a mesh, stored as a range of its index buffer
+     */
+    struct MeshLevel {
+        unsigned int first = 0;     // first index
+        unsigned int count = 0;     // number of indices
+        float error = 0.0f;         // largest deviation of the facets from the unit surface
+    };
+
+    /**
+     * @brief      Range of the instance buffer drawn at a single level of detail
+     */
+    struct InstanceBatch {
+        unsigned int first = 0;     // first instance
+        unsigned int count = 0;     // number of instances
+        unsigned int central = 0;   // number of leading instances in the central unit cell
+    };
+
+    /**
+     * @brief      Frame of the playback window
+     */
+    struct FrameSlot {
+        std::shared_ptr<const AtomInstances> atoms;     // null if the slot is free
+        std::shared_ptr<const BondInstances> bonds;
+    };
+
+    /**
+     * @brief      View for which the instances were distributed over the levels of detail
+     */
+    struct BatchView {
+        QMatrix4x4 modelview;
+        QMatrix4x4 projection;
+        int height = 0;             // height of the canvas in pixels
+        int detail = 0;             // detail setting
+        bool impostors = false;     // whether impostors were drawn
+
+        inline bool operator==(const BatchView& other) const {
+            return this->modelview == other.modelview && this->projection == other.projection &&
+                   this->height == other.height && this->detail == other.detail &&
+                   this->impostors == other.impostors;
+        }
+    };
+
+    // sphere facets, the levels of detail are stored consecutively
     std::vector<glm::vec3> sphere_vertices;
     std::vector<glm::vec3> sphere_normals;
     std::vector<unsigned int> sphere_indices;
+    std::array<MeshLevel, NR_LOD_LEVELS> sphere_levels;
 
-    // cylinder facets
-    std::vector<glm::vec3> cylinder_vertices;
-    std::vector<glm::vec3> cylinder_normals;
-    std::vector<unsigned int> cylinder_indices;
+    // bond facets: two unit cylinders, the w coordinate holds the half of the bond
+    std::vector<glm::vec4> bond_vertices;
+    std::vector<glm::vec3> bond_normals;
+    std::vector<unsigned int> bond_indices;
+    std::array<MeshLevel, NR_LOD_LEVELS> bond_levels;
 
     // vao and vbo for rendering
     QOpenGLVertexArrayObject vao_sphere;
     QOpenGLBuffer vbo_sphere[3];
 
-    QOpenGLVertexArrayObject vao_cylinder;
-    QOpenGLBuffer vbo_cylinder[3];
+    // atoms drawn as instances of the sphere; the instances are taken from
+    // the structure (which builds these ahead for prefetched frames), and
+    // are culled and sorted over the levels of detail when the view changes
+    std::shared_ptr<const AtomInstances> atom_instances;    // atoms in the central unit cell
+    std::vector<std::pair<unsigned int, QVector3D>> atom_images;        // shown periodic images and their translations
+    std::unordered_map<unsigned int, unsigned int> atom_image_selection;  // selection state of the selected atoms in the images
+    QOpenGLBuffer vbo_atom_instances;                   // visible instances sorted by level of detail
+    std::array<InstanceBatch, NR_LOD_LEVELS> atom_batches;
+    BatchView atom_batches_view;                        // view for which vbo_atom_instances was sorted
+    bool atom_batches_valid = false;                    // whether vbo_atom_instances follows atom_instances
+    std::unique_ptr<QOpenGLTexture> texture_elements;   // color (rgb) and radius (alpha) per element
+    std::vector<float> element_radii;                   // radius per element
+    bool atom_instances_xy = false;                     // whether the images include the xy expansion
+    bool atom_instances_z = false;                      // whether the images include the z expansion
+    unsigned int nr_central_instances = 0;              // number of instances in the central unit cell
+
+    // bonds drawn as instances of the bond mesh; the instances are taken
+    // from the structure like those of the atoms
+    QOpenGLVertexArrayObject vao_bond;
+    QOpenGLBuffer vbo_bond[3];
+    std::shared_ptr<const BondInstances> bond_instances;
+    QOpenGLBuffer vbo_bond_instances;                   // visible instances sorted by level of detail
+    std::array<InstanceBatch, NR_LOD_LEVELS> bond_batches;
+    BatchView bond_batches_view;                        // view for which vbo_bond_instances was sorted
+    bool bond_batches_valid = false;                    // whether vbo_bond_instances follows bond_instances
+    unsigned int nr_bond_instances = 0;                 // number of instances
+
+    // playback: the atom and bond instances of the frames ahead are kept in
+    // buffer textures, one slot per frame, such that showing a frame only
+    // selects its slot in the vertex shaders; the instances are drawn from
+    // a fixed layout at a single level of detail, without culling
+    std::vector<FrameSlot> playback_frames;             // frames to keep in the window, empty if not playing
+    bool playback_frames_changed = false;               // whether the window has to follow playback_frames
+    std::array<FrameSlot, FRAME_WINDOW_SIZE> frame_slots;
+    std::shared_ptr<const AtomInstances> frame_layout;  // frame whose elements and flags all slots share
+    QOpenGLBuffer vbo_frame_atoms;                      // atom instances per slot (see AtomInstance)
+    QOpenGLBuffer vbo_frame_bonds;                      // bond instances per slot (see BondInstance)
+    std::unique_ptr<QOpenGLTexture> texture_frame_atoms;    // vbo_frame_atoms as buffer texture
+    std::unique_ptr<QOpenGLTexture> texture_frame_bonds;    // vbo_frame_bonds as buffer texture
+    unsigned int frame_atom_capacity = 0;               // atoms per slot
+    unsigned int frame_bond_capacity = 0;               // bonds per slot
+    QOpenGLBuffer vbo_frame_instances;                  // central atoms followed by their shown periodic images
+    std::shared_ptr<const AtomInstances> frame_instances_layout;    // frame_layout when vbo_frame_instances was filled
+    std::unordered_map<unsigned int, unsigned int> frame_instances_selection;  // atom_image_selection idem
+    bool frame_instances_xy = false;                    // whether vbo_frame_instances includes the xy expansion
+    bool frame_instances_z = false;                     // whether vbo_frame_instances includes the z expansion
+    unsigned int nr_frame_instances = 0;                // number of instances in vbo_frame_instances
+    BatchView frame_levels_view;                        // view for which the levels below were selected
+    bool frame_levels_valid = false;                    // whether the levels follow frame_layout
+    unsigned int frame_atom_level = 0;                  // level of detail of the atoms during playback
+    unsigned int frame_bond_level = 0;                  // level of detail of the bonds during playback
+
+    // impostors: atoms are drawn as screen-aligned quads and bonds as boxes
+    // around both halves, the surfaces are ray-cast in the fragment shader;
+    // these share the instance buffers with the meshes above
+    std::vector<glm::vec2> impostor_quad_vertices;
+    std::vector<unsigned int> impostor_quad_indices;
+    std::vector<glm::vec4> impostor_box_vertices;       // w coordinate holds the half of the bond
+    std::vector<unsigned int> impostor_box_indices;
+    QOpenGLVertexArrayObject vao_atom_impostor;
+    QOpenGLBuffer vbo_atom_impostor[2];
+    QOpenGLVertexArrayObject vao_bond_impostor;
+    QOpenGLBuffer vbo_bond_impostor[2];
 
     QOpenGLVertexArrayObject vao_unitcell;
     QOpenGLBuffer vbo_unitcell[2];
+    uint64_t unitcell_generation = 0;   // cell generation of the structure in vbo_unitcell
 
     QOpenGLVertexArrayObject vao_line;
     QOpenGLBuffer vbo_line[2];
@@ -84,6 +211,8 @@ private:
     std::shared_ptr<Model> axis_model;
 
     bool flag_draw_unitcell = true;     // whether to draw the unitcell
+    bool flag_impostors = false;        // whether to draw atoms and bonds as ray-cast impostors
+    int detail = DETAIL_DEFAULT;        // level of detail setting
 
 public:
     /**
@@ -124,40 +253,80 @@ public:
         this->flag_draw_unitcell = false;
     }
 
+    /**
+     * @brief      Set whether atoms and bonds are drawn as ray-cast impostors
+     *
+     * @param[in]  impostors  Whether to use impostors rather than meshes
+     */
+    inline void set_impostors(bool impostors) {
+        this->flag_impostors = impostors;
+    }
+
+    /**
+     * @brief      Set the level of detail of the meshes
+     *
+     * @param[in]  _detail  The detail, between DETAIL_MIN and DETAIL_MAX
+     */
+    inline void set_detail(int _detail) {
+        this->detail = std::clamp(_detail, DETAIL_MIN, DETAIL_MAX);
+    }
+
+    /**
+     * @brief      Set the frames to keep on the GPU during playback
+     *
+     * @param[in]  frames  The frames, empty when playback stops
+     */
+    void set_playback_frames(const std::vector<std::shared_ptr<const Structure>>& frames);
+
 private:
     /**
-     * @brief      Draws atoms.
+     * @brief      Draws the atoms in the unit cell and the periodicity expansions.
      *
-     * @param[in]  atoms           The atoms
      * @param[in]  structure       The structure
      * @param[in]  periodicity_xy  The periodicity xy
      * @param[in]  periodicity_z   The periodicity z
      */
-    void draw_atoms(const std::vector<Atom>& atoms, const Structure* structure, bool periodicity_xy = false, bool periodicity_z = false);
+    void draw_atoms(const Structure* structure, bool periodicity_xy = false, bool periodicity_z = false);
 
     /**
-     * @brief      Draws silhouette of atoms.
+     * @brief      Draws silhouette of the atoms in the unit cell.
      *
-     * @param[in]  atoms           The atoms
      * @param[in]  structure       The structure
      */
-    void draw_atoms_silhouette(const std::vector<Atom>& atoms, const Structure* structure);
+    void draw_atoms_silhouette(const Structure* structure);
 
     /**
-     * @brief      Draws atoms in the regular unit cell.
+     * @brief      Draws silhouette of the atoms in the unit cell as impostors.
      *
-     * @param[in]  structure  The structure
+     * @param[in]  structure       The structure
      */
-    void draw_atoms_regular(const Structure* structure);
+    void draw_atoms_silhouette_impostors(const Structure* structure);
 
     /**
-     * @brief      Draws the atoms in the periodicity expansions.
+     * @brief      Adopt the atom instances of the structure if these have changed
      *
      * @param[in]  structure       The structure
-     * @param[in]  periodicity_xy  The periodicity xy
-     * @param[in]  periodicity_z   The periodicity z
+     * @param[in]  periodicity_xy  Whether to include the xy expansion
+     * @param[in]  periodicity_z   Whether to include the z expansion
+     */
+    void update_atom_instances(const Structure* structure, bool periodicity_xy, bool periodicity_z);
+
+    /**
+     * @brief      Collect the visible atom instances and sort these over the
+     *             levels of detail if the view has changed
+     *
+     * @param[in]  modelview  The model and view matrix
      */
-    void draw_atoms_expansion(const Structure* structure, bool periodicity_xy, bool periodicity_z);
+    void update_atom_batches(const QMatrix4x4& modelview);
+
+    /**
+     * @brief      Point the instance attributes of the bound vertex array object to atom instances
+     *
+     * @param      f      OpenGL functions
+     * @param      vbo    The instance buffer
+     * @param[in]  first  First instance
+     */
+    void set_atom_instance_attributes(QOpenGLExtraFunctions* f, QOpenGLBuffer& vbo, unsigned int first);
 
     /**
      * @brief      Draws bonds.
@@ -166,6 +335,100 @@ private:
      */
     void draw_bonds(const Structure* structure);
 
+    /**
+     * @brief      Adopt the bond instances of the structure if these have changed
+     *
+     * @param[in]  structure  The structure
+     */
+    void update_bond_instances(const Structure* structure);
+
+    /**
+     * @brief      Collect the visible bond instances and sort these over the
+     *             levels of detail if the view has changed
+     *
+     * @param[in]  modelview  The model and view matrix
+     */
+    void update_bond_batches(const QMatrix4x4& modelview);
+
+    /**
+     * @brief      Point the instance attributes of the bound vertex array object to bond instances
+     *
+     * @param      f      OpenGL functions
+     * @param[in]  first  First instance
+     */
+    void set_bond_instance_attributes(QOpenGLExtraFunctions* f, unsigned int first);
+
+    /**
+     * @brief      Upload the frames to keep during playback to the free slots
+     */
+    void update_frame_window();
+
+    /**
+     * @brief      Write the instances of a frame to a slot of the playback window
+     *
+     * @param[in]  slot   The slot
+     * @param[in]  frame  The frame
+     */
+    void write_frame_slot(unsigned int slot, const FrameSlot& frame);
+
+    /**
+     * @brief      Get the slot of the playback window holding the shown atoms
+     *
+     * @return     The slot, -1 if the atoms are drawn from vbo_atom_instances.
+     */
+    int get_frame_slot() const;
+
+    /**
+     * @brief      Fill the instances drawn from the playback window if the
+     *             shown periodic images have changed
+     */
+    void update_frame_instances();
+
+    /**
+     * @brief      Select the levels of detail drawn during playback if the view has changed
+     *
+     * @param[in]  modelview  The model and view matrix
+     */
+    void update_frame_levels(const QMatrix4x4& modelview);
+
+    /**
+     * @brief      Get the atom instances to draw and their distribution over the levels of detail
+     *
+     * @param[in]  modelview  The model and view matrix
+     * @param[in]  slot       Slot of the playback window holding the atoms, -1 if none
+     * @param[out] batches    The batches
+     *
+     * @return     The instance buffer.
+     */
+    QOpenGLBuffer& select_atom_batches(const QMatrix4x4& modelview, int slot, std::array<InstanceBatch, NR_LOD_LEVELS>& batches);
+
+    /**
+     * @brief      Set the uniforms selecting the shown frame in the playback window
+     *
+     * @param      shader     The atom or silhouette shader
+     * @param[in]  structure  The structure
+     * @param[in]  slot       The slot, -1 if not playing
+     */
+    void set_frame_uniforms(ShaderProgram* shader, const Structure* structure, int slot) const;
+
+    /**
+     * @brief      Get the pixel tolerance for the deviation of the meshes
+     *
+     * @return     The tolerance.
+     */
+    float get_lod_tolerance() const;
+
+    /**
+     * @brief      Select the coarsest level of detail within the tolerance
+     *
+     * @param[in]  levels     The levels of detail of the mesh
+     * @param[in]  radius     Radius of the object on screen (in pixels)
+     * @param[in]  tolerance  Tolerated deviation (in pixels)
+     *
+     * @return     The level.
+     */
+    static unsigned int select_lod(const std::array<MeshLevel, NR_LOD_LEVELS>& levels, float radius, float tolerance);
+
     /**
      * @brief      Draws the unitcell.
      *
@@ -188,19 +451,28 @@ private:
     void draw_movement_plane(const Structure* structure);
 
     /**
-     * @brief      Generate coordinates of a sphere
+     * @brief      Generate coordinates of a sphere and append these to the sphere facets
      *
      * @param[in]  tesselation_level  The tesselation level
+     *
+     * @return     The range of the sphere in the index buffer.
      */
-    void generate_sphere_coordinates(unsigned int tesselation_level);
+    MeshLevel generate_sphere_coordinates(unsigned int tesselation_level);
 
     /**
-     * @brief      Generate coordinates for a default cylinder (radius 1, height 1)
+     * @brief      Generate coordinates for a bond (radius 1, height 1) and append
+     *             these to the bond facets
      *
-     * @param[in]  stack_count  The stack count
      * @param[in]  slice_count  The slice count
+     *
+     * @return     The range of the bond in the index buffer.
      */
-    void generate_cylinder_coordinates(unsigned int stack_count, unsigned int slice_count);
+    MeshLevel generate_bond_coordinates(unsigned int slice_count);
+
+    /**
+     * @brief      Generate the proxy geometry of the atom and bond impostors
+     */
+    void generate_impostor_coordinates();
 
     /**
      * @brief      Generate the coordinates of the unitcell
@@ -222,51 +494,35 @@ private:
     /**
      * @brief      Load all data to a vertex array object
      */
-    void load_cylinder_to_vao();
+    void load_bond_to_vao();
 
     /**
-     * @brief      Load simple line data to vertex array object
+     * @brief      Load the impostor proxies to vertex array objects
      */
-    void load_line_to_vao();
+    void load_impostors_to_vao();
 
     /**
-     * @brief      Load simple plane data to vertex array object
+     * @brief      Load the colors and radii of the elements to a texture
      */
-    void load_plane_to_vao();
+    void load_element_texture();
 
     /**
-     * @brief      Loads an arrow model.
+     * @brief      Create the buffer textures of the playback window
      */
-    void load_arrow_model();
+    void load_frame_textures();
 
     /**
-     * @brief      Darken color
-     *
-     * @param[in]  color   The color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
+     * @brief      Load simple line data to vertex array object
      */
-    QVector3D darken(const QVector3D& color, float amount) const;
+    void load_line_to_vao();
 
     /**
-     * @brief      Lighten color
-     *
-     * @param[in]  color   The color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
+     * @brief      Load simple plane data to vertex array object
      */
-    QVector3D lighten(const QVector3D& color, float amount) const;
+    void load_plane_to_vao();
 
     /**
-     * @brief      Mix colors
-     *
-     * @param[in]  color1  First color
-     * @param[in]  color2  Second color
-     * @param[in]  amount  The amount
-     *
-     * @return     The 3D vector.
+     * @brief      Loads an arrow model.
      */
-    QVector3D mix(const QVector3D& color1, const QVector3D& color2, float amount) const;
+    void load_arrow_model();
 };
@@ -24,6 +24,7 @@
 #include <QStringList>
 #include <QDebug>
 #include <QCommandLineParser>
+#include <QSettings>
 
 #include <iostream>
 #include <iomanip>
@@ -32,6 +33,9 @@
 
 #include "atomarchitectapplication.h"
 #include "gui/mainwindow.h"
+#include "data/parallel.h"
+#include "data/structure_cache.h"
+#include "data/trajectory.h"
 #include "config.h"
 
 std::shared_ptr<QStringList> log_messages;
@@ -103,6 +107,9 @@ int main(int argc, char *argv[]) {
     QCommandLineOption openFile("o", "Open structure file", "file");
     parser.addOption(openFile);
 
+    QCommandLineOption noCache("no-cache", "Bypass the cache of parsed structure files");
+    parser.addOption(noCache);
+
     AtomArchitectApplication app(argc, argv);
     qRegisterMetaType<std::vector<uint8_t>>("stdvector_uint8_t");
 
@@ -112,9 +119,18 @@ int main(int argc, char *argv[]) {
     // parse command line arguments
     parser.process(app);
 
+    // cache of parsed structure files
+    QSettings settings;
+    StructureCache::get().set_enabled(settings.value("cache/enabled", true).toBool() && !parser.isSet(noCache));
+    StructureCache::get().set_size_limit((uint64_t)settings.value("cache/sizeLimitMB", 2048).toUInt() * 1024 * 1024);
+
+    // memory used for decoded frames of trajectories
+    Trajectory::set_default_cache_limit((size_t)settings.value("analysis/frameCacheMB", 512).toUInt() * 1024 * 1024);
+
     try {
         // build main window
         qInstallMessageHandler(message_output);
+        qDebug() << "Structure kernels use" << Parallel::get_nr_threads() << "thread(s)";
         mainWindow = std::make_unique<MainWindow>(log_messages);
         mainWindow->setWindowTitle(QString(PROGRAM_NAME) + " " + QString(PROGRAM_VERSION));
         mainWindow->set_cli_parser(parser);
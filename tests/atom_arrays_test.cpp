@@ -0,0 +1,151 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+
+// Compares the kernels of AtomArrays (vectorized and distributed over
+// threads where available) with straightforward loops over the atoms
+
+#include <cmath>
+#include <random>
+
+#include "atom_arrays.h"
+#include "check.h"
+
+namespace {
+
+/**
+ * @brief      Test the kernels on a set of random atoms
+ *
+ * @param[in]  n     Number of atoms; sizes that are not a multiple of the
+ *                   vector width exercise the remainder loops
+ * @param      rng   Random number generator
+ */
+void test_kernels(unsigned int n, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coord(-20.0, 20.0);
+
+    std::vector<Atom> atoms;
+    for(unsigned int i=0; i<n; i++) {
+        atoms.emplace_back(1 + i % 20, coord(rng), coord(rng), coord(rng));
+        atoms.back().atomtype = i % 8;
+    }
+
+    // coinciding atoms test the tie breaking
+    if(n > 5) {
+        atoms[5] = atoms[2];
+    }
+
+    AtomArrays arrays;
+    arrays.assign(atoms);
+    CHECK(arrays.size() == n);
+
+    // furthest atom, lowest index on ties
+    size_t furthest = 0;
+    float furthest_distance = -1.0f;
+    for(unsigned int i=0; i<n; i++) {
+        const QVector3D p = arrays.get_position(i);
+        const float d = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+        if(d > furthest_distance) {
+            furthest_distance = d;
+            furthest = i;
+        }
+    }
+    CHECK(arrays.find_furthest_from_origin() == furthest);
+
+    // squared distances
+    const QVector3D point((float)coord(rng), (float)coord(rng), (float)coord(rng));
+    std::vector<float> distances;
+    arrays.get_distances2(point, distances);
+    CHECK(distances.size() == n);
+    for(unsigned int i=0; i<distances.size(); i++) {
+        const float expected = (arrays.get_position(i) - point).lengthSquared();
+        CHECK(std::fabs(distances[i] - expected) <= 1e-4f * (1.0f + expected));
+    }
+
+    // ray casting, with and without a visibility table
+    std::array<bool, 8> visible;
+    for(unsigned int k=0; k<visible.size(); k++) {
+        visible[k] = k % 3 != 0;
+    }
+    const QVector3D depth_axis(0.3f, 0.9f, 0.1f);
+    const float depth_offset = 0.5f;
+    const std::array<const std::array<bool, 8>*, 2> tables = {nullptr, &visible};
+    for(unsigned int ray=0; ray<200; ray++) {
+        const QVector3D origin((float)coord(rng), (float)coord(rng), -50.0f);
+        const QVector3D direction = QVector3D((float)coord(rng) * 0.01f, (float)coord(rng) * 0.01f, 1.0f).normalized();
+
+        for(const std::array<bool, 8>* table : tables) {
+            int expected = -1;
+            float expected_depth = 1000.0f;
+            for(unsigned int i=0; i<n; i++) {
+                if(table && !(*table)[arrays.get_flags(i) & ATOM_FLAG_TYPE_MASK]) {
+                    continue;
+                }
+
+                const QVector3D p = arrays.get_position(i);
+                const QVector3D q = origin - p;
+                const float b = QVector3D::dotProduct(direction, q);
+                const float c = QVector3D::dotProduct(q, q) - arrays.get_radius(i) * arrays.get_radius(i);
+                const float depth = QVector3D::dotProduct(depth_axis, p) + depth_offset;
+                if(b * b >= c && depth < expected_depth) {
+                    expected_depth = depth;
+                    expected = (int)i;
+                }
+            }
+
+            float depth = 1000.0f;
+            CHECK(arrays.raycast(origin, direction, depth_axis, depth_offset, depth, table) == expected);
+        }
+    }
+
+    // wrapping into the unit cell keeps the positions on the same lattice
+    MatrixUnitcell unitcell;
+    unitcell << 5.0, 0.0, 0.0,
+                1.0, 6.0, 0.0,
+                0.5, 0.3, 7.0;
+    std::vector<double> px, py, pz;
+    for(const Atom& atom : atoms) {
+        px.push_back(atom.x);
+        py.push_back(atom.y);
+        pz.push_back(atom.z);
+    }
+    AtomArrays::wrap_positions(px.data(), py.data(), pz.data(), n, unitcell);
+
+    const MatrixUnitcell to_direct = unitcell.transpose().inverse();
+    for(unsigned int i=0; i<n; i++) {
+        const VectorPosition wrapped = to_direct * VectorPosition(px[i], py[i], pz[i]);
+        const VectorPosition original = to_direct * atoms[i].get_pos_eigen();
+        for(unsigned int j=0; j<3; j++) {
+            CHECK(wrapped[j] >= -1e-9 && wrapped[j] < 1.0 + 1e-9);
+            const double shift = wrapped[j] - original[j];
+            CHECK(std::fabs(shift - std::round(shift)) <= 1e-9);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(1);
+    for(unsigned int n : {0, 1, 3, 4, 5, 7, 8, 33, 1001, 4097, 9001}) {
+        test_kernels(n, rng);
+    }
+
+    return test_result();
+}
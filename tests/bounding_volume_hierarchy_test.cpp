@@ -0,0 +1,197 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+
+// Compares the frustum culling of BoundingVolumeHierarchy with testing
+// every box against the frustum planes, after building, refitting and for
+// frusta shifted over a lattice vector (as for the periodic images)
+
+#include <QVector4D>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+
+#include "bounding_volume_hierarchy.h"
+#include "check.h"
+
+namespace {
+
+typedef BoundingVolumeHierarchy::Box Box;
+
+/**
+ * @brief      Whether a box is not entirely outside any of the planes
+ *
+ * @param[in]  box      The box
+ * @param[in]  frustum  The frustum
+ *
+ * @return     True if the box is to be reported
+ */
+bool intersects(const Box& box, const BoundingVolumeHierarchy::Frustum& frustum) {
+    for(const auto& plane : frustum) {
+        float d = plane[3];
+        for(unsigned int j=0; j<3; j++) {
+            d += std::max(plane[j] * box.lo[j], plane[j] * box.hi[j]);
+        }
+        if(d < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief      Cull the boxes and compare with the brute-force test
+ *
+ * @param[in]  bvh    The hierarchy
+ * @param[in]  boxes  The boxes in the hierarchy
+ * @param[in]  mvp    Model, view and projection matrix
+ */
+void check_cull(const BoundingVolumeHierarchy& bvh, const std::vector<Box>& boxes, const QMatrix4x4& mvp) {
+    const BoundingVolumeHierarchy::Frustum frustum = BoundingVolumeHierarchy::get_frustum(mvp);
+
+    std::set<unsigned int> found;
+    unsigned int duplicates = 0;
+    bvh.cull(frustum, [&](unsigned int idx) {
+        duplicates += !found.insert(idx).second;
+    });
+    CHECK(duplicates == 0);
+
+    std::set<unsigned int> expected;
+    unsigned int missed = 0;
+    for(unsigned int i=0; i<boxes.size(); i++) {
+        if(intersects(boxes[i], frustum)) {
+            expected.insert(i);
+        }
+
+        // boxes whose center is on screen must never be culled
+        const QVector4D center(0.5f * (boxes[i].lo[0] + boxes[i].hi[0]),
+                               0.5f * (boxes[i].lo[1] + boxes[i].hi[1]),
+                               0.5f * (boxes[i].lo[2] + boxes[i].hi[2]), 1.0f);
+        const QVector4D clip = mvp * center;
+        if(std::fabs(clip.x()) <= clip.w() && std::fabs(clip.y()) <= clip.w() &&
+           std::fabs(clip.z()) <= clip.w()) {
+            missed += found.count(i) == 0;
+        }
+    }
+    CHECK(missed == 0);
+    CHECK(found == expected);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    for(unsigned int trial=0; trial<200; trial++) {
+        const unsigned int n = trial * 37 % 3000;
+        std::vector<Box> boxes(n);
+        for(Box& box : boxes) {
+            const float radius = 0.5f + 0.5f * std::fabs(unit(rng));
+            for(unsigned int j=0; j<3; j++) {
+                const float c = coord(rng);
+                box.lo[j] = c - radius;
+                box.hi[j] = c + radius;
+            }
+        }
+
+        BoundingVolumeHierarchy bvh;
+        bvh.update(boxes);
+        CHECK(bvh.get_nr_items() == n);
+
+        // camera at a random distance and orientation looking at the boxes
+        QMatrix4x4 projection;
+        projection.perspective(45.0f, 1.3f, 1.0f, 60.0f + 20.0f * unit(rng));
+        QMatrix4x4 view;
+        view.lookAt(QVector3D(0.0f, -25.0f - 10.0f * unit(rng), 0.0f), QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
+        QMatrix4x4 model;
+        model.rotate(180.0f * unit(rng), QVector3D(unit(rng), unit(rng), unit(rng)) + QVector3D(0.0f, 0.0f, 2.0f));
+        const QMatrix4x4 mvp = projection * view * model;
+
+        check_cull(bvh, boxes, mvp);
+
+        // small moves refit the hierarchy, large moves rebuild it
+        const float displacement = trial % 2 == 0 ? 0.3f : 10.0f;
+        for(Box& box : boxes) {
+            for(unsigned int j=0; j<3; j++) {
+                const float d = displacement * unit(rng);
+                box.lo[j] += d;
+                box.hi[j] += d;
+            }
+        }
+        bvh.update(boxes);
+        check_cull(bvh, boxes, mvp);
+
+        // periodic images: the frustum shifted over a lattice vector must
+        // report the same boxes as the translated boxes
+        const QVector3D translation(coord(rng), coord(rng), coord(rng));
+        QMatrix4x4 image_mvp = mvp;
+        image_mvp.translate(translation);
+
+        std::vector<Box> translated = boxes;
+        for(Box& box : translated) {
+            for(unsigned int j=0; j<3; j++) {
+                box.lo[j] += translation[j];
+                box.hi[j] += translation[j];
+            }
+        }
+        BoundingVolumeHierarchy translated_bvh;
+        translated_bvh.build(translated);
+
+        std::set<unsigned int> shifted;
+        std::set<unsigned int> moved;
+        bvh.cull(BoundingVolumeHierarchy::get_frustum(image_mvp), [&](unsigned int idx) {
+            shifted.insert(idx);
+        });
+        translated_bvh.cull(BoundingVolumeHierarchy::get_frustum(mvp), [&](unsigned int idx) {
+            moved.insert(idx);
+        });
+
+        // both are conservative; only boxes touching a plane may differ
+        for(unsigned int i=0; i<n; i++) {
+            if(shifted.count(i) != moved.count(i)) {
+                const BoundingVolumeHierarchy::Frustum frustum = BoundingVolumeHierarchy::get_frustum(mvp);
+                float closest = std::numeric_limits<float>::max();
+                for(const auto& plane : frustum) {
+                    float d = plane[3];
+                    for(unsigned int j=0; j<3; j++) {
+                        d += std::max(plane[j] * translated[i].lo[j], plane[j] * translated[i].hi[j]);
+                    }
+                    closest = std::min(closest, std::fabs(d));
+                }
+                CHECK(closest < 1e-3f);
+            }
+        }
+    }
+
+    // an empty hierarchy reports nothing
+    BoundingVolumeHierarchy empty;
+    unsigned int count = 0;
+    empty.cull(BoundingVolumeHierarchy::get_frustum(QMatrix4x4()), [&](unsigned int) {
+        count++;
+    });
+    CHECK(count == 0);
+
+    return test_result();
+}
@@ -0,0 +1,178 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+
+// Compares the neighbour candidates of CellList and PeriodicCellList with
+// a brute-force search over all atom pairs (and lattice images)
+
+#include <cmath>
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "cell_list.h"
+#include "periodic_cell_list.h"
+#include "check.h"
+
+namespace {
+
+/**
+ * @brief      Every pair within the radius must be among the candidates
+ */
+void test_cell_list() {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(-5.0, 25.0);
+    const double radius = 2.0;
+
+    for(unsigned int trial=0; trial<20; trial++) {
+        // every third set is stretched along z to get an elongated grid
+        const unsigned int n = 50 + trial * 40;
+        const double stretch = trial % 3 == 0 ? 10.0 : 1.0;
+        std::vector<Atom> atoms;
+        for(unsigned int i=0; i<n; i++) {
+            atoms.emplace_back(1, coord(rng), coord(rng), coord(rng) * stretch);
+        }
+
+        CellList cell_list;
+        cell_list.build(atoms, radius);
+
+        std::set<std::pair<unsigned int, unsigned int>> expected;
+        for(unsigned int i=0; i<n; i++) {
+            for(unsigned int j=i+1; j<n; j++) {
+                if(atoms[i].dist(atoms[j]) < radius) {
+                    expected.emplace(i, j);
+                }
+            }
+        }
+
+        std::set<std::pair<unsigned int, unsigned int>> by_index;
+        std::set<std::pair<unsigned int, unsigned int>> by_position;
+        for(unsigned int i=0; i<n; i++) {
+            cell_list.for_each_candidate(i, [&](unsigned int j) {
+                if(j > i && atoms[i].dist(atoms[j]) < radius) {
+                    by_index.emplace(i, j);
+                }
+            });
+            cell_list.for_each_candidate(atoms[i].x, atoms[i].y, atoms[i].z, [&](unsigned int j) {
+                if(j > i && atoms[i].dist(atoms[j]) < radius) {
+                    by_position.emplace(i, j);
+                }
+            });
+        }
+
+        CHECK(by_index == expected);
+        CHECK(by_position == expected);
+    }
+
+    // points outside of the grid still find the atoms at its border
+    std::vector<Atom> atoms;
+    atoms.emplace_back(1, 0.0, 0.0, 0.0);
+    atoms.emplace_back(1, 10.0, 0.0, 0.0);
+    CellList cell_list;
+    cell_list.build(atoms, radius);
+    unsigned int hits = 0;
+    cell_list.for_each_candidate(11.5, 0.0, 0.0, [&](unsigned int j) {
+        hits += (j == 1);
+    });
+    CHECK(hits == 1);
+}
+
+/**
+ * @brief      Every pair within the radius, over any lattice image, must be
+ *             among the candidates exactly once
+ */
+void test_periodic_cell_list() {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const double radius = 2.5;
+    const int max_image = 4;
+
+    for(unsigned int trial=0; trial<40; trial++) {
+        // triclinic cells, including cells narrower than the radius
+        const double length = trial % 4 == 0 ? 2.0 : (trial % 4 == 1 ? 6.0 : 15.0);
+        MatrixUnitcell unitcell;
+        unitcell << length, 0.0, 0.0,
+                    length * 0.3 * unit(rng), length * (0.8 + 0.4 * unit(rng)), 0.0,
+                    length * 0.2 * unit(rng), -length * 0.1 * unit(rng), length * (1.0 + unit(rng));
+
+        // some atoms lie outside of the unit cell
+        const unsigned int n = trial % 4 == 0 ? 3 : 60;
+        std::vector<Atom> atoms;
+        for(unsigned int i=0; i<n; i++) {
+            const VectorPosition fractional(unit(rng) * 1.4 - 0.2, unit(rng), unit(rng));
+            const VectorPosition p = unitcell.transpose() * fractional;
+            atoms.emplace_back(1, p[0], p[1], p[2]);
+        }
+
+        PeriodicCellList cell_list;
+        cell_list.build(atoms, unitcell, radius);
+
+        auto within = [&](unsigned int i, unsigned int j, const VectorPosition& t) {
+            const double dx = atoms[j].x + t[0] - atoms[i].x;
+            const double dy = atoms[j].y + t[1] - atoms[i].y;
+            const double dz = atoms[j].z + t[2] - atoms[i].z;
+            return std::sqrt(dx * dx + dy * dy + dz * dz) < radius;
+        };
+
+        typedef std::tuple<unsigned int, unsigned int, int, int, int> Pair;
+        std::set<Pair> expected;
+        for(unsigned int i=0; i<n; i++) {
+            for(unsigned int j=0; j<n; j++) {
+                for(int x=-max_image; x<=max_image; x++) {
+                    for(int y=-max_image; y<=max_image; y++) {
+                        for(int z=-max_image; z<=max_image; z++) {
+                            if(i == j && x == 0 && y == 0 && z == 0) {
+                                continue;
+                            }
+                            if(within(i, j, unitcell.transpose() * VectorPosition(x, y, z))) {
+                                expected.emplace(i, j, x, y, z);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        std::set<Pair> found;
+        unsigned int duplicates = 0;
+        for(unsigned int i=0; i<n; i++) {
+            cell_list.for_each_candidate(i, [&](unsigned int j, const std::array<int, 3>& image) {
+                if(i == j && image[0] == 0 && image[1] == 0 && image[2] == 0) {
+                    return;
+                }
+                if(within(i, j, cell_list.get_image_translation(image))) {
+                    duplicates += !found.emplace(i, j, image[0], image[1], image[2]).second;
+                }
+            });
+        }
+
+        CHECK(duplicates == 0);
+        CHECK(found == expected);
+    }
+}
+
+} // namespace
+
+int main() {
+    test_cell_list();
+    test_periodic_cell_list();
+
+    return test_result();
+}
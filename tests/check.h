@@ -0,0 +1,54 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <cstdio>
+
+/**
+ * @brief      Number of failed checks in the running test
+ *
+ * @return     The number.
+ */
+inline int& get_nr_failed_checks() {
+    static int nr_failed = 0;
+    return nr_failed;
+}
+
+// report a failed expression and carry on, such that a single run lists
+// all mismatches; main() returns test_result() as the exit code
+#define CHECK(expr) \
+    do { \
+        if(!(expr)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            get_nr_failed_checks()++; \
+        } \
+    } while(0)
+
+/**
+ * @brief      Exit code of the test
+ *
+ * @return     Zero if all checks passed, one otherwise
+ */
+inline int test_result() {
+    std::printf("%d failed checks\n", get_nr_failed_checks());
+    return get_nr_failed_checks() == 0 ? 0 : 1;
+}
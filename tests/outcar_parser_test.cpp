@@ -0,0 +1,342 @@
+/****************************************************************************
+ *                                                                          *
+ *   ATOM ARCHITECT                                                         *
+ *   Copyright (C) 2020-2026 Ivo Filot <i.a.w.filot@tue.nl>                 *
+ *                                                                          *
+ *   This program is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU Lesser General Public License as         *
+ *   published by the Free Software Foundation, either version 3 of the     *
+ *   License, or (at your option) any later version.                        *
+ *                                                                          *
+ *   This program is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *   GNU General Public License for more details.                           *
+ *                                                                          *
+ *   You should have received a copy of the GNU General Public license      *
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>. *
+ *                                                                          *
+ ****************************************************************************/
+
+
+// Compares OutcarParser with a transcription of the line-by-line regular
+// expression loop that StructureLoader::load_outcar() used before, both for
+// the file itself and for a long trajectory made by repeating its ionic steps
+
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <sstream>
+
+#include "outcar_parser.h"
+#include "trajectory.h"
+#include "check.h"
+
+namespace {
+
+/**
+ * @brief      Parse the first six numbers of a line
+ *
+ * @param[in]  line  The line
+ * @param      c     The numbers
+ *
+ * @return     Whether six numbers were found
+ */
+bool parse_six_columns(const std::string& line, double* c) {
+    const char* p = line.c_str();
+    char* end;
+    for(unsigned int i=0; i<6; i++) {
+        c[i] = std::strtod(p, &end);
+        if(p == end) {
+            return false;
+        }
+        p = end;
+    }
+
+    return true;
+}
+
+/**
+ * @brief      Read an OUTCAR the way the regular expression based loader did
+ *
+ * @param      in    The contents
+ *
+ * @return     The structures
+ */
+std::vector<std::shared_ptr<Structure>> parse_reference(std::istream& in) {
+    static const std::regex regex_vasp_version("^\\s*vasp.([0-9]).([0-9]+).([0-9]+).*$");
+    static const std::regex regex_element("^\\s*(VRHFIN\\s+=)([A-Za-z]+)\\s*:.*$");
+    static const std::regex regex_ions_per_element("^\\s*(ions per type =\\s+)([0-9 ]+)\\s*$");
+    static const std::regex regex_lattice_vectors("^\\s*direct lattice vectors.*$");
+    static const std::regex regex_atoms("^\\s*POSITION.*$");
+    static const std::regex regex_grab_energy("^\\s+energy  without entropy=\\s+([0-9.-]+)\\s+energy\\(sigma->0\\) =\\s+([0-9.-]+).*$");
+    static const std::regex regex_frequency_mode("^\\s*[0-9]+\\s+f(/i)?\\s*=\\s*([0-9eE.+-]+)\\s+THz.*$");
+    static const std::regex regex_frequency_eigenvector(
+        "^\\s*(?:[0-9]+\\s+)?([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s+([0-9eE.+-]+)\\s*$");
+
+    enum {
+        ELEMENTS,
+        LATTICE_VECTORS,
+        ATOMS
+    } state = ELEMENTS;
+
+    unsigned int nr_atoms = 0;
+    MatrixUnitcell unitcell = MatrixUnitcell::Zero(3,3);
+    std::vector<double> energies;
+    std::vector<std::string> elements;
+    std::vector<unsigned int> nr_atoms_per_elm;
+    std::vector<Structure::Eigenmode> eigenmodes;
+    bool reading_mode_eigenvectors = false;
+    std::vector<std::shared_ptr<Structure>> structures;
+
+    std::string line;
+    std::smatch match;
+    while(std::getline(in, line)) {
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if(reading_mode_eigenvectors) {
+            if(std::regex_match(line, match, regex_frequency_eigenvector)) {
+                eigenmodes.back().eigenvectors.emplace_back(std::stod(match[4]), std::stod(match[5]), std::stod(match[6]));
+                if(eigenmodes.back().eigenvectors.size() == nr_atoms) {
+                    reading_mode_eigenvectors = false;
+                }
+                continue;
+            }
+
+            if(!eigenmodes.back().eigenvectors.empty()) {
+                reading_mode_eigenvectors = false;
+            }
+        }
+
+        if(line.find("THz") != std::string::npos && std::regex_match(line, match, regex_frequency_mode)) {
+            const double eigenvalue = std::stod(match[2]);
+            eigenmodes.push_back({match[1] == "/i" ? -eigenvalue : eigenvalue, {}});
+            reading_mode_eigenvectors = true;
+            continue;
+        }
+
+        if(state == ELEMENTS) {
+            if(line.find("vasp.") != std::string::npos && std::regex_match(line, match, regex_vasp_version)) {
+                continue;
+            }
+
+            if(line.find("VRHFIN") != std::string::npos && std::regex_match(line, match, regex_element)) {
+                elements.push_back(match[2]);
+                continue;
+            }
+
+            if(line.find("ions per type") != std::string::npos && std::regex_match(line, match, regex_ions_per_element)) {
+                std::istringstream pieces(match[2]);
+                unsigned int count;
+                while(pieces >> count) {
+                    nr_atoms_per_elm.push_back(count);
+                    nr_atoms += count;
+                }
+                state = LATTICE_VECTORS;
+                continue;
+            }
+        }
+
+        if(state == LATTICE_VECTORS) {
+            if(line.find("direct lattice vectors") != std::string::npos && std::regex_match(line, match, regex_lattice_vectors)) {
+                for(unsigned int i=0; i<3; i++) {
+                    std::getline(in, line);
+                    double c[6];
+                    if(parse_six_columns(line, c)) {
+                        unitcell(i,0) = c[0];
+                        unitcell(i,1) = c[1];
+                        unitcell(i,2) = c[2];
+                    }
+                }
+                state = ATOMS;
+                continue;
+            }
+        }
+
+        if(state == ATOMS) {
+            if(line.find("energy  without entropy=") != std::string::npos && std::regex_match(line, match, regex_grab_energy)) {
+                energies.push_back(std::stod(match[2]));
+                continue;
+            }
+
+            if(line.find("POSITION") == std::string::npos || !std::regex_match(line, match, regex_atoms)) {
+                continue;
+            }
+
+            std::getline(in, line); // skip dashed line
+            structures.push_back(std::make_shared<Structure>(unitcell));
+            for(unsigned int i=0; i<nr_atoms_per_elm.size(); i++) {
+                for(unsigned int j=0; j<nr_atoms_per_elm[i]; j++) {
+                    std::getline(in, line);
+                    double c[6];
+                    if(parse_six_columns(line, c)) {
+                        structures.back()->add_atom(AtomSettings::get().get_atom_elnr(elements[i]),
+                                                    c[0], c[1], c[2], c[3], c[4], c[5]);
+                    }
+                }
+            }
+        }
+    }
+
+    if(energies.size() != structures.size()) {
+        throw std::runtime_error("Number of energies does not match number of structures.");
+    }
+    for(unsigned int i=0; i<energies.size(); i++) {
+        structures[i]->set_energy(energies[i]);
+    }
+
+    // frequency calculations keep the first structure with the complete modes
+    if(!eigenmodes.empty() && !structures.empty()) {
+        structures.resize(1);
+        for(const auto& mode : eigenmodes) {
+            if(mode.eigenvectors.size() == nr_atoms) {
+                structures.front()->add_eigenmode(mode.eigenvalue, mode.eigenvectors);
+            }
+        }
+    }
+
+    return structures;
+}
+
+/**
+ * @brief      Check that two structures hold the same data
+ *
+ * @param[in]  a       The structure
+ * @param[in]  b       The expected structure
+ * @param[in]  energy  Whether to compare the energies
+ */
+void check_equal(const Structure& a, const Structure& b, bool energy = true) {
+    CHECK(a.get_unitcell() == b.get_unitcell());
+    CHECK(!energy || a.get_energy() == b.get_energy());
+
+    CHECK(a.get_nr_atoms() == b.get_nr_atoms());
+    for(unsigned int i=0; i<std::min(a.get_nr_atoms(), b.get_nr_atoms()); i++) {
+        const Atom& atom = a.get_atoms()[i];
+        const Atom& expected = b.get_atoms()[i];
+        CHECK(atom.atnr == expected.atnr);
+        CHECK(atom.x == expected.x && atom.y == expected.y && atom.z == expected.z);
+    }
+
+    CHECK(a.get_eigenmodes().size() == b.get_eigenmodes().size());
+    for(unsigned int i=0; i<std::min(a.get_eigenmodes().size(), b.get_eigenmodes().size()); i++) {
+        CHECK(a.get_eigenmodes()[i].eigenvalue == b.get_eigenmodes()[i].eigenvalue);
+        CHECK(a.get_eigenmodes()[i].eigenvectors == b.get_eigenmodes()[i].eigenvectors);
+    }
+}
+
+/**
+ * @brief      Parse an OUTCAR with both parsers and compare the results
+ *
+ * @param[in]  contents  The contents of the OUTCAR
+ */
+void test_outcar(const std::string& contents) {
+    std::istringstream in(contents);
+    const auto expected = parse_reference(in);
+
+    OutcarParser parser(contents.data(), contents.size());
+    const auto structures = parser.parse();
+
+    CHECK(structures.size() == expected.size());
+    for(unsigned int i=0; i<std::min(structures.size(), expected.size()); i++) {
+        check_equal(*structures[i], *expected[i]);
+    }
+
+    // with a progress monitor the steps are parsed in batches
+    LoadProgress progress;
+    OutcarParser monitored(contents.data(), contents.size());
+    monitored.set_progress(&progress);
+    const auto batched = monitored.parse();
+    CHECK(progress.get_fraction() == 1.0);
+    CHECK(batched.size() == expected.size());
+    for(unsigned int i=0; i<std::min(batched.size(), expected.size()); i++) {
+        check_equal(*batched[i], *expected[i]);
+    }
+
+    // the frames of a trajectory are decoded from the index one at a time
+    OutcarParser indexer(contents.data(), contents.size());
+    indexer.set_progress(&progress);
+    Trajectory trajectory([&indexer](size_t offset) {
+        return indexer.parse_frame(offset);
+    });
+    OutcarParser::Scan scan;
+    const bool indexed = indexer.index(trajectory, scan);
+    const bool frequencies = !expected.empty() && !expected.front()->get_eigenmodes().empty();
+    CHECK(indexed == !frequencies);
+    if(!indexed) {
+        return;
+    }
+
+    // a parser that only reads the header decodes the same frames, as
+    // when the index is taken from the cache
+    OutcarParser cached(contents.data(), contents.size());
+    cached.read_frame_header();
+
+    const std::vector<Trajectory::Frame> frames = trajectory.get_frames();
+    CHECK(frames.size() == expected.size());
+    for(unsigned int i=0; i<std::min(frames.size(), expected.size()); i++) {
+        CHECK(frames[i].energy == expected[i]->get_energy());
+        check_equal(*trajectory.get_frame(i), *expected[i], false);
+        check_equal(*cached.parse_frame(frames[i].locator), *expected[i], false);
+    }
+}
+
+/**
+ * @brief      Repeat the second ionic step of an OUTCAR
+ *
+ * @param[in]  contents  The contents of the OUTCAR, with at least three
+ *                       ionic steps
+ * @param[in]  count     Number of times to insert the step
+ *
+ * @return     The contents with the inserted steps
+ */
+std::string repeat_ionic_step(const std::string& contents, unsigned int count) {
+    // ionic steps start with their first electronic iteration
+    std::vector<size_t> starts;
+    for(size_t pos = contents.find("Iteration"); pos != std::string::npos; pos = contents.find("Iteration", pos + 1)) {
+        const size_t eol = contents.find('\n', pos);
+        if(contents.substr(pos, eol - pos).find("(   1)") != std::string::npos) {
+            starts.push_back(contents.rfind('\n', pos) + 1);
+        }
+    }
+
+    if(starts.size() < 3) {
+        return contents;
+    }
+
+    const std::string step = contents.substr(starts[1], starts[2] - starts[1]);
+    std::string result = contents.substr(0, starts[2]);
+    for(unsigned int i=0; i<count; i++) {
+        result += step;
+    }
+    result += contents.substr(starts[2]);
+
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::fprintf(stderr, "Usage: %s OUTCAR\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if(!in) {
+        std::fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 2;
+    }
+    const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    test_outcar(contents);
+
+    // enough ionic steps to be distributed over the threads and to be
+    // parsed and indexed in several batches
+    const std::string repeated = repeat_ionic_step(contents, 200);
+    CHECK(repeated.size() > contents.size());
+    test_outcar(repeated);
+
+    return test_result();
+}